@@ -21,6 +21,7 @@
 
 // C system includes
 #include <stdint.h>
+#include <stddef.h>
 
 // C++ system includes
 #include <string>
@@ -59,6 +60,15 @@ void BcdToTime(int64_t encodedTime, uint32_t& hour, uint32_t& min, uint32_t& sec
  */
 time_t MjdToDate (int64_t encodedTime);
 
+/**
+ * Convert a 40-bit MJD/BCD UTC time straight to seconds since the epoch,
+ * without going through the local time zone
+ *
+ * @param encodedTime 16-bit MJD followed by 6 BCD digits
+ * @return seconds since 1970-01-01 00:00:00 UTC
+ */
+time_t MjdToUtcEpoch(int64_t encodedTime);
+
 /**
  * Decode text information that is coded as described in ETSI EN 300 468 annex A
  *
@@ -68,4 +78,13 @@ time_t MjdToDate (int64_t encodedTime);
  */
 std::string DecodeText(const unsigned char *str, size_t len);
 
+/**
+ * Calculate the CRC_32 as defined in ISO/IEC 13818-1 Annex A
+ *
+ * @param data data
+ * @param len length
+ * @return CRC_32, 0 over a complete section (including its CRC_32 field) means no error
+ */
+uint32_t Crc32(const uint8_t* data, size_t len);
+
 #endif /* DVBUTILS_H_ */
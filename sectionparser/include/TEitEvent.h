@@ -43,6 +43,7 @@ private:
   uint8_t  RunningStatus;
   bool IsCaModeIndicator;
   bool IsNearVideoOnDeman;
+  uint8_t SectionNumber;
   std::vector<TMpegDescriptor> EventDescriptorVector;
 
 public:
@@ -51,7 +52,8 @@ public:
       StartTime(startTime),
       Duration(dur),
       RunningStatus(runningStatus),
-      IsCaModeIndicator(freeCa)
+      IsCaModeIndicator(freeCa),
+      SectionNumber(0)
   {
     IsNearVideoOnDeman = ((StartTime & 0xFFFFF000) == 0xFFFFF000 && RunningStatus == 0x0);
   }
@@ -111,9 +113,10 @@ public:
     return static_cast<TRunningStatus>(RunningStatus);
   }
 
+  // UTC seconds since the epoch
   time_t GetStartTime() const
   {
-    return MjdToDate(StartTime);
+    return MjdToUtcEpoch(StartTime);
   }
 
   uint64_t GetStartTimeBcd() const
@@ -121,6 +124,18 @@ public:
     return StartTime;
   }
 
+  // Section of the sub-table the event was carried in. In an EIT schedule section / 8 is
+  // the segment, in an EIT p/f 0 is the present event and 1 the following one.
+  uint8_t GetSectionNumber() const
+  {
+    return SectionNumber;
+  }
+
+  void SetSectionNumber(uint8_t sectionNumber)
+  {
+    SectionNumber = sectionNumber;
+  }
+
 };
 
 #endif // EITEVENT_H
@@ -0,0 +1,201 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TOBSERVERDISPATCHER_H
+#define TOBSERVERDISPATCHER_H
+
+// C system includes
+#include <stdint.h>
+
+// C++ system includes
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project's includes
+#include "TSiPriority.h"
+
+/**
+ * Per-observer delivery statistics
+ */
+struct TObserverDispatcherStats
+{
+  TObserverDispatcherStats()
+    : QueueDepth(0),
+      MaxQueueDepth(0),
+      DeliveredEvents(0),
+      BlockedPosts(0),
+      ShedEvents(0),
+      TotalLatencyUs(0),
+      MaxLatencyUs(0)
+  {
+    // Empty
+  }
+
+  size_t QueueDepth;                    //!< events waiting for delivery
+  size_t MaxQueueDepth;                 //!< high-water mark of the queue depth
+  uint64_t DeliveredEvents;             //!< number of completed deliveries
+  uint64_t BlockedPosts;                //!< number of times the producer waited for a full queue
+  uint64_t ShedEvents;                  //!< low priority events dropped under overload
+  uint64_t TotalLatencyUs;              //!< sum of post-to-completion latencies
+  uint64_t MaxLatencyUs;                //!< worst post-to-completion latency
+};
+
+/**
+ * Per-priority class delivery statistics. The percentiles are upper bounds with a
+ * power of two resolution.
+ */
+struct TSiPriorityStats
+{
+  TSiPriorityStats()
+    : DeliveredEvents(0),
+      ShedEvents(0),
+      P50LatencyUs(0),
+      P95LatencyUs(0),
+      P99LatencyUs(0),
+      MaxLatencyUs(0)
+  {
+    // Empty
+  }
+
+  uint64_t DeliveredEvents;
+  uint64_t ShedEvents;
+  uint64_t P50LatencyUs;
+  uint64_t P95LatencyUs;
+  uint64_t P99LatencyUs;
+  uint64_t MaxLatencyUs;
+};
+
+/**
+ * Observer dispatcher
+ *
+ * Delivers the events to the observers on a pool of worker threads, so a slow observer
+ * does not stall the parsing thread or the other observers.
+ * Every observer has its own bounded queue; the events of one observer are delivered in order,
+ * by one worker at a time. Posting to a full queue blocks the producer until there is space.
+ *
+ * Every event has a priority class (see TSiPriority). The pending events of an observer are
+ * delivered highest class first, in order within a class, and the observer with the most urgent
+ * event is served first. Under overload the EIT classes are shed instead of blocking the producer:
+ * EIT other when the queue is half full, EIT schedule actual when it is three quarters full, and
+ * both when the latency of the higher classes exceeds the latency target. The shed callback of a
+ * dropped event is called on the posting thread, after the dispatcher lock has been released.
+ */
+class TObserverDispatcher
+{
+public:
+  typedef std::function<void()> Task_t;
+
+private:
+  static const size_t PRIORITY_COUNT = static_cast<size_t>(TSiPriority::SI_PRIORITY_COUNT);
+  // Bucket i counts the latencies below 2^i microseconds
+  static const size_t LATENCY_BUCKETS = 32;
+
+  struct TQueuedTask
+  {
+    Task_t Task;
+    Task_t OnShed;
+    TSiPriority Priority;
+    std::chrono::steady_clock::time_point PostTime;
+  };
+
+  struct TObserverQueue
+  {
+    TObserverQueue()
+      : Depth(0),
+        IsScheduled(false),
+        IsRunning(false),
+        IsRemoved(false)
+    {
+      // Empty
+    }
+
+    std::deque<TQueuedTask> Tasks[PRIORITY_COUNT];
+    size_t Depth;
+    bool IsScheduled;                   // in the ready queue or owned by a worker
+    bool IsRunning;                     // a worker is executing one of the tasks
+    bool IsRemoved;
+    TObserverDispatcherStats Stats;
+  };
+
+  typedef std::map<const void*, std::shared_ptr<TObserverQueue>> QueueMap_t;
+
+  // Disable default copy contructor.
+  TObserverDispatcher(const TObserverDispatcher& other);
+  TObserverDispatcher& operator=(const TObserverDispatcher&);
+
+  struct TPriorityClass
+  {
+    TPriorityClass()
+      : DeliveredEvents(0),
+        ShedEvents(0),
+        MaxLatencyUs(0),
+        LatencyHistogram()
+    {
+      // Empty
+    }
+
+    uint64_t DeliveredEvents;
+    uint64_t ShedEvents;
+    uint64_t MaxLatencyUs;
+    uint64_t LatencyHistogram[LATENCY_BUCKETS];
+  };
+
+  void WorkerThread();
+  bool IsShed(TSiPriority priority, size_t depth) const;
+  bool ShedQueuedTask(TObserverQueue& observerQueue, Task_t& onShed);
+  static size_t GetUrgentClass(const TObserverQueue& observerQueue);
+  static uint64_t GetPercentile(const TPriorityClass& priorityClass, uint64_t percent);
+
+  size_t QueueCapacity;
+  // Shedding latency target of the higher classes, zero when disabled
+  uint64_t LatencyTargetUs;
+  uint64_t HighPriorityLatencyUs;
+  TPriorityClass PriorityClasses[PRIORITY_COUNT];
+  bool IsStopping;
+  std::mutex DispatcherMutex;
+  std::condition_variable WorkCondition;
+  std::condition_variable SpaceCondition;
+  std::condition_variable IdleCondition;
+  std::deque<std::shared_ptr<TObserverQueue>> ReadyQueue;
+  QueueMap_t QueueMap;
+  std::vector<std::thread> WorkerVector;
+
+public:
+  TObserverDispatcher(size_t workerCount, size_t queueCapacity);
+  ~TObserverDispatcher();
+
+  bool Post(const void* observer, const Task_t& task, TSiPriority priority = TSiPriority::SI_PRIORITY_SI,
+            const Task_t& onShed = Task_t());
+  void RemoveObserver(const void* observer);
+  void WaitIdle();
+
+  bool GetStats(const void* observer, TObserverDispatcherStats& stats);
+  std::map<const void*, TObserverDispatcherStats> GetStats();
+
+  void SetLatencyTarget(uint64_t latencyUs);
+  TSiPriorityStats GetPriorityStats(TSiPriority priority);
+};
+
+#endif // TOBSERVERDISPATCHER_H
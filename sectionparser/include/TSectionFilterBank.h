@@ -0,0 +1,112 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONFILTERBANK_H
+#define TSECTIONFILTERBANK_H
+
+// C system includes
+#include <stdint.h>
+
+// C++ system includes
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Section filter, modelled on the demux hardware filters.
+ * Byte 0 is compared against the table_id, bytes 1..15 against the section bytes 3..17
+ * (the section_length field is skipped). Bits with a 0 mask are not compared.
+ */
+struct TSectionFilter
+{
+  static const uint8_t FILTER_DEPTH = 16;
+
+  TSectionFilter();
+  TSectionFilter(uint8_t tableId, uint8_t tableIdMask);
+
+  void SetTableIdExtension(uint16_t extId, uint16_t extIdMask = 0xffff);
+  void SetByte(uint8_t index, uint8_t match, uint8_t mask);
+
+  uint8_t Match[FILTER_DEPTH];
+  uint8_t Mask[FILTER_DEPTH];
+};
+
+/**
+ * Filter bank
+ *
+ * Decides from the raw section header whether a section is wanted, before anything gets allocated.
+ * The filters are compiled into candidate lists indexed by the table_id, so a section is only
+ * compared against the filters that can accept its table_id. The filters can be added and removed
+ * at runtime while another thread is matching sections.
+ */
+class TSectionFilterBank
+{
+private:
+  struct TCompiledFilter
+  {
+    uint32_t Id;
+    uint8_t Depth;                                    // number of header bytes to compare
+    uint8_t Match[TSectionFilter::FILTER_DEPTH];
+    uint8_t Mask[TSectionFilter::FILTER_DEPTH];
+    std::shared_ptr<std::atomic<uint64_t>> HitCount;
+  };
+
+  struct TFilterEntry
+  {
+    TSectionFilter Filter;
+    std::shared_ptr<std::atomic<uint64_t>> HitCount;
+  };
+
+  // Candidate filters per table_id, in the order the filters were added
+  struct TCompiledBank
+  {
+    std::vector<TCompiledFilter> Candidates[256];
+  };
+
+  // Disable default copy contructor.
+  TSectionFilterBank(const TSectionFilterBank& other);
+  TSectionFilterBank& operator=(const TSectionFilterBank&);
+
+  void Compile();
+
+  std::mutex FilterMutex;
+  uint32_t NextFilterId;
+  std::map<uint32_t, TFilterEntry> FilterMap;
+  std::shared_ptr<const TCompiledBank> CompiledBank;
+
+public:
+  // Filter identifiers of the default filters, by the first table_id of each range
+  typedef std::map<uint8_t, std::vector<uint32_t>> TDefaultFilterIds;
+
+  TSectionFilterBank();
+
+  uint32_t AddFilter(const TSectionFilter& filter);
+  std::vector<uint32_t> AddTableIdRange(uint8_t first, uint8_t last);
+  bool RemoveFilter(uint32_t filterId);
+  void Clear();
+  TDefaultFilterIds AddDefaultFilters();
+
+  bool IsMatch(const uint8_t* data, uint32_t size) const;
+
+  uint64_t GetHitCount(uint32_t filterId);
+  std::map<uint32_t, uint64_t> GetHitCounts();
+};
+
+#endif // TSECTIONFILTERBANK_H
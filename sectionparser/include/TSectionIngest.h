@@ -0,0 +1,131 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONINGEST_H
+#define TSECTIONINGEST_H
+
+// C system includes
+#include <stdint.h>
+
+// C++ system includes
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project's includes
+#include "TSectionParser.h"
+
+/**
+ * Ingest ring statistics
+ */
+struct TSectionIngestStats
+{
+  TSectionIngestStats()
+    : PushedSections(0),
+      ParsedSections(0),
+      OverflowDrops(0),
+      HeadroomDrops(0),
+      InvalidDrops(0),
+      Fill(0),
+      MaxFill(0)
+  {
+    // Empty
+  }
+
+  uint64_t PushedSections;              //!< sections accepted into the ring
+  uint64_t ParsedSections;              //!< sections handed to the parser
+  uint64_t OverflowDrops;               //!< sections dropped because the ring was full
+  uint64_t HeadroomDrops;               //!< EIT schedule sections dropped to keep room for the other tables
+  uint64_t InvalidDrops;                //!< empty or oversized sections
+  size_t Fill;                          //!< sections waiting in the ring
+  size_t MaxFill;                       //!< high-water mark of the fill level
+};
+
+/**
+ * Section ingest ring
+ *
+ * Decouples the demux section callback from the parser. Push() copies the section into a
+ * preallocated slot of a bounded single-producer/single-consumer ring and returns in constant
+ * time, without locking; a dedicated thread drains the ring into TSectionParser.
+ * When the free space falls below the headroom, EIT schedule sections are dropped so that
+ * EIT p/f, SDT, NIT, BAT and TDT/TOT sections still get through.
+ *
+ * Push() must always be called from the same thread.
+ */
+class TSectionIngest
+{
+private:
+  // Largest private section (ISO/IEC 13818-1)
+  static const uint32_t MAX_SECTION_SIZE = 4096;
+
+  struct TSlot
+  {
+    uint32_t Size;
+    uint32_t StreamContext;
+  };
+
+  // Disable default copy contructor.
+  TSectionIngest(const TSectionIngest& other);
+  TSectionIngest& operator=(const TSectionIngest&);
+
+  static bool IsSheddable(const uint8_t* data);
+  void ConsumerThread();
+
+  TSectionParser& Parser;
+  size_t Capacity;                      // power of two
+  size_t Headroom;
+  std::vector<TSlot> SlotVector;
+  std::vector<uint8_t> SlotData;
+
+  // Written by the producer only
+  std::atomic<size_t> Head;
+  // Written by the consumer only
+  std::atomic<size_t> Tail;
+
+  std::atomic<uint64_t> PushedSections;
+  std::atomic<uint64_t> ParsedSections;
+  std::atomic<uint64_t> OverflowDrops;
+  std::atomic<uint64_t> HeadroomDrops;
+  std::atomic<uint64_t> InvalidDrops;
+  std::atomic<size_t> MaxFill;
+
+  // Consumer wake-up. The producer only takes the mutex when the consumer is about to sleep or asleep:
+  // Head and IsConsumerWaiting are sequentially consistent, so one of the two sides sees the other.
+  std::mutex WakeMutex;
+  std::condition_variable WakeCondition;
+  std::atomic<bool> IsConsumerWaiting;
+  std::atomic<bool> IsStopping;
+  std::thread Consumer;
+
+public:
+  /**
+   * @param parser parser fed by the consumer thread
+   * @param capacity number of slots, rounded up to a power of two
+   * @param headroom free slots kept for the sections other than EIT schedule
+   */
+  TSectionIngest(TSectionParser& parser, size_t capacity, size_t headroom);
+  ~TSectionIngest();
+
+  bool Push(const uint8_t* data, uint32_t size, uint32_t streamContext = 0);
+
+  TSectionIngestStats GetStats() const;
+};
+
+#endif // TSECTIONINGEST_H
@@ -0,0 +1,130 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONKEY_H
+#define TSECTIONKEY_H
+
+// C system includes
+#include <stdint.h>
+
+// Project's includes
+#include "TSiSection.h"
+#include "TSiTable.h"
+
+/**
+ * Sub-table key
+ *
+ * Identifies the state of a sub-table. The EIT and SDT sub-tables also carry the
+ * original_network_id and transport_stream_id of their payload, so the sub-tables of different
+ * transports sharing the same table_id_extension don't collide. The stream context (tuner or
+ * TS handle) separates the assemblies of the same sub-table received from different inputs.
+ */
+struct TSectionKey
+{
+  TSectionKey()
+    : StreamContext(0),
+      TableId(0),
+      ExtensionTableId(0),
+      OriginalNetworkId(0),
+      TransportStreamId(0)
+  {
+    // Empty
+  }
+
+  TSectionKey(uint8_t tableId, uint16_t extId, uint16_t onId = 0, uint16_t tsId = 0, uint32_t streamContext = 0)
+    : StreamContext(streamContext),
+      TableId(tableId),
+      ExtensionTableId(extId),
+      OriginalNetworkId(onId),
+      TransportStreamId(tsId)
+  {
+    // Empty
+  }
+
+  TSectionKey(const TSiSection& section, uint32_t streamContext);
+
+  // Same sub-table, regardless of the input it was received from
+  TSectionKey GetContentKey() const
+  {
+    return TSectionKey(TableId, ExtensionTableId, OriginalNetworkId, TransportStreamId);
+  }
+
+  bool operator<(const TSectionKey& other) const
+  {
+    if(StreamContext != other.StreamContext)
+    {
+      return StreamContext < other.StreamContext;
+    }
+    if(TableId != other.TableId)
+    {
+      return TableId < other.TableId;
+    }
+    if(ExtensionTableId != other.ExtensionTableId)
+    {
+      return ExtensionTableId < other.ExtensionTableId;
+    }
+    if(OriginalNetworkId != other.OriginalNetworkId)
+    {
+      return OriginalNetworkId < other.OriginalNetworkId;
+    }
+    return TransportStreamId < other.TransportStreamId;
+  }
+
+  uint32_t StreamContext;
+  uint8_t TableId;
+  uint16_t ExtensionTableId;
+  uint16_t OriginalNetworkId;
+  uint16_t TransportStreamId;
+};
+
+/**
+ * Build the key of a received section
+ *
+ * @param section section
+ * @param streamContext input the section was received from
+ */
+inline TSectionKey::TSectionKey(const TSiSection& section, uint32_t streamContext)
+  : StreamContext(streamContext),
+    TableId(section.TableId),
+    ExtensionTableId(section.ExtensionTableId),
+    OriginalNetworkId(0),
+    TransportStreamId(0)
+{
+  TTableId tableId = static_cast<TTableId>(section.TableId);
+  const std::vector<uint8_t>& payload = section.Payload;
+
+  if((tableId >= TTableId::TABLE_ID_EIT_PF) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END))
+  {
+    // transport_stream_id, original_network_id
+    if(payload.size() >= 4)
+    {
+      TransportStreamId = (payload[0] << 8) | payload[1];
+      OriginalNetworkId = (payload[2] << 8) | payload[3];
+    }
+  }
+  else if((tableId == TTableId::TABLE_ID_SDT) || (tableId == TTableId::TABLE_ID_SDT_OTHER))
+  {
+    // original_network_id, the transport_stream_id is the table_id_extension
+    if(payload.size() >= 2)
+    {
+      OriginalNetworkId = (payload[0] << 8) | payload[1];
+    }
+  }
+}
+
+#endif // TSECTIONKEY_H
@@ -23,11 +23,14 @@
 #include <stdint.h>
 
 // C++ system includes
-#include <list>
+#include <bitset>
+#include <chrono>
 #include <string>
+#include <vector>
 
 // Project's includes
 #include "TSiSection.h"
+#include "TSectionStore.h"
 
 // Forward declarations
 class TSiTable;
@@ -38,6 +41,29 @@ class TEitTable;
 class TTotTable;
 class TUdtTable;
 
+/**
+ * What is left of a complete section list once the table has been built.
+ * Enough to tell a repetition from a new version.
+ */
+struct TSectionListSignature
+{
+  TSectionListSignature()
+    : TableId(0),
+      ExtensionTableId(0),
+      VersionNumber(0),
+      LastSectionNumber(0)
+  {
+    // Empty
+  }
+
+  uint8_t TableId;
+  uint16_t ExtensionTableId;
+  uint8_t VersionNumber;
+  uint8_t LastSectionNumber;
+  std::bitset<256> SectionBitmap;       //!< received section numbers
+  std::vector<uint32_t> SectionCrc;     //!< CRC_32 of the received sections in section number order, optional
+};
+
 /**
  * Section list class
  */
@@ -46,13 +72,24 @@ class TSectionList
 private:
   bool IsComplete;
   uint8_t FirstReceivedSectionNumber;
-  std::list<TSiSection> SiSectionList;
+  TSectionStore SiSectionList;
+  size_t PayloadSize;
+  std::chrono::steady_clock::time_point LastAccessTime;
+  std::chrono::steady_clock::time_point AssemblyStartTime;
+  uint32_t CycleCount;
+  bool IsPartialPublished;
+  bool IsCompacted;
+  bool IsRevision;
+  TSectionListSignature Signature;
   void InsertSectionIntoList(TSiSection& section);
+  bool AddSiSectionToSignature(TSiSection& section);
+  static uint32_t GetSectionCrc(const TSiSection& section);
 
   //  Check if the section list is complete (all sections of the table are in place)
   bool IsSectionListComplete(TSiSection& lastRcvdSect);
   void InitializeSectionList(TSiSection& section);
   bool IsEit(uint8_t tableId);
+  bool IsEitPf(uint8_t tableId);
 
   TNitTable* BuildNit();
   TBatTable* BuildBat();
@@ -74,6 +111,95 @@ public:
     return IsComplete;
   }
 
+  uint8_t GetVersionNumber() const
+  {
+    if(IsCompacted)
+    {
+      return Signature.VersionNumber;
+    }
+    return SiSectionList.empty() ? 0 : SiSectionList.front().VersionNumber;
+  }
+
+  uint8_t GetLastSectionNumber() const
+  {
+    if(IsCompacted)
+    {
+      return Signature.LastSectionNumber;
+    }
+    return SiSectionList.empty() ? 0 : SiSectionList.front().LastSectionNumber;
+  }
+
+  // Sections held, 0 once compacted
+  size_t GetSectionCount() const
+  {
+    return SiSectionList.size();
+  }
+
+  // Section numbers of the current version that have not been received yet
+  std::bitset<256> GetMissingSections() const;
+
+  // When the assembly of the current version started
+  std::chrono::steady_clock::time_point GetAssemblyStartTime() const
+  {
+    return AssemblyStartTime;
+  }
+
+  // Number of times the first received section came round again before the list completed
+  uint32_t GetCycleCount() const
+  {
+    return CycleCount;
+  }
+
+  bool GetPartialPublishedFlag() const
+  {
+    return IsPartialPublished;
+  }
+
+  void SetPartialPublishedFlag(bool published)
+  {
+    IsPartialPublished = published;
+  }
+
+  // Release the sections of a complete table, keeping only its signature
+  void Compact(bool keepCrc);
+
+  bool IsCompactedList() const
+  {
+    return IsCompacted;
+  }
+
+  // Forget the section CRCs of the signature, e.g. when they were taken from the "next" sections
+  // (current_next_indicator = 0) and would not match the repetitions of the current version
+  void DropSectionCrc()
+  {
+    std::vector<uint32_t>().swap(Signature.SectionCrc);
+  }
+
+  // True while re-assembling a compacted table whose sections changed without a version update
+  bool IsRevisedVersion() const
+  {
+    return IsRevision;
+  }
+
+  // Approximate heap usage of the sections held by the list
+  size_t GetMemoryUsage() const
+  {
+    return PayloadSize + SiSectionList.GetMemoryUsage() + Signature.SectionCrc.size() * sizeof(uint32_t);
+  }
+
+  const std::chrono::steady_clock::time_point& GetLastAccessTime() const
+  {
+    return LastAccessTime;
+  }
+
+  void SetLastAccessTime(const std::chrono::steady_clock::time_point& time)
+  {
+    LastAccessTime = time;
+  }
+
+  // Exchange the contents of two section lists in constant time
+  void Swap(TSectionList& other);
+
   std::string ToString() const;
 
 };
@@ -24,12 +24,89 @@
 #include <list>
 #include <utility>
 #include <memory>
+#include <mutex>
+#include <chrono>
 
 #include "TSectionList.h"
+#include "TSectionKey.h"
+#include "TSiTableDiff.h"
+#include "TObserverDispatcher.h"
+#include "TSectionFilterBank.h"
 #include "IDvbSectionParserSubject.h"
 #include "IDvbSectionParserObserver.h"
+#include "IDvbTableObserver.h"
+#include "IDvbTableParser.h"
+#include "TSectionParserObserverAdapter.h"
 
-typedef std::map<std::pair<uint8_t, uint16_t>, TSectionList> SectionMap_t;
+/**
+ * Arrival-to-delivery latency of the small, frequent tables. Measured from the ParseSiData()
+ * call until the observers return (or the tables are queued, with the asynchronous delivery).
+ */
+struct TFastPathStats
+{
+  TFastPathStats()
+    : TdtSections(0),
+      TotalTdtLatencyUs(0),
+      MaxTdtLatencyUs(0),
+      EitPfTables(0),
+      TotalEitPfLatencyUs(0),
+      MaxEitPfLatencyUs(0)
+  {
+    // Empty
+  }
+
+  uint64_t TdtSections;
+  uint64_t TotalTdtLatencyUs;
+  uint64_t MaxTdtLatencyUs;
+  uint64_t EitPfTables;
+  uint64_t TotalEitPfLatencyUs;
+  uint64_t MaxEitPfLatencyUs;
+};
+
+typedef std::map<TSectionKey, TSectionList> SectionMap_t;
+typedef std::pair<uint8_t, TSiTableSignature> TVersionSignature;
+typedef std::map<TSectionKey, TVersionSignature> SignatureMap_t;
+
+/**
+ * Published version of a sub-table. Counted in the memory budget and evicted like the section state.
+ */
+struct TPublishedTable
+{
+  TPublishedTable()
+    : VersionNumber(0),
+      LastSectionNumber(0),
+      IsPartial(false),
+      IsShed(false),
+      StreamContext(0),
+      TableSize(0)
+  {
+    // Empty
+  }
+
+  std::shared_ptr<const TSiTable> Table;
+  uint8_t VersionNumber;
+  uint8_t LastSectionNumber;
+  bool IsPartial;
+  bool IsShed;                                          //!< a delivery was shed, the version is published again
+  uint32_t StreamContext;                               //!< input the version was acquired from
+  std::chrono::steady_clock::time_point PublishTime;
+  size_t TableSize;                                     //!< approximate heap usage of the table
+  std::chrono::steady_clock::time_point LastAccessTime; //!< publication or last GetTable()
+};
+typedef std::map<TSectionKey, TPublishedTable> PublishedTableMap_t;
+
+// Next version of a sub-table, built ahead of its activation
+struct TNextTable
+{
+  TNextTable()
+    : TableSize(0)
+  {
+    // Empty
+  }
+
+  std::shared_ptr<TSiTable> Table;
+  size_t TableSize;
+};
 
 /**
  * TSectionParser
@@ -39,19 +116,199 @@ typedef std::map<std::pair<uint8_t, uint16_t>, TSectionList> SectionMap_t;
 class TSectionParser : public IDvbSectionParserSubject
 {
 private:
-  std::vector<IDvbSectionParserObserver*> ObserverVector;
+  // Typed observer, with the adapter delivering the tables to a legacy observer
+  struct TTableObserver
+  {
+    IDvbTableObserver* Observer;
+    std::shared_ptr<TSectionParserObserverAdapter> Adapter;
+    const void* DispatcherKey;          //!< the legacy observers are queued by their own address
+  };
+  typedef std::vector<IDvbSectionParserObserver*> ObserverVector_t;
+  typedef std::vector<TTableObserver> TableObserverVector_t;
+
+  // The observer lists are replaced on registration and delivered from snapshots, so the
+  // parsing threads never iterate a list being modified
+  std::mutex ObserverMutex;
+  std::shared_ptr<const ObserverVector_t> ObserverVector;
+  std::shared_ptr<const TableObserverVector_t> TableObserverVector;
   // Disable default copy contructor.
   TSectionParser(const TSectionParser& other);
   TSectionParser& operator=(const TSectionParser&);
 
-  bool IsTableSupported(uint8_t tableId);
+  // Table completed while holding the section state mutex, delivered after releasing it
+  struct TTableDelivery
+  {
+    TSectionKey Key;
+    std::shared_ptr<TSiTable> Table;
+    std::shared_ptr<TSiTableDelta> Delta;
+    std::shared_ptr<const TVersionSignature> PreviousSignature; //!< delta base, restored if the delivery is shed
+  };
+  typedef std::vector<TTableDelivery> TTableDeliveryList;
+
+  // Deliveries of one sub-table, made by one thread at a time in the publication order
+  struct TDeliveryQueue
+  {
+    TDeliveryQueue()
+      : IsDelivering(false)
+    {
+      // Empty
+    }
+
+    std::list<TTableDelivery> Pending;
+    bool IsDelivering;
+  };
+
+  void AssembleSection(uint8_t *data, uint32_t size, uint32_t streamContext, TTableDeliveryList& deliveries,
+                       bool& isVersionStart);
+  std::shared_ptr<TSiTableDelta> GetTableDelta(const TSectionKey& key, const TSiTable& tbl,
+                                               std::shared_ptr<const TVersionSignature>& previous);
+  void PublishTable(const TSectionKey& key, const std::shared_ptr<const TSiTable>& tbl, uint8_t lastSectionNumber,
+                    size_t tableSize);
+  void CompleteTable(const TSectionKey& key, const std::shared_ptr<TSiTable>& tbl, uint8_t lastSectionNumber,
+                     size_t tableSize, TTableDeliveryList& deliveries);
+  void QueueDeliveries(const TTableDeliveryList& deliveries);
+  void DeliverTables(const TTableDeliveryList& deliveries);
+  bool IsStaleVersion(const TSectionKey& key, uint8_t version);
+  bool IsPublishedVersion(const TSectionKey& key, uint8_t version, uint8_t lastSectionNumber);
+  bool IsPartialPublicationDue(const TSectionList& secList) const;
+  void PublishPartialTable(const TSectionKey& key, TSectionList& secList, TTableDeliveryList& deliveries);
+  void UpdateMemoryUsage(size_t prevUsage, size_t usage);
+  void EvictSectionList(SectionMap_t& sectionMap, SectionMap_t::iterator it);
+  void MaintainSectionState();
+  void HandleTdt(const uint8_t *data, uint32_t size);
+  bool HandleCustomSection(const uint8_t *data, uint32_t size, uint32_t streamContext);
+  void NotifyCustomTable(const std::shared_ptr<const TSiTable>& tbl);
+  void NotifyVersionSeen(const uint8_t *data, uint32_t size);
+  void UpdateFastPathStats(TTableId tableId, std::chrono::steady_clock::time_point arrivalTime);
+  std::shared_ptr<const ObserverVector_t> GetObservers();
+  std::shared_ptr<const TableObserverVector_t> GetTableObservers();
+  std::shared_ptr<TObserverDispatcher> GetDispatcher();
+  void AddTableObserver(IDvbTableObserver* observer, const std::shared_ptr<TSectionParserObserverAdapter>& adapter);
+  void NotifyDvbTableObserver(const TTableDelivery& delivery);
+  void HandleShedTable(const TSectionKey& key, uint8_t version, const std::shared_ptr<const TVersionSignature>& previous);
+  static void DispatchTable(IDvbTableObserver* observer, const std::shared_ptr<const TSiTable>& tbl);
+  void AddNextSection(TSiSection& section, const TSectionKey& key);
+  bool ActivateNextTable(TSiSection& section, const TSectionKey& key, TTableDeliveryList& deliveries);
+  void DropStaleNextVersion(const TSiSection& section, const TSectionKey& key);
+
+  // Protects the section state (section maps, memory accounting, delta signatures)
+  std::mutex SectionStateMutex;
   SectionMap_t m_sectionMap;
 
+  // Memory budget of the section state
+  size_t MemoryBudget;
+  std::chrono::seconds PartialAssemblyTimeout;
+  size_t SectionMemoryUsage;
+  std::chrono::steady_clock::time_point LastSweepTime;
+
+  // Complete sub-tables are reduced to their signature
+  bool IsCompactionEnabled;
+  bool IsSectionCrcKept;
+
+  // Incomplete sub-tables are published as partial tables after this age or number of cycles
+  std::chrono::seconds PartialPublicationAge;
+  uint32_t PartialPublicationCycles;
+
+  // Sections rejected by the filter bank never reach the section map
+  TSectionFilterBank FilterBank;
+  TSectionFilterBank::TDefaultFilterIds DefaultFilterIds;
+
+  // Sub-tables with current_next_indicator = 0, assembled and built ahead of their activation
+  SectionMap_t NextSectionMap;
+  std::map<TSectionKey, TNextTable> NextTableMap;
+
+  // Last complete version of every sub-table. Kept while the next version is being assembled.
+  // The memory usage is updated with the section state mutex held.
+  std::mutex PublishedTableMutex;
+  PublishedTableMap_t PublishedTableMap;
+  size_t PublishedMemoryUsage;
+
+  // Pending deliveries by content key. Queued with the section state mutex held, so the observers
+  // get the versions of a sub-table in the order they were published, never concurrently.
+  std::mutex DeliveryMutex;
+  std::map<TSectionKey, TDeliveryQueue> DeliveryQueueMap;
+
+  // Signatures of the last published SDT/EIT versions, used for the delta events
+  bool IsTableDeltaEnabled;
+  SignatureMap_t SignatureMap;
+
+  // Asynchronous table delivery, NULL when the observers are called on the parsing thread.
+  // Replaced under the observer mutex, the deliveries in progress keep the previous one.
+  std::shared_ptr<TObserverDispatcher> Dispatcher;
+
+  // User defined table parsers by table identifier. The calls are made with the mutex held.
+  std::mutex TableParserMutex;
+  IDvbTableParser* TableParsers[256];
+
+  std::mutex FastPathStatsMutex;
+  TFastPathStats FastPathStats;
+
 public:
   TSectionParser();
   virtual ~TSectionParser();
 
   void ParseSiData(uint8_t *data, uint32_t size);
+  // Sections from several inputs can be fed concurrently, each input assembles its own sub-tables.
+  // A version older than the one published from another input is dropped, and the versions of a
+  // sub-table are delivered one at a time, in the order they were published.
+  void ParseSiData(uint8_t *data, uint32_t size, uint32_t streamContext);
+
+  // Last complete version of the sub-table, or NULL if none has completed yet (or the memory budget
+  // has evicted it). Safe to call from any thread; the returned snapshot is never modified.
+  std::shared_ptr<const TSiTable> GetTable(uint8_t tableId, uint16_t extId);
+  std::shared_ptr<const TSiTable> GetTable(const TSectionKey& key);
+
+  // Bound the memory held by the sub-tables being assembled and the published tables
+  void SetMemoryBudget(size_t budget, uint32_t partialTimeout);
+  // Enabled by default, with the CRC_32 of every section kept
+  void SetCompaction(bool enable, bool keepCrc);
+  // Disabled by default. See TSiTable::IsPartial.
+  void SetPartialPublication(uint32_t maxAge, uint32_t maxCycles);
+  size_t GetMemoryUsage();
+  void Flush();
+  void Flush(uint32_t streamContext);
+  void Reset();
+
+  // The bank starts with the filters for all the supported tables. It can be reprogrammed at any time.
+  TSectionFilterBank& GetFilterBank()
+  {
+    return FilterBank;
+  }
+
+  // Identifiers of the filters the bank starts with, see TSectionFilterBank::AddDefaultFilters
+  const TSectionFilterBank::TDefaultFilterIds& GetDefaultFilterIds() const
+  {
+    return DefaultFilterIds;
+  }
+
+  // When enabled, every new SDT/EIT version is followed by IDvbTableObserver::OnDelta (a TABLE_DELTA_EVENT
+  // for the legacy observers)
+  void SetTableDeltaEnabled(bool enable);
+
+  // Deliver the tables (and the delta events) on a pool of worker threads with a bounded queue
+  // per observer, most urgent table class first. Zero workers restores the synchronous delivery.
+  // A shed EIT table is delivered again from the next repetition of its sections, so the observers
+  // that did receive it may see the same version twice. Can be switched while other threads parse:
+  // the previous dispatcher delivers its pending events once the last delivery posting to it returns.
+  // Not to be called from an observer callback, or while one may call the statistics getters.
+  void SetAsyncDelivery(size_t workerCount, size_t queueCapacity, uint64_t latencyTargetUs = 0);
+  // Queue depth and latency of the observer (IDvbTableObserver or IDvbSectionParserObserver)
+  bool GetObserverStats(const void* observerObject, TObserverDispatcherStats& stats);
+  // Latency percentiles and shed tables of a priority class, over all the observers
+  bool GetPriorityStats(TSiPriority priority, TSiPriorityStats& stats);
+  // TDT and EIT p/f latency from the section arrival
+  TFastPathStats GetFastPathStats();
+
+  // User defined tables (0x80-0xfe) of the range are handed to the parser instead of being assembled
+  // into a TUdtTable. Its tables reach the observers through OnCustomTable.
+  bool RegisterTableParser(uint8_t firstTableId, uint8_t lastTableId, IDvbTableParser* parser);
+  void RemoveTableParser(IDvbTableParser* parser);
+
+  // Typed table delivery. The table instance is shared by all the observers and never modified.
+  // Safe to call while other threads parse; with the synchronous delivery, a call already in
+  // progress on a parsing thread may still complete after the removal.
+  void RegisterDvbTableObserver(IDvbTableObserver* observerObject);
+  void RemoveDvbTableObserver(IDvbTableObserver* observerObject);
 
   // IDvbSectionParserSubject 
   virtual void RegisterDvbSectionParserObserver(IDvbSectionParserObserver* observerObject);
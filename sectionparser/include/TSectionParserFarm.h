@@ -0,0 +1,146 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONPARSERFARM_H
+#define TSECTIONPARSERFARM_H
+
+// C system includes
+#include <stdint.h>
+
+// C++ system includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project's includes
+#include "TSectionParser.h"
+
+/**
+ * Per-instance statistics
+ */
+struct TParserInstanceStats
+{
+  TParserInstanceStats()
+    : ParsedSections(0),
+      DroppedSections(0),
+      CrcErrors(0),
+      QueueDepth(0),
+      MaxQueueDepth(0),
+      CpuTimeUs(0)
+  {
+    // Empty
+  }
+
+  uint64_t ParsedSections;              //!< sections handed to the parser
+  uint64_t DroppedSections;             //!< sections dropped because the queue was full
+  uint64_t CrcErrors;                   //!< sections dropped because of a CRC_32 error
+  size_t QueueDepth;                    //!< sections waiting to be parsed
+  size_t MaxQueueDepth;                 //!< high-water mark of the queue depth
+  uint64_t CpuTimeUs;                   //!< thread CPU time spent parsing and notifying the observers
+};
+
+/**
+ * Section parser farm
+ *
+ * Runs many logical parser instances (e.g. one per multiplex) on a fixed pool of worker threads.
+ * The sections of an instance are parsed in the order they were submitted, by one worker at a time.
+ * Every worker serves its own instances first and steals ready instances from the other workers
+ * when it runs out of work. The text conversion descriptors and the CRC table are shared by all
+ * the instances running on the pool.
+ */
+class TSectionParserFarm
+{
+private:
+  struct TInstance
+  {
+    TInstance(uint32_t id, size_t homeWorker)
+      : Id(id),
+        HomeWorker(homeWorker),
+        IsScheduled(false),
+        IsRunning(false),
+        IsRemoved(false)
+    {
+      // Empty
+    }
+
+    uint32_t Id;
+    size_t HomeWorker;
+    TSectionParser Parser;
+    std::mutex QueueMutex;
+    std::condition_variable IdleCondition;
+    std::deque<std::vector<uint8_t>> SectionQueue;
+    bool IsScheduled;                   // in a ready queue or owned by a worker
+    bool IsRunning;
+    bool IsRemoved;
+    TParserInstanceStats Stats;
+  };
+
+  struct TWorker
+  {
+    std::mutex ReadyMutex;
+    std::deque<std::shared_ptr<TInstance>> ReadyQueue;
+    std::thread Thread;
+  };
+
+  // Disable default copy contructor.
+  TSectionParserFarm(const TSectionParserFarm& other);
+  TSectionParserFarm& operator=(const TSectionParserFarm&);
+
+  void WorkerThread(size_t index);
+  void Schedule(size_t workerIndex, const std::shared_ptr<TInstance>& instance);
+  std::shared_ptr<TInstance> TakeInstance(size_t workerIndex);
+  void RunInstance(size_t workerIndex, const std::shared_ptr<TInstance>& instance);
+  std::shared_ptr<TInstance> FindInstance(uint32_t id);
+
+  size_t QueueCapacity;
+  std::atomic<bool> IsCrcCheckEnabled;
+  std::vector<std::unique_ptr<TWorker>> WorkerVector;
+
+  std::mutex InstanceMutex;
+  uint32_t NextInstanceId;
+  std::map<uint32_t, std::shared_ptr<TInstance>> InstanceMap;
+
+  // Sleeping workers
+  std::mutex WakeMutex;
+  std::condition_variable WakeCondition;
+  std::atomic<size_t> ReadyInstances;
+  bool IsStopping;
+
+public:
+  TSectionParserFarm(size_t workerCount, size_t queueCapacity);
+  ~TSectionParserFarm();
+
+  // Enables the CRC_32 check of the sections with the syntax indicator set
+  void SetCrcCheck(bool enable);
+
+  uint32_t CreateParser();
+  void DestroyParser(uint32_t id);
+
+  // Valid until the instance is destroyed. Used to register the observers and configure the parser.
+  TSectionParser* GetParser(uint32_t id);
+
+  bool Submit(uint32_t id, const uint8_t* data, uint32_t size);
+  bool GetStats(uint32_t id, TParserInstanceStats& stats);
+};
+
+#endif // TSECTIONPARSERFARM_H
@@ -0,0 +1,68 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONPARSEROBSERVERADAPTER_H
+#define TSECTIONPARSEROBSERVERADAPTER_H
+
+#include <memory>
+
+#include "TSiTable.h"
+#include "TSiTableDiff.h"
+#include "IDvbTableObserver.h"
+#include "IDvbSectionParserObserver.h"
+
+/**
+ * Delivers the typed table events to an observer implementing the legacy SendEvent interface.
+ * The event type is the table identifier and the event data points to a heap copy of the table,
+ * owned by the observer as before the typed delivery. The TSiTableDelta of a TABLE_DELTA_EVENT
+ * is only valid during the call.
+ * The tables of the user defined parsers are not sent: the legacy observers take the user defined
+ * table identifiers for TUdtTable.
+ */
+class TSectionParserObserverAdapter : public IDvbTableObserver
+{
+private:
+  IDvbSectionParserObserver* Observer;
+
+  template<class T>
+  void SendTable(const T& tbl);
+
+public:
+  explicit TSectionParserObserverAdapter(IDvbSectionParserObserver* observer)
+    : Observer(observer)
+  {
+    // Empty
+  }
+
+  IDvbSectionParserObserver* GetObserver() const
+  {
+    return Observer;
+  }
+
+  // IDvbTableObserver
+  virtual void OnNit(const std::shared_ptr<const TNitTable>& nit);
+  virtual void OnSdt(const std::shared_ptr<const TSdtTable>& sdt);
+  virtual void OnBat(const std::shared_ptr<const TBatTable>& bat);
+  virtual void OnEit(const std::shared_ptr<const TEitTable>& eit);
+  virtual void OnTot(const std::shared_ptr<const TTotTable>& tot);
+  virtual void OnUdt(const std::shared_ptr<const TUdtTable>& udt);
+  virtual void OnTdt(time_t utcTime, uint64_t utcTimeBcd);
+  virtual void OnDelta(const std::shared_ptr<const TSiTableDelta>& delta);
+};
+
+#endif // TSECTIONPARSEROBSERVERADAPTER_H
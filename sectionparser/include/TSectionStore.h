@@ -0,0 +1,180 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONSTORE_H
+#define TSECTIONSTORE_H
+
+// C system includes
+#include <stdint.h>
+
+// C++ system includes
+#include <algorithm>
+#include <vector>
+
+// Project's includes
+#include "TSiSection.h"
+
+/**
+ * Sections of a sub-table, kept in section number order
+ *
+ * The EIT present/following sub-tables have sections 0 and 1 only. Their sections go to two
+ * fixed slots that keep their payload buffers from one version to the next, so a new p/f version
+ * allocates neither list nodes nor, once the buffers are large enough, payloads.
+ */
+class TSectionStore
+{
+public:
+  typedef TSiSection* iterator;
+  typedef const TSiSection* const_iterator;
+
+  TSectionStore()
+    : IsFixed(false),
+      FixedCount(0)
+  {
+    // Empty
+  }
+
+  // Empty the store and select the fixed slots (EIT p/f) or the growing array
+  void Reset(bool useFixedSlots)
+  {
+    clear();
+    if(IsFixed != useFixedSlots)
+    {
+      for(uint32_t i = 0; i < FIXED_SLOT_COUNT; i++)
+      {
+        std::vector<uint8_t>().swap(FixedSlots[i].Payload);
+      }
+      IsFixed = useFixedSlots;
+    }
+  }
+
+  /**
+   * Insert the section at its place
+   *
+   * @param section received section
+   * @return false if a section of the same number is already in place, or the fixed slots are full
+   */
+  bool Insert(const TSiSection& section)
+  {
+    iterator it = std::lower_bound(begin(), end(), section.SectionNumber,
+                                   [](const TSiSection& s, uint8_t number) { return s.SectionNumber < number; });
+    if((it != end()) && (it->SectionNumber == section.SectionNumber))
+    {
+      return false;
+    }
+
+    if(!IsFixed)
+    {
+      Sections.insert(Sections.begin() + (it - begin()), section);
+      return true;
+    }
+
+    if(FixedCount == FIXED_SLOT_COUNT)
+    {
+      return false;
+    }
+
+    // The slot past the last one is free, its payload buffer is reused by the assignment
+    for(iterator slot = end(); slot != it; --slot)
+    {
+      std::swap(*slot, *(slot - 1));
+    }
+    *it = section;
+    FixedCount++;
+    return true;
+  }
+
+  // The payload buffers of the fixed slots are kept for the next version
+  void clear()
+  {
+    std::vector<TSiSection>().swap(Sections);
+    FixedCount = 0;
+  }
+
+  void swap(TSectionStore& other)
+  {
+    std::swap(IsFixed, other.IsFixed);
+    std::swap(FixedCount, other.FixedCount);
+    for(uint32_t i = 0; i < FIXED_SLOT_COUNT; i++)
+    {
+      std::swap(FixedSlots[i], other.FixedSlots[i]);
+    }
+    Sections.swap(other.Sections);
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  size_t size() const
+  {
+    return IsFixed ? FixedCount : Sections.size();
+  }
+
+  TSiSection& front()
+  {
+    return *begin();
+  }
+
+  const TSiSection& front() const
+  {
+    return *begin();
+  }
+
+  iterator begin()
+  {
+    return IsFixed ? FixedSlots : Sections.data();
+  }
+
+  iterator end()
+  {
+    return begin() + size();
+  }
+
+  const_iterator begin() const
+  {
+    return IsFixed ? FixedSlots : Sections.data();
+  }
+
+  const_iterator end() const
+  {
+    return begin() + size();
+  }
+
+  // Heap usage of the store, the payloads of the stored sections excluded
+  size_t GetMemoryUsage() const
+  {
+    size_t usage = Sections.capacity() * sizeof(TSiSection);
+    for(uint32_t i = 0; i < FIXED_SLOT_COUNT; i++)
+    {
+      usage += FixedSlots[i].Payload.capacity() - ((i < FixedCount) ? FixedSlots[i].Payload.size() : 0);
+    }
+    return usage;
+  }
+
+private:
+  static const uint32_t FIXED_SLOT_COUNT = 2;
+
+  bool IsFixed;
+  uint8_t FixedCount;
+  TSiSection FixedSlots[FIXED_SLOT_COUNT];
+  std::vector<TSiSection> Sections;
+};
+
+#endif // TSECTIONSTORE_H
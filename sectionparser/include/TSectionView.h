@@ -0,0 +1,106 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONVIEW_H
+#define TSECTIONVIEW_H
+
+// C system includes
+#include <stdint.h>
+
+/**
+ * Read-only view of a raw section
+ *
+ * Same header fields as TSiSection, without copying the payload. Only valid during the call
+ * it is passed to; the data belongs to the caller of TSectionParser::ParseSiData.
+ */
+struct TSectionView
+{
+  /**
+   * @param data section data
+   * @param size data size
+   */
+  TSectionView(const uint8_t* data, uint32_t size)
+    : Data(data),
+      Size(size),
+      TableId(0),
+      SectionSyntaxIndicator(false),
+      SectionLength(0),
+      ExtensionTableId(0),
+      VersionNumber(0),
+      CurrentNextIndicator(true),
+      SectionNumber(0),
+      LastSectionNumber(0),
+      Payload(0),
+      PayloadSize(0)
+  {
+    if(!data || size < 3)
+    {
+      return;
+    }
+
+    TableId = data[0];
+    SectionSyntaxIndicator = data[1] & 0x80;
+    SectionLength = ((uint16_t)(data[1] & 0xf)) << 8 | data[2];
+
+    uint32_t offset = 3;
+    uint32_t end = SectionLength + 3;
+    if(SectionSyntaxIndicator)
+    {
+      if(size < 8)
+      {
+        return;
+      }
+
+      ExtensionTableId = (data[3] << 8) | data[4];
+      VersionNumber = (data[5] >> 1) & 0x1f;
+      CurrentNextIndicator = data[5] & 1;
+      SectionNumber = data[6];
+      LastSectionNumber = data[7];
+      offset = 8;
+      // CRC_32 is not part of the payload
+      end -= 4;
+    }
+
+    if((offset <= end) && (end <= size))
+    {
+      Payload = data + offset;
+      PayloadSize = end - offset;
+    }
+  }
+
+  // False if the section is truncated
+  bool IsValid() const
+  {
+    return Payload != 0;
+  }
+
+  const uint8_t* Data;                  //!< whole section, header and CRC_32 included
+  uint32_t Size;
+  uint8_t TableId;
+  bool SectionSyntaxIndicator;
+  uint16_t SectionLength;
+  uint16_t ExtensionTableId;
+  uint8_t VersionNumber;
+  bool CurrentNextIndicator;
+  uint8_t SectionNumber;
+  uint8_t LastSectionNumber;
+  const uint8_t* Payload;               //!< data following the header, CRC_32 excluded
+  uint32_t PayloadSize;
+};
+
+#endif // TSECTIONVIEW_H
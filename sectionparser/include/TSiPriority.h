@@ -0,0 +1,72 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSIPRIORITY_H
+#define TSIPRIORITY_H
+
+// C system includes
+#include <stdint.h>
+
+// Project's includes
+#include "TSiTable.h"
+
+/**
+ * Delivery priority classes, highest first
+ */
+enum class TSiPriority : uint8_t
+{
+  SI_PRIORITY_TIME = 0,                 //!< TDT/TOT
+  SI_PRIORITY_EIT_PF,                   //!< EIT present/following actual
+  SI_PRIORITY_SI,                       //!< SDT, NIT, BAT and the other tables
+  SI_PRIORITY_EIT_SCHED,                //!< EIT schedule actual
+  SI_PRIORITY_EIT_OTHER,                //!< EIT present/following and schedule other
+  SI_PRIORITY_COUNT
+};
+
+/**
+ * Get the priority class of a table
+ *
+ * @param id table identifier
+ * @return priority class
+ */
+inline TSiPriority GetSiPriority(uint8_t id)
+{
+  TTableId tableId = static_cast<TTableId>(id);
+
+  if((tableId == TTableId::TABLE_ID_TDT) || (tableId == TTableId::TABLE_ID_TOT))
+  {
+    return TSiPriority::SI_PRIORITY_TIME;
+  }
+  else if(tableId == TTableId::TABLE_ID_EIT_PF)
+  {
+    return TSiPriority::SI_PRIORITY_EIT_PF;
+  }
+  else if((tableId >= TTableId::TABLE_ID_EIT_SCHED_START) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_END))
+  {
+    return TSiPriority::SI_PRIORITY_EIT_SCHED;
+  }
+  else if((tableId == TTableId::TABLE_ID_EIT_PF_OTHER) ||
+          ((tableId >= TTableId::TABLE_ID_EIT_SCHED_OTHER_START) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END)))
+  {
+    return TSiPriority::SI_PRIORITY_EIT_OTHER;
+  }
+
+  return TSiPriority::SI_PRIORITY_SI;
+}
+
+#endif // TSIPRIORITY_H
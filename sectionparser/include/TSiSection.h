@@ -31,6 +31,11 @@
  */
 struct TSiSection
 {
+    /**
+     * Empty section, e.g. a free slot of a section store
+     */
+    TSiSection();
+
     /**
      * @param data section data
      * @param len data length
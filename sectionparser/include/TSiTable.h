@@ -20,6 +20,7 @@
 #define TSITABLE_H
 
 #include <stdint.h>
+#include <bitset>
 
 //enum class TTableId : uint8_t
 enum TTableId {
@@ -67,13 +68,16 @@ private:
   uint16_t TableExtensionId;
   uint8_t VersionNumber;
   bool CurrentNextIndicator;
+  bool Partial;
+  std::bitset<256> MissingSections;
 
 public:
   TSiTable(uint8_t id, uint16_t extId, uint8_t ver, bool cur)
     : TableId(id),
       TableExtensionId(extId),
       VersionNumber(ver),
-      CurrentNextIndicator(cur)
+      CurrentNextIndicator(cur),
+      Partial(false)
    {
      // Empty
    }
@@ -88,6 +92,11 @@ public:
      return CurrentNextIndicator;
    }
 
+   inline void SetCurrentNextIndicator(bool cur)
+   {
+     CurrentNextIndicator = cur;
+   }
+
    inline uint16_t GetTableExtensionId() const
    {
      return TableExtensionId;
@@ -103,6 +112,27 @@ public:
      return VersionNumber;
    }
 
+   /**
+    * Partial tables are built from an incomplete sub-table, see TSectionParser::SetPartialPublication.
+    * The complete table follows once the missing sections arrive.
+    */
+   inline bool IsPartial() const
+   {
+     return Partial;
+   }
+
+   inline void SetPartial(const std::bitset<256>& missingSections)
+   {
+     Partial = true;
+     MissingSections = missingSections;
+   }
+
+   // Section numbers missing from a partial table
+   inline const std::bitset<256>& GetMissingSections() const
+   {
+     return MissingSections;
+   }
+
 };
 
 
@@ -0,0 +1,97 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSITABLEDIFF_H
+#define TSITABLEDIFF_H
+
+// C system includes
+#include <stdint.h>
+
+// C++ system includes
+#include <map>
+#include <vector>
+
+// Project's includes
+#include "TSiTable.h"
+#include "TMpegDescriptor.h"
+
+/**
+ * Section parser event types that are not table identifiers.
+ * Table events use the 8-bit table identifier as the event type.
+ */
+enum TSectionParserEvent {
+  TABLE_DELTA_EVENT = 0x100             //!< eventData points to a TSiTableDelta
+};
+
+/**
+ * Sub-table signature: entry identifier (service_id or event_id) mapped to
+ * a hash of the entry header fields and its descriptor loop.
+ */
+typedef std::map<uint16_t, uint32_t> TSiTableSignature;
+
+/**
+ * Difference between two versions of the same sub-table
+ */
+struct TSiTableDelta
+{
+  TSiTableDelta(uint8_t id, uint16_t extId, uint8_t prevVer, uint8_t ver)
+    : TableId(id),
+      TableExtensionId(extId),
+      PreviousVersionNumber(prevVer),
+      VersionNumber(ver)
+  {
+    // Empty
+  }
+
+  bool IsEmpty() const
+  {
+    return AddedEntries.empty() && RemovedEntries.empty() && ChangedEntries.empty();
+  }
+
+  uint8_t TableId;
+  uint16_t TableExtensionId;
+  uint8_t PreviousVersionNumber;
+  uint8_t VersionNumber;
+
+  /**
+   * Entry identifiers (service_id for SDT, event_id for EIT), sorted in ascending order
+   */
+  std::vector<uint16_t> AddedEntries;
+  std::vector<uint16_t> RemovedEntries;
+  std::vector<uint16_t> ChangedEntries;
+};
+
+/**
+ * Version-to-version comparison of SDT and EIT sub-tables
+ */
+class TSiTableDiff
+{
+private:
+  static uint32_t HashDescriptors(const std::vector<TMpegDescriptor>& descriptors, uint32_t hash);
+
+public:
+  static bool IsDiffSupported(uint8_t tableId);
+
+  static TSiTableSignature GetSignature(const TSiTable& tbl);
+
+  static void Compare(const TSiTableSignature& prev, const TSiTableSignature& next, TSiTableDelta& delta);
+
+  static TSiTableDelta Compare(const TSiTable& prev, const TSiTable& next);
+};
+
+#endif // TSITABLEDIFF_H
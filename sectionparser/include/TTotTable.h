@@ -78,9 +78,10 @@ public:
     return UtcTime;
   }
 
+  // UTC epoch, independent of the local time zone
   inline time_t GetUtcTime() const
   {
-    return MjdToDate(UtcTime);
+    return MjdToUtcEpoch(UtcTime);
   }
 
   inline void SetUtcTime(uint64_t utcTime)
@@ -24,6 +24,11 @@
 
 class IDvbSectionParserObserver {
 public:
+  /**
+   * Table event: eventType is the table identifier and eventData a TSiTable subclass allocated
+   * with new, owned by the observer from then on. TABLE_DELTA_EVENT: eventData points to a
+   * TSiTableDelta, only valid during the call.
+   */
   virtual void SendEvent(uint32_t eventType, void *eventData, size_t dataSize) = 0;
 };
 
@@ -0,0 +1,85 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef IDVBTABLEOBSERVER_H
+#define IDVBTABLEOBSERVER_H
+
+#include <stdint.h>
+#include <time.h>
+#include <memory>
+
+class TSiTable;
+class TNitTable;
+class TSdtTable;
+class TBatTable;
+class TEitTable;
+class TTotTable;
+class TUdtTable;
+struct TSiTableDelta;
+
+/**
+ * Typed table observer
+ *
+ * Every completed table is delivered as a shared immutable object. All the observers receive
+ * the same instance, so they can keep a reference instead of copying the table.
+ */
+class IDvbTableObserver {
+public:
+  virtual ~IDvbTableObserver() {}
+
+  virtual void OnNit(const std::shared_ptr<const TNitTable>&) {}
+  virtual void OnSdt(const std::shared_ptr<const TSdtTable>&) {}
+  virtual void OnBat(const std::shared_ptr<const TBatTable>&) {}
+  virtual void OnEit(const std::shared_ptr<const TEitTable>&) {}
+  virtual void OnTot(const std::shared_ptr<const TTotTable>&) {}     //!< TOT
+  virtual void OnUdt(const std::shared_ptr<const TUdtTable>&) {}
+
+  /**
+   * TDT. Decoded straight from the section, no table object is built.
+   *
+   * @param utcTime UTC time in seconds since the epoch
+   * @param utcTimeBcd UTC_time field (16-bit MJD and 6 BCD digits)
+   */
+  virtual void OnTdt(time_t /*utcTime*/, uint64_t /*utcTimeBcd*/) {}
+
+  /**
+   * Table built by a user defined parser, see IDvbTableParser. The type depends on the parser.
+   * Not sent to the legacy IDvbSectionParserObserver observers.
+   */
+  virtual void OnCustomTable(const std::shared_ptr<const TSiTable>&) {}
+
+  /**
+   * First section of a new NIT actual or SDT version, received before the sub-table is complete.
+   * Lets an observer holding that version from an earlier run confirm it without waiting for the
+   * whole sub-table. Not sent to the legacy IDvbSectionParserObserver observers.
+   *
+   * @param tableId table identifier
+   * @param extId network_id of the NIT, transport_stream_id of the SDT
+   * @param onId original_network_id of the SDT, 0 for the NIT
+   * @param version version number
+   */
+  virtual void OnVersionSeen(uint8_t /*tableId*/, uint16_t /*extId*/, uint16_t /*onId*/, uint8_t /*version*/) {}
+
+  /**
+   * Difference between a new SDT/EIT version and the previous one of its sub-table, delivered right
+   * after the new table when TSectionParser::SetTableDeltaEnabled is on. Shed together with its table.
+   */
+  virtual void OnDelta(const std::shared_ptr<const TSiTableDelta>&) {}
+};
+
+#endif // IDVBTABLEOBSERVER_H
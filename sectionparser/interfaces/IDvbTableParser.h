@@ -0,0 +1,49 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef IDVBTABLEPARSER_H
+#define IDVBTABLEPARSER_H
+
+#include <stdint.h>
+#include <memory>
+
+class TSiTable;
+struct TSectionView;
+
+/**
+ * Parser of a user defined table
+ *
+ * Registered with TSectionParser for a range of table identifiers. Receives every matching section
+ * as a view of the caller's buffer, assembles its sub-tables the way it sees fit and returns its own
+ * table type once one is complete. The calls are serialized by the section parser.
+ * The tables go to the typed observers only (IDvbTableObserver::OnCustomTable); the legacy
+ * IDvbSectionParserObserver observers no longer get the user defined table identifiers it handles.
+ */
+class IDvbTableParser {
+public:
+  virtual ~IDvbTableParser() {}
+
+  /**
+   * @param section section view, only valid during the call
+   * @param streamContext input the section was received from
+   * @return table to publish, NULL if nothing is complete
+   */
+  virtual std::shared_ptr<TSiTable> ParseSection(const TSectionView& section, uint32_t streamContext) = 0;
+};
+
+#endif // IDVBTABLEPARSER_H
@@ -25,6 +25,9 @@
 #include <string.h>
 #include <iconv.h>
 
+// C++ system includes
+#include <map>
+
 // Other libraries' includes
 
 // Project's includes
@@ -33,6 +36,52 @@
 
 using std::string;
 
+/**
+ * CRC_32 lookup table (polynomial 0x04c11db7, MSB first), built once and shared by all the parsers
+ */
+static const uint32_t* GetCrc32Table()
+{
+    static const struct TCrc32Table
+    {
+        TCrc32Table()
+        {
+            for(uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t crc = i << 24;
+                for(int bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 0x80000000) ? ((crc << 1) ^ 0x04c11db7) : (crc << 1);
+                }
+                Table[i] = crc;
+            }
+        }
+
+        uint32_t Table[256];
+    } crcTable;
+
+    return crcTable.Table;
+}
+
+/**
+ * Calculate the CRC_32 as defined in ISO/IEC 13818-1 Annex A
+ *
+ * @param data data
+ * @param len length
+ * @return CRC_32, 0 over a complete section (including its CRC_32 field) means no error
+ */
+uint32_t Crc32(const uint8_t* data, size_t len)
+{
+    const uint32_t* table = GetCrc32Table();
+    uint32_t crc = 0xffffffff;
+
+    for(size_t i = 0; i < len; i++)
+    {
+        crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xff];
+    }
+
+    return crc;
+}
+
 /**
  * Convert a binary coded decimal (byte) to decimal
  *
@@ -121,9 +170,8 @@ time_t MjdToDate (int64_t encodedTime)
     int32_t month = M + 2 - (12 * J);
     int32_t year = 100 * (C - 49) + Y + J;
 
-    // Converting to time_t
-    //struct tm time = {0};
-    struct tm time;
+    // Converting to time_t, tm_isdst = 0
+    struct tm time = tm();
     time.tm_mday = day;
     time.tm_mon = month - 1;
     time.tm_year = year - 1900;
@@ -134,6 +182,26 @@ time_t MjdToDate (int64_t encodedTime)
     return mktime(&time);
 }
 
+/**
+ * Convert a 40-bit MJD/BCD UTC time straight to seconds since the epoch
+ *
+ * @param encodedTime 16-bit MJD followed by 6 BCD digits
+ * @return seconds since 1970-01-01 00:00:00 UTC
+ */
+time_t MjdToUtcEpoch(int64_t encodedTime)
+{
+    // MJD 40587 is 1970-01-01
+    static const int64_t MJD_EPOCH = 40587;
+    int64_t mjd = (encodedTime >> 24) & 0xFFFF;
+    uint32_t hour = 0;
+    uint32_t min = 0;
+    uint32_t sec = 0;
+
+    BcdToTime(encodedTime, hour, min, sec);
+
+    return (time_t)((mjd - MJD_EPOCH) * 86400 + hour * 3600 + min * 60 + sec);
+}
+
 /**
  * Convert a Latin00 string to a UTF-8 string
  *
@@ -382,6 +450,57 @@ static string LatinToUtf(const unsigned char *in, size_t len)
     return res;
 }
 
+/**
+ * Conversion descriptors of the calling thread. Opening a descriptor is expensive, so they are
+ * kept for the lifetime of the thread and shared by all the parsers running on it.
+ */
+class TIconvCache
+{
+private:
+    std::map<string, iconv_t> DescriptorMap;
+
+public:
+    ~TIconvCache()
+    {
+        for(auto it = DescriptorMap.begin(), end = DescriptorMap.end(); it != end; ++it)
+        {
+            if(it->second != (iconv_t)(-1))
+            {
+                iconv_close(it->second);
+            }
+        }
+    }
+
+    iconv_t Get(const char* type)
+    {
+        auto it = DescriptorMap.find(type);
+        if(it == DescriptorMap.end())
+        {
+            it = DescriptorMap.insert(std::make_pair(string(type), iconv_open("UTF-8", type))).first;
+        }
+        else if(it->second != (iconv_t)(-1))
+        {
+            // Back to the initial shift state
+            iconv(it->second, NULL, NULL, NULL, NULL);
+        }
+
+        return it->second;
+    }
+};
+
+/**
+ * Get a conversion descriptor to UTF-8
+ *
+ * @param type source character set
+ * @return conversion descriptor (owned by the thread's cache), (iconv_t)(-1) if not supported
+ */
+static iconv_t GetIconvDescriptor(const char* type)
+{
+    static thread_local TIconvCache cache;
+
+    return cache.Get(type);
+}
+
 /**
  * Decode text information that is coded as described in ETSI EN 300 468 annex A
  *
@@ -534,7 +653,7 @@ string DecodeText(const unsigned char *str, size_t len)
     {
         OS_LOG(DVB_TRACE1,    "<%s> converting from UTF-8 to %s\n", __FUNCTION__, type);
 
-        iconv_t cd = iconv_open("UTF-8", type);
+        iconv_t cd = GetIconvDescriptor(type);
         if(cd == (iconv_t)(-1))
         {
             OS_LOG(DVB_WARN,    "<%s> conversion from UTF-8 to %s is not supported by iconv\n", __FUNCTION__, type);
@@ -560,7 +679,6 @@ string DecodeText(const unsigned char *str, size_t len)
             }
 
             delete [] buf;
-            iconv_close(cd);
         }
     }
 
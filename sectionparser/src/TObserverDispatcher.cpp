@@ -0,0 +1,463 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TObserverDispatcher.h"
+
+#include <algorithm>
+
+using std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+/**
+ * Constructor
+ *
+ * @param workerCount number of worker threads (at least one is started)
+ * @param queueCapacity maximum number of pending events per observer (at least one)
+ */
+TObserverDispatcher::TObserverDispatcher(size_t workerCount, size_t queueCapacity)
+  : QueueCapacity(queueCapacity ? queueCapacity : 1),
+    LatencyTargetUs(0),
+    HighPriorityLatencyUs(0),
+    IsStopping(false)
+{
+    if(workerCount == 0)
+    {
+        workerCount = 1;
+    }
+
+    for(size_t i = 0; i < workerCount; i++)
+    {
+        WorkerVector.push_back(std::thread(&TObserverDispatcher::WorkerThread, this));
+    }
+}
+
+/**
+ * Destructor. The pending events are delivered before the workers exit.
+ */
+TObserverDispatcher::~TObserverDispatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(DispatcherMutex);
+        IsStopping = true;
+    }
+    WorkCondition.notify_all();
+    SpaceCondition.notify_all();
+
+    for(auto it = WorkerVector.begin(), end = WorkerVector.end(); it != end; ++it)
+    {
+        it->join();
+    }
+}
+
+/**
+ * Check if an event must be dropped instead of queued
+ *
+ * @param priority priority class of the event
+ * @param depth number of events pending for the observer
+ * @return true if the event is shed
+ */
+bool TObserverDispatcher::IsShed(TSiPriority priority, size_t depth) const
+{
+    bool isOverloaded = (LatencyTargetUs > 0) && (HighPriorityLatencyUs > LatencyTargetUs);
+
+    if(priority == TSiPriority::SI_PRIORITY_EIT_OTHER)
+    {
+        return isOverloaded || (depth * 2 >= QueueCapacity);
+    }
+    else if(priority == TSiPriority::SI_PRIORITY_EIT_SCHED)
+    {
+        return isOverloaded || (depth * 4 >= QueueCapacity * 3);
+    }
+
+    return false;
+}
+
+/**
+ * Drop the oldest pending event of the lowest sheddable class
+ *
+ * @param observerQueue observer queue
+ * @param onShed receives the shed callback of the dropped event
+ * @return true if an event was dropped
+ */
+bool TObserverDispatcher::ShedQueuedTask(TObserverQueue& observerQueue, Task_t& onShed)
+{
+    for(size_t i = PRIORITY_COUNT; i-- > static_cast<size_t>(TSiPriority::SI_PRIORITY_EIT_SCHED);)
+    {
+        if(!observerQueue.Tasks[i].empty())
+        {
+            onShed.swap(observerQueue.Tasks[i].front().OnShed);
+            observerQueue.Tasks[i].pop_front();
+            observerQueue.Depth--;
+            observerQueue.Stats.ShedEvents++;
+            PriorityClasses[i].ShedEvents++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Get the most urgent pending class of the observer
+ *
+ * @param observerQueue observer queue
+ * @return class index, PRIORITY_COUNT if nothing is pending
+ */
+size_t TObserverDispatcher::GetUrgentClass(const TObserverQueue& observerQueue)
+{
+    size_t i = 0;
+
+    while((i < PRIORITY_COUNT) && observerQueue.Tasks[i].empty())
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/**
+ * Queue an event for the observer
+ *
+ * @param observer observer identifier, the events of the same observer and class are delivered in order
+ * @param task delivery function
+ * @param priority priority class of the event
+ * @param onShed called if the event, or a pending event to make room for it, is shed
+ * @return true if the event was queued, false if it was shed or the dispatcher is stopping
+ */
+bool TObserverDispatcher::Post(const void* observer, const Task_t& task, TSiPriority priority, const Task_t& onShed)
+{
+    std::unique_lock<std::mutex> lock(DispatcherMutex);
+
+    std::shared_ptr<TObserverQueue>& queue = QueueMap[observer];
+    if(!queue)
+    {
+        queue = std::make_shared<TObserverQueue>();
+    }
+
+    // Keep a reference, the observer might be removed while we are waiting for space
+    std::shared_ptr<TObserverQueue> observerQueue(queue);
+    size_t priorityIndex = static_cast<size_t>(priority);
+
+    if(IsShed(priority, observerQueue->Depth))
+    {
+        observerQueue->Stats.ShedEvents++;
+        PriorityClasses[priorityIndex].ShedEvents++;
+        lock.unlock();
+
+        if(onShed)
+        {
+            onShed();
+        }
+        return false;
+    }
+
+    // A full queue makes room by shedding a low priority event before blocking the producer
+    Task_t queuedShed;
+    if((observerQueue->Depth >= QueueCapacity) && !ShedQueuedTask(*observerQueue, queuedShed))
+    {
+        observerQueue->Stats.BlockedPosts++;
+        SpaceCondition.wait(lock, [&] {
+            return IsStopping || observerQueue->IsRemoved || (observerQueue->Depth < QueueCapacity);
+        });
+    }
+
+    if(IsStopping || observerQueue->IsRemoved)
+    {
+        lock.unlock();
+
+        if(queuedShed)
+        {
+            queuedShed();
+        }
+        return false;
+    }
+
+    TQueuedTask queuedTask;
+    queuedTask.Task = task;
+    queuedTask.OnShed = onShed;
+    queuedTask.Priority = priority;
+    queuedTask.PostTime = steady_clock::now();
+    observerQueue->Tasks[priorityIndex].push_back(queuedTask);
+    observerQueue->Depth++;
+
+    TObserverDispatcherStats& stats = observerQueue->Stats;
+    stats.QueueDepth = observerQueue->Depth;
+    if(stats.QueueDepth > stats.MaxQueueDepth)
+    {
+        stats.MaxQueueDepth = stats.QueueDepth;
+    }
+
+    if(!observerQueue->IsScheduled)
+    {
+        observerQueue->IsScheduled = true;
+        ReadyQueue.push_back(observerQueue);
+        WorkCondition.notify_one();
+    }
+    lock.unlock();
+
+    if(queuedShed)
+    {
+        queuedShed();
+    }
+
+    return true;
+}
+
+/**
+ * Drop the pending events of the observer and wait for the event being delivered, if any.
+ * Must not be called from the observer's own delivery function.
+ *
+ * @param observer observer identifier
+ */
+void TObserverDispatcher::RemoveObserver(const void* observer)
+{
+    std::unique_lock<std::mutex> lock(DispatcherMutex);
+
+    auto it = QueueMap.find(observer);
+    if(it == QueueMap.end())
+    {
+        return;
+    }
+
+    std::shared_ptr<TObserverQueue> observerQueue(it->second);
+    QueueMap.erase(it);
+
+    observerQueue->IsRemoved = true;
+    for(size_t i = 0; i < PRIORITY_COUNT; i++)
+    {
+        observerQueue->Tasks[i].clear();
+    }
+    observerQueue->Depth = 0;
+    SpaceCondition.notify_all();
+
+    IdleCondition.wait(lock, [&] { return !observerQueue->IsRunning; });
+}
+
+/**
+ * Wait until all the queued events have been delivered
+ */
+void TObserverDispatcher::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(DispatcherMutex);
+
+    IdleCondition.wait(lock, [&] {
+        for(auto it = QueueMap.begin(), end = QueueMap.end(); it != end; ++it)
+        {
+            if(it->second->IsScheduled)
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+/**
+ * Get the delivery statistics of the observer
+ *
+ * @param observer observer identifier
+ * @param stats statistics
+ * @return true if the observer is known, false otherwise
+ */
+bool TObserverDispatcher::GetStats(const void* observer, TObserverDispatcherStats& stats)
+{
+    std::lock_guard<std::mutex> lock(DispatcherMutex);
+
+    auto it = QueueMap.find(observer);
+    if(it == QueueMap.end())
+    {
+        return false;
+    }
+
+    stats = it->second->Stats;
+    return true;
+}
+
+/**
+ * Get the delivery statistics of all the observers
+ *
+ * @return statistics by observer identifier
+ */
+std::map<const void*, TObserverDispatcherStats> TObserverDispatcher::GetStats()
+{
+    std::map<const void*, TObserverDispatcherStats> ret;
+    std::lock_guard<std::mutex> lock(DispatcherMutex);
+
+    for(auto it = QueueMap.begin(), end = QueueMap.end(); it != end; ++it)
+    {
+        ret[it->first] = it->second->Stats;
+    }
+
+    return ret;
+}
+
+/**
+ * Set the latency above which the EIT classes are shed
+ *
+ * @param latencyUs post-to-completion latency target of the TDT/TOT, EIT p/f and SI classes, zero to disable
+ */
+void TObserverDispatcher::SetLatencyTarget(uint64_t latencyUs)
+{
+    std::lock_guard<std::mutex> lock(DispatcherMutex);
+    LatencyTargetUs = latencyUs;
+}
+
+uint64_t TObserverDispatcher::GetPercentile(const TPriorityClass& priorityClass, uint64_t percent)
+{
+    uint64_t rank = (priorityClass.DeliveredEvents * percent + 99) / 100;
+    uint64_t count = 0;
+
+    for(size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        count += priorityClass.LatencyHistogram[i];
+        if((count >= rank) && (count > 0))
+        {
+            uint64_t upperBound = (1ull << i) - 1;
+            return std::min(upperBound, priorityClass.MaxLatencyUs);
+        }
+    }
+
+    return priorityClass.MaxLatencyUs;
+}
+
+/**
+ * Get the delivery statistics of a priority class, over all the observers
+ *
+ * @param priority priority class
+ * @return statistics
+ */
+TSiPriorityStats TObserverDispatcher::GetPriorityStats(TSiPriority priority)
+{
+    TSiPriorityStats stats;
+    std::lock_guard<std::mutex> lock(DispatcherMutex);
+
+    if(priority >= TSiPriority::SI_PRIORITY_COUNT)
+    {
+        return stats;
+    }
+
+    const TPriorityClass& priorityClass = PriorityClasses[static_cast<size_t>(priority)];
+    stats.DeliveredEvents = priorityClass.DeliveredEvents;
+    stats.ShedEvents = priorityClass.ShedEvents;
+    stats.P50LatencyUs = GetPercentile(priorityClass, 50);
+    stats.P95LatencyUs = GetPercentile(priorityClass, 95);
+    stats.P99LatencyUs = GetPercentile(priorityClass, 99);
+    stats.MaxLatencyUs = priorityClass.MaxLatencyUs;
+
+    return stats;
+}
+
+void TObserverDispatcher::WorkerThread()
+{
+    std::unique_lock<std::mutex> lock(DispatcherMutex);
+
+    while(true)
+    {
+        WorkCondition.wait(lock, [&] { return IsStopping || !ReadyQueue.empty(); });
+        if(ReadyQueue.empty())
+        {
+            // Stopping and everything has been delivered
+            break;
+        }
+
+        // Serve the observer with the most urgent event
+        auto ready = ReadyQueue.begin();
+        size_t urgentClass = GetUrgentClass(**ready);
+        for(auto it = ReadyQueue.begin(), end = ReadyQueue.end(); (it != end) && (urgentClass > 0); ++it)
+        {
+            size_t cls = GetUrgentClass(**it);
+            if(cls < urgentClass)
+            {
+                urgentClass = cls;
+                ready = it;
+            }
+        }
+
+        std::shared_ptr<TObserverQueue> observerQueue(*ready);
+        ReadyQueue.erase(ready);
+
+        if(urgentClass == PRIORITY_COUNT)
+        {
+            // Removed while waiting in the ready queue
+            observerQueue->IsScheduled = false;
+            IdleCondition.notify_all();
+            continue;
+        }
+
+        // The queue stays scheduled while we own it, so no other worker can reorder its events
+        TQueuedTask queuedTask(observerQueue->Tasks[urgentClass].front());
+        observerQueue->Tasks[urgentClass].pop_front();
+        observerQueue->Depth--;
+        observerQueue->Stats.QueueDepth = observerQueue->Depth;
+        observerQueue->IsRunning = true;
+        SpaceCondition.notify_all();
+
+        lock.unlock();
+        queuedTask.Task();
+        uint64_t latency = duration_cast<microseconds>(steady_clock::now() - queuedTask.PostTime).count();
+        lock.lock();
+
+        observerQueue->IsRunning = false;
+
+        TObserverDispatcherStats& stats = observerQueue->Stats;
+        stats.DeliveredEvents++;
+        stats.TotalLatencyUs += latency;
+        if(latency > stats.MaxLatencyUs)
+        {
+            stats.MaxLatencyUs = latency;
+        }
+
+        TPriorityClass& priorityClass = PriorityClasses[urgentClass];
+        size_t bucket = 0;
+        while((bucket < LATENCY_BUCKETS - 1) && (latency >> bucket))
+        {
+            bucket++;
+        }
+        priorityClass.LatencyHistogram[bucket]++;
+        priorityClass.DeliveredEvents++;
+        if(latency > priorityClass.MaxLatencyUs)
+        {
+            priorityClass.MaxLatencyUs = latency;
+        }
+
+        // Moving average (1/8 weight) of the classes protected by the shedding
+        if(queuedTask.Priority < TSiPriority::SI_PRIORITY_EIT_SCHED)
+        {
+            HighPriorityLatencyUs = (HighPriorityLatencyUs * 7 + latency) / 8;
+        }
+
+        if(observerQueue->Depth > 0)
+        {
+            // One event per turn, so the other observers get their share of the workers
+            ReadyQueue.push_back(observerQueue);
+            WorkCondition.notify_one();
+        }
+        else
+        {
+            observerQueue->IsScheduled = false;
+        }
+
+        if(ReadyQueue.empty())
+        {
+            // The backlog is gone, the overload is over
+            HighPriorityLatencyUs = 0;
+        }
+        IdleCondition.notify_all();
+    }
+}
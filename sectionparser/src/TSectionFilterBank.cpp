@@ -0,0 +1,285 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TSectionFilterBank.h"
+
+#include <string.h>
+
+#include "oswrap.h"
+#include "TSiTable.h"
+
+// The filter bytes 1..15 map to the section bytes 3..17
+static inline uint32_t FilterToSectionOffset(uint8_t index)
+{
+    return index ? index + 2 : 0;
+}
+
+TSectionFilter::TSectionFilter()
+{
+    memset(Match, 0, sizeof(Match));
+    memset(Mask, 0, sizeof(Mask));
+}
+
+TSectionFilter::TSectionFilter(uint8_t tableId, uint8_t tableIdMask)
+{
+    memset(Match, 0, sizeof(Match));
+    memset(Mask, 0, sizeof(Mask));
+    SetByte(0, tableId, tableIdMask);
+}
+
+void TSectionFilter::SetTableIdExtension(uint16_t extId, uint16_t extIdMask)
+{
+    SetByte(1, (uint8_t)(extId >> 8), (uint8_t)(extIdMask >> 8));
+    SetByte(2, (uint8_t)extId, (uint8_t)extIdMask);
+}
+
+void TSectionFilter::SetByte(uint8_t index, uint8_t match, uint8_t mask)
+{
+    if(index < FILTER_DEPTH)
+    {
+        Match[index] = match & mask;
+        Mask[index] = mask;
+    }
+}
+
+TSectionFilterBank::TSectionFilterBank()
+  : NextFilterId(1),
+    CompiledBank(std::make_shared<TCompiledBank>())
+{
+    // Empty
+}
+
+/**
+ * Rebuild the candidate lists. Called with the filter mutex held.
+ */
+void TSectionFilterBank::Compile()
+{
+    std::shared_ptr<TCompiledBank> bank(std::make_shared<TCompiledBank>());
+
+    for(auto it = FilterMap.begin(), end = FilterMap.end(); it != end; ++it)
+    {
+        const TSectionFilter& filter = it->second.Filter;
+
+        TCompiledFilter compiled;
+        compiled.Id = it->first;
+        compiled.HitCount = it->second.HitCount;
+        compiled.Depth = 1;
+        for(uint8_t i = 0; i < TSectionFilter::FILTER_DEPTH; i++)
+        {
+            compiled.Match[i] = filter.Match[i];
+            compiled.Mask[i] = filter.Mask[i];
+            if(filter.Mask[i])
+            {
+                compiled.Depth = i + 1;
+            }
+        }
+
+        for(uint32_t tableId = 0; tableId < 256; tableId++)
+        {
+            if((tableId & filter.Mask[0]) == filter.Match[0])
+            {
+                bank->Candidates[tableId].push_back(compiled);
+            }
+        }
+    }
+
+    std::atomic_store(&CompiledBank, std::shared_ptr<const TCompiledBank>(bank));
+}
+
+/**
+ * Add a filter
+ *
+ * @param filter filter
+ * @return filter identifier
+ */
+uint32_t TSectionFilterBank::AddFilter(const TSectionFilter& filter)
+{
+    std::lock_guard<std::mutex> lock(FilterMutex);
+
+    uint32_t filterId = NextFilterId++;
+    TFilterEntry& entry = FilterMap[filterId];
+    entry.Filter = filter;
+    entry.HitCount = std::make_shared<std::atomic<uint64_t>>(0);
+
+    OS_LOG(DVB_DEBUG,  "<%s> Filter %d: table id 0x%x/0x%x\n", __FUNCTION__, filterId, filter.Match[0], filter.Mask[0]);
+
+    Compile();
+    return filterId;
+}
+
+/**
+ * Add the filters accepting a range of table identifiers
+ *
+ * @param first first table identifier
+ * @param last last table identifier
+ * @return identifiers of the filters covering the range
+ */
+std::vector<uint32_t> TSectionFilterBank::AddTableIdRange(uint8_t first, uint8_t last)
+{
+    std::vector<uint32_t> ret;
+    uint32_t tableId = first;
+
+    // Split the range into aligned blocks, each of them is a single match/mask filter
+    while(tableId <= last)
+    {
+        uint32_t blockSize = 1;
+        while(((tableId & (blockSize * 2 - 1)) == 0) && (tableId + blockSize * 2 - 1 <= last) && (blockSize < 256))
+        {
+            blockSize *= 2;
+        }
+
+        ret.push_back(AddFilter(TSectionFilter((uint8_t)tableId, (uint8_t)~(blockSize - 1))));
+        tableId += blockSize;
+    }
+
+    return ret;
+}
+
+/**
+ * Remove a filter
+ *
+ * @param filterId filter identifier
+ * @return true if the filter was removed, false if it doesn't exist
+ */
+bool TSectionFilterBank::RemoveFilter(uint32_t filterId)
+{
+    std::lock_guard<std::mutex> lock(FilterMutex);
+
+    if(FilterMap.erase(filterId) == 0)
+    {
+        return false;
+    }
+
+    Compile();
+    return true;
+}
+
+/**
+ * Remove all the filters. No section is accepted until a filter is added.
+ */
+void TSectionFilterBank::Clear()
+{
+    std::lock_guard<std::mutex> lock(FilterMutex);
+
+    FilterMap.clear();
+    Compile();
+}
+
+/**
+ * Add the filters for the supported tables: NIT, SDT, BAT, EIT, TDT, TOT and user defined tables
+ *
+ * The filters of a range can be removed on their own, e.g. the EIT schedule ones.
+ *
+ * @return filter identifiers by the first table identifier of each range: TABLE_ID_NIT (actual and
+ *         other), TABLE_ID_SDT, TABLE_ID_SDT_OTHER, TABLE_ID_BAT, TABLE_ID_EIT_PF (actual and other),
+ *         TABLE_ID_EIT_SCHED_START, TABLE_ID_EIT_SCHED_OTHER_START, TABLE_ID_TDT, TABLE_ID_TOT and
+ *         TABLE_ID_USER_DEFINED_START
+ */
+TSectionFilterBank::TDefaultFilterIds TSectionFilterBank::AddDefaultFilters()
+{
+    TDefaultFilterIds ret;
+
+    ret[TTableId::TABLE_ID_NIT] = AddTableIdRange(TTableId::TABLE_ID_NIT, TTableId::TABLE_ID_NIT_OTHER);
+    ret[TTableId::TABLE_ID_SDT] = AddTableIdRange(TTableId::TABLE_ID_SDT, TTableId::TABLE_ID_SDT);
+    ret[TTableId::TABLE_ID_SDT_OTHER] = AddTableIdRange(TTableId::TABLE_ID_SDT_OTHER, TTableId::TABLE_ID_SDT_OTHER);
+    ret[TTableId::TABLE_ID_BAT] = AddTableIdRange(TTableId::TABLE_ID_BAT, TTableId::TABLE_ID_BAT);
+    ret[TTableId::TABLE_ID_EIT_PF] = AddTableIdRange(TTableId::TABLE_ID_EIT_PF, TTableId::TABLE_ID_EIT_PF_OTHER);
+    ret[TTableId::TABLE_ID_EIT_SCHED_START] =
+        AddTableIdRange(TTableId::TABLE_ID_EIT_SCHED_START, TTableId::TABLE_ID_EIT_SCHED_END);
+    ret[TTableId::TABLE_ID_EIT_SCHED_OTHER_START] =
+        AddTableIdRange(TTableId::TABLE_ID_EIT_SCHED_OTHER_START, TTableId::TABLE_ID_EIT_SCHED_OTHER_END);
+    ret[TTableId::TABLE_ID_TDT] = AddTableIdRange(TTableId::TABLE_ID_TDT, TTableId::TABLE_ID_TDT);
+    ret[TTableId::TABLE_ID_TOT] = AddTableIdRange(TTableId::TABLE_ID_TOT, TTableId::TABLE_ID_TOT);
+    ret[TTableId::TABLE_ID_USER_DEFINED_START] =
+        AddTableIdRange(TTableId::TABLE_ID_USER_DEFINED_START, TTableId::TABLE_ID_USER_DEFINED_END);
+
+    return ret;
+}
+
+/**
+ * Match the section header against the filters
+ *
+ * @param data section data
+ * @param size data size
+ * @return true if any filter accepts the section, false otherwise
+ */
+bool TSectionFilterBank::IsMatch(const uint8_t* data, uint32_t size) const
+{
+    if(!data || size == 0)
+    {
+        return false;
+    }
+
+    std::shared_ptr<const TCompiledBank> bank(std::atomic_load(&CompiledBank));
+    const std::vector<TCompiledFilter>& candidates = bank->Candidates[data[0]];
+
+    for(auto it = candidates.begin(), end = candidates.end(); it != end; ++it)
+    {
+        if(FilterToSectionOffset(it->Depth - 1) >= size)
+        {
+            // Section too short for this filter
+            continue;
+        }
+
+        uint8_t i = 1;
+        while((i < it->Depth) && ((data[FilterToSectionOffset(i)] & it->Mask[i]) == it->Match[i]))
+        {
+            i++;
+        }
+
+        if(i == it->Depth)
+        {
+            (*it->HitCount)++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Get the number of sections accepted by a filter
+ *
+ * @param filterId filter identifier
+ * @return hit count, 0 if the filter doesn't exist
+ */
+uint64_t TSectionFilterBank::GetHitCount(uint32_t filterId)
+{
+    std::lock_guard<std::mutex> lock(FilterMutex);
+
+    auto it = FilterMap.find(filterId);
+    return (it == FilterMap.end()) ? 0 : it->second.HitCount->load();
+}
+
+/**
+ * Get the hit counts of all the filters
+ *
+ * @return hit count by filter identifier
+ */
+std::map<uint32_t, uint64_t> TSectionFilterBank::GetHitCounts()
+{
+    std::map<uint32_t, uint64_t> ret;
+    std::lock_guard<std::mutex> lock(FilterMutex);
+
+    for(auto it = FilterMap.begin(), end = FilterMap.end(); it != end; ++it)
+    {
+        ret[it->first] = it->second.HitCount->load();
+    }
+
+    return ret;
+}
@@ -0,0 +1,198 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TSectionIngest.h"
+
+#include <algorithm>
+
+#include "oswrap.h"
+#include "TSiTable.h"
+
+/**
+ * Constructor
+ *
+ * @param parser parser fed by the consumer thread
+ * @param capacity number of slots, rounded up to a power of two
+ * @param headroom free slots kept for the sections other than EIT schedule
+ */
+TSectionIngest::TSectionIngest(TSectionParser& parser, size_t capacity, size_t headroom)
+  : Parser(parser),
+    Capacity(1),
+    Headroom(headroom),
+    Head(0),
+    Tail(0),
+    PushedSections(0),
+    ParsedSections(0),
+    OverflowDrops(0),
+    HeadroomDrops(0),
+    InvalidDrops(0),
+    MaxFill(0),
+    IsConsumerWaiting(false),
+    IsStopping(false)
+{
+    while(Capacity < capacity)
+    {
+        Capacity <<= 1;
+    }
+
+    if(Headroom >= Capacity)
+    {
+        Headroom = Capacity - 1;
+    }
+
+    SlotVector.resize(Capacity);
+    SlotData.resize(Capacity * MAX_SECTION_SIZE);
+
+    Consumer = std::thread(&TSectionIngest::ConsumerThread, this);
+}
+
+/**
+ * Destructor. The sections still in the ring are parsed before the consumer exits.
+ */
+TSectionIngest::~TSectionIngest()
+{
+    {
+        std::lock_guard<std::mutex> lock(WakeMutex);
+        IsStopping = true;
+    }
+    WakeCondition.notify_one();
+
+    Consumer.join();
+}
+
+/**
+ * Check if a section can be dropped to keep room for the other tables
+ *
+ * @param data section data
+ * @return true for EIT schedule sections
+ */
+bool TSectionIngest::IsSheddable(const uint8_t* data)
+{
+    TTableId tableId = static_cast<TTableId>(data[0]);
+
+    return (tableId >= TTableId::TABLE_ID_EIT_SCHED_START) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END);
+}
+
+/**
+ * Copy a section into the ring. Never blocks.
+ *
+ * @param data section data
+ * @param size data size
+ * @param streamContext input the section was received from, see TSectionParser::ParseSiData
+ * @return true if the section was queued, false if it was dropped
+ */
+bool TSectionIngest::Push(const uint8_t* data, uint32_t size, uint32_t streamContext)
+{
+    if(!data || (size == 0) || (size > MAX_SECTION_SIZE))
+    {
+        InvalidDrops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t head = Head.load(std::memory_order_relaxed);
+    size_t fill = head - Tail.load(std::memory_order_acquire);
+
+    if(fill >= Capacity)
+    {
+        OverflowDrops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if((Capacity - fill <= Headroom) && IsSheddable(data))
+    {
+        HeadroomDrops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t index = head & (Capacity - 1);
+    SlotVector[index].Size = size;
+    SlotVector[index].StreamContext = streamContext;
+    std::copy(data, data + size, &SlotData[index * MAX_SECTION_SIZE]);
+
+    // Sequentially consistent with the check of IsConsumerWaiting below, see ConsumerThread()
+    Head.store(head + 1, std::memory_order_seq_cst);
+
+    PushedSections.fetch_add(1, std::memory_order_relaxed);
+    if(fill + 1 > MaxFill.load(std::memory_order_relaxed))
+    {
+        MaxFill.store(fill + 1, std::memory_order_relaxed);
+    }
+
+    if(IsConsumerWaiting.load(std::memory_order_seq_cst))
+    {
+        // Taking the mutex makes sure the consumer is either before its last check or already waiting
+        {
+            std::lock_guard<std::mutex> lock(WakeMutex);
+        }
+        WakeCondition.notify_one();
+    }
+
+    return true;
+}
+
+void TSectionIngest::ConsumerThread()
+{
+    while(true)
+    {
+        size_t tail = Tail.load(std::memory_order_relaxed);
+        size_t head = Head.load(std::memory_order_acquire);
+
+        if(tail == head)
+        {
+            if(IsStopping)
+            {
+                break;
+            }
+
+            // Either the producer sees the flag and wakes the consumer up, or the consumer sees the new head
+            std::unique_lock<std::mutex> lock(WakeMutex);
+            IsConsumerWaiting.store(true, std::memory_order_seq_cst);
+            WakeCondition.wait(lock, [&] { return (Head.load(std::memory_order_seq_cst) != tail) || IsStopping; });
+            IsConsumerWaiting.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        for(; tail != head; tail++)
+        {
+            size_t index = tail & (Capacity - 1);
+            Parser.ParseSiData(&SlotData[index * MAX_SECTION_SIZE], SlotVector[index].Size, SlotVector[index].StreamContext);
+
+            // Release the slot right away, the producer may be waiting for room
+            Tail.store(tail + 1, std::memory_order_release);
+            ParsedSections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    OS_LOG(DVB_DEBUG,  "<%s> Consumer stopped, %llu sections parsed\n", __FUNCTION__,
+            (unsigned long long)ParsedSections.load());
+}
+
+TSectionIngestStats TSectionIngest::GetStats() const
+{
+    TSectionIngestStats stats;
+
+    stats.PushedSections = PushedSections.load(std::memory_order_relaxed);
+    stats.ParsedSections = ParsedSections.load(std::memory_order_relaxed);
+    stats.OverflowDrops = OverflowDrops.load(std::memory_order_relaxed);
+    stats.HeadroomDrops = HeadroomDrops.load(std::memory_order_relaxed);
+    stats.InvalidDrops = InvalidDrops.load(std::memory_order_relaxed);
+    stats.Fill = Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire);
+    stats.MaxFill = MaxFill.load(std::memory_order_relaxed);
+
+    return stats;
+}
@@ -31,13 +31,17 @@
 #include "TTotTable.h"
 #include "TUdtTable.h"
 
-using std::list;
 using std::string;
 
 
 TSectionList::TSectionList()
     : IsComplete(false),
-      FirstReceivedSectionNumber(0)
+      FirstReceivedSectionNumber(0),
+      PayloadSize(0),
+      CycleCount(0),
+      IsPartialPublished(false),
+      IsCompacted(false),
+      IsRevision(false)
 {
   // Empty
 }
@@ -49,15 +53,26 @@ TSectionList::~TSectionList()
 
 void TSectionList::InitializeSectionList(TSiSection& section)
 {
-    // Let's InitializeSectionList the list
-    SiSectionList.clear();
-    SiSectionList.push_front(section);
+    // Let's InitializeSectionList the list. EIT p/f goes to the fixed slots.
+    SiSectionList.Reset(IsEitPf(section.TableId));
+    SiSectionList.Insert(section);
+    PayloadSize = section.Payload.size();
+    IsRevision = false;
+    AssemblyStartTime = std::chrono::steady_clock::now();
+    CycleCount = 0;
+    IsPartialPublished = false;
+
+    if(IsCompacted)
+    {
+        IsCompacted = false;
+        Signature = TSectionListSignature();
+    }
 
     // Let's set the new section number
     FirstReceivedSectionNumber = section.SectionNumber;
 
-    // We need to handle EIT sections differently
-    if(!IsEit(section.TableId))
+    // We need to handle EIT schedule sections differently
+    if(!IsEit(section.TableId) || IsEitPf(section.TableId))
     {
         IsComplete = IsSectionListComplete(section);
     }
@@ -70,6 +85,11 @@ void TSectionList::InitializeSectionList(TSiSection& section)
 
 bool TSectionList::AddSiSection(TSiSection& section)
 {
+    if(IsCompacted)
+    {
+        return AddSiSectionToSignature(section);
+    }
+
     // empty?
     if(!SiSectionList.empty())
     {
@@ -117,6 +137,12 @@ bool TSectionList::AddSiSection(TSiSection& section)
         return true;
     }
 
+    if(section.SectionNumber == FirstReceivedSectionNumber)
+    {
+        // The carousel went round once more without completing the list
+        CycleCount++;
+    }
+
     // Everything checks out. Time to insert the section into the list.
     InsertSectionIntoList(section);
 
@@ -126,29 +152,132 @@ bool TSectionList::AddSiSection(TSiSection& section)
     return true;
 }
 
-void TSectionList::InsertSectionIntoList(TSiSection& section)
+/**
+ * Check a section against the signature of the compacted table
+ *
+ * @param section received section
+ * @return true if the section starts a new assembly, false if it is a repetition
+ */
+bool TSectionList::AddSiSectionToSignature(TSiSection& section)
 {
-    auto it = SiSectionList.begin();
-    auto end = SiSectionList.end();
+    if(Signature.ExtensionTableId != section.ExtensionTableId)
+    {
+        OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: ext_id mismatch\n", __FUNCTION__, section.TableId, section.ExtensionTableId);
+        return false;
+    }
+
+    if((Signature.VersionNumber != section.VersionNumber) ||
+       (Signature.LastSectionNumber != section.LastSectionNumber))
+    {
+        OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: VersionNumber or last section number mismatch\n",
+         __FUNCTION__, section.TableId, section.ExtensionTableId);
+        InitializeSectionList(section);
+        return true;
+    }
 
-    // Let's keep the section numbers sorted in the list
-    while(it != end)
+    if(!Signature.SectionCrc.empty() && Signature.SectionBitmap.test(section.SectionNumber))
     {
-        if(it->SectionNumber == section.SectionNumber)
+        // The CRCs are stored in section number order: the index is the number of sections below this one
+        size_t index = (Signature.SectionBitmap << (256 - section.SectionNumber)).count();
+
+        if(Signature.SectionCrc[index] != GetSectionCrc(section))
         {
-            // Do nothing
-            return;
+            OS_LOG(DVB_WARN,  "<%s> 0x%x.0x%x: section %d changed without a version update\n",
+             __FUNCTION__, section.TableId, section.ExtensionTableId, section.SectionNumber);
+            InitializeSectionList(section);
+            IsRevision = true;
+            return true;
         }
-        else if(it->SectionNumber > section.SectionNumber)
+    }
+
+    OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: ignoring (same version, table already complete)\n",
+     __FUNCTION__, section.TableId, section.ExtensionTableId);
+    return false;
+}
+
+/**
+ * Get the CRC_32 of a section with the syntax indicator set
+ *
+ * @param section section
+ * @return CRC_32 field (the last 4 bytes of the payload), 0 if the payload is too short
+ */
+uint32_t TSectionList::GetSectionCrc(const TSiSection& section)
+{
+    size_t size = section.Payload.size();
+    if(size < 4)
+    {
+        return 0;
+    }
+
+    return ((uint32_t)section.Payload[size - 4] << 24) | ((uint32_t)section.Payload[size - 3] << 16) |
+           ((uint32_t)section.Payload[size - 2] << 8) | section.Payload[size - 1];
+}
+
+/**
+ * Release the sections of a complete table. The repetitions are still detected from the
+ * version number, the last section number, the received section numbers and optionally
+ * the CRC_32 of every section. The fixed EIT p/f slots keep their buffers for the next version.
+ *
+ * @param keepCrc true to keep the CRC_32 of every section, so a changed section is detected
+ *        even if the broadcaster does not update the version number
+ */
+void TSectionList::Compact(bool keepCrc)
+{
+    if(IsCompacted || !IsComplete || SiSectionList.empty() || !SiSectionList.front().SectionSyntaxIndicator)
+    {
+        // The tables without syntax (TDT, TOT) are single section tables, rebuilt every time anyway
+        return;
+    }
+
+    const TSiSection& front = SiSectionList.front();
+    Signature.TableId = front.TableId;
+    Signature.ExtensionTableId = front.ExtensionTableId;
+    Signature.VersionNumber = front.VersionNumber;
+    Signature.LastSectionNumber = front.LastSectionNumber;
+    Signature.SectionBitmap.reset();
+    Signature.SectionCrc.clear();
+
+    if(keepCrc)
+    {
+        Signature.SectionCrc.reserve(SiSectionList.size());
+    }
+
+    for(auto it = SiSectionList.begin(), end = SiSectionList.end(); it != end; ++it)
+    {
+        Signature.SectionBitmap.set(it->SectionNumber);
+        if(keepCrc)
         {
-            SiSectionList.insert(it, section);
-            return;
+            Signature.SectionCrc.push_back(GetSectionCrc(*it));
         }
+    }
 
-        ++it;
+    SiSectionList.clear();
+    PayloadSize = 0;
+    IsCompacted = true;
+}
+
+void TSectionList::InsertSectionIntoList(TSiSection& section)
+{
+    // The store keeps the section numbers sorted and ignores the repetitions
+    if(SiSectionList.Insert(section))
+    {
+        PayloadSize += section.Payload.size();
     }
+}
 
-    SiSectionList.push_back(section);
+void TSectionList::Swap(TSectionList& other)
+{
+    std::swap(IsComplete, other.IsComplete);
+    std::swap(FirstReceivedSectionNumber, other.FirstReceivedSectionNumber);
+    SiSectionList.swap(other.SiSectionList);
+    std::swap(PayloadSize, other.PayloadSize);
+    std::swap(LastAccessTime, other.LastAccessTime);
+    std::swap(AssemblyStartTime, other.AssemblyStartTime);
+    std::swap(CycleCount, other.CycleCount);
+    std::swap(IsPartialPublished, other.IsPartialPublished);
+    std::swap(IsCompacted, other.IsCompacted);
+    std::swap(IsRevision, other.IsRevision);
+    std::swap(Signature, other.Signature);
 }
 
 TNitTable* TSectionList::BuildNit()
@@ -345,6 +474,7 @@ TEitTable* TSectionList::BuildEit()
 
             // Let's now make a DvbEvent object using the extracted data
             TEitEvent event(eventId, startTime, duration, runningStatus, isScrambled);
+            event.SetSectionNumber(it->SectionNumber);
 
             p += 12;
             event.AddDescriptors(TMpegDescriptor::ParseMpegDescriptors(p, descLength));
@@ -448,6 +578,64 @@ TSiTable* TSectionList::BuildTable()
     return tbl;
 }
 
+/**
+ * Get the section numbers of the current version that have not been received yet.
+ * For the EIT schedule, a segment without any received section is reported as a whole,
+ * since its segment_last_section_number is unknown.
+ *
+ * @return missing section numbers
+ */
+std::bitset<256> TSectionList::GetMissingSections() const
+{
+    std::bitset<256> missing;
+
+    if(IsCompacted || SiSectionList.empty())
+    {
+        return missing;
+    }
+
+    const TSiSection& first = SiSectionList.front();
+    uint32_t lastSectionNumber = first.LastSectionNumber;
+    std::bitset<256> received;
+
+    for(auto it = SiSectionList.begin(), end = SiSectionList.end(); it != end; ++it)
+    {
+        received.set(it->SectionNumber);
+    }
+
+    TTableId tableId = static_cast<TTableId>(first.TableId);
+    if((tableId < TTableId::TABLE_ID_EIT_SCHED_START) || (tableId > TTableId::TABLE_ID_EIT_SCHED_OTHER_END))
+    {
+        for(uint32_t i = 0; i <= lastSectionNumber; i++)
+        {
+            missing[i] = !received[i];
+        }
+        return missing;
+    }
+
+    // EIT schedule: 8 sections per segment, each segment ends at its segment_last_section_number
+    for(uint32_t segment = 0; segment <= lastSectionNumber; segment += 8)
+    {
+        uint32_t segmentLast = std::min(segment + 7, lastSectionNumber);
+
+        for(auto it = SiSectionList.begin(), end = SiSectionList.end(); it != end; ++it)
+        {
+            if(((it->SectionNumber & ~7) == segment) && (it->Payload.size() > 4))
+            {
+                segmentLast = std::min((uint32_t)it->Payload[4], segmentLast);
+                break;
+            }
+        }
+
+        for(uint32_t i = segment; i <= segmentLast; i++)
+        {
+            missing[i] = !received[i];
+        }
+    }
+
+    return missing;
+}
+
 bool TSectionList::IsEit(uint8_t id)
 {
     TTableId tableId = static_cast<TTableId>(id);
@@ -460,11 +648,23 @@ bool TSectionList::IsEit(uint8_t id)
     return false;
 }
 
+bool TSectionList::IsEitPf(uint8_t id)
+{
+    TTableId tableId = static_cast<TTableId>(id);
+
+    return (tableId == TTableId::TABLE_ID_EIT_PF) || (tableId == TTableId::TABLE_ID_EIT_PF_OTHER);
+}
+
 string TSectionList::ToString() const
 {
     std::stringstream ss;
 
-    if(!SiSectionList.empty())
+    if(IsCompacted)
+    {
+        ss << "TableId = " << (int) Signature.TableId << ", TableExtId = "
+           << (int) Signature.ExtensionTableId << ", compacted, " << Signature.SectionBitmap.count() << " sections";
+    }
+    else if(!SiSectionList.empty())
     {
         ss << "TableId = " << (int) SiSectionList.front().TableId << ", TableExtId = "
            << (int) SiSectionList.front().ExtensionTableId << ", ";
@@ -497,8 +697,9 @@ bool TSectionList::IsSectionListComplete(TSiSection& lastRcvdSect)
 
     bool complete = false;
 
-    // We need to handle EIT tables differently
-    if(IsEit(SiSectionList.front().TableId))
+    // We need to handle EIT schedule tables differently. EIT p/f has no segments and at most two
+    // sections, so it is complete as soon as both are in place, like any other table.
+    if(IsEit(SiSectionList.front().TableId) && !IsEitPf(SiSectionList.front().TableId))
     {
         // Check only if we received the same section second time (full cycle passed)
         // to make sure we got all the sections.
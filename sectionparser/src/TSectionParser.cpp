@@ -29,6 +29,8 @@
 #include <utility>
 
 #include "oswrap.h"
+#include "DvbUtils.h"
+#include "TSectionView.h"
 
 //#define DVB_SECTION_OUTPUT
 #define DVB_TABLE_DEBUG
@@ -57,57 +59,74 @@
 #else
 #include "TSiTable.h"
 #include "TSiSection.h"
+#include "TNitTable.h"
+#include "TSdtTable.h"
+#include "TEitTable.h"
+#include "TTotTable.h"
+#include "TBatTable.h"
+#include "TUdtTable.h"
 #endif
 
 using std::map;
 using std::pair;
 
+// Heap usage of a published table entry, on top of the table itself
+static const size_t PUBLISHED_ENTRY_SIZE = sizeof(PublishedTableMap_t::value_type) + 4 * sizeof(void*);
+
+// A next version no longer announced for this long is dropped
+static const std::chrono::seconds NEXT_VERSION_TIMEOUT(60);
+
+// An older version from another input is rejected while the published version is younger than this
+static const std::chrono::seconds STALE_VERSION_WINDOW(30);
+
 TSectionParser::TSectionParser()
+  : MemoryBudget(0),
+    PartialAssemblyTimeout(0),
+    SectionMemoryUsage(0),
+    LastSweepTime(std::chrono::steady_clock::now()),
+    IsCompactionEnabled(true),
+    IsSectionCrcKept(true),
+    PartialPublicationAge(0),
+    PartialPublicationCycles(0),
+    PublishedMemoryUsage(0),
+    IsTableDeltaEnabled(false)
 {
-  // Empty
+  std::fill(TableParsers, TableParsers + 256, static_cast<IDvbTableParser*>(NULL));
+
+  // NIT, SDT, BAT, EIT, TDT, TOT, UDT
+  DefaultFilterIds = FilterBank.AddDefaultFilters();
 }
 
 TSectionParser::~TSectionParser()
 {
-  ObserverVector.clear();
+  // Deliver the pending events while the adapters are still there
+  Dispatcher.reset();
+  ObserverVector.reset();
+  TableObserverVector.reset();
 }
 
 /**
- * Check if tables of certain type are supported or not.
- * Note that some optional DVB tables might not be supported.
+ * Parse SI Section
  *
- * @param tableId table identifier
- * @return true if supported, false otherwise
+ * @param data section data
+ * @param size data size
  */
-bool TSectionParser::IsTableSupported(uint8_t id)
+void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
 {
-    TTableId tableId = static_cast<TTableId>(id);
-
-    // NIT, SDT, BAT, EIT, TDT, TOT, UDT
-    if( ((tableId >= TTableId::TABLE_ID_NIT) && (tableId <= TTableId::TABLE_ID_SDT)) ||  
-         (tableId == TTableId::TABLE_ID_SDT_OTHER) || (tableId == TTableId::TABLE_ID_BAT)  ||
-        ((tableId >= TTableId::TABLE_ID_EIT_PF) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END)) ||
-         (tableId == TTableId::TABLE_ID_TDT) || (tableId == TTableId::TABLE_ID_TOT) ||
-        ((tableId >= TTableId::TABLE_ID_USER_DEFINED_START) && (tableId <= TTableId::TABLE_ID_USER_DEFINED_END)) )
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    ParseSiData(data, size, 0);
 }
 
 /**
- * Parse SI Section
+ * Parse SI Section received from a certain input. Can be called from several threads at once.
  *
  * @param data section data
  * @param size data size
+ * @param streamContext input (tuner or TS handle) the section was received from
  */
-void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
+void TSectionParser::ParseSiData(uint8_t *data, uint32_t size, uint32_t streamContext)
 {
     OS_LOG(DVB_TRACE3, 
-            "<%s> data: %p, size: 0x%x\n", __FUNCTION__, data, size);
+            "<%s> data: %p, size: 0x%x, context: %u\n", __FUNCTION__, data, size, streamContext);
 
     // Sanity check
     if(!data || size == 0)
@@ -116,25 +135,336 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
         return;
     }
 
-    // Check if we support this table or not
-    if(!IsTableSupported(data[0]))
+    // Check if anybody wants this sub-table before assembling it
+    if(!FilterBank.IsMatch(data, size))
+    {
+        OS_LOG(DVB_TRACE1,  "<%s> Table id 0x%x is filtered out\n", __FUNCTION__, data[0]);
+        return;
+    }
+
+    std::chrono::steady_clock::time_point arrivalTime = std::chrono::steady_clock::now();
+
+#ifndef DVB_SECTION_OUTPUT
+    if((data[0] >= TTableId::TABLE_ID_USER_DEFINED_START) && (data[0] <= TTableId::TABLE_ID_USER_DEFINED_END) &&
+       HandleCustomSection(data, size, streamContext))
+    {
+        return;
+    }
+
+    // TDT has no sub-table state at all, it is decoded right here
+    if(static_cast<TTableId>(data[0]) == TTableId::TABLE_ID_TDT)
+    {
+        HandleTdt(data, size);
+        UpdateFastPathStats(TTableId::TABLE_ID_TDT, arrivalTime);
+        return;
+    }
+#endif // DVB_SECTION_OUTPUT
+
+    TTableDeliveryList deliveries;
+    bool isVersionStart = false;
+    {
+        std::lock_guard<std::mutex> lock(SectionStateMutex);
+        AssembleSection(data, size, streamContext, deliveries, isVersionStart);
+        QueueDeliveries(deliveries);
+    }
+
+    // The observers are called outside of the lock, so the other inputs are not held up
+    if(isVersionStart)
+    {
+        NotifyVersionSeen(data, size);
+    }
+    DeliverTables(deliveries);
+
+    for(auto it = deliveries.begin(), end = deliveries.end(); it != end; ++it)
+    {
+        if(it->Table->GetTableId() == TTableId::TABLE_ID_EIT_PF)
+        {
+            UpdateFastPathStats(TTableId::TABLE_ID_EIT_PF, arrivalTime);
+        }
+    }
+}
+
+/**
+ * Decode a TDT section and deliver the time to the typed observers, without building a section
+ * or a table object. The adapters of the legacy observers still allocate a TTotTable for them.
+ *
+ * @param data section data
+ * @param size data size
+ */
+void TSectionParser::HandleTdt(const uint8_t *data, uint32_t size)
+{
+    // table_id, section_length and the 40-bit UTC_time
+    if(size < 8)
+    {
+        OS_LOG(DVB_ERROR,  "<%s> TDT section too short: %u\n", __FUNCTION__, size);
+        return;
+    }
+
+    uint64_t utcTimeBcd = ((uint64_t)data[3] << 32) | ((uint64_t)data[4] << 24) | ((uint64_t)data[5] << 16) |
+                          ((uint64_t)data[6] << 8) | (uint64_t)data[7];
+    time_t utcTime = MjdToUtcEpoch(utcTimeBcd);
+
+    OS_LOG(DVB_TRACE1,  "<%s> TDT: %ld\n", __FUNCTION__, (long)utcTime);
+
+    std::shared_ptr<const TableObserverVector_t> observers(GetTableObservers());
+    std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+    for(auto it = observers->begin(), end = observers->end(); it != end; ++it)
+    {
+        IDvbTableObserver* observer = it->Observer;
+
+        if(!dispatcher)
+        {
+            observer->OnTdt(utcTime, utcTimeBcd);
+            continue;
+        }
+
+        std::shared_ptr<TSectionParserObserverAdapter> adapter(it->Adapter);
+        dispatcher->Post(it->DispatcherKey, [observer, adapter, utcTime, utcTimeBcd]() {
+            observer->OnTdt(utcTime, utcTimeBcd);
+        }, TSiPriority::SI_PRIORITY_TIME);
+    }
+}
+
+/**
+ * Hand a user defined section to its registered parser and publish the table it returns
+ *
+ * @param data section data
+ * @param size data size
+ * @param streamContext input the section was received from
+ * @return false if no parser is registered for the table identifier
+ */
+bool TSectionParser::HandleCustomSection(const uint8_t *data, uint32_t size, uint32_t streamContext)
+{
+    std::shared_ptr<TSiTable> tbl;
+    {
+        std::lock_guard<std::mutex> lock(TableParserMutex);
+
+        IDvbTableParser* parser = TableParsers[data[0]];
+        if(!parser)
+        {
+            return false;
+        }
+
+        TSectionView view(data, size);
+        if(!view.IsValid())
+        {
+            OS_LOG(DVB_ERROR,  "<%s> Table id 0x%x: truncated section, size = %u\n", __FUNCTION__, data[0], size);
+            return true;
+        }
+
+        tbl = parser->ParseSection(view, streamContext);
+    }
+
+    if(tbl)
+    {
+        OS_LOG(DVB_DEBUG,  "<%s> Custom table 0x%x.0x%x, version %d\n", __FUNCTION__,
+                tbl->GetTableId(), tbl->GetTableExtensionId(), tbl->GetVersionNumber());
+
+        {
+            std::lock_guard<std::mutex> lock(SectionStateMutex);
+            PublishTable(TSectionKey(tbl->GetTableId(), tbl->GetTableExtensionId()), tbl, 0, size);
+        }
+        NotifyCustomTable(tbl);
+    }
+
+    return true;
+}
+
+/**
+ * Deliver a table built by a user defined parser to the typed observers. The legacy observers are
+ * skipped, they would take the table for a TUdtTable.
+ *
+ * @param tbl table
+ */
+void TSectionParser::NotifyCustomTable(const std::shared_ptr<const TSiTable>& tbl)
+{
+    std::shared_ptr<const TableObserverVector_t> observers(GetTableObservers());
+    std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+    for(auto it = observers->begin(), end = observers->end(); it != end; ++it)
+    {
+        IDvbTableObserver* observer = it->Observer;
+
+        if(it->Adapter)
+        {
+            continue;
+        }
+
+        if(!dispatcher)
+        {
+            observer->OnCustomTable(tbl);
+            continue;
+        }
+
+        dispatcher->Post(it->DispatcherKey, [observer, tbl]() { observer->OnCustomTable(tbl); },
+                GetSiPriority(static_cast<uint8_t>(tbl->GetTableId())));
+    }
+}
+
+/**
+ * Tell the typed observers that the first section of a new NIT/SDT version has arrived
+ *
+ * @param data section data
+ * @param size data size
+ */
+void TSectionParser::NotifyVersionSeen(const uint8_t *data, uint32_t size)
+{
+    TSectionView view(data, size);
+    if(!view.IsValid())
     {
-        OS_LOG(DVB_WARN,  "<%s> Table id 0x%x is not supported\n", __FUNCTION__, data[0]);
         return;
     }
 
-    TSiSection* section = new TSiSection(data, size);
+    uint8_t tableId = view.TableId;
+    uint16_t extId = view.ExtensionTableId;
+    uint8_t version = view.VersionNumber;
+    // The SDT starts with its original_network_id
+    uint16_t onId = ((tableId != TTableId::TABLE_ID_NIT) && (view.PayloadSize >= 2)) ?
+                    (((uint16_t)view.Payload[0] << 8) | view.Payload[1]) : 0;
+
+    std::shared_ptr<const TableObserverVector_t> observers(GetTableObservers());
+    std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+    for(auto it = observers->begin(), end = observers->end(); it != end; ++it)
+    {
+        IDvbTableObserver* observer = it->Observer;
+
+        if(it->Adapter)
+        {
+            continue;
+        }
+
+        if(!dispatcher)
+        {
+            observer->OnVersionSeen(tableId, extId, onId, version);
+            continue;
+        }
+
+        dispatcher->Post(it->DispatcherKey, [observer, tableId, extId, onId, version]() {
+            observer->OnVersionSeen(tableId, extId, onId, version);
+        }, TSiPriority::SI_PRIORITY_SI);
+    }
+}
+
+/**
+ * Register a parser for a range of user defined tables. Replaces the parser previously registered
+ * for these table identifiers, if any. The filter bank must let the sections through (the default
+ * filters do).
+ *
+ * @param firstTableId first table identifier, 0x80 or above
+ * @param lastTableId last table identifier, 0xfe or below
+ * @param parser user defined parser
+ * @return false if the range is not a user defined range
+ */
+bool TSectionParser::RegisterTableParser(uint8_t firstTableId, uint8_t lastTableId, IDvbTableParser* parser)
+{
+    if(!parser || (firstTableId > lastTableId) ||
+       (firstTableId < TTableId::TABLE_ID_USER_DEFINED_START) || (lastTableId > TTableId::TABLE_ID_USER_DEFINED_END))
+    {
+        OS_LOG(DVB_ERROR,  "<%s> Invalid range 0x%x-0x%x\n", __FUNCTION__, firstTableId, lastTableId);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(TableParserMutex);
+    std::fill(TableParsers + firstTableId, TableParsers + lastTableId + 1, parser);
+
+    return true;
+}
+
+/**
+ * Remove a user defined parser. Waits for the call in progress, if any.
+ *
+ * @param parser user defined parser
+ */
+void TSectionParser::RemoveTableParser(IDvbTableParser* parser)
+{
+    std::lock_guard<std::mutex> lock(TableParserMutex);
+    std::replace(TableParsers, TableParsers + 256, parser, static_cast<IDvbTableParser*>(NULL));
+}
+
+void TSectionParser::UpdateFastPathStats(TTableId tableId, std::chrono::steady_clock::time_point arrivalTime)
+{
+    uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - arrivalTime).count();
+
+    std::lock_guard<std::mutex> lock(FastPathStatsMutex);
+    if(tableId == TTableId::TABLE_ID_TDT)
+    {
+        FastPathStats.TdtSections++;
+        FastPathStats.TotalTdtLatencyUs += latency;
+        FastPathStats.MaxTdtLatencyUs = std::max(FastPathStats.MaxTdtLatencyUs, latency);
+    }
+    else
+    {
+        FastPathStats.EitPfTables++;
+        FastPathStats.TotalEitPfLatencyUs += latency;
+        FastPathStats.MaxEitPfLatencyUs = std::max(FastPathStats.MaxEitPfLatencyUs, latency);
+    }
+}
+
+TFastPathStats TSectionParser::GetFastPathStats()
+{
+    std::lock_guard<std::mutex> lock(FastPathStatsMutex);
+    return FastPathStats;
+}
+
+/**
+ * Add the section to its sub-table and build the table once the sub-table is complete.
+ * Called with the section state mutex held.
+ *
+ * @param data section data
+ * @param size data size
+ * @param streamContext input the section was received from
+ * @param deliveries the completed tables are appended to this list
+ * @param isVersionStart set if the section starts the assembly of a new NIT actual or SDT version
+ */
+void TSectionParser::AssembleSection(uint8_t *data, uint32_t size, uint32_t streamContext, TTableDeliveryList& deliveries,
+                                     bool& isVersionStart)
+{
+    // The section object copies the payload, whether or not the section list keeps it
+    TSiSection section(data, size);
 
     OS_LOG(DVB_DEBUG,  "<%s> Handling id = 0x%x, SectionSyntaxIndicator = %d, extId = 0x%x, ver = %d %d/%d\n", __FUNCTION__,
-      section->TableId, section->SectionSyntaxIndicator, section->ExtensionTableId,
-      section->VersionNumber, section->SectionNumber, section->LastSectionNumber);
+      section.TableId, section.SectionSyntaxIndicator, section.ExtensionTableId,
+      section.VersionNumber, section.SectionNumber, section.LastSectionNumber);
+
+    TSectionKey key(section, streamContext);
+
+#ifndef DVB_SECTION_OUTPUT
+    if(section.SectionSyntaxIndicator && !section.CurrentNextIndicator)
+    {
+        // The section is not applicable yet. Let's assemble it aside from the current version.
+        AddNextSection(section, key);
+        return;
+    }
+
+    if(ActivateNextTable(section, key, deliveries))
+    {
+        // The pre-built "next" version became the current one
+        return;
+    }
+
+    if(section.SectionSyntaxIndicator)
+    {
+        DropStaleNextVersion(section, key);
+    }
+#endif // DVB_SECTION_OUTPUT
 
     // Find the list in the section map
-    pair<uint8_t, uint16_t> key(section->TableId, section->ExtensionTableId);
     TSectionList& secList = m_sectionMap[key];
+    size_t prevMemoryUsage = secList.GetMemoryUsage();
+    bool isNewVersion = (secList.GetSectionCount() == 0) || (secList.GetVersionNumber() != section.VersionNumber);
+    secList.SetLastAccessTime(std::chrono::steady_clock::now());
 
     // Adding the section to the list
-    if(secList.AddSiSection(*section))
+    bool isAdded = secList.AddSiSection(section);
+    UpdateMemoryUsage(prevMemoryUsage, secList.GetMemoryUsage());
+
+    // A repetition of the first section does not start the version again
+    TTableId tableId = static_cast<TTableId>(section.TableId);
+    isVersionStart = isAdded && isNewVersion && section.SectionSyntaxIndicator && !secList.GetCompletenessFlag() &&
+                     ((tableId == TTableId::TABLE_ID_NIT) || (tableId == TTableId::TABLE_ID_SDT) ||
+                      (tableId == TTableId::TABLE_ID_SDT_OTHER));
+
+    if(isAdded)
     {
         OS_LOG(DVB_TRACE3,  "<%s> Add() returned true\n", __FUNCTION__);
 #ifdef DVB_SECTION_OUTPUT
@@ -143,7 +473,7 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
         std::copy(data, data + size, p);
 
         // Let's publish the event right away
-        NotifyDvbSectionParserObserver((uint32_t)section->TableId, p, size);
+        NotifyDvbSectionParserObserver((uint32_t)section.TableId, p, size);
 #else
         // Let's check if the table became complete
         if(secList.GetCompletenessFlag())
@@ -151,16 +481,23 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
             OS_LOG(DVB_DEBUG,  "<%s> table is complete\n", __FUNCTION__);
             OS_LOG(DVB_DEBUG,  "<%s> SectionList: %s\n", __FUNCTION__, secList.ToString().c_str());
 
-            // Time to build the table
-            TSiTable* tbl = secList.BuildTable();
+            // Time to build the table, unless the state was evicted and this version is already out
+            std::shared_ptr<TSiTable> tbl;
+            if(!section.SectionSyntaxIndicator || secList.IsRevisedVersion() ||
+               !IsPublishedVersion(key, section.VersionNumber, section.LastSectionNumber))
+            {
+                tbl.reset(secList.BuildTable());
+            }
+
             if(tbl)
             {
+
 // This block parses certain tables and logs the results. Used for debugging purposes only.
 #ifdef DVB_TABLE_DEBUG
                 if(tbl->GetTableId() == TTableId::TABLE_ID_NIT)
                 {
                     OS_LOG(DVB_DEBUG,  "<%s> NIT table received, id: 0x%x, extId: 0x%x\n", __FUNCTION__, tbl->GetTableId(), tbl->GetTableExtensionId());
-                    TNitTable* nit = static_cast<TNitTable*>(tbl);
+                    TNitTable* nit = static_cast<TNitTable*>(tbl.get());
                     const std::vector<TMpegDescriptor>& descriptors = nit->GetNetworkDescriptors();
                     const TMpegDescriptor* desc = TMpegDescriptor::FindMpegDescriptor(descriptors, TDescriptorTag::NETWORK_NAME_TAG);
                     if(desc)
@@ -209,7 +546,7 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
                 else if(tbl->GetTableId() == TTableId::TABLE_ID_SDT || tbl->GetTableId() == TTableId::TABLE_ID_SDT_OTHER)
                 {
                     OS_LOG(DVB_DEBUG,  "<%s> SDT table received, id: 0x%x, extId: 0x%x\n", __FUNCTION__, tbl->GetTableId(), tbl->GetTableExtensionId());
-                    TSdtTable* sdt = static_cast<TSdtTable*>(tbl);
+                    TSdtTable* sdt = static_cast<TSdtTable*>(tbl.get());
 
                     const std::vector<TSdtService>& serviceList = sdt->GetServices();
 
@@ -246,7 +583,7 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
                 else if((tbl->GetTableId() >= TTableId::TABLE_ID_EIT_PF) && (tbl->GetTableId() <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END))
                 {
                     OS_LOG(DVB_DEBUG,  "<%s> EIT table received, id: 0x%x, extId: 0x%x\n", __FUNCTION__, tbl->GetTableId(), tbl->GetTableExtensionId());
-                    TEitTable* eit = static_cast<TEitTable*>(tbl);
+                    TEitTable* eit = static_cast<TEitTable*>(tbl.get());
 
                     const std::vector<TEitEvent>& eventList = eit->GetEvents();
                     for(auto it = eventList.begin(), end = eventList.end(); it != end; ++it)
@@ -328,7 +665,7 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
                 }
                 else if((tbl->GetTableId() == TTableId::TABLE_ID_TDT) || (tbl->GetTableId() == TTableId::TABLE_ID_TOT))
                 {
-                    TTotTable* tot = static_cast<TTotTable*>(tbl);
+                    TTotTable* tot = static_cast<TTotTable*>(tbl.get());
                     OS_LOG(DVB_DEBUG,  "<%s> TDT/TOT table received, id: 0x%x, UTC: %" PRId64"\n", __FUNCTION__, tot->GetTableId(), tot->GetUtcTimeBcd());
                     if(tot->GetTableId() == TTableId::TABLE_ID_TOT)
                     {
@@ -352,7 +689,7 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
                 }
                 else if(tbl->GetTableId() == TTableId::TABLE_ID_BAT)
                 {
-                    TBatTable* bat = static_cast<TBatTable*>(tbl);
+                    TBatTable* bat = static_cast<TBatTable*>(tbl.get());
                     OS_LOG(DVB_DEBUG,  "<%s> BAT table received, id: 0x%x, bouquet_id: 0x%x\n", __FUNCTION__, bat->GetTableId(), bat->GetBouquetId());
 
                     const std::vector<TMpegDescriptor>& bouquetDesc = bat->GetBouquetDescriptors();
@@ -399,19 +736,31 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
                 }
                 else if((tbl->GetTableId() >= TTableId::TABLE_ID_USER_DEFINED_START) && (tbl->GetTableId() <= TTableId::TABLE_ID_USER_DEFINED_END))
                 {
-                    TUdtTable* udt = static_cast<TUdtTable*>(tbl);
+                    TUdtTable* udt = static_cast<TUdtTable*>(tbl.get());
                     const std::vector<TSiSection>& list = udt->GetSectionList();
                     OS_LOG(DVB_DEBUG,  "<%s> UDT table received, id: 0x%x, num of sections: %lu\n", __FUNCTION__, udt->GetTableId(), list.size());
                 }
 #endif // DVB_TABLE_DEBUG
 
-                // Let's publish the event
-                NotifyDvbSectionParserObserver((uint32_t)tbl->GetTableId(), tbl, 0);
+                CompleteTable(key, tbl, section.LastSectionNumber, secList.GetMemoryUsage(), deliveries);
+            }
+
+            if(IsCompactionEnabled)
+            {
+                // Only the signature is needed to detect the repetitions from now on
+                size_t usage = secList.GetMemoryUsage();
+                secList.Compact(IsSectionCrcKept);
+                UpdateMemoryUsage(usage, secList.GetMemoryUsage());
             }
         }
         else // isComplete()
         {
             OS_LOG(DVB_DEBUG,  "<%s> table is not complete yet\n", __FUNCTION__);
+
+            if(section.SectionSyntaxIndicator && IsPartialPublicationDue(secList))
+            {
+                PublishPartialTable(key, secList, deliveries);
+            }
         }
 #endif // DVB_SECTION_OUTPUT
     }
@@ -420,24 +769,1031 @@ void TSectionParser::ParseSiData(uint8_t *data, uint32_t size)
         OS_LOG(DVB_DEBUG,  "<%s> Add() returned false\n", __FUNCTION__);
     }
 
-    // clean up
-    delete section;
+    if(MemoryBudget || PartialAssemblyTimeout.count() || !NextSectionMap.empty())
+    {
+        MaintainSectionState();
+    }
 }
 
-void TSectionParser::RegisterDvbSectionParserObserver(IDvbSectionParserObserver* observerObject)
+/**
+ * Add a section with current_next_indicator = 0 to the "next" slot of its sub-table.
+ * The table is built as soon as the slot is complete, but it is not published before activation.
+ *
+ * @param section section that is not applicable yet
+ * @param key sub-table key
+ */
+void TSectionParser::AddNextSection(TSiSection& section, const TSectionKey& key)
 {
-  ObserverVector.push_back(observerObject);
+    TSectionList& nextList = NextSectionMap[key];
+    size_t prevMemoryUsage = nextList.GetMemoryUsage();
+    nextList.SetLastAccessTime(std::chrono::steady_clock::now());
+
+    bool isAdded = nextList.AddSiSection(section);
+    UpdateMemoryUsage(prevMemoryUsage, nextList.GetMemoryUsage());
+
+    if(!isAdded)
+    {
+        return;
+    }
+
+    if(!nextList.GetCompletenessFlag())
+    {
+        // Still assembling (possibly a different next version), drop any stale pre-built table
+        NextTableMap.erase(key);
+        return;
+    }
+
+    std::shared_ptr<TSiTable> tbl(nextList.BuildTable());
+    if(tbl)
+    {
+        OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: next version %d is ready\n", __FUNCTION__,
+                key.TableId, key.ExtensionTableId, tbl->GetVersionNumber());
+        TNextTable& next = NextTableMap[key];
+        next.Table = tbl;
+        next.TableSize = nextList.GetMemoryUsage();
+    }
+
+    if(IsCompactionEnabled)
+    {
+        size_t usage = nextList.GetMemoryUsage();
+        nextList.Compact(IsSectionCrcKept);
+        UpdateMemoryUsage(usage, nextList.GetMemoryUsage());
+    }
 }
 
-void TSectionParser::RemoveDvbSectionParserObserver(IDvbSectionParserObserver* observerObject)
+/**
+ * Promote the pre-built "next" table once the broadcaster switches to its version
+ *
+ * @param section section with current_next_indicator = 1
+ * @param key sub-table key
+ * @param deliveries the activated table is appended to this list
+ * @return true if the next table was activated and the section has been consumed, false otherwise
+ */
+bool TSectionParser::ActivateNextTable(TSiSection& section, const TSectionKey& key, TTableDeliveryList& deliveries)
+{
+    auto tblIt = NextTableMap.find(key);
+    if(tblIt == NextTableMap.end())
+    {
+        return false;
+    }
+
+    auto listIt = NextSectionMap.find(key);
+    if((listIt == NextSectionMap.end()) ||
+       (listIt->second.GetVersionNumber() != section.VersionNumber) ||
+       (listIt->second.GetLastSectionNumber() != section.LastSectionNumber))
+    {
+        // The current version is still running
+        return false;
+    }
+
+    OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: activating version %d\n", __FUNCTION__,
+            key.TableId, key.ExtensionTableId, section.VersionNumber);
+
+    std::shared_ptr<TSiTable> tbl;
+    tbl.swap(tblIt->second.Table);
+    size_t tableSize = tblIt->second.TableSize;
+    NextTableMap.erase(tblIt);
+
+    // The complete "next" section list becomes the current one, so the repetitions are ignored from now on.
+    // Its section CRCs cover current_next_indicator = 0, so the current sections would look revised.
+    TSectionList& secList = m_sectionMap[key];
+    secList.Swap(listIt->second);
+    size_t usage = secList.GetMemoryUsage();
+    secList.DropSectionCrc();
+    UpdateMemoryUsage(listIt->second.GetMemoryUsage() + usage, secList.GetMemoryUsage());
+    NextSectionMap.erase(listIt);
+
+    tbl->SetCurrentNextIndicator(true);
+    CompleteTable(key, tbl, section.LastSectionNumber, tableSize, deliveries);
+
+    return true;
+}
+
+/**
+ * Drop the "next" version of a sub-table that will not be activated: the broadcaster has switched
+ * to another current version, or to this one before it was complete (the current assembly takes over).
+ *
+ * @param section section with current_next_indicator = 1
+ * @param key sub-table key
+ */
+void TSectionParser::DropStaleNextVersion(const TSiSection& section, const TSectionKey& key)
+{
+    auto listIt = NextSectionMap.find(key);
+    if(listIt == NextSectionMap.end())
+    {
+        return;
+    }
+
+    auto curIt = m_sectionMap.find(key);
+    bool isStale = (curIt != m_sectionMap.end()) ? (curIt->second.GetVersionNumber() != section.VersionNumber) :
+                                                   (listIt->second.GetVersionNumber() == section.VersionNumber);
+    if(!isStale)
+    {
+        return;
+    }
+
+    OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: dropping next version %d, current version is %d\n", __FUNCTION__,
+            key.TableId, key.ExtensionTableId, listIt->second.GetVersionNumber(), section.VersionNumber);
+    EvictSectionList(NextSectionMap, listIt);
+}
+
+/**
+ * Check if a version of the sub-table has already been published
+ *
+ * @param key sub-table key
+ * @param version version number
+ * @param lastSectionNumber last section number of the version
+ * @return true if the published table is complete, has been delivered and has the same version and section set,
+ *         false otherwise
+ */
+bool TSectionParser::IsPublishedVersion(const TSectionKey& key, uint8_t version, uint8_t lastSectionNumber)
+{
+    std::lock_guard<std::mutex> lock(PublishedTableMutex);
+
+    auto it = PublishedTableMap.find(key.GetContentKey());
+    return (it != PublishedTableMap.end()) && !it->second.IsPartial && !it->second.IsShed &&
+           (it->second.VersionNumber == version) && (it->second.LastSectionNumber == lastSectionNumber);
+}
+
+/**
+ * Check if a version acquired from one input is older than the version published from another one,
+ * e.g. when that input lags behind. The version numbers are compared modulo 32.
+ *
+ * @param key sub-table key
+ * @param version version number
+ * @return true if the version must not replace the published one, false otherwise
+ */
+bool TSectionParser::IsStaleVersion(const TSectionKey& key, uint8_t version)
 {
-  ObserverVector.erase(std::remove(ObserverVector.begin(), ObserverVector.end(), observerObject), ObserverVector.end());
+    std::lock_guard<std::mutex> lock(PublishedTableMutex);
+
+    auto it = PublishedTableMap.find(key.GetContentKey());
+    if((it == PublishedTableMap.end()) || (it->second.StreamContext == key.StreamContext))
+    {
+        // The versions acquired from one input follow each other
+        return false;
+    }
+
+    // Up to 15 versions ahead is newer, 16 to 31 is older
+    uint8_t distance = (version - it->second.VersionNumber) & 0x1F;
+    if(distance < 16)
+    {
+        return false;
+    }
+
+    // An old publication no longer vouches for its version (e.g. the broadcaster restarted the numbering)
+    return std::chrono::steady_clock::now() - it->second.PublishTime < STALE_VERSION_WINDOW;
+}
+
+/**
+ * Check if an incomplete sub-table has waited long enough for a partial table
+ *
+ * @param secList incomplete section list
+ * @return true if the partial table should be published now
+ */
+bool TSectionParser::IsPartialPublicationDue(const TSectionList& secList) const
+{
+    if(secList.GetPartialPublishedFlag() || secList.IsCompactedList())
+    {
+        return false;
+    }
+
+    if(PartialPublicationCycles && (secList.GetCycleCount() >= PartialPublicationCycles))
+    {
+        return true;
+    }
+
+    return PartialPublicationAge.count() &&
+           (std::chrono::steady_clock::now() - secList.GetAssemblyStartTime() >= PartialPublicationAge);
+}
+
+/**
+ * Build a table from the sections received so far and publish it, flagged as partial.
+ * Published once per version; the complete table replaces it when the list completes.
+ * Called with the section state mutex held.
+ *
+ * @param key sub-table key
+ * @param secList incomplete section list
+ * @param deliveries the partial table is appended to this list
+ */
+void TSectionParser::PublishPartialTable(const TSectionKey& key, TSectionList& secList, TTableDeliveryList& deliveries)
+{
+    secList.SetPartialPublishedFlag(true);
+
+    if(IsStaleVersion(key, secList.GetVersionNumber()))
+    {
+        return;
+    }
+
+    std::shared_ptr<TSiTable> tbl(secList.BuildTable());
+    if(!tbl)
+    {
+        return;
+    }
+
+    std::bitset<256> missing(secList.GetMissingSections());
+    tbl->SetPartial(missing);
+
+    OS_LOG(DVB_INFO,  "<%s> 0x%x.0x%x: publishing version %d with %lu missing sections after %u cycles\n", __FUNCTION__,
+            key.TableId, key.ExtensionTableId, tbl->GetVersionNumber(), missing.count(), secList.GetCycleCount());
+
+    // The delta signatures are only updated by complete versions
+    PublishTable(key, tbl, secList.GetLastSectionNumber(), secList.GetMemoryUsage());
+
+    TTableDelivery delivery;
+    delivery.Key = key;
+    delivery.Table = tbl;
+    deliveries.push_back(delivery);
+}
+
+/**
+ * Enable the publication of partial tables for the sub-tables that don't complete
+ *
+ * @param maxAge seconds since the start of the assembly, 0 to disable
+ * @param maxCycles carousel cycles (repetitions of the first received section), 0 to disable
+ */
+void TSectionParser::SetPartialPublication(uint32_t maxAge, uint32_t maxCycles)
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+    PartialPublicationAge = std::chrono::seconds(maxAge);
+    PartialPublicationCycles = maxCycles;
+}
+
+void TSectionParser::UpdateMemoryUsage(size_t prevUsage, size_t usage)
+{
+    SectionMemoryUsage = SectionMemoryUsage + usage - prevUsage;
+}
+
+/**
+ * Drop the state of a sub-table
+ *
+ * @param sectionMap section map holding the sub-table
+ * @param it sub-table to drop
+ */
+void TSectionParser::EvictSectionList(SectionMap_t& sectionMap, SectionMap_t::iterator it)
+{
+    if(&sectionMap == &NextSectionMap)
+    {
+        NextTableMap.erase(it->first);
+    }
+
+    UpdateMemoryUsage(it->second.GetMemoryUsage(), 0);
+    sectionMap.erase(it);
+}
+
+/**
+ * Age out stale partial assemblies and next versions, and enforce the memory budget.
+ * The assemblies are checked once per second. When the budget is exceeded, the least
+ * recently used sub-tables and published tables are dropped until the usage falls below 3/4 of
+ * the budget. A dropped complete sub-table is simply assembled again on its next repetition.
+ * A dropped published table is published again when its sub-table is assembled again.
+ */
+void TSectionParser::MaintainSectionState()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    bool isOverBudget = MemoryBudget && (SectionMemoryUsage + PublishedMemoryUsage > MemoryBudget);
+
+    if(!isOverBudget && (now - LastSweepTime < std::chrono::seconds(1)))
+    {
+        return;
+    }
+    LastSweepTime = now;
+
+    SectionMap_t* sectionMaps[] = { &m_sectionMap, &NextSectionMap };
+
+    if(PartialAssemblyTimeout.count())
+    {
+        for(size_t i = 0; i < sizeof(sectionMaps) / sizeof(sectionMaps[0]); i++)
+        {
+            for(auto it = sectionMaps[i]->begin(); it != sectionMaps[i]->end();)
+            {
+                auto cur = it++;
+                if(!cur->second.GetCompletenessFlag() && (now - cur->second.GetLastAccessTime() > PartialAssemblyTimeout))
+                {
+                    OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: partial assembly aged out\n", __FUNCTION__,
+                            cur->first.TableId, cur->first.ExtensionTableId);
+                    EvictSectionList(*sectionMaps[i], cur);
+                }
+            }
+        }
+    }
+
+    // Next versions the broadcaster stopped announcing without ever activating them
+    for(auto it = NextSectionMap.begin(); it != NextSectionMap.end();)
+    {
+        auto cur = it++;
+        if(now - cur->second.GetLastAccessTime() > NEXT_VERSION_TIMEOUT)
+        {
+            OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: next version %d aged out\n", __FUNCTION__,
+                    cur->first.TableId, cur->first.ExtensionTableId, cur->second.GetVersionNumber());
+            EvictSectionList(NextSectionMap, cur);
+        }
+    }
+
+    if(!MemoryBudget || (SectionMemoryUsage + PublishedMemoryUsage <= MemoryBudget))
+    {
+        return;
+    }
+
+    // Index 0 and 1 are the section maps, 2 the published tables
+    const size_t publishedIndex = sizeof(sectionMaps) / sizeof(sectionMaps[0]);
+    typedef std::pair<std::chrono::steady_clock::time_point, std::pair<size_t, TSectionKey>> LruEntry_t;
+    std::vector<LruEntry_t> lru;
+    for(size_t i = 0; i < publishedIndex; i++)
+    {
+        for(auto it = sectionMaps[i]->begin(), end = sectionMaps[i]->end(); it != end; ++it)
+        {
+            lru.push_back(LruEntry_t(it->second.GetLastAccessTime(), std::make_pair(i, it->first)));
+        }
+    }
+
+    std::vector<std::shared_ptr<const TSiTable>> releasedTables;
+    std::unique_lock<std::mutex> publishedLock(PublishedTableMutex);
+    for(auto it = PublishedTableMap.begin(), end = PublishedTableMap.end(); it != end; ++it)
+    {
+        lru.push_back(LruEntry_t(it->second.LastAccessTime, std::make_pair(publishedIndex, it->first)));
+    }
+    std::sort(lru.begin(), lru.end());
+
+    size_t lowWaterMark = MemoryBudget / 4 * 3;
+    size_t evicted = 0;
+    for(auto it = lru.begin(), end = lru.end();
+        (it != end) && (SectionMemoryUsage + PublishedMemoryUsage > lowWaterMark); ++it)
+    {
+        if(it->second.first == publishedIndex)
+        {
+            auto published = PublishedTableMap.find(it->second.second);
+            releasedTables.push_back(published->second.Table);
+            PublishedMemoryUsage -= published->second.TableSize + PUBLISHED_ENTRY_SIZE;
+            PublishedTableMap.erase(published);
+        }
+        else
+        {
+            SectionMap_t& sectionMap = *sectionMaps[it->second.first];
+            EvictSectionList(sectionMap, sectionMap.find(it->second.second));
+        }
+        evicted++;
+    }
+    publishedLock.unlock();
+
+    OS_LOG(DVB_INFO,  "<%s> Memory budget %lu exceeded, %lu sub-tables evicted, usage %lu + %lu published\n", __FUNCTION__,
+            MemoryBudget, evicted, SectionMemoryUsage, PublishedMemoryUsage);
+
+    // The evicted tables still referenced by the observers are released when they let go of them
+}
+
+/**
+ * Configure the compaction of the complete sub-tables
+ *
+ * @param enable true to release the sections of a sub-table once its table is built
+ * @param keepCrc true to keep the CRC_32 of every section, so a section changed without a version update is detected
+ */
+void TSectionParser::SetCompaction(bool enable, bool keepCrc)
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+    IsCompactionEnabled = enable;
+    IsSectionCrcKept = keepCrc;
+}
+
+/**
+ * Set the memory budget of the section state
+ *
+ * @param budget maximum number of bytes held by the sub-tables being assembled and the published tables, 0 for no limit
+ * @param partialTimeout seconds after which an incomplete sub-table without new sections is dropped, 0 to keep it
+ */
+void TSectionParser::SetMemoryBudget(size_t budget, uint32_t partialTimeout)
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+    MemoryBudget = budget;
+    PartialAssemblyTimeout = std::chrono::seconds(partialTimeout);
+}
+
+/**
+ * Get the memory used by the section state
+ *
+ * @return approximate number of bytes held by the sub-tables being assembled and the published tables
+ */
+size_t TSectionParser::GetMemoryUsage()
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+    return SectionMemoryUsage + PublishedMemoryUsage;
+}
+
+/**
+ * Drop the section state (e.g. on retune). The published tables are kept.
+ */
+void TSectionParser::Flush()
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+
+    OS_LOG(DVB_DEBUG,  "<%s> Dropping %lu sub-tables, %lu bytes\n", __FUNCTION__,
+            m_sectionMap.size() + NextSectionMap.size(), SectionMemoryUsage);
+
+    m_sectionMap.clear();
+    NextSectionMap.clear();
+    NextTableMap.clear();
+    SectionMemoryUsage = 0;
+}
+
+/**
+ * Drop the section state of one input (e.g. when that tuner is retuned)
+ *
+ * @param streamContext input
+ */
+void TSectionParser::Flush(uint32_t streamContext)
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+
+    SectionMap_t* sectionMaps[] = { &m_sectionMap, &NextSectionMap };
+    for(size_t i = 0; i < sizeof(sectionMaps) / sizeof(sectionMaps[0]); i++)
+    {
+        // The keys are ordered by the stream context first
+        auto it = sectionMaps[i]->lower_bound(TSectionKey(0, 0, 0, 0, streamContext));
+        while((it != sectionMaps[i]->end()) && (it->first.StreamContext == streamContext))
+        {
+            EvictSectionList(*sectionMaps[i], it++);
+        }
+    }
+}
+
+/**
+ * Drop the section state, the published tables and the delta signatures
+ */
+void TSectionParser::Reset()
+{
+    Flush();
+
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+    SignatureMap.clear();
+
+    std::lock_guard<std::mutex> publishedLock(PublishedTableMutex);
+    PublishedTableMap.clear();
+    PublishedMemoryUsage = 0;
+}
+
+/**
+ * Publish a complete table and queue it for the observers.
+ * Called with the section state mutex held.
+ *
+ * @param key sub-table key
+ * @param tbl complete table
+ * @param lastSectionNumber last section number of the table
+ * @param tableSize approximate heap usage of the table
+ * @param deliveries the table is appended to this list
+ */
+void TSectionParser::CompleteTable(const TSectionKey& key, const std::shared_ptr<TSiTable>& tbl, uint8_t lastSectionNumber,
+                                   size_t tableSize, TTableDeliveryList& deliveries)
+{
+    if(IsStaleVersion(key, tbl->GetVersionNumber()))
+    {
+        OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: version %d from input %u is older than the published one\n", __FUNCTION__,
+                key.TableId, key.ExtensionTableId, tbl->GetVersionNumber(), key.StreamContext);
+        return;
+    }
+
+    // Replace the previously published version of the sub-table
+    PublishTable(key, tbl, lastSectionNumber, tableSize);
+
+    TTableDelivery delivery;
+    delivery.Key = key;
+    delivery.Table = tbl;
+
+    if(IsTableDeltaEnabled && TSiTableDiff::IsDiffSupported(tbl->GetTableId()))
+    {
+        delivery.Delta = GetTableDelta(key, *tbl, delivery.PreviousSignature);
+    }
+
+    deliveries.push_back(delivery);
+}
+
+/**
+ * Queue the completed tables for delivery, in the order they were published.
+ * Called with the section state mutex held.
+ *
+ * @param deliveries completed tables
+ */
+void TSectionParser::QueueDeliveries(const TTableDeliveryList& deliveries)
+{
+    if(deliveries.empty())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(DeliveryMutex);
+    for(auto it = deliveries.begin(), end = deliveries.end(); it != end; ++it)
+    {
+        DeliveryQueueMap[it->Key.GetContentKey()].Pending.push_back(*it);
+    }
+}
+
+/**
+ * Notify the observers about the completed tables.
+ * A thread already delivering the same sub-table delivers the queued versions as well, so the
+ * versions of a sub-table reach the observers one at a time and in order.
+ *
+ * @param deliveries completed tables
+ */
+void TSectionParser::DeliverTables(const TTableDeliveryList& deliveries)
+{
+    for(auto it = deliveries.begin(), end = deliveries.end(); it != end; ++it)
+    {
+        std::unique_lock<std::mutex> lock(DeliveryMutex);
+
+        auto queueIt = DeliveryQueueMap.find(it->Key.GetContentKey());
+        if((queueIt == DeliveryQueueMap.end()) || queueIt->second.IsDelivering)
+        {
+            // Delivered by another thread
+            continue;
+        }
+
+        TDeliveryQueue& queue = queueIt->second;
+        queue.IsDelivering = true;
+        while(!queue.Pending.empty())
+        {
+            TTableDelivery delivery(queue.Pending.front());
+            queue.Pending.pop_front();
+            lock.unlock();
+
+            // Let's publish the table. All the observers share the same instance.
+            NotifyDvbTableObserver(delivery);
+
+            lock.lock();
+        }
+        DeliveryQueueMap.erase(queueIt);
+    }
+}
+
+/**
+ * Make the table the published version of its sub-table.
+ * Called with the section state mutex held.
+ *
+ * @param key sub-table key
+ * @param tbl complete table
+ * @param lastSectionNumber last section number of the table, 0 for the custom tables
+ * @param tableSize approximate heap usage of the table, counted in the memory budget
+ */
+void TSectionParser::PublishTable(const TSectionKey& key, const std::shared_ptr<const TSiTable>& tbl,
+                                  uint8_t lastSectionNumber, size_t tableSize)
+{
+    std::shared_ptr<const TSiTable> prev(tbl);
+
+    {
+        std::lock_guard<std::mutex> lock(PublishedTableMutex);
+
+        auto result = PublishedTableMap.insert(std::make_pair(key.GetContentKey(), TPublishedTable()));
+        TPublishedTable& published = result.first->second;
+        if(result.second)
+        {
+            PublishedMemoryUsage += PUBLISHED_ENTRY_SIZE;
+        }
+
+        published.Table.swap(prev);
+        published.VersionNumber = tbl->GetVersionNumber();
+        published.LastSectionNumber = lastSectionNumber;
+        published.StreamContext = key.StreamContext;
+        published.PublishTime = std::chrono::steady_clock::now();
+        published.IsPartial = tbl->IsPartial();
+        published.IsShed = false;
+        PublishedMemoryUsage = PublishedMemoryUsage + tableSize - published.TableSize;
+        published.TableSize = tableSize;
+        published.LastAccessTime = std::chrono::steady_clock::now();
+    }
+
+    // The previous version (if any) is released here, outside of the lock
+}
+
+/**
+ * Get the last complete version of a sub-table.
+ * If several transports carry a sub-table with the same identifiers, the first one is returned.
+ *
+ * @param tableId table identifier
+ * @param extId table identifier extension
+ * @return table snapshot or NULL if no version of the sub-table has completed yet
+ */
+std::shared_ptr<const TSiTable> TSectionParser::GetTable(uint8_t tableId, uint16_t extId)
+{
+    std::lock_guard<std::mutex> lock(PublishedTableMutex);
+
+    auto it = PublishedTableMap.lower_bound(TSectionKey(tableId, extId));
+    if((it == PublishedTableMap.end()) || (it->first.TableId != tableId) || (it->first.ExtensionTableId != extId))
+    {
+        return std::shared_ptr<const TSiTable>();
+    }
+
+    it->second.LastAccessTime = std::chrono::steady_clock::now();
+    return it->second.Table;
+}
+
+/**
+ * Get the last complete version of a sub-table
+ *
+ * @param key sub-table key, the stream context is ignored
+ * @return table snapshot or NULL if no version of the sub-table has completed yet
+ */
+std::shared_ptr<const TSiTable> TSectionParser::GetTable(const TSectionKey& key)
+{
+    std::lock_guard<std::mutex> lock(PublishedTableMutex);
+
+    auto it = PublishedTableMap.find(key.GetContentKey());
+    if(it == PublishedTableMap.end())
+    {
+        return std::shared_ptr<const TSiTable>();
+    }
+
+    it->second.LastAccessTime = std::chrono::steady_clock::now();
+    return it->second.Table;
+}
+
+/**
+ * Compare the new table version against the signature of the previous one.
+ * Called with the section state mutex held.
+ *
+ * @param key sub-table key
+ * @param tbl new SDT/EIT table
+ * @param previous receives the signature replaced by the new version, NULL for the first version
+ * @return delta, NULL for the first version or if nothing changed
+ */
+std::shared_ptr<TSiTableDelta> TSectionParser::GetTableDelta(const TSectionKey& key, const TSiTable& tbl,
+                                                             std::shared_ptr<const TVersionSignature>& previous)
+{
+    TSiTableSignature signature = TSiTableDiff::GetSignature(tbl);
+
+    auto it = SignatureMap.find(key.GetContentKey());
+    if(it == SignatureMap.end())
+    {
+        // First version of the sub-table, there is nothing to compare against
+        SignatureMap[key.GetContentKey()] = std::make_pair(tbl.GetVersionNumber(), signature);
+        return std::shared_ptr<TSiTableDelta>();
+    }
+
+    std::shared_ptr<TSiTableDelta> ret(std::make_shared<TSiTableDelta>(tbl.GetTableId(), tbl.GetTableExtensionId(),
+                                                                       it->second.first, tbl.GetVersionNumber()));
+    TSiTableDelta& delta = *ret;
+    TSiTableDiff::Compare(it->second.second, signature, delta);
+
+    OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: version %d -> %d, added = %lu, removed = %lu, changed = %lu\n", __FUNCTION__,
+            delta.TableId, delta.TableExtensionId, delta.PreviousVersionNumber, delta.VersionNumber,
+            delta.AddedEntries.size(), delta.RemovedEntries.size(), delta.ChangedEntries.size());
+
+    std::shared_ptr<TVersionSignature> replaced(std::make_shared<TVersionSignature>(it->second.first, TSiTableSignature()));
+    replaced->second.swap(it->second.second);
+    previous = replaced;
+
+    it->second.first = tbl.GetVersionNumber();
+    it->second.second.swap(signature);
+
+    if(delta.IsEmpty())
+    {
+        ret.reset();
+    }
+
+    return ret;
+}
+
+void TSectionParser::SetTableDeltaEnabled(bool enable)
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+
+    IsTableDeltaEnabled = enable;
+    if(!enable)
+    {
+        SignatureMap.clear();
+    }
+}
+
+/**
+ * Deliver a complete table, followed by its delta if the delta events are enabled
+ *
+ * @param delivery completed table
+ */
+void TSectionParser::NotifyDvbTableObserver(const TTableDelivery& delivery)
+{
+    std::shared_ptr<const TSiTable> tbl(delivery.Table);
+    std::shared_ptr<const TSiTableDelta> delta(delivery.Delta);
+    std::shared_ptr<const TableObserverVector_t> observers(GetTableObservers());
+    std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+
+    if(!dispatcher)
+    {
+        for(auto it = observers->begin(), end = observers->end(); it != end; ++it)
+        {
+            DispatchTable(it->Observer, tbl);
+            if(delta)
+            {
+                it->Observer->OnDelta(delta);
+            }
+        }
+        return;
+    }
+
+    // A shed table is delivered again from the next repetition of its sections
+    TSectionKey key(delivery.Key);
+    uint8_t version = tbl->GetVersionNumber();
+    std::shared_ptr<const TVersionSignature> previous(delivery.PreviousSignature);
+    TObserverDispatcher::Task_t onShed([this, key, version, previous]() { HandleShedTable(key, version, previous); });
+    TSiPriority priority = GetSiPriority(static_cast<uint8_t>(tbl->GetTableId()));
+
+    for(auto it = observers->begin(), end = observers->end(); it != end; ++it)
+    {
+        IDvbTableObserver* observer = it->Observer;
+        std::shared_ptr<TSectionParserObserverAdapter> adapter(it->Adapter);
+
+        // The delta is queued in the same event as its table, so both are delivered or shed together
+        dispatcher->Post(it->DispatcherKey, [observer, adapter, tbl, delta]() {
+                DispatchTable(observer, tbl);
+                if(delta)
+                {
+                    observer->OnDelta(delta);
+                }
+            }, priority, onShed);
+    }
+}
+
+/**
+ * Called on the posting thread when the dispatcher sheds the delivery of a table. The version is no
+ * longer considered published: the complete section list is dropped, so the next repetition of the
+ * sections builds and delivers the table again, and the delta base is restored.
+ *
+ * @param key sub-table key
+ * @param version shed version
+ * @param previous delta base replaced by the shed version, NULL if none
+ */
+void TSectionParser::HandleShedTable(const TSectionKey& key, uint8_t version,
+                                     const std::shared_ptr<const TVersionSignature>& previous)
+{
+    std::lock_guard<std::mutex> lock(SectionStateMutex);
+
+    {
+        std::lock_guard<std::mutex> publishedLock(PublishedTableMutex);
+
+        auto it = PublishedTableMap.find(key.GetContentKey());
+        if((it == PublishedTableMap.end()) || (it->second.VersionNumber != version))
+        {
+            // Replaced by a newer version in the meantime, that one is delivered instead
+            return;
+        }
+        it->second.IsShed = true;
+    }
+
+    OS_LOG(DVB_DEBUG,  "<%s> 0x%x.0x%x: version %d shed, waiting for the next repetition\n", __FUNCTION__,
+            key.TableId, key.ExtensionTableId, version);
+
+    auto listIt = m_sectionMap.find(key);
+    if((listIt != m_sectionMap.end()) && listIt->second.GetCompletenessFlag() &&
+       (listIt->second.GetVersionNumber() == version))
+    {
+        EvictSectionList(m_sectionMap, listIt);
+    }
+
+    auto sigIt = SignatureMap.find(key.GetContentKey());
+    if(previous && (sigIt != SignatureMap.end()) && (sigIt->second.first == version))
+    {
+        sigIt->second = *previous;
+    }
+}
+
+/**
+ * Call the observer method matching the table type
+ *
+ * @param observer typed observer
+ * @param tbl complete table
+ */
+void TSectionParser::DispatchTable(IDvbTableObserver* observer, const std::shared_ptr<const TSiTable>& tbl)
+{
+    TTableId tableId = tbl->GetTableId();
+
+    if((tableId == TTableId::TABLE_ID_NIT) || (tableId == TTableId::TABLE_ID_NIT_OTHER))
+    {
+        observer->OnNit(std::static_pointer_cast<const TNitTable>(tbl));
+    }
+    else if((tableId == TTableId::TABLE_ID_SDT) || (tableId == TTableId::TABLE_ID_SDT_OTHER))
+    {
+        observer->OnSdt(std::static_pointer_cast<const TSdtTable>(tbl));
+    }
+    else if(tableId == TTableId::TABLE_ID_BAT)
+    {
+        observer->OnBat(std::static_pointer_cast<const TBatTable>(tbl));
+    }
+    else if((tableId >= TTableId::TABLE_ID_EIT_PF) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END))
+    {
+        observer->OnEit(std::static_pointer_cast<const TEitTable>(tbl));
+    }
+    else if((tableId == TTableId::TABLE_ID_TDT) || (tableId == TTableId::TABLE_ID_TOT))
+    {
+        observer->OnTot(std::static_pointer_cast<const TTotTable>(tbl));
+    }
+    else if((tableId >= TTableId::TABLE_ID_USER_DEFINED_START) && (tableId <= TTableId::TABLE_ID_USER_DEFINED_END))
+    {
+        observer->OnUdt(std::static_pointer_cast<const TUdtTable>(tbl));
+    }
+}
+
+/**
+ * Get a snapshot of the legacy observers
+ *
+ * @return observer list, never NULL
+ */
+std::shared_ptr<const TSectionParser::ObserverVector_t> TSectionParser::GetObservers()
+{
+    std::lock_guard<std::mutex> lock(ObserverMutex);
+
+    if(!ObserverVector)
+    {
+        ObserverVector = std::make_shared<ObserverVector_t>();
+    }
+    return ObserverVector;
+}
+
+/**
+ * Get a snapshot of the typed observers, the adapters of the legacy observers included
+ *
+ * @return observer list, never NULL
+ */
+std::shared_ptr<const TSectionParser::TableObserverVector_t> TSectionParser::GetTableObservers()
+{
+    std::lock_guard<std::mutex> lock(ObserverMutex);
+
+    if(!TableObserverVector)
+    {
+        TableObserverVector = std::make_shared<TableObserverVector_t>();
+    }
+    return TableObserverVector;
+}
+
+/**
+ * Get the dispatcher of the asynchronous delivery. A delivery posts all its events to the same
+ * dispatcher, even if SetAsyncDelivery() replaces it meanwhile.
+ *
+ * @return dispatcher, NULL with the synchronous delivery
+ */
+std::shared_ptr<TObserverDispatcher> TSectionParser::GetDispatcher()
+{
+    std::lock_guard<std::mutex> lock(ObserverMutex);
+
+    return Dispatcher;
+}
+
+/**
+ * Add a typed observer to a new copy of the list
+ *
+ * @param observer typed observer
+ * @param adapter adapter of the legacy observer if the observer is one, NULL otherwise
+ */
+void TSectionParser::AddTableObserver(IDvbTableObserver* observer, const std::shared_ptr<TSectionParserObserverAdapter>& adapter)
+{
+    TTableObserver entry;
+    entry.Observer = observer;
+    entry.Adapter = adapter;
+    entry.DispatcherKey = adapter ? static_cast<const void*>(adapter->GetObserver()) : observer;
+
+    std::lock_guard<std::mutex> lock(ObserverMutex);
+
+    std::shared_ptr<TableObserverVector_t> observers(TableObserverVector ? std::make_shared<TableObserverVector_t>(*TableObserverVector) :
+                                                                           std::make_shared<TableObserverVector_t>());
+    observers->push_back(entry);
+    TableObserverVector = observers;
+}
+
+void TSectionParser::RegisterDvbTableObserver(IDvbTableObserver* observerObject)
+{
+  AddTableObserver(observerObject, std::shared_ptr<TSectionParserObserverAdapter>());
+}
+
+void TSectionParser::RemoveDvbTableObserver(IDvbTableObserver* observerObject)
+{
+  {
+    std::lock_guard<std::mutex> lock(ObserverMutex);
+
+    if (TableObserverVector) {
+      std::shared_ptr<TableObserverVector_t> observers(std::make_shared<TableObserverVector_t>());
+      for (auto it = TableObserverVector->begin(); it != TableObserverVector->end(); ++it) {
+        if (it->Observer != observerObject) {
+          observers->push_back(*it);
+        }
+      }
+      TableObserverVector = observers;
+    }
+  }
+
+  // No new event is posted from now on, the pending ones are dropped
+  std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+  if (dispatcher) {
+    dispatcher->RemoveObserver(observerObject);
+  }
+}
+
+/**
+ * Enable or disable the asynchronous delivery to the observers
+ *
+ * @param workerCount number of worker threads, 0 to deliver on the parsing thread
+ * @param queueCapacity maximum number of pending events per observer
+ * @param latencyTargetUs latency of the TDT/TOT, EIT p/f and SI tables above which the EIT schedule
+ *        and EIT other tables are shed, zero to shed on the queue depth only
+ */
+void TSectionParser::SetAsyncDelivery(size_t workerCount, size_t queueCapacity, uint64_t latencyTargetUs)
+{
+    std::shared_ptr<TObserverDispatcher> dispatcher;
+
+    if(workerCount > 0)
+    {
+        OS_LOG(DVB_INFO,  "<%s> %lu workers, queue capacity %lu\n", __FUNCTION__, workerCount, queueCapacity);
+        dispatcher = std::make_shared<TObserverDispatcher>(workerCount, queueCapacity);
+        dispatcher->SetLatencyTarget(latencyTargetUs);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ObserverMutex);
+        Dispatcher.swap(dispatcher);
+    }
+
+    // The old dispatcher delivers its pending events once the parsing threads posting to it are done
+    dispatcher.reset();
+}
+
+/**
+ * Get the delivery statistics of the observer
+ *
+ * @param observerObject IDvbTableObserver or IDvbSectionParserObserver
+ * @param stats statistics
+ * @return true if the asynchronous delivery is enabled and the observer has received events, false otherwise
+ */
+bool TSectionParser::GetObserverStats(const void* observerObject, TObserverDispatcherStats& stats)
+{
+    std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+
+    return dispatcher && dispatcher->GetStats(observerObject, stats);
+}
+
+/**
+ * Get the delivery statistics of a priority class
+ *
+ * @param priority priority class
+ * @param stats statistics
+ * @return true if the asynchronous delivery is enabled, false otherwise
+ */
+bool TSectionParser::GetPriorityStats(TSiPriority priority, TSiPriorityStats& stats)
+{
+    std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+
+    if(!dispatcher)
+    {
+        return false;
+    }
+
+    stats = dispatcher->GetPriorityStats(priority);
+    return true;
+}
+
+void TSectionParser::RegisterDvbSectionParserObserver(IDvbSectionParserObserver* observerObject)
+{
+  {
+    std::lock_guard<std::mutex> lock(ObserverMutex);
+
+    std::shared_ptr<ObserverVector_t> observers(ObserverVector ? std::make_shared<ObserverVector_t>(*ObserverVector) :
+                                                                 std::make_shared<ObserverVector_t>());
+    observers->push_back(observerObject);
+    ObserverVector = observers;
+  }
+
+  // The tables reach the legacy observers through the typed interface
+  std::shared_ptr<TSectionParserObserverAdapter> adapter(new TSectionParserObserverAdapter(observerObject));
+  AddTableObserver(adapter.get(), adapter);
+}
+
+void TSectionParser::RemoveDvbSectionParserObserver(IDvbSectionParserObserver* observerObject)
+{
+  {
+    std::lock_guard<std::mutex> lock(ObserverMutex);
+
+    if (ObserverVector) {
+      std::shared_ptr<ObserverVector_t> observers(std::make_shared<ObserverVector_t>(*ObserverVector));
+      observers->erase(std::remove(observers->begin(), observers->end(), observerObject), observers->end());
+      ObserverVector = observers;
+    }
+
+    if (TableObserverVector) {
+      std::shared_ptr<TableObserverVector_t> tableObservers(std::make_shared<TableObserverVector_t>());
+      for (auto it = TableObserverVector->begin(); it != TableObserverVector->end(); ++it) {
+        if (!it->Adapter || (it->Adapter->GetObserver() != observerObject)) {
+          tableObservers->push_back(*it);
+        }
+      }
+      TableObserverVector = tableObservers;
+    }
+  }
+
+  // No new event is posted from now on, the pending ones are dropped
+  std::shared_ptr<TObserverDispatcher> dispatcher(GetDispatcher());
+  if (dispatcher) {
+    dispatcher->RemoveObserver(observerObject);
+  }
 }
 
 void TSectionParser::NotifyDvbSectionParserObserver(uint32_t eventType, void *eventData, size_t dataSize)
 {
-  std::vector<IDvbSectionParserObserver*>::const_iterator iter = ObserverVector.begin();
-  for (; iter != ObserverVector.end(); ++iter) {
+  std::shared_ptr<const ObserverVector_t> observers(GetObservers());
+  std::vector<IDvbSectionParserObserver*>::const_iterator iter = observers->begin();
+  for (; iter != observers->end(); ++iter) {
     (*iter)->SendEvent(eventType, eventData, dataSize);
   }
 
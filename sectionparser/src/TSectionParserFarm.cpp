@@ -0,0 +1,368 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TSectionParserFarm.h"
+
+#include <time.h>
+
+#include "oswrap.h"
+#include "DvbUtils.h"
+
+// Sections parsed before an instance goes back to the ready queue
+static const size_t SECTION_BATCH_SIZE = 32;
+
+static uint64_t GetThreadCpuTimeUs()
+{
+    struct timespec ts;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+    {
+        return 0;
+    }
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Constructor
+ *
+ * @param workerCount number of worker threads (at least one is started)
+ * @param queueCapacity maximum number of pending sections per instance
+ */
+TSectionParserFarm::TSectionParserFarm(size_t workerCount, size_t queueCapacity)
+  : QueueCapacity(queueCapacity ? queueCapacity : 1),
+    IsCrcCheckEnabled(false),
+    NextInstanceId(1),
+    ReadyInstances(0),
+    IsStopping(false)
+{
+    if(workerCount == 0)
+    {
+        workerCount = 1;
+    }
+
+    for(size_t i = 0; i < workerCount; i++)
+    {
+        WorkerVector.push_back(std::unique_ptr<TWorker>(new TWorker()));
+    }
+
+    // All the workers exist before any of them can try to steal
+    for(size_t i = 0; i < workerCount; i++)
+    {
+        WorkerVector[i]->Thread = std::thread(&TSectionParserFarm::WorkerThread, this, i);
+    }
+}
+
+/**
+ * Destructor. The pending sections are dropped.
+ */
+TSectionParserFarm::~TSectionParserFarm()
+{
+    {
+        std::lock_guard<std::mutex> lock(WakeMutex);
+        IsStopping = true;
+    }
+    WakeCondition.notify_all();
+
+    for(auto it = WorkerVector.begin(), end = WorkerVector.end(); it != end; ++it)
+    {
+        (*it)->Thread.join();
+    }
+}
+
+void TSectionParserFarm::SetCrcCheck(bool enable)
+{
+    IsCrcCheckEnabled = enable;
+}
+
+/**
+ * Create a parser instance
+ *
+ * @return instance identifier
+ */
+uint32_t TSectionParserFarm::CreateParser()
+{
+    std::lock_guard<std::mutex> lock(InstanceMutex);
+
+    uint32_t id = NextInstanceId++;
+    InstanceMap[id] = std::make_shared<TInstance>(id, id % WorkerVector.size());
+
+    OS_LOG(DVB_DEBUG,  "<%s> Instance %u created\n", __FUNCTION__, id);
+    return id;
+}
+
+/**
+ * Destroy a parser instance. The pending sections are dropped and the section being parsed,
+ * if any, is completed first.
+ *
+ * @param id instance identifier
+ */
+void TSectionParserFarm::DestroyParser(uint32_t id)
+{
+    std::shared_ptr<TInstance> instance;
+    {
+        std::lock_guard<std::mutex> lock(InstanceMutex);
+
+        auto it = InstanceMap.find(id);
+        if(it == InstanceMap.end())
+        {
+            return;
+        }
+        instance = it->second;
+        InstanceMap.erase(it);
+    }
+
+    std::unique_lock<std::mutex> lock(instance->QueueMutex);
+    instance->IsRemoved = true;
+    instance->SectionQueue.clear();
+    instance->IdleCondition.wait(lock, [&] { return !instance->IsRunning; });
+
+    OS_LOG(DVB_DEBUG,  "<%s> Instance %u destroyed\n", __FUNCTION__, id);
+}
+
+std::shared_ptr<TSectionParserFarm::TInstance> TSectionParserFarm::FindInstance(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(InstanceMutex);
+
+    auto it = InstanceMap.find(id);
+    return (it == InstanceMap.end()) ? std::shared_ptr<TInstance>() : it->second;
+}
+
+TSectionParser* TSectionParserFarm::GetParser(uint32_t id)
+{
+    std::shared_ptr<TInstance> instance(FindInstance(id));
+    return instance ? &instance->Parser : NULL;
+}
+
+/**
+ * Queue a section for an instance. Returns right away, the section is copied.
+ *
+ * @param id instance identifier
+ * @param data section data
+ * @param size data size
+ * @return true if the section was queued, false if the instance doesn't exist or its queue is full
+ */
+bool TSectionParserFarm::Submit(uint32_t id, const uint8_t* data, uint32_t size)
+{
+    if(!data || size == 0)
+    {
+        return false;
+    }
+
+    std::shared_ptr<TInstance> instance(FindInstance(id));
+    if(!instance)
+    {
+        OS_LOG(DVB_ERROR,  "<%s> Unknown instance %u\n", __FUNCTION__, id);
+        return false;
+    }
+
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(instance->QueueMutex);
+
+        TParserInstanceStats& stats = instance->Stats;
+        if(instance->SectionQueue.size() >= QueueCapacity)
+        {
+            stats.DroppedSections++;
+            return false;
+        }
+
+        instance->SectionQueue.push_back(std::vector<uint8_t>(data, data + size));
+        stats.QueueDepth = instance->SectionQueue.size();
+        if(stats.QueueDepth > stats.MaxQueueDepth)
+        {
+            stats.MaxQueueDepth = stats.QueueDepth;
+        }
+
+        if(!instance->IsScheduled)
+        {
+            instance->IsScheduled = true;
+            schedule = true;
+        }
+    }
+
+    if(schedule)
+    {
+        Schedule(instance->HomeWorker, instance);
+    }
+
+    return true;
+}
+
+bool TSectionParserFarm::GetStats(uint32_t id, TParserInstanceStats& stats)
+{
+    std::shared_ptr<TInstance> instance(FindInstance(id));
+    if(!instance)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(instance->QueueMutex);
+    stats = instance->Stats;
+    return true;
+}
+
+void TSectionParserFarm::Schedule(size_t workerIndex, const std::shared_ptr<TInstance>& instance)
+{
+    // Counted before it can be taken, so the count never drops below the queued instances
+    {
+        std::lock_guard<std::mutex> lock(WakeMutex);
+        ReadyInstances++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(WorkerVector[workerIndex]->ReadyMutex);
+        WorkerVector[workerIndex]->ReadyQueue.push_back(instance);
+    }
+    WakeCondition.notify_one();
+}
+
+/**
+ * Take the next ready instance: from the worker's own queue first, then from the tail of the others
+ *
+ * @param workerIndex worker
+ * @return instance or NULL if there is no work
+ */
+std::shared_ptr<TSectionParserFarm::TInstance> TSectionParserFarm::TakeInstance(size_t workerIndex)
+{
+    std::shared_ptr<TInstance> instance;
+    size_t workerCount = WorkerVector.size();
+
+    for(size_t i = 0; (i < workerCount) && !instance; i++)
+    {
+        TWorker& worker = *WorkerVector[(workerIndex + i) % workerCount];
+        std::lock_guard<std::mutex> lock(worker.ReadyMutex);
+
+        if(worker.ReadyQueue.empty())
+        {
+            continue;
+        }
+
+        if(i == 0)
+        {
+            instance = worker.ReadyQueue.front();
+            worker.ReadyQueue.pop_front();
+        }
+        else
+        {
+            // Steal the most recently scheduled instance, the owner keeps the oldest ones
+            instance = worker.ReadyQueue.back();
+            worker.ReadyQueue.pop_back();
+        }
+    }
+
+    if(instance)
+    {
+        size_t ready = ReadyInstances.load();
+        while((ready > 0) && !ReadyInstances.compare_exchange_weak(ready, ready - 1))
+        {
+            // Retry with the updated count
+        }
+    }
+
+    return instance;
+}
+
+/**
+ * Parse a batch of sections of the instance
+ *
+ * @param workerIndex worker
+ * @param instance instance owned by the worker
+ */
+void TSectionParserFarm::RunInstance(size_t workerIndex, const std::shared_ptr<TInstance>& instance)
+{
+    uint64_t cpuTimeStart = GetThreadCpuTimeUs();
+    uint64_t parsed = 0;
+    uint64_t crcErrors = 0;
+
+    for(size_t i = 0; i < SECTION_BATCH_SIZE; i++)
+    {
+        std::vector<uint8_t> section;
+        {
+            std::lock_guard<std::mutex> lock(instance->QueueMutex);
+            if(instance->IsRemoved || instance->SectionQueue.empty())
+            {
+                break;
+            }
+
+            section.swap(instance->SectionQueue.front());
+            instance->SectionQueue.pop_front();
+            instance->IsRunning = true;
+        }
+
+        // Syntax indicator set: the section ends with a CRC_32
+        if(IsCrcCheckEnabled && (section.size() > 3) && (section[1] & 0x80) && Crc32(section.data(), section.size()))
+        {
+            crcErrors++;
+        }
+        else
+        {
+            instance->Parser.ParseSiData(section.data(), section.size());
+            parsed++;
+        }
+    }
+
+    uint64_t cpuTime = GetThreadCpuTimeUs() - cpuTimeStart;
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(instance->QueueMutex);
+
+        TParserInstanceStats& stats = instance->Stats;
+        stats.ParsedSections += parsed;
+        stats.CrcErrors += crcErrors;
+        stats.CpuTimeUs += cpuTime;
+        stats.QueueDepth = instance->SectionQueue.size();
+
+        instance->IsRunning = false;
+        if(!instance->IsRemoved && !instance->SectionQueue.empty())
+        {
+            schedule = true;
+        }
+        else
+        {
+            instance->IsScheduled = false;
+        }
+    }
+    instance->IdleCondition.notify_all();
+
+    if(schedule)
+    {
+        // Back to the tail of the worker's queue, so the other instances get their turn
+        Schedule(workerIndex, instance);
+    }
+}
+
+void TSectionParserFarm::WorkerThread(size_t index)
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(WakeMutex);
+            WakeCondition.wait(lock, [&] { return IsStopping || (ReadyInstances > 0); });
+            if(IsStopping)
+            {
+                break;
+            }
+        }
+
+        std::shared_ptr<TInstance> instance(TakeInstance(index));
+        if(instance)
+        {
+            RunInstance(index, instance);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TSectionParserObserverAdapter.h"
+
+#include "TNitTable.h"
+#include "TSdtTable.h"
+#include "TBatTable.h"
+#include "TEitTable.h"
+#include "TTotTable.h"
+#include "TUdtTable.h"
+
+/**
+ * Hand a copy of the table to the observer. The legacy observers own the tables they receive,
+ * so the shared instance itself is never passed to them.
+ *
+ * @param tbl table
+ */
+template<class T>
+void TSectionParserObserverAdapter::SendTable(const T& tbl)
+{
+    Observer->SendEvent((uint32_t)tbl.GetTableId(), new T(tbl), 0);
+}
+
+void TSectionParserObserverAdapter::OnDelta(const std::shared_ptr<const TSiTableDelta>& delta)
+{
+    Observer->SendEvent((uint32_t)TABLE_DELTA_EVENT, const_cast<TSiTableDelta*>(delta.get()), sizeof(*delta));
+}
+
+void TSectionParserObserverAdapter::OnNit(const std::shared_ptr<const TNitTable>& nit)
+{
+    SendTable(*nit);
+}
+
+void TSectionParserObserverAdapter::OnSdt(const std::shared_ptr<const TSdtTable>& sdt)
+{
+    SendTable(*sdt);
+}
+
+void TSectionParserObserverAdapter::OnBat(const std::shared_ptr<const TBatTable>& bat)
+{
+    SendTable(*bat);
+}
+
+void TSectionParserObserverAdapter::OnEit(const std::shared_ptr<const TEitTable>& eit)
+{
+    SendTable(*eit);
+}
+
+void TSectionParserObserverAdapter::OnTot(const std::shared_ptr<const TTotTable>& tot)
+{
+    SendTable(*tot);
+}
+
+void TSectionParserObserverAdapter::OnUdt(const std::shared_ptr<const TUdtTable>& udt)
+{
+    SendTable(*udt);
+}
+
+void TSectionParserObserverAdapter::OnTdt(time_t /*utcTime*/, uint64_t utcTimeBcd)
+{
+    // The legacy observers still get a table object of their own
+    TTotTable* tdt = new TTotTable(static_cast<uint8_t>(TTableId::TABLE_ID_TDT), 0, 0, true);
+    tdt->SetUtcTime(utcTimeBcd);
+
+    Observer->SendEvent((uint32_t)TTableId::TABLE_ID_TDT, tdt, 0);
+}
@@ -22,6 +22,19 @@
 
 using std::vector;
 
+TSiSection::TSiSection()
+    : TableId(0),
+      SectionSyntaxIndicator(false),
+      SectionLength(0),
+      ExtensionTableId(0),
+      VersionNumber(0),
+      CurrentNextIndicator(true),
+      SectionNumber(0),
+      LastSectionNumber(0)
+{
+    // Empty
+}
+
 TSiSection::TSiSection(uint8_t* data, size_t len)
     : ExtensionTableId(0),
       VersionNumber(0),
@@ -0,0 +1,189 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TSiTableDiff.h"
+
+#include "oswrap.h"
+
+#include "TSdtTable.h"
+#include "TEitTable.h"
+
+using std::vector;
+
+// FNV-1a parameters
+static const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static const uint32_t FNV_PRIME = 16777619u;
+
+static inline uint32_t HashByte(uint32_t hash, uint8_t byte)
+{
+    return (hash ^ byte) * FNV_PRIME;
+}
+
+static inline uint32_t HashValue(uint32_t hash, uint64_t value, size_t size)
+{
+    for(size_t i = 0; i < size; i++)
+    {
+        hash = HashByte(hash, (uint8_t)(value >> (8 * i)));
+    }
+
+    return hash;
+}
+
+/**
+ * Hash a descriptor loop (tag, length and data of every descriptor)
+ *
+ * @param descriptors descriptor loop
+ * @param hash initial hash value
+ * @return hash value
+ */
+uint32_t TSiTableDiff::HashDescriptors(const vector<TMpegDescriptor>& descriptors, uint32_t hash)
+{
+    for(auto it = descriptors.begin(), end = descriptors.end(); it != end; ++it)
+    {
+        const vector<uint8_t>& data = it->GetDescriptorData();
+
+        hash = HashByte(hash, static_cast<uint8_t>(it->GetDescriptorTag()));
+        hash = HashByte(hash, (uint8_t)data.size());
+        for(auto byte = data.begin(), byteEnd = data.end(); byte != byteEnd; ++byte)
+        {
+            hash = HashByte(hash, *byte);
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * Check if the sub-tables of certain type can be compared
+ *
+ * @param tableId table identifier
+ * @return true for SDT and EIT tables, false otherwise
+ */
+bool TSiTableDiff::IsDiffSupported(uint8_t id)
+{
+    TTableId tableId = static_cast<TTableId>(id);
+
+    return (tableId == TTableId::TABLE_ID_SDT) || (tableId == TTableId::TABLE_ID_SDT_OTHER) ||
+           ((tableId >= TTableId::TABLE_ID_EIT_PF) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END));
+}
+
+/**
+ * Build the signature of a sub-table
+ *
+ * @param tbl SDT or EIT table
+ * @return signature keyed by service_id (SDT) or event_id (EIT), empty for other tables
+ */
+TSiTableSignature TSiTableDiff::GetSignature(const TSiTable& tbl)
+{
+    TSiTableSignature signature;
+    TTableId tableId = tbl.GetTableId();
+
+    if((tableId == TTableId::TABLE_ID_SDT) || (tableId == TTableId::TABLE_ID_SDT_OTHER))
+    {
+        const vector<TSdtService>& services = static_cast<const TSdtTable&>(tbl).GetServices();
+        for(auto it = services.begin(), end = services.end(); it != end; ++it)
+        {
+            uint32_t hash = FNV_OFFSET_BASIS;
+            hash = HashByte(hash, it->IsEitSchedFlagSet());
+            hash = HashByte(hash, it->IsEitPfFlagSet());
+            hash = HashByte(hash, it->GetRunningStatus());
+            hash = HashByte(hash, it->IsScrambled());
+            signature[it->GetServiceId()] = HashDescriptors(it->GetServiceDescriptors(), hash);
+        }
+    }
+    else if((tableId >= TTableId::TABLE_ID_EIT_PF) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END))
+    {
+        const vector<TEitEvent>& events = static_cast<const TEitTable&>(tbl).GetEvents();
+        for(auto it = events.begin(), end = events.end(); it != end; ++it)
+        {
+            uint32_t hash = FNV_OFFSET_BASIS;
+            hash = HashValue(hash, it->GetStartTimeBcd(), 5);
+            hash = HashValue(hash, it->GetDurationBcd(), 3);
+            hash = HashByte(hash, it->GetRunningStatus());
+            hash = HashByte(hash, it->IsScrambled());
+            signature[it->GetEventId()] = HashDescriptors(it->GetEventDescriptors(), hash);
+        }
+    }
+    else
+    {
+        OS_LOG(DVB_WARN, "<%s> Table id 0x%x can't be compared\n", __FUNCTION__, tableId);
+    }
+
+    return signature;
+}
+
+/**
+ * Compare two sub-table signatures
+ *
+ * @param prev signature of the previous version
+ * @param next signature of the new version
+ * @param delta added, removed and changed entries are appended to this delta
+ */
+void TSiTableDiff::Compare(const TSiTableSignature& prev, const TSiTableSignature& next, TSiTableDelta& delta)
+{
+    auto prevIt = prev.begin();
+    auto prevEnd = prev.end();
+    auto nextIt = next.begin();
+    auto nextEnd = next.end();
+
+    // Both signatures are sorted by the entry identifier, so a single merge pass is enough
+    while((prevIt != prevEnd) || (nextIt != nextEnd))
+    {
+        if((nextIt == nextEnd) || ((prevIt != prevEnd) && (prevIt->first < nextIt->first)))
+        {
+            delta.RemovedEntries.push_back(prevIt->first);
+            ++prevIt;
+        }
+        else if((prevIt == prevEnd) || (nextIt->first < prevIt->first))
+        {
+            delta.AddedEntries.push_back(nextIt->first);
+            ++nextIt;
+        }
+        else
+        {
+            if(prevIt->second != nextIt->second)
+            {
+                delta.ChangedEntries.push_back(nextIt->first);
+            }
+            ++prevIt;
+            ++nextIt;
+        }
+    }
+}
+
+/**
+ * Compare two versions of the same sub-table
+ *
+ * @param prev previous version
+ * @param next new version
+ * @return delta between the versions
+ */
+TSiTableDelta TSiTableDiff::Compare(const TSiTable& prev, const TSiTable& next)
+{
+    TSiTableDelta delta(next.GetTableId(), next.GetTableExtensionId(), prev.GetVersionNumber(), next.GetVersionNumber());
+
+    if((prev.GetTableId() != next.GetTableId()) || (prev.GetTableExtensionId() != next.GetTableExtensionId()))
+    {
+        OS_LOG(DVB_WARN, "<%s> Comparing different sub-tables: 0x%x.0x%x vs 0x%x.0x%x\n", __FUNCTION__,
+                prev.GetTableId(), prev.GetTableExtensionId(), next.GetTableId(), next.GetTableExtensionId());
+    }
+
+    Compare(GetSignature(prev), GetSignature(next), delta);
+
+    return delta;
+}
@@ -0,0 +1,99 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Switching between the synchronous and the asynchronous delivery while another thread parses:
+// no table or TDT is lost, and the observer statistics can be read meanwhile.
+
+#include <atomic>
+
+#include "TSectionBuilder.h"
+#include "TSectionParser.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t TRANSPORT_COUNT = 8;
+const uint32_t SECTION_COUNT = 20000;
+const uint32_t SWITCH_COUNT = 200;
+
+void CheckSwitchWhileParsing()
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  parser.RegisterDvbTableObserver(&recorder);
+
+  // Every SDT section is a new version of its sub-table, so every one is delivered
+  std::atomic<bool> isParsing(true);
+  uint32_t sdtCount = 0;
+  uint32_t tdtCount = 0;
+  std::thread producer([&]() {
+    std::vector<uint16_t> serviceIds(1, 0x10);
+    for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+      TSectionData data;
+      if (i % 4 == 3) {
+        data = BuildTdt(1400000000 + i);
+        tdtCount++;
+      }
+      else {
+        uint16_t tsId = 0x100 + sdtCount % TRANSPORT_COUNT;
+        uint8_t version = (sdtCount / TRANSPORT_COUNT) % 32;
+        data = BuildSdt(TTableId::TABLE_ID_SDT_OTHER, tsId, NETWORK_ID, version, serviceIds);
+        sdtCount++;
+      }
+      parser.ParseSiData(data.data(), data.size());
+    }
+    isParsing = false;
+  });
+
+  // A second observer comes and goes, its removal drops its pending events
+  TTableRecorder transient;
+  uint32_t switches = 0;
+  while (isParsing || (switches < SWITCH_COUNT)) {
+    parser.SetAsyncDelivery((switches % 2) ? 0 : 2, 16);
+    if (switches % 3 == 0) {
+      parser.RegisterDvbTableObserver(&transient);
+    }
+    else {
+      parser.RemoveDvbTableObserver(&transient);
+    }
+
+    TObserverDispatcherStats stats;
+    TSiPriorityStats priorityStats;
+    parser.GetObserverStats(&recorder, stats);
+    parser.GetPriorityStats(TSiPriority::SI_PRIORITY_SI, priorityStats);
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+    switches++;
+  }
+  producer.join();
+  parser.RemoveDvbTableObserver(&transient);
+
+  // Drains the last dispatcher
+  parser.SetAsyncDelivery(0, 0);
+  TEST_CHECK(recorder.GetTableCount() == sdtCount);
+  TEST_CHECK(recorder.GetTdtCount() == tdtCount);
+  printf("%u switches, %u SDT versions and %u TDT delivered\n", switches, sdtCount, tdtCount);
+}
+
+} // namespace
+
+int main()
+{
+  CheckSwitchWhileParsing();
+  return TestFailures ? 1 : 0;
+}
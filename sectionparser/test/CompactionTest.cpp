@@ -0,0 +1,102 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Compacted section lists: the repetitions of a complete table are recognized from its signature,
+// and with the CRCs kept a section changed without a version update restarts the assembly.
+
+#include "TSectionBuilder.h"
+#include "TSectionList.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+const uint8_t LAST_SECTION_NUMBER = 3;
+
+TSiSection MakeSdtSection(uint8_t version, uint8_t sectionNumber, const std::string& prefix = "svc")
+{
+  std::vector<uint16_t> serviceIds(1, 0x1000 + sectionNumber);
+  TSectionData data = BuildSection(TTableId::TABLE_ID_SDT_OTHER, TS_ID, version, sectionNumber, LAST_SECTION_NUMBER,
+    BuildSdtPayload(NETWORK_ID, serviceIds, prefix));
+  return TSiSection(data.data(), data.size());
+}
+
+// Assembles the table out of order, then compacts it
+void AssembleAndCompact(TSectionList& secList, bool keepCrc)
+{
+  const uint8_t order[] = {2, 0, 3, 1};
+  for (size_t i = 0; i < sizeof(order); i++) {
+    TSiSection section = MakeSdtSection(1, order[i]);
+    TEST_CHECK(secList.AddSiSection(section));
+  }
+  TEST_CHECK(secList.GetCompletenessFlag());
+
+  size_t usage = secList.GetMemoryUsage();
+  secList.Compact(keepCrc);
+  TEST_CHECK(secList.IsCompactedList());
+  TEST_CHECK(secList.GetMemoryUsage() < usage);
+  TEST_CHECK(secList.GetCompletenessFlag());
+  TEST_CHECK((secList.GetVersionNumber() == 1) && (secList.GetLastSectionNumber() == LAST_SECTION_NUMBER));
+}
+
+void CheckRepetitions(bool keepCrc)
+{
+  TSectionList secList;
+  AssembleAndCompact(secList, keepCrc);
+  for (uint8_t sectionNumber = 0; sectionNumber <= LAST_SECTION_NUMBER; sectionNumber++) {
+    TSiSection section = MakeSdtSection(1, sectionNumber);
+    TEST_CHECK(!secList.AddSiSection(section));
+  }
+  TEST_CHECK(secList.IsCompactedList());
+
+  // A new version starts over
+  TSiSection next = MakeSdtSection(2, 3);
+  TEST_CHECK(secList.AddSiSection(next));
+  TEST_CHECK(!secList.IsCompactedList() && !secList.GetCompletenessFlag());
+  TEST_CHECK(!secList.IsRevisedVersion());
+}
+
+void CheckRevision(bool keepCrc)
+{
+  // Every section is looked up at its own index of the CRC list
+  for (uint8_t changed = 0; changed <= LAST_SECTION_NUMBER; changed++) {
+    TSectionList secList;
+    AssembleAndCompact(secList, keepCrc);
+    for (uint8_t sectionNumber = 0; sectionNumber < changed; sectionNumber++) {
+      TSiSection section = MakeSdtSection(1, sectionNumber);
+      TEST_CHECK(!secList.AddSiSection(section));
+    }
+
+    TSiSection section = MakeSdtSection(1, changed, "new");
+    TEST_CHECK(secList.AddSiSection(section) == keepCrc);
+    TEST_CHECK(secList.IsRevisedVersion() == keepCrc);
+    TEST_CHECK(secList.IsCompactedList() != keepCrc);
+  }
+}
+
+} // namespace
+
+int main()
+{
+  CheckRepetitions(true);
+  CheckRepetitions(false);
+  CheckRevision(true);
+  CheckRevision(false);
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Delta events: the typed observers get OnDelta right after the new version of the sub-table,
+// the legacy observers a TABLE_DELTA_EVENT, with the synchronous and the asynchronous delivery.
+
+#include "TSectionBuilder.h"
+#include "TSectionParser.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+
+// Copies the delta events and checks that each follows a table of the same sub-table
+class TLegacyDeltaObserver : public IDvbSectionParserObserver
+{
+public:
+  TLegacyDeltaObserver()
+    : LastTableId(0),
+      OrderErrors(0)
+  {
+    // Empty
+  }
+
+  virtual void SendEvent(uint32_t eventType, void *eventData, size_t /*dataSize*/)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    if (eventType == TABLE_DELTA_EVENT) {
+      const TSiTableDelta* delta = static_cast<const TSiTableDelta*>(eventData);
+      if (delta->TableId != LastTableId) {
+        OrderErrors++;
+      }
+      Deltas.push_back(*delta);
+      LastTableId = 0;
+    }
+    else {
+      delete static_cast<TSiTable*>(eventData);
+      LastTableId = eventType;
+    }
+  }
+
+  std::mutex Mutex;
+  std::vector<TSiTableDelta> Deltas;
+  uint32_t LastTableId;
+  uint32_t OrderErrors;
+};
+
+void CheckDeltaDelivery(size_t workerCount)
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  TLegacyDeltaObserver legacy;
+  parser.SetTableDeltaEnabled(true);
+  parser.SetAsyncDelivery(workerCount, 16);
+  parser.RegisterDvbTableObserver(&recorder);
+  parser.RegisterDvbSectionParserObserver(&legacy);
+
+  // Version 1 adds 0x12 and drops 0x10, version 2 renames both services
+  std::vector<uint16_t> first;
+  first.push_back(0x10);
+  first.push_back(0x11);
+  std::vector<uint16_t> second;
+  second.push_back(0x11);
+  second.push_back(0x12);
+  std::vector<TSectionData> sections;
+  sections.push_back(BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, 0, first));
+  sections.push_back(BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, 1, second));
+  sections.push_back(BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, 2, second, "renamed"));
+  for (auto it = sections.begin(), end = sections.end(); it != end; ++it) {
+    parser.ParseSiData(it->data(), it->size());
+  }
+  parser.SetAsyncDelivery(0, 0);
+
+  // No delta for the first version
+  std::vector<std::shared_ptr<const TSiTableDelta>> deltas(recorder.GetDeltas());
+  TEST_CHECK(recorder.GetTableCount() == 3);
+  TEST_CHECK(deltas.size() == 2);
+  if (deltas.size() == 2) {
+    TEST_CHECK(deltas[0]->TableExtensionId == TS_ID);
+    TEST_CHECK((deltas[0]->PreviousVersionNumber == 0) && (deltas[0]->VersionNumber == 1));
+    TEST_CHECK((deltas[0]->AddedEntries.size() == 1) && (deltas[0]->AddedEntries[0] == 0x12));
+    TEST_CHECK((deltas[0]->RemovedEntries.size() == 1) && (deltas[0]->RemovedEntries[0] == 0x10));
+    TEST_CHECK(deltas[0]->ChangedEntries.empty());
+    TEST_CHECK(deltas[1]->AddedEntries.empty() && deltas[1]->RemovedEntries.empty());
+    TEST_CHECK((deltas[1]->ChangedEntries.size() == 2) && (deltas[1]->ChangedEntries[0] == 0x11));
+  }
+
+  std::lock_guard<std::mutex> lock(legacy.Mutex);
+  TEST_CHECK(legacy.Deltas.size() == 2);
+  TEST_CHECK(legacy.OrderErrors == 0);
+}
+
+} // namespace
+
+int main()
+{
+  CheckDeltaDelivery(0);
+  CheckDeltaDelivery(2);
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Default filters: the parser keeps their identifiers, so one range, e.g. the EIT schedule, can be
+// removed without reprogramming the whole bank.
+
+#include <set>
+
+#include "TSectionBuilder.h"
+#include "TSectionParser.h"
+
+namespace {
+
+bool IsAccepted(TSectionFilterBank& bank, uint8_t tableId)
+{
+  TSectionData data = BuildSection(tableId, 0x1001, 1, 0, 0, TSectionData());
+  return bank.IsMatch(data.data(), data.size());
+}
+
+void CheckDefaultFilters()
+{
+  TSectionParser parser;
+  TSectionFilterBank& bank = parser.GetFilterBank();
+  const TSectionFilterBank::TDefaultFilterIds& ids = parser.GetDefaultFilterIds();
+  TEST_CHECK(ids.size() == 10);
+
+  // Every range has its own filters
+  std::set<uint32_t> filterIds;
+  size_t filterCount = 0;
+  for (auto it = ids.begin(), end = ids.end(); it != end; ++it) {
+    TEST_CHECK(!it->second.empty());
+    filterIds.insert(it->second.begin(), it->second.end());
+    filterCount += it->second.size();
+  }
+  TEST_CHECK(filterIds.size() == filterCount);
+  TEST_CHECK(bank.GetHitCounts().size() == filterCount);
+
+  const uint8_t accepted[] = {0x40, 0x41, 0x42, 0x46, 0x4a, 0x4e, 0x4f, 0x50, 0x5f, 0x60, 0x6f, 0x70, 0x73, 0x80, 0xfe};
+  for (size_t i = 0; i < sizeof(accepted); i++) {
+    TEST_CHECK(IsAccepted(bank, accepted[i]));
+  }
+  const uint8_t rejected[] = {0x00, 0x02, 0x43, 0x4b, 0x71, 0x7e, 0xff};
+  for (size_t i = 0; i < sizeof(rejected); i++) {
+    TEST_CHECK(!IsAccepted(bank, rejected[i]));
+  }
+
+  // The section of a table_id is counted by the filters of its range
+  auto sched = ids.find(TTableId::TABLE_ID_EIT_SCHED_START);
+  TEST_CHECK(sched != ids.end());
+  uint64_t hits = 0;
+  for (auto it = sched->second.begin(), end = sched->second.end(); it != end; ++it) {
+    hits += bank.GetHitCount(*it);
+  }
+  TEST_CHECK(hits == 2);
+}
+
+void CheckRemoveRange()
+{
+  TSectionParser parser;
+  TSectionFilterBank& bank = parser.GetFilterBank();
+  const TSectionFilterBank::TDefaultFilterIds& ids = parser.GetDefaultFilterIds();
+
+  // Without the EIT schedule actual filters, only those sections are dropped
+  auto sched = ids.find(TTableId::TABLE_ID_EIT_SCHED_START);
+  TEST_CHECK(sched != ids.end());
+  for (auto it = sched->second.begin(), end = sched->second.end(); it != end; ++it) {
+    TEST_CHECK(bank.RemoveFilter(*it));
+  }
+  for (uint32_t tableId = TTableId::TABLE_ID_EIT_SCHED_START; tableId <= TTableId::TABLE_ID_EIT_SCHED_END; tableId++) {
+    TEST_CHECK(!IsAccepted(bank, (uint8_t)tableId));
+  }
+  TEST_CHECK(IsAccepted(bank, TTableId::TABLE_ID_EIT_PF));
+  TEST_CHECK(IsAccepted(bank, TTableId::TABLE_ID_EIT_SCHED_OTHER_START));
+  TEST_CHECK(IsAccepted(bank, TTableId::TABLE_ID_SDT));
+
+  // Added back, the range is accepted again
+  bank.AddTableIdRange(TTableId::TABLE_ID_EIT_SCHED_START, TTableId::TABLE_ID_EIT_SCHED_END);
+  TEST_CHECK(IsAccepted(bank, TTableId::TABLE_ID_EIT_SCHED_START));
+}
+
+} // namespace
+
+int main()
+{
+  CheckDefaultFilters();
+  CheckRemoveRange();
+  return TestFailures ? 1 : 0;
+}
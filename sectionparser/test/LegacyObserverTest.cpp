@@ -0,0 +1,109 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Legacy observers own the tables they receive: every SDT and TDT event carries a copy the
+// observer deletes, while the typed observers share the published instance.
+
+#include "TSectionBuilder.h"
+#include "TSectionParser.h"
+#include "TTotTable.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+
+// Deletes every table, as the observers written for the table-per-delivery interface do
+class TOwningObserver : public IDvbSectionParserObserver
+{
+public:
+  TOwningObserver()
+    : SdtCount(0),
+      TdtCount(0),
+      LastServiceCount(0),
+      LastUtcTimeBcd(0)
+  {
+    // Empty
+  }
+
+  virtual void SendEvent(uint32_t eventType, void *eventData, size_t /*dataSize*/)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    if (eventType == TTableId::TABLE_ID_SDT_OTHER) {
+      TSdtTable* sdt = static_cast<TSdtTable*>(eventData);
+      LastServiceCount = sdt->GetServices().size();
+      SdtCount++;
+      delete sdt;
+    }
+    else if (eventType == TTableId::TABLE_ID_TDT) {
+      TTotTable* tdt = static_cast<TTotTable*>(eventData);
+      LastUtcTimeBcd = tdt->GetUtcTimeBcd();
+      TdtCount++;
+      delete tdt;
+    }
+  }
+
+  std::mutex Mutex;
+  uint32_t SdtCount;
+  uint32_t TdtCount;
+  size_t LastServiceCount;
+  uint64_t LastUtcTimeBcd;
+};
+
+void CheckOwnership(size_t workerCount)
+{
+  TSectionParser parser;
+  TOwningObserver legacy;
+  TTableRecorder recorder;
+  parser.SetAsyncDelivery(workerCount, 16);
+  parser.RegisterDvbSectionParserObserver(&legacy);
+  parser.RegisterDvbTableObserver(&recorder);
+
+  std::vector<uint16_t> serviceIds;
+  for (uint8_t version = 0; version < 4; version++) {
+    serviceIds.push_back(0x1000 + version);
+    TSectionData sdt = BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, version, serviceIds);
+    parser.ParseSiData(sdt.data(), sdt.size());
+    TSectionData tdt = BuildTdt(1400000000 + version);
+    parser.ParseSiData(tdt.data(), tdt.size());
+  }
+  parser.SetAsyncDelivery(0, 0);
+
+  std::lock_guard<std::mutex> lock(legacy.Mutex);
+  TEST_CHECK(legacy.SdtCount == 4);
+  TEST_CHECK(legacy.LastServiceCount == 4);
+  TEST_CHECK(legacy.TdtCount == 4);
+  TEST_CHECK(legacy.LastUtcTimeBcd == EncodeMjdUtc(1400000003));
+
+  // The published table is still intact after the legacy observer deleted its copy
+  std::shared_ptr<const TSdtTable> published(
+    std::static_pointer_cast<const TSdtTable>(parser.GetTable(TSectionKey(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID))));
+  TEST_CHECK(published && (published->GetServices().size() == 4));
+  TEST_CHECK(recorder.GetTableCount() == 4);
+  parser.RemoveDvbSectionParserObserver(&legacy);
+}
+
+} // namespace
+
+int main()
+{
+  CheckOwnership(0);
+  CheckOwnership(2);
+  return TestFailures ? 1 : 0;
+}
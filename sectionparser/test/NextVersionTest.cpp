@@ -0,0 +1,114 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Sections with current_next_indicator = 0: the next version is assembled aside, published on the
+// first current section of that version, and dropped when the broadcaster switches to another one.
+
+#include "TSectionBuilder.h"
+#include "TSectionParser.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+
+// Section of a two-section SDT, one service per section
+void ParseSdtSection(TSectionParser& parser, uint8_t version, uint8_t sectionNumber, bool isCurrent)
+{
+  std::vector<uint16_t> serviceIds(1, 0x1000 + version * 0x10 + sectionNumber);
+  TSectionData data = BuildSection(TTableId::TABLE_ID_SDT_OTHER, TS_ID, version, sectionNumber, 1,
+    BuildSdtPayload(NETWORK_ID, serviceIds), isCurrent);
+  parser.ParseSiData(data.data(), data.size());
+}
+
+void ParseSdt(TSectionParser& parser, uint8_t version, bool isCurrent)
+{
+  ParseSdtSection(parser, version, 0, isCurrent);
+  ParseSdtSection(parser, version, 1, isCurrent);
+}
+
+uint8_t GetPublishedVersion(TSectionParser& parser)
+{
+  std::shared_ptr<const TSiTable> tbl(parser.GetTable(TTableId::TABLE_ID_SDT_OTHER, TS_ID));
+  return tbl ? tbl->GetVersionNumber() : 0xff;
+}
+
+void CheckActivation()
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  parser.RegisterDvbTableObserver(&recorder);
+  ParseSdt(parser, 1, true);
+  TEST_CHECK(recorder.GetTableCount() == 1);
+
+  // The next version is not published, however often it is repeated
+  ParseSdt(parser, 2, false);
+  ParseSdt(parser, 2, false);
+  TEST_CHECK(recorder.GetTableCount() == 1);
+  TEST_CHECK(GetPublishedVersion(parser) == 1);
+
+  // Any current section of that version activates the whole table
+  ParseSdtSection(parser, 2, 1, true);
+  TEST_CHECK(recorder.GetTableCount() == 2);
+  std::shared_ptr<const TSdtTable> sdt(
+    std::static_pointer_cast<const TSdtTable>(parser.GetTable(TTableId::TABLE_ID_SDT_OTHER, TS_ID)));
+  TEST_CHECK(sdt && (sdt->GetVersionNumber() == 2) && sdt->IsCurrentNextIndicator());
+  TEST_CHECK(sdt && (sdt->GetServices().size() == 2));
+
+  // The repetitions of the activated version are ignored
+  ParseSdt(parser, 2, true);
+  TEST_CHECK(recorder.GetTableCount() == 2);
+  parser.RemoveDvbTableObserver(&recorder);
+}
+
+void CheckStaleVersion()
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  parser.RegisterDvbTableObserver(&recorder);
+  ParseSdt(parser, 1, true);
+
+  // The broadcaster skips the announced version 2: the pre-built table is dropped
+  ParseSdt(parser, 2, false);
+  ParseSdt(parser, 3, true);
+  TEST_CHECK(recorder.GetTableCount() == 2);
+  TEST_CHECK(GetPublishedVersion(parser) == 3);
+  ParseSdtSection(parser, 2, 0, true);
+  TEST_CHECK(recorder.GetTableCount() == 2);
+  ParseSdtSection(parser, 2, 1, true);
+  TEST_CHECK(recorder.GetTableCount() == 3);
+
+  // Switching to a next version that is still incomplete: the current assembly takes over
+  ParseSdtSection(parser, 4, 0, false);
+  ParseSdtSection(parser, 4, 1, true);
+  TEST_CHECK(recorder.GetTableCount() == 3);
+  ParseSdtSection(parser, 4, 0, true);
+  TEST_CHECK(recorder.GetTableCount() == 4);
+  TEST_CHECK(GetPublishedVersion(parser) == 4);
+  parser.RemoveDvbTableObserver(&recorder);
+}
+
+} // namespace
+
+int main()
+{
+  CheckActivation();
+  CheckStaleVersion();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Observer dispatcher: the pending events are delivered highest class first and in order within a
+// class, the EIT classes are shed at their fill levels, to make room in a full queue and when the
+// higher classes run late.
+
+#include <atomic>
+
+#include "TSectionBuilder.h"
+#include "TObserverDispatcher.h"
+
+namespace {
+
+// Holds a worker in a delivery until it is opened
+class TGate
+{
+public:
+  TGate()
+    : IsEntered(false),
+      IsOpen(false)
+  {
+    // Empty
+  }
+
+  TObserverDispatcher::Task_t GetTask()
+  {
+    return [this]() {
+      IsEntered = true;
+      while (!IsOpen) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    };
+  }
+
+  void WaitEntered()
+  {
+    while (!IsEntered) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  void Open()
+  {
+    IsOpen = true;
+  }
+
+private:
+  std::atomic<bool> IsEntered;
+  std::atomic<bool> IsOpen;
+};
+
+class TOrderLog
+{
+public:
+  TObserverDispatcher::Task_t GetTask(int id)
+  {
+    return [this, id]() {
+      std::lock_guard<std::mutex> lock(Mutex);
+      Ids.push_back(id);
+    };
+  }
+
+  std::vector<int> GetIds()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Ids;
+  }
+
+private:
+  std::mutex Mutex;
+  std::vector<int> Ids;
+};
+
+void CheckOrdering()
+{
+  TObserverDispatcher dispatcher(1, 16);
+  TGate gate;
+  TOrderLog log;
+  int observer = 0;
+  dispatcher.Post(&observer, gate.GetTask());
+  gate.WaitEntered();
+
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(1), TSiPriority::SI_PRIORITY_SI));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(2), TSiPriority::SI_PRIORITY_EIT_SCHED));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(3), TSiPriority::SI_PRIORITY_TIME));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(4), TSiPriority::SI_PRIORITY_SI));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(5), TSiPriority::SI_PRIORITY_EIT_PF));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(6), TSiPriority::SI_PRIORITY_EIT_OTHER));
+  gate.Open();
+  dispatcher.WaitIdle();
+
+  std::vector<int> expected = {3, 5, 1, 4, 2, 6};
+  TEST_CHECK(log.GetIds() == expected);
+
+  TObserverDispatcherStats stats;
+  TEST_CHECK(dispatcher.GetStats(&observer, stats));
+  TEST_CHECK((stats.DeliveredEvents == 7) && (stats.MaxQueueDepth == 6) && (stats.ShedEvents == 0));
+  TEST_CHECK(dispatcher.GetPriorityStats(TSiPriority::SI_PRIORITY_SI).DeliveredEvents == 3);
+}
+
+void CheckFillShedding()
+{
+  const size_t capacity = 8;
+  TObserverDispatcher dispatcher(1, capacity);
+  TGate gate;
+  TOrderLog log;
+  std::atomic<int> shedCount(0);
+  TObserverDispatcher::Task_t onShed = [&shedCount]() { shedCount++; };
+  int observer = 0;
+  dispatcher.Post(&observer, gate.GetTask());
+  gate.WaitEntered();
+
+  for (int id = 0; id < 4; id++) {
+    TEST_CHECK(dispatcher.Post(&observer, log.GetTask(id), TSiPriority::SI_PRIORITY_SI, onShed));
+  }
+
+  // Half full: EIT other is shed, EIT schedule actual until three quarters
+  TEST_CHECK(!dispatcher.Post(&observer, log.GetTask(10), TSiPriority::SI_PRIORITY_EIT_OTHER, onShed));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(11), TSiPriority::SI_PRIORITY_EIT_SCHED, onShed));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(12), TSiPriority::SI_PRIORITY_EIT_SCHED, onShed));
+  TEST_CHECK(!dispatcher.Post(&observer, log.GetTask(13), TSiPriority::SI_PRIORITY_EIT_SCHED, onShed));
+  TEST_CHECK(shedCount == 2);
+
+  // Full: the queued EIT schedule events make room for the SI, oldest first
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(4), TSiPriority::SI_PRIORITY_SI, onShed));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(5), TSiPriority::SI_PRIORITY_SI, onShed));
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(6), TSiPriority::SI_PRIORITY_SI, onShed));
+  TEST_CHECK(shedCount == 3);
+  TEST_CHECK(dispatcher.Post(&observer, log.GetTask(7), TSiPriority::SI_PRIORITY_SI, onShed));
+  TEST_CHECK(shedCount == 4);
+
+  TObserverDispatcherStats stats;
+  TEST_CHECK(dispatcher.GetStats(&observer, stats));
+  TEST_CHECK((stats.ShedEvents == 4) && (stats.BlockedPosts == 0) && (stats.QueueDepth == capacity));
+  gate.Open();
+  dispatcher.WaitIdle();
+
+  std::vector<int> expected = {0, 1, 2, 3, 4, 5, 6, 7};
+  TEST_CHECK(log.GetIds() == expected);
+  TEST_CHECK(dispatcher.GetPriorityStats(TSiPriority::SI_PRIORITY_EIT_SCHED).ShedEvents == 3);
+  TEST_CHECK(dispatcher.GetPriorityStats(TSiPriority::SI_PRIORITY_EIT_OTHER).ShedEvents == 1);
+}
+
+void CheckLatencyShedding()
+{
+  TObserverDispatcher dispatcher(1, 16);
+  dispatcher.SetLatencyTarget(100);
+  TGate gate;
+  TOrderLog log;
+  int slow = 0;
+  int held = 0;
+  int eit = 0;
+
+  // The slow SI delivery completes with a backlog behind it: the higher classes run late
+  dispatcher.Post(&slow, []() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+  dispatcher.Post(&held, gate.GetTask());
+  gate.WaitEntered();
+  TEST_CHECK(!dispatcher.Post(&eit, log.GetTask(1), TSiPriority::SI_PRIORITY_EIT_SCHED));
+  TEST_CHECK(dispatcher.Post(&eit, log.GetTask(2), TSiPriority::SI_PRIORITY_SI));
+
+  // The backlog is gone, so is the overload
+  gate.Open();
+  dispatcher.WaitIdle();
+  TEST_CHECK(dispatcher.Post(&eit, log.GetTask(3), TSiPriority::SI_PRIORITY_EIT_SCHED));
+  dispatcher.WaitIdle();
+  std::vector<int> expected = {2, 3};
+  TEST_CHECK(log.GetIds() == expected);
+}
+
+} // namespace
+
+int main()
+{
+  CheckOrdering();
+  CheckFillShedding();
+  CheckLatencyShedding();
+  return TestFailures ? 1 : 0;
+}
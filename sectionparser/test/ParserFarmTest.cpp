@@ -0,0 +1,187 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Parser farm: the sections of an instance are parsed in order and never by two workers at once,
+// an idle worker steals the instances of a busy one, full queues and CRC errors are counted.
+
+#include <atomic>
+#include <set>
+
+#include "TSectionBuilder.h"
+#include "TSectionParserFarm.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const size_t WORKER_COUNT = 2;
+const size_t INSTANCE_COUNT = 4;
+const uint32_t VERSION_COUNT = 200;
+const uint32_t DELAY_US = 200;
+
+// Records the threads an instance ran on and checks the order and exclusiveness of its tables
+class TInstanceObserver : public IDvbTableObserver
+{
+public:
+  TInstanceObserver()
+    : Running(0),
+      OverlapErrors(0),
+      OrderErrors(0),
+      TableCount(0)
+  {
+    // Empty
+  }
+
+  virtual void OnSdt(const std::shared_ptr<const TSdtTable>& sdt)
+  {
+    if (Running++ != 0) {
+      OverlapErrors++;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(DELAY_US));
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      if (sdt->GetVersionNumber() != TableCount % 32) {
+        OrderErrors++;
+      }
+      TableCount++;
+      Threads.insert(std::this_thread::get_id());
+    }
+    Running--;
+  }
+
+  std::atomic<int> Running;
+  std::atomic<uint32_t> OverlapErrors;
+  std::mutex Mutex;
+  uint32_t OrderErrors;
+  uint32_t TableCount;
+  std::set<std::thread::id> Threads;
+};
+
+// Every section is a new version of the SDT, so every one is delivered
+TSectionData MakeSdt(uint32_t index)
+{
+  return BuildSdt(TTableId::TABLE_ID_SDT_OTHER, 0x100, NETWORK_ID, index % 32, std::vector<uint16_t>(1, 0x1000));
+}
+
+void CheckStealing()
+{
+  TSectionParserFarm farm(WORKER_COUNT, VERSION_COUNT);
+  std::vector<uint32_t> ids;
+  std::vector<std::unique_ptr<TInstanceObserver>> observers;
+  for (size_t i = 0; i < INSTANCE_COUNT; i++) {
+    ids.push_back(farm.CreateParser());
+    observers.push_back(std::unique_ptr<TInstanceObserver>(new TInstanceObserver()));
+    farm.GetParser(ids.back())->RegisterDvbTableObserver(observers.back().get());
+  }
+
+  // Only the instances of one worker get sections, the other worker has to steal them
+  std::vector<size_t> busy;
+  for (size_t i = 0; i < INSTANCE_COUNT; i++) {
+    if (ids[i] % WORKER_COUNT == 0) {
+      busy.push_back(i);
+    }
+  }
+  for (uint32_t version = 0; version < VERSION_COUNT; version++) {
+    for (auto it = busy.begin(), end = busy.end(); it != end; ++it) {
+      TSectionData data = MakeSdt(version);
+      TEST_CHECK(farm.Submit(ids[*it], data.data(), data.size()));
+    }
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::set<std::thread::id> threads;
+  for (auto it = busy.begin(), end = busy.end(); it != end; ++it) {
+    TInstanceObserver& observer = *observers[*it];
+    while (ElapsedMs(start) < 30000) {
+      {
+        std::lock_guard<std::mutex> lock(observer.Mutex);
+        if (observer.TableCount == VERSION_COUNT) {
+          break;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    std::lock_guard<std::mutex> lock(observer.Mutex);
+    TEST_CHECK(observer.TableCount == VERSION_COUNT);
+    TEST_CHECK(observer.OrderErrors == 0);
+    TEST_CHECK(observer.OverlapErrors == 0);
+    threads.insert(observer.Threads.begin(), observer.Threads.end());
+
+    TParserInstanceStats stats;
+    TEST_CHECK(farm.GetStats(ids[*it], stats));
+    TEST_CHECK((stats.ParsedSections == VERSION_COUNT) && (stats.DroppedSections == 0));
+  }
+  TEST_CHECK(threads.size() == WORKER_COUNT);
+  printf("%zu instances of one worker parsed on %zu workers in %lld ms\n", busy.size(), threads.size(),
+    (long long)ElapsedMs(start));
+
+  for (size_t i = 0; i < INSTANCE_COUNT; i++) {
+    farm.GetParser(ids[i])->RemoveDvbTableObserver(observers[i].get());
+    farm.DestroyParser(ids[i]);
+  }
+  TEST_CHECK(!farm.GetParser(ids.front()));
+}
+
+void CheckDrops()
+{
+  TSectionParserFarm farm(1, 4);
+  farm.SetCrcCheck(true);
+  uint32_t id = farm.CreateParser();
+  TInstanceObserver observer;
+  farm.GetParser(id)->RegisterDvbTableObserver(&observer);
+
+  // The first sections keep the worker busy while the queue fills up
+  uint32_t submitted = 0;
+  uint32_t dropped = 0;
+  for (uint32_t i = 0; i < 40; i++) {
+    TSectionData data = MakeSdt(i);
+    if (i == 1) {
+      data[data.size() - 1] ^= 0xff;
+    }
+    if (farm.Submit(id, data.data(), data.size())) {
+      submitted++;
+    }
+    else {
+      dropped++;
+    }
+  }
+  TEST_CHECK(dropped > 0);
+
+  TParserInstanceStats stats;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  do {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    farm.GetStats(id, stats);
+  } while ((stats.ParsedSections + stats.CrcErrors < submitted) && (ElapsedMs(start) < 10000));
+  TEST_CHECK(stats.DroppedSections == dropped);
+  TEST_CHECK(stats.CrcErrors == 1);
+  TEST_CHECK(stats.ParsedSections == submitted - 1);
+  TEST_CHECK(stats.MaxQueueDepth <= 4);
+  farm.GetParser(id)->RemoveDvbTableObserver(&observer);
+  farm.DestroyParser(id);
+}
+
+} // namespace
+
+int main()
+{
+  CheckStealing();
+  CheckDrops();
+  return TestFailures ? 1 : 0;
+}
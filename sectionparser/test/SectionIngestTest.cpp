@@ -0,0 +1,125 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Section ingest ring: the sections come out intact and in order after many wrap-arounds, the
+// headroom keeps room for the tables other than EIT schedule, and a full ring drops sections.
+
+#include "TSectionBuilder.h"
+#include "TSectionIngest.h"
+#include "TSectionParser.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+const uint32_t SECTION_COUNT = 5000;
+
+// Every section is a new version of the SDT with its own service
+TSectionData MakeSdt(uint32_t index)
+{
+  return BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, index % 32,
+    std::vector<uint16_t>(1, (uint16_t)index));
+}
+
+TSectionData MakeEitSchedule()
+{
+  std::vector<TTestEvent> events(1, TTestEvent{1, 1400000000, 0x010000});
+  return BuildEit(TTableId::TABLE_ID_EIT_SCHED_OTHER_START, 0x1001, TS_ID, NETWORK_ID, 1, 0, 0, events);
+}
+
+void CheckWrapAround()
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  parser.RegisterDvbTableObserver(&recorder);
+  TSectionIngestStats stats;
+  {
+    // Rounded up to 8 slots
+    TSectionIngest ingest(parser, 5, 0);
+    for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+      TSectionData data = MakeSdt(i);
+      while (!ingest.Push(data.data(), data.size())) {
+        std::this_thread::yield();
+      }
+    }
+    stats = ingest.GetStats();
+    TEST_CHECK(stats.PushedSections == SECTION_COUNT);
+    TEST_CHECK(stats.MaxFill <= 8);
+  }
+
+  // The destructor parsed the rest
+  std::vector<std::shared_ptr<const TSiTable>> tables(recorder.GetTables());
+  TEST_CHECK(tables.size() == SECTION_COUNT);
+  uint32_t errors = 0;
+  for (size_t i = 0; i < tables.size(); i++) {
+    const std::vector<TSdtService>& services = std::static_pointer_cast<const TSdtTable>(tables[i])->GetServices();
+    if ((services.size() != 1) || (services.front().GetServiceId() != (uint16_t)i)) {
+      errors++;
+    }
+  }
+  TEST_CHECK(errors == 0);
+  printf("%u sections through 8 slots, %llu overflows, max fill %zu\n", SECTION_COUNT,
+    (unsigned long long)stats.OverflowDrops, stats.MaxFill);
+  parser.RemoveDvbTableObserver(&recorder);
+}
+
+void CheckHeadroom()
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  recorder.SetDelayUs(100000);
+  parser.RegisterDvbTableObserver(&recorder);
+  TSectionIngest ingest(parser, 8, 3);
+
+  // The first SDT holds the consumer up, its slot is released once it is parsed
+  uint32_t index = 0;
+  for (; index < 4; index++) {
+    TSectionData data = MakeSdt(index);
+    TEST_CHECK(ingest.Push(data.data(), data.size()));
+  }
+  TSectionData eit = MakeEitSchedule();
+  TEST_CHECK(ingest.Push(eit.data(), eit.size()));
+
+  // 3 free slots left: reserved for the other tables
+  TEST_CHECK(!ingest.Push(eit.data(), eit.size()));
+  for (; index < 7; index++) {
+    TSectionData data = MakeSdt(index);
+    TEST_CHECK(ingest.Push(data.data(), data.size()));
+  }
+  TSectionData data = MakeSdt(index);
+  TEST_CHECK(!ingest.Push(data.data(), data.size()));
+  TEST_CHECK(!ingest.Push(data.data(), 0));
+
+  TSectionIngestStats stats = ingest.GetStats();
+  TEST_CHECK(stats.PushedSections == 8);
+  TEST_CHECK(stats.HeadroomDrops == 1);
+  TEST_CHECK(stats.OverflowDrops == 1);
+  TEST_CHECK(stats.InvalidDrops == 1);
+  TEST_CHECK(stats.MaxFill == 8);
+  parser.RemoveDvbTableObserver(&recorder);
+}
+
+} // namespace
+
+int main()
+{
+  CheckWrapAround();
+  CheckHeadroom();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Sub-table keys: EIT and SDT sub-tables of different networks or transports are kept apart, and
+// the sections of one sub-table received from two inputs are assembled separately.
+
+#include "TSectionBuilder.h"
+#include "TSectionKey.h"
+#include "TSectionParser.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t OTHER_NETWORK_ID = 0x4321;
+const uint16_t TS_ID = 0x100;
+const uint16_t OTHER_TS_ID = 0x200;
+const uint16_t SERVICE_ID = 0x1001;
+
+TSiSection MakeSection(const TSectionData& data)
+{
+  TSectionData copy(data);
+  return TSiSection(copy.data(), copy.size());
+}
+
+void CheckOrdering()
+{
+  // Stream context first, then table id, extension, original_network_id and transport_stream_id
+  std::vector<TSectionKey> keys;
+  keys.push_back(TSectionKey(0x4e, 0x10, 1, 1, 0));
+  keys.push_back(TSectionKey(0x4e, 0x10, 1, 2, 0));
+  keys.push_back(TSectionKey(0x4e, 0x10, 2, 0, 0));
+  keys.push_back(TSectionKey(0x4e, 0x11, 0, 0, 0));
+  keys.push_back(TSectionKey(0x50, 0x00, 0, 0, 0));
+  keys.push_back(TSectionKey(0x40, 0x00, 0, 0, 1));
+  for (size_t i = 0; i < keys.size(); i++) {
+    TEST_CHECK(!(keys[i] < keys[i]));
+    for (size_t j = i + 1; j < keys.size(); j++) {
+      TEST_CHECK(keys[i] < keys[j]);
+      TEST_CHECK(!(keys[j] < keys[i]));
+    }
+  }
+
+  TSectionKey content = keys.back().GetContentKey();
+  TEST_CHECK((content.StreamContext == 0) && (content.TableId == 0x40));
+}
+
+void CheckSectionKeys()
+{
+  std::vector<TTestEvent> events(1, TTestEvent{1, 1400000000, 0x010000});
+  TSectionKey eit(MakeSection(BuildEit(TTableId::TABLE_ID_EIT_PF_OTHER, SERVICE_ID, OTHER_TS_ID, OTHER_NETWORK_ID,
+    1, 0, 0, events)), 3);
+  TEST_CHECK((eit.ExtensionTableId == SERVICE_ID) && (eit.TransportStreamId == OTHER_TS_ID));
+  TEST_CHECK((eit.OriginalNetworkId == OTHER_NETWORK_ID) && (eit.StreamContext == 3));
+
+  TSectionKey sdt(MakeSection(BuildSdt(TTableId::TABLE_ID_SDT_OTHER, OTHER_TS_ID, OTHER_NETWORK_ID, 1,
+    std::vector<uint16_t>(1, SERVICE_ID))), 0);
+  TEST_CHECK((sdt.ExtensionTableId == OTHER_TS_ID) && (sdt.OriginalNetworkId == OTHER_NETWORK_ID));
+  TEST_CHECK(sdt.TransportStreamId == 0);
+}
+
+void CheckParserKeys()
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  parser.RegisterDvbTableObserver(&recorder);
+
+  // The same service_id on two transports and two networks: three EIT sub-tables
+  std::vector<TTestEvent> events(1, TTestEvent{1, 1400000000, 0x010000});
+  TSectionData data = BuildEit(TTableId::TABLE_ID_EIT_PF_OTHER, SERVICE_ID, TS_ID, NETWORK_ID, 1, 0, 0, events);
+  parser.ParseSiData(data.data(), data.size());
+  data = BuildEit(TTableId::TABLE_ID_EIT_PF_OTHER, SERVICE_ID, OTHER_TS_ID, NETWORK_ID, 1, 0, 0, events);
+  parser.ParseSiData(data.data(), data.size());
+  data = BuildEit(TTableId::TABLE_ID_EIT_PF_OTHER, SERVICE_ID, TS_ID, OTHER_NETWORK_ID, 1, 0, 0, events);
+  parser.ParseSiData(data.data(), data.size());
+  TEST_CHECK(recorder.GetTableCount() == 3);
+  TEST_CHECK(parser.GetTable(TSectionKey(TTableId::TABLE_ID_EIT_PF_OTHER, SERVICE_ID, OTHER_NETWORK_ID, TS_ID)));
+
+  // Two inputs carrying different versions of an SDT do not reset each other's assembly
+  std::vector<uint16_t> serviceIds(1, SERVICE_ID);
+  recorder.Clear();
+  for (uint8_t sectionNumber = 0; sectionNumber < 2; sectionNumber++) {
+    data = BuildSection(TTableId::TABLE_ID_SDT_OTHER, TS_ID, 1, sectionNumber, 1,
+      BuildSdtPayload(NETWORK_ID, serviceIds));
+    parser.ParseSiData(data.data(), data.size(), 1);
+    data = BuildSection(TTableId::TABLE_ID_SDT_OTHER, TS_ID, 2, sectionNumber, 1,
+      BuildSdtPayload(NETWORK_ID, serviceIds));
+    parser.ParseSiData(data.data(), data.size(), 2);
+  }
+  TEST_CHECK(recorder.GetTableCount() == 2);
+  std::shared_ptr<const TSiTable> sdt(parser.GetTable(TSectionKey(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID)));
+  TEST_CHECK(sdt && (sdt->GetVersionNumber() == 2));
+  parser.RemoveDvbTableObserver(&recorder);
+}
+
+} // namespace
+
+int main()
+{
+  CheckOrdering();
+  CheckSectionKeys();
+  CheckParserKeys();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// The section store: sorted insertion in both modes, and the EIT p/f sub-tables assembled
+// in the fixed slots whatever the order of their two sections.
+
+#include "TSectionBuilder.h"
+#include "TSectionList.h"
+#include "TSectionParser.h"
+#include "TSectionStore.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+const uint16_t SERVICE_ID = 0x1001;
+
+TSiSection MakeSection(const TSectionData& data)
+{
+  TSectionData copy(data);
+  return TSiSection(copy.data(), copy.size());
+}
+
+TSiSection MakePfSection(uint8_t version, uint8_t sectionNumber, uint16_t eventId)
+{
+  std::vector<TTestEvent> events(1, TTestEvent{eventId, 1400000000 + eventId * 3600, 0x010000});
+  return MakeSection(BuildEit(TTableId::TABLE_ID_EIT_PF, SERVICE_ID, TS_ID, NETWORK_ID, version, sectionNumber, 1,
+    events));
+}
+
+void CheckStore(bool useFixedSlots)
+{
+  TSectionStore store;
+  store.Reset(useFixedSlots);
+  TEST_CHECK(store.empty());
+
+  TEST_CHECK(store.Insert(MakePfSection(1, 1, 2)));
+  TEST_CHECK(store.Insert(MakePfSection(1, 0, 1)));
+  TEST_CHECK(!store.Insert(MakePfSection(1, 1, 2)));
+  TEST_CHECK(store.size() == 2);
+  TEST_CHECK(store.front().SectionNumber == 0);
+  TEST_CHECK((store.end() - 1)->SectionNumber == 1);
+
+  // The fixed slots hold two sections at most
+  TEST_CHECK(store.Insert(MakePfSection(1, 2, 3)) == !useFixedSlots);
+
+  // Cleared fixed slots keep their payload buffers
+  size_t usage = store.GetMemoryUsage();
+  store.clear();
+  TEST_CHECK(store.empty());
+  TEST_CHECK(useFixedSlots ? (store.GetMemoryUsage() > usage) : (store.GetMemoryUsage() == 0));
+
+  TSectionStore other;
+  store.Insert(MakePfSection(2, 0, 1));
+  other.swap(store);
+  TEST_CHECK(store.empty());
+  TEST_CHECK((other.size() == 1) && (other.front().VersionNumber == 2));
+}
+
+void CheckPfAssembly()
+{
+  TSectionList secList;
+  TSiSection second = MakePfSection(3, 1, 2);
+  TSiSection first = MakePfSection(3, 0, 1);
+  TEST_CHECK(secList.AddSiSection(second));
+  TEST_CHECK(!secList.GetCompletenessFlag());
+  TEST_CHECK(secList.AddSiSection(first));
+  TEST_CHECK(secList.GetCompletenessFlag());
+
+  std::unique_ptr<TSiTable> tbl(secList.BuildTable());
+  TEitTable* eit = dynamic_cast<TEitTable*>(tbl.get());
+  TEST_CHECK(eit && (eit->GetEvents().size() == 2));
+  TEST_CHECK(eit && (eit->GetEvents()[0].GetEventId() == 1) && (eit->GetEvents()[1].GetEventId() == 2));
+
+  // A new version starts over in the same slots
+  TSiSection next = MakePfSection(4, 0, 5);
+  TEST_CHECK(secList.AddSiSection(next));
+  TEST_CHECK(!secList.GetCompletenessFlag());
+  TEST_CHECK(secList.GetVersionNumber() == 4);
+}
+
+void CheckParserDelivery()
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  parser.RegisterDvbTableObserver(&recorder);
+
+  std::vector<TTestEvent> present(1, TTestEvent{1, 1400000000, 0x010000});
+  std::vector<TTestEvent> following(1, TTestEvent{2, 1400003600, 0x010000});
+  for (uint8_t version = 0; version < 4; version++) {
+    for (int repetition = 0; repetition < 3; repetition++) {
+      TSectionData data = BuildEit(TTableId::TABLE_ID_EIT_PF, SERVICE_ID, TS_ID, NETWORK_ID, version, 1, 1, following);
+      parser.ParseSiData(data.data(), data.size());
+      data = BuildEit(TTableId::TABLE_ID_EIT_PF, SERVICE_ID, TS_ID, NETWORK_ID, version, 0, 1, present);
+      parser.ParseSiData(data.data(), data.size());
+    }
+  }
+  TEST_CHECK(recorder.GetTableCount() == 4);
+  TEST_CHECK(parser.GetFastPathStats().EitPfTables == 4);
+  parser.RemoveDvbTableObserver(&recorder);
+}
+
+} // namespace
+
+int main()
+{
+  CheckStore(true);
+  CheckStore(false);
+  CheckPfAssembly();
+  CheckParserDelivery();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Version-to-version comparison: the added, removed and changed services of an SDT and events
+// of an EIT, each list in ascending identifier order.
+
+#include "TSectionBuilder.h"
+#include "TSectionList.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+const uint16_t SERVICE_ID = 0x1001;
+
+// Assembles a single section table
+std::shared_ptr<TSiTable> BuildTable(const TSectionData& data)
+{
+  TSectionData copy(data);
+  TSiSection section(copy.data(), copy.size());
+  TSectionList secList;
+  secList.AddSiSection(section);
+  TEST_CHECK(secList.GetCompletenessFlag());
+  return std::shared_ptr<TSiTable>(secList.BuildTable());
+}
+
+std::vector<uint16_t> MakeIds(std::initializer_list<uint16_t> ids)
+{
+  return std::vector<uint16_t>(ids);
+}
+
+void CheckSignatures()
+{
+  TSiTableSignature prev;
+  TSiTableSignature next;
+  prev[1] = 10;
+  prev[2] = 20;
+  prev[4] = 40;
+  next[2] = 21;
+  next[3] = 30;
+  next[4] = 40;
+  next[5] = 50;
+
+  TSiTableDelta delta(TTableId::TABLE_ID_SDT, TS_ID, 1, 2);
+  TSiTableDiff::Compare(prev, next, delta);
+  TEST_CHECK(delta.AddedEntries == MakeIds({3, 5}));
+  TEST_CHECK(delta.RemovedEntries == MakeIds({1}));
+  TEST_CHECK(delta.ChangedEntries == MakeIds({2}));
+
+  TSiTableDelta same(TTableId::TABLE_ID_SDT, TS_ID, 1, 2);
+  TSiTableDiff::Compare(prev, prev, same);
+  TEST_CHECK(same.IsEmpty());
+
+  TSiTableDelta emptied(TTableId::TABLE_ID_SDT, TS_ID, 1, 2);
+  TSiTableDiff::Compare(prev, TSiTableSignature(), emptied);
+  TEST_CHECK(emptied.RemovedEntries == MakeIds({1, 2, 4}));
+  TEST_CHECK(emptied.AddedEntries.empty() && emptied.ChangedEntries.empty());
+}
+
+void CheckSdt()
+{
+  std::shared_ptr<TSiTable> prev = BuildTable(BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, 1,
+    MakeIds({0x10, 0x11, 0x12})));
+  std::shared_ptr<TSiTable> next = BuildTable(BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, 2,
+    MakeIds({0x11, 0x12, 0x13})));
+  TEST_CHECK(prev && next);
+  if (!prev || !next) {
+    return;
+  }
+
+  TSiTableDelta delta = TSiTableDiff::Compare(*prev, *next);
+  TEST_CHECK((delta.TableId == TTableId::TABLE_ID_SDT_OTHER) && (delta.TableExtensionId == TS_ID));
+  TEST_CHECK((delta.PreviousVersionNumber == 1) && (delta.VersionNumber == 2));
+  TEST_CHECK(delta.AddedEntries == MakeIds({0x13}));
+  TEST_CHECK(delta.RemovedEntries == MakeIds({0x10}));
+  TEST_CHECK(delta.ChangedEntries.empty());
+
+  // Renamed services change their descriptor loop
+  std::shared_ptr<TSiTable> renamed = BuildTable(BuildSdt(TTableId::TABLE_ID_SDT_OTHER, TS_ID, NETWORK_ID, 3,
+    MakeIds({0x11, 0x12, 0x13}), "new"));
+  TEST_CHECK(renamed && (TSiTableDiff::Compare(*next, *renamed).ChangedEntries == MakeIds({0x11, 0x12, 0x13})));
+  TEST_CHECK(TSiTableDiff::Compare(*next, *next).IsEmpty());
+}
+
+void CheckEit()
+{
+  std::vector<TTestEvent> events;
+  events.push_back(TTestEvent{1, 1400000000, 0x010000});
+  events.push_back(TTestEvent{2, 1400003600, 0x010000});
+  events.push_back(TTestEvent{3, 1400007200, 0x010000});
+  std::shared_ptr<TSiTable> prev = BuildTable(BuildEit(TTableId::TABLE_ID_EIT_PF_OTHER, SERVICE_ID, TS_ID,
+    NETWORK_ID, 1, 0, 0, events));
+
+  // Event 2 gets longer, event 3 is replaced by event 4
+  events[1].DurationBcd = 0x013000;
+  events[2].EventId = 4;
+  std::shared_ptr<TSiTable> next = BuildTable(BuildEit(TTableId::TABLE_ID_EIT_PF_OTHER, SERVICE_ID, TS_ID,
+    NETWORK_ID, 2, 0, 0, events));
+  TEST_CHECK(prev && next);
+  if (!prev || !next) {
+    return;
+  }
+
+  TSiTableDelta delta = TSiTableDiff::Compare(*prev, *next);
+  TEST_CHECK(delta.AddedEntries == MakeIds({4}));
+  TEST_CHECK(delta.RemovedEntries == MakeIds({3}));
+  TEST_CHECK(delta.ChangedEntries == MakeIds({2}));
+
+  TEST_CHECK(TSiTableDiff::IsDiffSupported(TTableId::TABLE_ID_EIT_PF));
+  TEST_CHECK(TSiTableDiff::IsDiffSupported(TTableId::TABLE_ID_SDT));
+  TEST_CHECK(!TSiTableDiff::IsDiffSupported(TTableId::TABLE_ID_NIT));
+}
+
+} // namespace
+
+int main()
+{
+  CheckSignatures();
+  CheckSdt();
+  CheckEit();
+  return TestFailures ? 1 : 0;
+}
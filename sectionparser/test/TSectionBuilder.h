@@ -0,0 +1,301 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSECTIONBUILDER_H
+#define TSECTIONBUILDER_H
+
+// C system includes
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// C++ system includes
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project's includes
+#include "IDvbTableObserver.h"
+#include "TMpegDescriptor.h"
+#include "TEitTable.h"
+#include "TSdtTable.h"
+#include "TSiTable.h"
+#include "TSiTableDiff.h"
+
+// Failed checks of the test, the exit status of main()
+static int TestFailures = 0;
+
+#define TEST_CHECK(cond)                                                   \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);     \
+      ++TestFailures;                                                      \
+    }                                                                      \
+  } while (0)
+
+typedef std::vector<uint8_t> TSectionData;
+
+static inline int64_t ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// CRC_32 of ISO/IEC 13818-1 annex A
+static inline uint32_t GetMpegCrc(const uint8_t* data, size_t size)
+{
+  uint32_t crc = 0xffffffff;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= (uint32_t)data[i] << 24;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static inline void PutUint16(TSectionData& data, uint16_t value)
+{
+  data.push_back(value >> 8);
+  data.push_back(value & 0xff);
+}
+
+static inline uint8_t EncodeBcdByte(uint32_t value)
+{
+  return (uint8_t)(((value / 10) % 10) << 4 | (value % 10));
+}
+
+// 16-bit MJD followed by 6 BCD digits, the UTC_time of a TDT and the start_time of an EIT event
+static inline uint64_t EncodeMjdUtc(time_t utcTime)
+{
+  uint64_t mjd = 40587 + utcTime / 86400;
+  uint32_t seconds = utcTime % 86400;
+  return (mjd << 24) | ((uint64_t)EncodeBcdByte(seconds / 3600) << 16) |
+    ((uint64_t)EncodeBcdByte(seconds / 60 % 60) << 8) | EncodeBcdByte(seconds % 60);
+}
+
+/**
+ * Long form section: the header, the payload and the CRC_32
+ */
+static inline TSectionData BuildSection(uint8_t tableId, uint16_t extId, uint8_t version, uint8_t sectionNumber,
+  uint8_t lastSectionNumber, const TSectionData& payload, bool isCurrent = true)
+{
+  TSectionData data;
+  uint16_t sectionLength = 5 + payload.size() + 4;
+  data.push_back(tableId);
+  PutUint16(data, 0xb000 | sectionLength);
+  PutUint16(data, extId);
+  data.push_back(0xc0 | ((version & 0x1f) << 1) | (isCurrent ? 1 : 0));
+  data.push_back(sectionNumber);
+  data.push_back(lastSectionNumber);
+  data.insert(data.end(), payload.begin(), payload.end());
+  uint32_t crc = GetMpegCrc(data.data(), data.size());
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    data.push_back((crc >> shift) & 0xff);
+  }
+  return data;
+}
+
+/**
+ * SDT payload: the services of the list, each with a service descriptor naming it
+ * "<prefix><service_id>"
+ */
+static inline TSectionData BuildSdtPayload(uint16_t networkId, const std::vector<uint16_t>& serviceIds,
+  const std::string& prefix = "svc")
+{
+  TSectionData payload;
+  PutUint16(payload, networkId);
+  payload.push_back(0xff);
+  for (auto it = serviceIds.begin(), end = serviceIds.end(); it != end; ++it) {
+    std::string name = prefix + std::to_string(*it);
+    TSectionData descriptor;
+    descriptor.push_back(0x48);
+    descriptor.push_back(3 + name.size());
+    descriptor.push_back(0x01);
+    descriptor.push_back(0);
+    descriptor.push_back(name.size());
+    descriptor.insert(descriptor.end(), name.begin(), name.end());
+
+    PutUint16(payload, *it);
+    payload.push_back(0xfd);
+    // running, free_CA_mode 0
+    PutUint16(payload, 0x8000 | descriptor.size());
+    payload.insert(payload.end(), descriptor.begin(), descriptor.end());
+  }
+  return payload;
+}
+
+static inline TSectionData BuildSdt(uint8_t tableId, uint16_t tsId, uint16_t networkId, uint8_t version,
+  const std::vector<uint16_t>& serviceIds, const std::string& prefix = "svc")
+{
+  return BuildSection(tableId, tsId, version, 0, 0, BuildSdtPayload(networkId, serviceIds, prefix));
+}
+
+struct TTestEvent {
+  uint16_t EventId;
+  time_t StartTime;
+  uint32_t DurationBcd;
+};
+
+/**
+ * EIT section carrying the events, without descriptors
+ */
+static inline TSectionData BuildEit(uint8_t tableId, uint16_t serviceId, uint16_t tsId, uint16_t networkId,
+  uint8_t version, uint8_t sectionNumber, uint8_t lastSectionNumber, const std::vector<TTestEvent>& events,
+  bool isCurrent = true)
+{
+  TSectionData payload;
+  PutUint16(payload, tsId);
+  PutUint16(payload, networkId);
+  payload.push_back(lastSectionNumber);
+  payload.push_back(tableId);
+  for (auto it = events.begin(), end = events.end(); it != end; ++it) {
+    uint64_t start = EncodeMjdUtc(it->StartTime);
+    PutUint16(payload, it->EventId);
+    for (int shift = 32; shift >= 0; shift -= 8) {
+      payload.push_back((start >> shift) & 0xff);
+    }
+    payload.push_back(it->DurationBcd >> 16);
+    payload.push_back((it->DurationBcd >> 8) & 0xff);
+    payload.push_back(it->DurationBcd & 0xff);
+    // running, free_CA_mode 0, no descriptors
+    PutUint16(payload, 0x8000);
+  }
+  return BuildSection(tableId, serviceId, version, sectionNumber, lastSectionNumber, payload, isCurrent);
+}
+
+static inline TSectionData BuildTdt(time_t utcTime)
+{
+  uint64_t utc = EncodeMjdUtc(utcTime);
+  TSectionData data;
+  data.push_back(0x70);
+  PutUint16(data, 0x7005);
+  for (int shift = 32; shift >= 0; shift -= 8) {
+    data.push_back((utc >> shift) & 0xff);
+  }
+  return data;
+}
+
+/**
+ * Records the SDT and EIT deliveries. Safe to use with the asynchronous delivery.
+ */
+class TTableRecorder : public IDvbTableObserver
+{
+public:
+  TTableRecorder()
+    : TdtCount(0),
+      VersionSeenCount(0),
+      DelayUs(0)
+  {
+    // Empty
+  }
+
+  virtual void OnSdt(const std::shared_ptr<const TSdtTable>& sdt)
+  {
+    Record(sdt);
+  }
+
+  virtual void OnEit(const std::shared_ptr<const TEitTable>& eit)
+  {
+    Record(eit);
+  }
+
+  virtual void OnTdt(time_t /*utcTime*/, uint64_t /*utcTimeBcd*/)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    TdtCount++;
+  }
+
+  virtual void OnVersionSeen(uint8_t /*tableId*/, uint16_t /*extId*/, uint16_t /*onId*/, uint8_t /*version*/)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    VersionSeenCount++;
+  }
+
+  virtual void OnDelta(const std::shared_ptr<const TSiTableDelta>& delta)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Deltas.push_back(delta);
+  }
+
+  // Time spent in every table callback, to simulate a slow observer
+  void SetDelayUs(uint32_t delayUs)
+  {
+    DelayUs = delayUs;
+  }
+
+  std::vector<std::shared_ptr<const TSiTable>> GetTables()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Tables;
+  }
+
+  std::vector<std::shared_ptr<const TSiTableDelta>> GetDeltas()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Deltas;
+  }
+
+  size_t GetTableCount()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Tables.size();
+  }
+
+  uint32_t GetTdtCount()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return TdtCount;
+  }
+
+  uint32_t GetVersionSeenCount()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return VersionSeenCount;
+  }
+
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Tables.clear();
+    Deltas.clear();
+    TdtCount = 0;
+    VersionSeenCount = 0;
+  }
+
+private:
+  void Record(const std::shared_ptr<const TSiTable>& tbl)
+  {
+    if (DelayUs > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(DelayUs));
+    }
+    std::lock_guard<std::mutex> lock(Mutex);
+    Tables.push_back(tbl);
+  }
+
+  std::mutex Mutex;
+  std::vector<std::shared_ptr<const TSiTable>> Tables;
+  std::vector<std::shared_ptr<const TSiTableDelta>> Deltas;
+  uint32_t TdtCount;
+  uint32_t VersionSeenCount;
+  uint32_t DelayUs;
+};
+
+#endif // TSECTIONBUILDER_H
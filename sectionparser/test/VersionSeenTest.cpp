@@ -0,0 +1,75 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// The typed observers hear of a new SDT version on its first section, once per version, before
+// the table itself is complete.
+
+#include "TSectionBuilder.h"
+#include "TSectionParser.h"
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+
+TSectionData BuildSdtSection(uint8_t version, uint8_t sectionNumber)
+{
+  std::vector<uint16_t> serviceIds(1, 0x1000 + sectionNumber);
+  return BuildSection(TTableId::TABLE_ID_SDT_OTHER, TS_ID, version, sectionNumber, 1,
+    BuildSdtPayload(NETWORK_ID, serviceIds));
+}
+
+void CheckVersionSeen(size_t workerCount)
+{
+  TSectionParser parser;
+  TTableRecorder recorder;
+  parser.SetAsyncDelivery(workerCount, 16);
+  parser.RegisterDvbTableObserver(&recorder);
+
+  for (uint8_t version = 0; version < 3; version++) {
+    for (int repetition = 0; repetition < 2; repetition++) {
+      TSectionData data = BuildSdtSection(version, 0);
+      parser.ParseSiData(data.data(), data.size());
+    }
+    if (workerCount == 0) {
+      TEST_CHECK(recorder.GetVersionSeenCount() == version + 1U);
+      TEST_CHECK(recorder.GetTableCount() == version);
+    }
+    TSectionData data = BuildSdtSection(version, 1);
+    parser.ParseSiData(data.data(), data.size());
+  }
+  parser.SetAsyncDelivery(0, 0);
+  TEST_CHECK(recorder.GetVersionSeenCount() == 3);
+  TEST_CHECK(recorder.GetTableCount() == 3);
+
+  // A single section table is complete at once, there is nothing to announce
+  TSectionData sdt = BuildSdt(TTableId::TABLE_ID_SDT, TS_ID, NETWORK_ID, 0, std::vector<uint16_t>(1, 0x1000));
+  parser.ParseSiData(sdt.data(), sdt.size());
+  TEST_CHECK(recorder.GetVersionSeenCount() == 3);
+  parser.RemoveDvbTableObserver(&recorder);
+}
+
+} // namespace
+
+int main()
+{
+  CheckVersionSeen(0);
+  CheckVersionSeen(2);
+  return TestFailures ? 1 : 0;
+}
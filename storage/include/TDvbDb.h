@@ -27,6 +27,7 @@
 // C++ system includes
 #include <string>
 #include <list>
+#include <map>
 #include <vector>
 #include <mutex>
 #include <memory>
@@ -79,6 +80,12 @@ public:
     EndTime -= StartTime;
   };
 
+  // Seconds between the start and the finish of the measurement
+  double GetElapsedTime() const
+  {
+    return EndTime;
+  };
+
   void Display();
 };
 
@@ -215,6 +222,8 @@ public:
   const char* GetScanSetting(const char* variable);
   void SetScanSetting(const char* variable, const char* value);
   void ClearScanSettings();
+  std::vector<std::vector<uint32_t>> GetAcquisitionTimes();
+  void AddAcquisitionTime(uint32_t frequency, uint32_t tableType, uint32_t timeMs, uint32_t historySize);
   void CreateTables();
   void DropTables();
   int32_t GetNumberOfRowsModified();
@@ -243,6 +252,12 @@ public:
   // @return int32_t returns the status of the operation 0 if successful, -1 for failure
   std::vector<std::shared_ptr<TMpegDescriptor>> FindDescriptor(std::string queryStr);
 
+  // Read all the descriptors of a descriptor table in one query
+  // @param tablename const char pointer of the name of the descriptor table
+  // @param descMap map filled with the descriptors of each parent foreign key, in insertion order
+  // @return int32_t returns the status of the operation 0 if successful, -1 for failure
+  int32_t FindAllDescriptors(const char* tableName, std::map<int64_t, std::vector<TMpegDescriptor>>& descMap);
+
   // Insert a vector of descriptors 
   // @param tablename const char pointer of the name of the descriptor table
   // @param fkey int64_t parent foreign key value
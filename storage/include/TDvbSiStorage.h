@@ -20,20 +20,29 @@
 #define TDVBSISTORAGE_H
 
 #include "IDvbStorageSubject.h"
+#include "IDvbNowNextObserver.h"
 #include "IDvbStorageObserver.h"
+#include "IDvbTableObserver.h"
 #include "TBatTable.h"
 #include "TDvbDb.h"
 #include "TDvbStorageNamespace.h"
 #include "TDvbJanssonParser.h"
 #include "TEitTable.h"
+#include "TEpgGridIndex.h"
 #include "TNitTable.h"
+#include "TNowNextTable.h"
 #include "TSdtTable.h"
 #include "TSiTable.h"
 #include "TTransportStream.h"
 #include "TTotTable.h"
 #include "boost/scoped_ptr.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -43,7 +52,7 @@
 #include <tuple>
 #include <vector>
 
-class TDvbSiStorage : IDvbStorageSubject
+class TDvbSiStorage : IDvbStorageSubject, public IDvbTableObserver
 {
 private:
   const uint32_t& HomeTsFrequency;
@@ -53,14 +62,199 @@ private:
   const std::string& DbFilePath;
   const std::string& NetworkConfigJsonFile;
   uint32_t BackGroundScanInterval; 
-  bool IsFastScan;
-  bool CurrentTuneStatus;
-  uint8_t TunerIndex;
+  std::atomic<bool> IsFastScan;
+  std::atomic<uint8_t> TunerCount;
+  // The scan waits are satisfied by partial tables, see SetPartialTablesAccepted()
+  std::atomic<bool> IsPartialAccepted;
   TDvbDb StorageDb;
   boost::scoped_ptr<TDvbJanssonParser> JsonParser;
-  std::mutex CacheDataMutex;
+
+  // The NIT and SDT caches are immutable snapshots. Readers take a snapshot with
+  // std::atomic_load and never block; writers copy the current snapshot under
+  // CacheWriteMutex, modify the copy and publish it with std::atomic_store.
+  std::mutex CacheWriteMutex;
+  std::atomic<uint64_t> CachePublishCount;
+  std::atomic<uint64_t> CacheSkippedWriteCount;
+  std::atomic<uint64_t> CacheWriteContentionCount;
+  std::atomic<uint64_t> CacheRestoredCount;
+  std::atomic<uint64_t> CacheVerifiedCount;
+  std::unique_lock<std::mutex> LockCacheWrite();
+
+  // Replaces the entry of key in a copy of the cache and publishes the copy
+  template <typename TMap>
+  void PublishCacheEntry(std::shared_ptr<const TMap>& cache, const typename TMap::key_type& key,
+    const typename TMap::mapped_type& value)
+  {
+    std::shared_ptr<TMap> next(new TMap(*std::atomic_load(&cache)));
+    next->erase(key);
+    next->insert(std::make_pair(key, value));
+    std::atomic_store(&cache, std::shared_ptr<const TMap>(next));
+    ++CachePublishCount;
+  }
+
+  // Makes the entry of a previous run current once the run sees its version. False if the version
+  // differs or the run already has the table.
+  template <typename TMap>
+  bool PromotePreviousEntry(std::shared_ptr<const TMap>& cache, const std::shared_ptr<const TMap>& previous,
+    const typename TMap::key_type& key, uint8_t version)
+  {
+    if (std::atomic_load(&cache)->count(key) != 0) {
+      return false;
+    }
+    std::shared_ptr<const TMap> previousMap = std::atomic_load(&previous);
+    auto it = previousMap->find(key);
+    if ((it == previousMap->end()) || (it->second->GetVersionNumber() != version)) {
+      return false;
+    }
+    PublishCacheEntry(cache, key, it->second);
+    ++CacheVerifiedCount;
+    return true;
+  }
+
+  // The entries of newer, and those of older that newer doesn't have
+  template <typename TMap>
+  static std::shared_ptr<const TMap> MergeCache(const std::shared_ptr<const TMap>& older,
+    const std::shared_ptr<const TMap>& newer)
+  {
+    if (newer->empty()) {
+      return older;
+    }
+    std::shared_ptr<TMap> merged(new TMap(*newer));
+    merged->insert(older->begin(), older->end());
+    return merged;
+  }
+
+  // Guards CacheWaitList and the pending lists of its requests
+  std::mutex CacheWaitMutex;
+
+  // Tables a scan step is waiting for, removed as they reach the cache
+  struct TCacheWaitRequest {
+    TCacheWaitRequest()
+      : IsPartialAccepted(false)
+    {
+      // Empty
+    }
+    std::vector<std::shared_ptr<TSiTable>> Pending;
+    bool IsPartialAccepted;
+    std::condition_variable Condition;
+    // Set by the scan state machine instead of waiting on the condition
+    std::function<void()> Notify;
+  };
+  std::list<TCacheWaitRequest*> CacheWaitList;
+  bool IsTableCached(const TSiTable& wanted, bool isPartialAccepted);
+  void SignalCacheWaiters();
+
+  // Scan state machine. The events are queued under ScanMutex, everything else
+  // is owned by the scan thread.
+  enum TScanEventType {
+    SCAN_EVENT_STOP,
+    SCAN_EVENT_RESTART,
+    SCAN_EVENT_TUNE_DONE,
+    SCAN_EVENT_TUNE_FAILED,
+    SCAN_EVENT_TABLES_READY,
+    SCAN_EVENT_TUNER_LOST,
+    SCAN_EVENT_TUNER_AVAILABLE
+  };
+  struct TScanEvent {
+    TScanEvent(TScanEventType type, uint8_t tuner = 0, uint32_t seq = 0)
+      : Type(type),
+        Tuner(tuner),
+        Sequence(seq)
+    {
+      // Empty
+    }
+    TScanEventType Type;
+    uint8_t Tuner;
+    uint32_t Sequence;
+  };
+  enum TScanStep {
+    SCAN_STEP_IDLE,
+    SCAN_STEP_TUNING,
+    SCAN_STEP_COLLECTING
+  };
+  enum TScanPhase {
+    SCAN_PHASE_NIT_BAT,
+    SCAN_PHASE_HOME_SDT,
+    SCAN_PHASE_SDT_EIT_PF,
+    SCAN_PHASE_SDT,
+    SCAN_PHASE_EIT_PF,
+    SCAN_PHASE_EIT_SCHED,
+    SCAN_PHASE_BARKER_EIT,
+    // SDT other and EIT p/f other of the other transports, seen from home before planning
+    SCAN_PHASE_HOME_INVENTORY
+  };
+  // One tune of the scan and the tables collected on it
+  struct TScanJob {
+    TScanJob(uint32_t freq, TDvbStorageNamespace::TModulationMode mod, uint32_t symbol, uint16_t nId, uint16_t tsId)
+      : Frequency(freq),
+        Modulation(mod),
+        SymbolRate(symbol),
+        NetworkId(nId),
+        TransportStreamId(tsId),
+        PhaseIndex(0),
+        IsExclusive(false),
+        Status()
+    {
+      // Empty
+    }
+    uint32_t Frequency;
+    TDvbStorageNamespace::TModulationMode Modulation;
+    uint32_t SymbolRate;
+    uint16_t NetworkId;
+    uint16_t TransportStreamId;
+    std::vector<TScanPhase> Phases;
+    size_t PhaseIndex;
+    // Runs alone: the home job builds the job list, the barker job clears the EIT cache
+    bool IsExclusive;
+    TDvbStorageNamespace::TDvbSiTableStatus Status;
+  };
+  // A tuner resource of the scan and the job it is running
+  struct TScanTuner {
+    TScanTuner(uint8_t index)
+      : Index(index),
+        Step(SCAN_STEP_IDLE),
+        IsAvailable(true),
+        IsTuned(false),
+        Sequence(0),
+        Job(0, TDvbStorageNamespace::MODULATION_MODE_UNKNOWN, 0, 0, 0)
+    {
+      // Empty
+    }
+    uint8_t Index;
+    TScanStep Step;
+    bool IsAvailable;
+    bool IsTuned;
+    uint32_t Sequence;
+    std::chrono::steady_clock::time_point CollectStart;
+    std::chrono::steady_clock::time_point PhaseStart;
+    std::chrono::steady_clock::time_point Deadline;
+    TScanJob Job;
+    TCacheWaitRequest Wait;
+  };
+
   std::mutex ScanMutex;
   std::condition_variable ThreadScanCondition;
+  std::deque<TScanEvent> ScanEventQueue;
+  std::mutex ScanStatusMutex;
+
+  bool ScanRunActive;
+  bool ScanRunIsFast;
+  std::chrono::steady_clock::time_point ScanDeadline;
+  // Jobs waiting for a tuner
+  std::deque<TScanJob> ScanJobs;
+  std::vector<std::unique_ptr<TScanTuner>> ScanTuners;
+  TElapseTime ScanElapse;
+
+  // Acquisition times (ms) of the scan phases by frequency and table type, persisted in the database
+  enum {
+    ACQUISITION_HISTORY_SIZE = 32,
+    ACQUISITION_MIN_SAMPLES = 5,
+    ACQUISITION_PERCENTILE = 95,
+    ACQUISITION_MARGIN_MS = 1000,
+    ACQUISITION_MAX_FACTOR = 4
+  };
+  std::map<std::pair<uint32_t, uint32_t>, std::deque<uint32_t>> AcquisitionHistory;
+  bool IsAcquisitionHistoryLoaded;
   std::vector<IDvbStorageObserver*> ObserverVector;
 
   enum TDVBConstellation {
@@ -77,64 +271,163 @@ private:
   uint32_t BarkerEitTimout; 
   TDvbStorageNamespace::TModulationMode BarkerModulationMode;
 
-  std::map<uint16_t, std::shared_ptr<TNitTable>> NitTableMap; 
-  void HandleNitEvent(const TNitTable& nit);
-  void ProcessNitEventCache(const TNitTable& nit);
-  void ProcessNitEventDb(const TNitTable& nit);
+  typedef std::map<uint16_t, std::shared_ptr<const TNitTable>> TNitTableMap;
+  std::shared_ptr<const TNitTableMap> NitTableMap;
+  void HandleNitEvent(const std::shared_ptr<const TNitTable>& nit);
+  bool ProcessNitEventCache(const std::shared_ptr<const TNitTable>& nit);
+  void ProcessNitEventDb(const TNitTable& nit, bool isCompletion);
   int64_t ProcessNetwork(const TNitTable& nit);
   int64_t ProcessTransport(const TTransportStream& ts, int64_t network_fk);
   
-  std::map<std::pair<uint16_t, uint16_t>, std::shared_ptr<TSdtTable>> SdtTableMap;
-  void HandleSdtEvent(const TSdtTable& sdt);
-  void ProcessSdtEventCache(const TSdtTable& sdt);
+  typedef std::map<std::pair<uint16_t, uint16_t>, std::shared_ptr<const TSdtTable>> TSdtTableMap;
+  std::shared_ptr<const TSdtTableMap> SdtTableMap;
+  void HandleSdtEvent(const std::shared_ptr<const TSdtTable>& sdt);
+  bool ProcessSdtEventCache(const std::shared_ptr<const TSdtTable>& sdt);
   void ProcessSdtEventDb(const TSdtTable& sdt);
   int64_t ProcessService(const TSdtTable& sdt);
+
+  // NIT and SDT tables of the previous scan runs, or restored from the database at start up.
+  // The getters fall back to them until the current run has acquired the table again.
+  std::shared_ptr<const TNitTableMap> PreviousNitTableMap;
+  std::shared_ptr<const TSdtTableMap> PreviousSdtTableMap;
+  std::shared_ptr<const TNitTable> FindCachedNit(uint16_t nId);
+  std::shared_ptr<const TSdtTable> FindCachedSdt(uint16_t nId, uint16_t tsId);
+  void LoadCachedTables();
+
   void HandleTotEvent(const TTotTable& tot);
+  void HandleTdtEvent(time_t newTime);
+
+  // Arrival of a table the scan waits for but never reads back
+  struct TTableLedgerEntry {
+    TTableLedgerEntry(uint8_t ver, time_t completionTime, uint32_t count, bool isPartial)
+      : VersionNumber(ver),
+        CompletionTime(completionTime),
+        EntryCount(count),
+        IsPartial(isPartial)
+    {
+      // Empty
+    }
+    uint8_t VersionNumber;
+    time_t CompletionTime;
+    uint32_t EntryCount;   //!< Transport streams of a BAT, events of an EIT
+    bool IsPartial;        //!< Some sections of the version are missing, see TSiTable::IsPartial
+  };
 
-  std::map<uint16_t, std::shared_ptr<TBatTable>> BatTableMap;
+  // The ledgers are written on every BAT and EIT version and only looked up by
+  // the scan, so they are updated in place under LedgerMutex rather than copied
+  std::mutex LedgerMutex;
+  std::unique_lock<std::mutex> LockLedger();
+  typedef std::map<uint16_t, TTableLedgerEntry> TBatLedger;
+  TBatLedger BatLedger;
   void HandleBatEvent(const TBatTable& bat);
-  void ProcessBatEventCache(const TBatTable& bat);
-  void ProcessBatEventDb(const TBatTable& bat);
-  int64_t ProcessBouquet(const TBatTable& bat);
+  bool ProcessBatEventCache(const TBatTable& bat);
+  void ProcessBatEventDb(const TBatTable& bat, bool isCompletion);
+  int64_t ProcessBouquet(const TBatTable& bat, bool isCompletion);
+  void UpdateBouquetTransports(const TBatTable& bat, int64_t bouquet_fk);
 
-  std::map<std::tuple<uint16_t, uint16_t, uint16_t, bool>, std::shared_ptr<TEitTable>> EitTableMap;
+  typedef std::map<std::tuple<uint16_t, uint16_t, uint16_t, bool>, TTableLedgerEntry> TEitLedger;
+  TEitLedger EitLedger;
+  TEpgGridIndex EpgGridIndex;
+  TNowNextTable NowNextTable;
+  // Replaced as a whole under NowNextObserverMutex, notified from a snapshot
+  std::shared_ptr<const std::vector<IDvbNowNextObserver*>> NowNextObserverVector;
+  std::mutex NowNextObserverMutex;
+  void NotifyNowNextObserver(uint16_t serviceHandle, const std::shared_ptr<const TDvbStorageNamespace::NowNextStruct>& nowNext);
   void HandleEitEvent(const TEitTable& eit);
-  void ProcessEitEventCache(const TEitTable& eit);
+  bool ProcessEitEventCache(const TEitTable& eit);
   void ProcessEitEventDb(const TEitTable& eit);
   int64_t ProcessEvent(const TEitTable& eit);
   int64_t ProcessEventItem(const std::vector<TMpegDescriptor>& descList, int64_t event_fk);
 
   // Scan thread related functions
   void ScanThread();
-  bool IsFastScanEnabled();
-  bool IsBackgroundScanEnabled();
-  bool ScanHome();
-  bool CheckCacheTableCollections(std::vector<std::shared_ptr<TSiTable>>& tables, int timeout);
+  void PostScanEvent(const TScanEvent& event);
+  void HandleScanEvent(const TScanEvent& event);
+  void HandleScanTimeout();
+  std::chrono::steady_clock::time_point GetScanDeadline();
+  void StartScanRun();
+  void FinishScanRun(bool isSuccess);
+  void AbortScanRun();
+  void DispatchScanJobs();
+  bool PlanScanJob(TScanJob& job);
+  bool IsScanPhaseCached(const TScanJob& job, TScanPhase phase);
+  int GetScanJobCost(const TScanJob& job);
+  void StartScanJob(TScanTuner& tuner);
+  void StartScanPhase(TScanTuner& tuner);
+  void CompleteScanPhase(TScanTuner& tuner, bool isReceived);
+  void SetScanPhaseStatus(TDvbStorageNamespace::TDvbSiTableStatus& status, TScanPhase phase, bool isReceived);
+  void CompleteScanJob(TScanTuner& tuner);
+  void ReleaseScanTuner(TScanTuner& tuner, bool isLost);
+  void AddTransportScanJobs();
+  std::vector<std::shared_ptr<TSiTable>> GetScanPhaseTables(const TScanJob& job, TScanPhase phase);
+  int GetScanPhaseDefaultTimeout(TScanPhase phase);
+  uint32_t GetScanPhaseTableType(TScanPhase phase);
+  int GetScanPhaseTimeout(const TScanJob& job, TScanPhase phase);
+  void LoadAcquisitionHistory();
+  void RecordAcquisitionTime(const TScanTuner& tuner, bool isReceived);
+  bool ArmScanWait(TScanTuner& tuner, const std::vector<std::shared_ptr<TSiTable>>& tables, int timeout);
+  void DisarmScanWait(TScanTuner& tuner);
+  void SetScanState(TDvbStorageNamespace::TDvbScanState state);
+  bool CheckCacheTableCollections(std::vector<std::shared_ptr<TSiTable>>& tables, int timeout, bool isPartialAccepted = false);
   TDvbStorageNamespace::TModulationMode MapModulationMode(TDVBConstellation in);
   std::vector<std::shared_ptr<TDvbStorageNamespace::TStorageTransportStreamStruct>> GetTsListByNetIdCache(uint16_t nId);
   std::vector<std::shared_ptr<TDvbStorageNamespace::ServiceStruct>> GetServiceListByTsIdCache(uint16_t nId, uint16_t tsId);
   void ClearCachedTables();
-  bool IsTuneDone();
-public:
+  // Guarded by ScanStatusMutex, read with GetScanStatus()
   TDvbStorageNamespace::TDvbScanStatus DvbScanStatus;
+public:
   TDvbSiStorage(const uint32_t& homeTsFreq, const TDvbStorageNamespace::TModulationMode& modulation,
     const uint32_t& homeTsSymbRate, const uint16_t& prefNetworkId, const std::string& dbFile, const std::string& networkConfigFile);
   ~TDvbSiStorage();
   TDvbStorageNamespace::TFileStatus CreateDatabase();
+  // Legacy entry point, the table is copied into the cache
   void HandleTableEvent(const TSiTable& tbl);
   void SetBarkerInfo(const uint32_t& barkerFreq, const TDvbStorageNamespace::TModulationMode& barkMod, const uint32_t& barkSymbRate);
   void UpdateScanType(bool isFastScan);
   void UpdateTuneStatus(bool isTuneSuccess);
+  void UpdateTuneStatus(uint8_t tunerIndex, bool isTuneSuccess);
+  void ReportTuneFailure(uint8_t tunerIndex);
+  void SetTunerCount(uint8_t count);
+  void SetTunerAvailable(uint8_t tunerIndex, bool isAvailable);
+  void RestartScan();
+  void StopScan();
+  // Off by default: a scan step waits for the complete tables, not the partial ones published
+  // for sub-tables that miss sections (see TSectionParser::SetPartialPublication)
+  void SetPartialTablesAccepted(bool accept);
   static void ScanThreadInit(void *arg);
 
   std::vector<std::shared_ptr<TDvbStorageNamespace::TStorageTransportStreamStruct>> GetTsListByNetId(uint16_t nId);
   std::vector<std::shared_ptr<TDvbStorageNamespace::ServiceStruct>> GetServiceListByTsId(uint16_t nId, uint16_t tsId);
   std::vector<std::shared_ptr<TDvbStorageNamespace::EventStruct>> GetEventListByServiceId(uint16_t nId, uint16_t tsId, uint16_t sId);
+  // Events of the service overlapping [startTime, endTime), answered from the in-memory EPG index.
+  // The window and the StartTime of the events are UTC seconds since the epoch, the events are
+  // sorted by start time.
+  std::vector<std::shared_ptr<const TDvbStorageNamespace::EventStruct>> GetEventsInWindow(uint16_t nId, uint16_t tsId,
+    uint16_t sId, time_t startTime, time_t endTime);
+  // Same for several services, one event list per requested service in the same order
+  std::vector<std::vector<std::shared_ptr<const TDvbStorageNamespace::EventStruct>>> GetEventGrid(
+    const std::vector<TDvbStorageNamespace::TServiceKey>& services, time_t startTime, time_t endTime);
   std::vector<std::shared_ptr<TDvbStorageNamespace::InbandTableInfoStruct>> GetInbandTableInfo(std::string& profile);
+  // Present and following events, answered from memory. The handle of a service stays
+  // valid for the lifetime of the storage.
+  uint16_t GetServiceHandle(uint16_t nId, uint16_t tsId, uint16_t sId);
+  std::shared_ptr<const TDvbStorageNamespace::NowNextStruct> GetNowNext(uint16_t serviceHandle);
+  void RegisterNowNextObserver(IDvbNowNextObserver* observerObject);
+  void RemoveNowNextObserver(IDvbNowNextObserver* observerObject);
   TDvbStorageNamespace::TDvbScanStatus GetScanStatus();
+  TDvbStorageNamespace::TCacheStats GetCacheStats();
   std::string GetProfiles();
   bool SetProfiles(std::string& profiles);
 
+  // IDvbTableObserver, the tables are cached without copying
+  virtual void OnNit(const std::shared_ptr<const TNitTable>& nit);
+  virtual void OnSdt(const std::shared_ptr<const TSdtTable>& sdt);
+  virtual void OnBat(const std::shared_ptr<const TBatTable>& bat);
+  virtual void OnEit(const std::shared_ptr<const TEitTable>& eit);
+  virtual void OnTot(const std::shared_ptr<const TTotTable>& tot);
+  virtual void OnTdt(time_t utcTime, uint64_t utcTimeBcd);
+  virtual void OnVersionSeen(uint8_t tableId, uint16_t extId, uint16_t onId, uint8_t version);
+
   // IDvbStorageSubject
   virtual void RegisterDvbStorageObserver(IDvbStorageObserver* observerObject);
   virtual void RemoveDvbStorageObserver(IDvbStorageObserver* observerObject);
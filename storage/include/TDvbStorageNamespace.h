@@ -20,7 +20,9 @@
 #define TDVBSTORAGENAMESPACE_H
 
 #include <stdint.h>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace TDvbStorageNamespace
@@ -112,6 +114,35 @@ namespace TDvbStorageNamespace
     std::string EventText;
   } EventStruct;
 
+  // original_network_id, transport_stream_id, service_id
+  typedef std::tuple<uint16_t, uint16_t, uint16_t> TServiceKey;
+
+  // Present and following events of a service, from EIT p/f
+  typedef struct NowNext {
+    NowNext(uint16_t net, uint16_t ts, uint16_t id, uint8_t ver)
+    : NetworkId(net),
+      TransportStreamId(ts),
+      ServiceId(id),
+      VersionNumber(ver),
+      PresentRunningStatus(0),
+      FollowingRunningStatus(0)
+    {
+      // Empty
+    }
+    uint16_t NetworkId;
+    uint16_t TransportStreamId;
+    uint16_t ServiceId;
+    uint8_t VersionNumber;
+    std::shared_ptr<const EventStruct> Present;     //!< Null if nothing is on
+    std::shared_ptr<const EventStruct> Following;   //!< Null if nothing is announced
+    uint8_t PresentRunningStatus;
+    uint8_t FollowingRunningStatus;
+  } NowNextStruct;
+
+  enum {
+    INVALID_SERVICE_HANDLE = 0xFFFF
+  };
+
   enum {
     NIT_TIMEOUT = 15,
     NIT_OTHER_TIMEOUT = 15,
@@ -122,6 +153,7 @@ namespace TDvbStorageNamespace
     EIT_PF_OTHER_TIMEOUT = 15,
     EIT_8_DAY_SCHED_TIMEOUT = 15,
     EIT_PAST_8_DAY_SCHED_TIMEOUT = 60,
+    TUNE_TIMEOUT = 10,
   };
 
   typedef struct InbandTableInfo {
@@ -155,8 +187,36 @@ namespace TDvbStorageNamespace
   };
 
   struct TDvbScanStatus {
+    TDvbScanStatus()
+    : ScanState(SCAN_STOPPED),
+      NaiveTuneCount(0),
+      PlannedTuneCount(0)
+    {
+      // Empty
+    }
     TDvbScanState ScanState;
     std::vector<std::pair<uint32_t, TDvbSiTableStatus>> TsList;
+    // Tunes of the current scan, including home: one per transport vs. only the ones with tables missing
+    uint32_t NaiveTuneCount;
+    uint32_t PlannedTuneCount;
+  };
+
+  // Table cache counters since the storage was created
+  struct TCacheStats {
+    TCacheStats()
+    : Publishes(0),
+      SkippedWrites(0),
+      WriteContentions(0),
+      RestoredTables(0),
+      VerifiedTables(0)
+    {
+      // Empty
+    }
+    uint64_t Publishes;          //!< Cache snapshots and ledger entries made visible to the readers
+    uint64_t SkippedWrites;      //!< Tables received again with an unchanged version
+    uint64_t WriteContentions;   //!< Writers that found the cache write or ledger mutex taken
+    uint64_t RestoredTables;     //!< NIT and SDT tables restored from the database at start up
+    uint64_t VerifiedTables;     //!< Tables of a previous run received again with the same version
   };
 }
 #endif // TDVBSTORAGENAMESPACE_H
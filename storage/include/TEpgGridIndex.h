@@ -0,0 +1,135 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TEPGGRIDINDEX_H
+#define TEPGGRIDINDEX_H
+
+#include "TDvbStorageNamespace.h"
+
+// C system includes
+#include <stdint.h>
+#include <time.h>
+
+// C++ system includes
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Forward declarations
+class TEitEvent;
+class TEitTable;
+
+/**
+ * In-memory service x time index of the EIT events, maintained from the EIT ingestion.
+ *
+ * The events of a service are kept in an array sorted by start time, so the events
+ * overlapping a time window are found with a binary search. Every array is an immutable
+ * snapshot replaced on update, readers never block the EIT ingestion.
+ */
+class TEpgGridIndex
+{
+private:
+  // Start and end are seconds since the epoch, UTC
+  struct TEntry {
+    time_t StartTime;
+    time_t EndTime;
+    uint8_t TableId;    //!< EIT sub-table that carried the event
+    uint8_t Segment;    //!< Section number / 8, 0 for the EIT p/f
+    std::shared_ptr<const TDvbStorageNamespace::EventStruct> Event;
+  };
+
+  struct TServiceEvents {
+    TServiceEvents()
+    : MaxDuration(0)
+    {
+      // Empty
+    }
+    std::vector<TEntry> Entries;   //!< Sorted by start time
+    uint32_t MaxDuration;          //!< Longest event, bounds the backward search of a window
+  };
+
+  // The map only changes when a service is added, the events of a service are
+  // swapped in their slot.
+  struct TServiceSlot {
+    std::shared_ptr<const TServiceEvents> Events;
+  };
+  typedef std::map<TDvbStorageNamespace::TServiceKey, std::shared_ptr<TServiceSlot>> TServiceMap;
+
+  std::shared_ptr<const TServiceMap> Services;
+  std::mutex WriteMutex;
+  std::atomic<uint32_t> EventCount;
+  uint32_t RetentionTime;
+
+  std::shared_ptr<TServiceSlot> FindSlot(const TDvbStorageNamespace::TServiceKey& key) const;
+  void GetEvents(const TServiceEvents& events, time_t startTime, time_t endTime,
+    std::vector<std::shared_ptr<const TDvbStorageNamespace::EventStruct>>& out) const;
+
+public:
+  /**
+   * Constructor
+   *
+   * @param retention seconds an event is kept after it ended
+   */
+  TEpgGridIndex(uint32_t retention = 3 * 3600);
+
+  /**
+   * Replace the events of an EIT sub-table. The events the sub-table carried in each of its
+   * segments are replaced by those of the new version, so events removed by the broadcaster
+   * and segments that became empty disappear. A partial table only replaces the segments it
+   * has all the sections of, its other events are matched by event_id. An event_id carried
+   * by another sub-table of the service is replaced as well. Events that ended more than the
+   * retention time ago are dropped from the service.
+   *
+   * @param eit EIT p/f or schedule table
+   */
+  void Update(const TEitTable& eit);
+
+  /**
+   * Remove all the events
+   */
+  void Clear();
+
+  /**
+   * Events of a service overlapping [startTime, endTime), sorted by start time.
+   * The times are UTC seconds since the epoch, so is the StartTime of the returned events.
+   */
+  std::vector<std::shared_ptr<const TDvbStorageNamespace::EventStruct>> GetEvents(
+    const TDvbStorageNamespace::TServiceKey& service, time_t startTime, time_t endTime) const;
+
+  /**
+   * Events of several services overlapping [startTime, endTime).
+   * The result has one event list per requested service, in the same order.
+   */
+  std::vector<std::vector<std::shared_ptr<const TDvbStorageNamespace::EventStruct>>> GetEvents(
+    const std::vector<TDvbStorageNamespace::TServiceKey>& services, time_t startTime, time_t endTime) const;
+
+  /**
+   * Build the event returned by the queries from an EIT event,
+   * the title and text come from the first short event descriptor
+   */
+  static std::shared_ptr<const TDvbStorageNamespace::EventStruct> CreateEvent(const TEitTable& eit, const TEitEvent& eitEvent);
+
+  uint32_t GetEventCount() const
+  {
+    return EventCount;
+  }
+};
+
+#endif // TEPGGRIDINDEX_H
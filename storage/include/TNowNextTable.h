@@ -0,0 +1,115 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TNOWNEXTTABLE_H
+#define TNOWNEXTTABLE_H
+
+#include "TDvbStorageNamespace.h"
+
+// C system includes
+#include <stdint.h>
+
+// C++ system includes
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Forward declarations
+class TEitTable;
+
+/**
+ * Present and following event of every service, maintained from EIT p/f.
+ *
+ * A service gets a compact handle the first time its EIT p/f is seen. The handle indexes
+ * a table of immutable entries, each replaced as a whole on change, so a read is an array
+ * access and never waits for the EIT ingestion. The slots are allocated in chunks that never
+ * move, so the table grows up to 0xFFFF services without copying the published entries.
+ */
+class TNowNextTable
+{
+private:
+  struct TSlot {
+    std::shared_ptr<const TDvbStorageNamespace::NowNextStruct> NowNext;
+  };
+
+  typedef std::map<TDvbStorageNamespace::TServiceKey, uint16_t> THandleMap;
+
+  enum {
+    CHUNK_SIZE = 256,
+    CHUNK_COUNT = 256     //!< Handles up to 0xFFFE, 0xFFFF is INVALID_SERVICE_HANDLE
+  };
+  // A chunk is allocated before the first handle it holds becomes visible in ServiceCount
+  std::unique_ptr<TSlot[]> Chunks[CHUNK_COUNT];
+  std::atomic<uint16_t> ServiceCount;
+  // Looked up once per service by the readers, an insert doesn't copy the map
+  THandleMap Handles;
+  mutable std::mutex HandleMutex;
+  std::mutex WriteMutex;
+
+  TSlot& GetSlot(uint16_t handle) const
+  {
+    return Chunks[handle / CHUNK_SIZE][handle % CHUNK_SIZE];
+  }
+
+  static bool IsSameEvent(const std::shared_ptr<const TDvbStorageNamespace::EventStruct>& a,
+    const std::shared_ptr<const TDvbStorageNamespace::EventStruct>& b);
+
+public:
+  TNowNextTable();
+
+  /**
+   * Update the entry of the service from an EIT p/f sub-table, the present event is the one
+   * carried in section 0 and the following event the one in section 1
+   *
+   * @param eit EIT p/f actual or other
+   * @param handle set to the handle of the service
+   * @param nowNext set to the new entry of the service
+   * @return true if the present or following event, or a running status, has changed
+   */
+  bool Update(const TEitTable& eit, uint16_t& handle, std::shared_ptr<const TDvbStorageNamespace::NowNextStruct>& nowNext);
+
+  /**
+   * Get the handle of a service
+   *
+   * @param service service key
+   * @return the handle, INVALID_SERVICE_HANDLE if no EIT p/f has been received for the service
+   */
+  uint16_t GetServiceHandle(const TDvbStorageNamespace::TServiceKey& service) const;
+
+  /**
+   * Get the present and following events of a service
+   *
+   * @param handle service handle
+   * @return the entry, null for an invalid handle
+   */
+  std::shared_ptr<const TDvbStorageNamespace::NowNextStruct> Get(uint16_t handle) const
+  {
+    if (handle >= ServiceCount) {
+      return std::shared_ptr<const TDvbStorageNamespace::NowNextStruct>();
+    }
+    return std::atomic_load(&GetSlot(handle).NowNext);
+  }
+
+  uint16_t GetServiceCount() const
+  {
+    return ServiceCount;
+  }
+};
+
+#endif // TNOWNEXTTABLE_H
@@ -0,0 +1,37 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef IDVBNOWNEXTOBSERVER_H
+#define IDVBNOWNEXTOBSERVER_H
+
+#include "TDvbStorageNamespace.h"
+
+#include <memory>
+
+class IDvbNowNextObserver {
+public:
+  // Called when the present or following event of a service, or its running status, has changed.
+  // The handle is the one returned by GetServiceHandle(). The call comes from the thread that
+  // delivers the EIT to the storage: a section parser thread, or a worker of the parser's
+  // dispatcher when asynchronous delivery is enabled (TSectionParser::SetAsyncDelivery).
+  // Calls for different services may run concurrently. A call already in progress on another
+  // thread can still follow the removal of the observer.
+  virtual void NowNextChanged(uint16_t serviceHandle, const std::shared_ptr<const TDvbStorageNamespace::NowNextStruct>& nowNext) = 0;
+};
+
+#endif // IDVBNOWNEXTOBSERVER_H
@@ -25,6 +25,21 @@ class IDvbStorageObserver {
 public:
   virtual void Tune(const uint32_t& freq, const TDvbStorageNamespace::TModulationMode& mod, const uint32_t& symbol) = 0;
   virtual void UnTune() = 0;
+
+  // Multi-tuner scan. The default implementations drive the single tuner.
+  // The tuner lock is reported with TDvbSiStorage::UpdateTuneStatus(tunerIndex, true); false keeps its
+  // meaning of "not tuned yet". ReportTuneFailure() abandons the transport before the tune timeout.
+  virtual void Tune(uint8_t tunerIndex, const uint32_t& freq, const TDvbStorageNamespace::TModulationMode& mod,
+    const uint32_t& symbol)
+  {
+    (void)tunerIndex;
+    Tune(freq, mod, symbol);
+  }
+  virtual void UnTune(uint8_t tunerIndex)
+  {
+    (void)tunerIndex;
+    UnTune();
+  }
 };
 
 #endif // IDVBSECTIONPARSEROBSERVER 
@@ -22,6 +22,7 @@
 #include <sys/time.h>
 
 #include <cstdio>
+#include <sstream>
 
 #include <oswrap.h>
 
@@ -605,6 +606,51 @@ void  TDvbDb::ClearScanSettings()
   DbSettingsVector.clear();
 }
 
+// Acquisition times of the scan tables, oldest first.
+// Each row holds frequency, table type (table_ids packed from the low byte up) and the time in milliseconds.
+vector<vector<uint32_t>> TDvbDb::GetAcquisitionTimes()
+{
+  std::lock_guard<std::mutex> lock(DbMutex);
+  vector<vector<uint32_t>> results;
+  SqlCommand("CREATE TABLE IF NOT EXISTS AcquisitionTime (" \
+    "frequency INTEGER,"                                    \
+    "table_type INTEGER,"                                   \
+    "acquisition_ms INTEGER);");
+  // The table type is a code of table_ids (0x40 and up), earlier rows held scan phase numbers
+  SqlCommand("DELETE FROM AcquisitionTime WHERE table_type < 64;");
+  const char* queryStr = "SELECT frequency, table_type, acquisition_ms FROM AcquisitionTime ORDER BY rowid";
+  try {
+    sqlite3pp::query qry(Sqlite3ppWrapper, queryStr);
+    for (query::iterator it = qry.begin(); it != qry.end(); ++it) {
+      long long int frequency, tableType, timeMs;
+      (*it).getter() >> frequency >> tableType >> timeMs;
+      results.push_back({(uint32_t)frequency, (uint32_t)tableType, (uint32_t)timeMs});
+    }
+  }
+  catch (exception& ex) {
+    OS_LOG(DVB_DEBUG,  "<%s> - Exception: %s cmd: %s\n", __FUNCTION__, ex.what(), queryStr);
+  }
+  catch(...) {
+    OS_LOG(DVB_ERROR,  "<%s> - Unknown Exception: cmd: %s\n", __FUNCTION__, queryStr);
+  }
+  return results;
+}
+
+// Store an acquisition time, keeping the latest historySize ones of the frequency and table type
+void TDvbDb::AddAcquisitionTime(uint32_t frequency, uint32_t tableType, uint32_t timeMs, uint32_t historySize)
+{
+  std::lock_guard<std::mutex> lock(DbMutex);
+  std::stringstream ss;
+  ss << "INSERT INTO AcquisitionTime (frequency, table_type, acquisition_ms) VALUES ("
+     << frequency << ", " << tableType << ", " << timeMs << ");";
+  SqlCommand(ss.str().c_str());
+
+  ss.str("");
+  ss << "DELETE FROM AcquisitionTime WHERE rowid IN (SELECT rowid FROM AcquisitionTime WHERE frequency = "
+     << frequency << " AND table_type = " << tableType << " ORDER BY rowid DESC LIMIT -1 OFFSET " << historySize << ");";
+  SqlCommand(ss.str().c_str());
+}
+
 int64_t TDvbDb::FindPrimaryKey(string& queryStr)
 {
   std::lock_guard<std::mutex> lock(DbMutex);
@@ -676,9 +722,9 @@ vector<shared_ptr<TMpegDescriptor>>  TDvbDb::FindDescriptor(string queryStr)
   std::lock_guard<std::mutex> lock(DbMutex);
   vector<shared_ptr<TMpegDescriptor>>  results;
   try {
-    if (!queryStr.empty()) {
+    if (queryStr.empty()) {
       OS_LOG(DVB_ERROR,  "<%s> - No query specified.\n", __FUNCTION__);
-      throw new logic_error("Invalid query string.");
+      throw logic_error("Invalid query string.");
     }
 
         sqlite3pp::query qry(Sqlite3ppWrapper, queryStr.c_str());
@@ -688,19 +734,19 @@ vector<shared_ptr<TMpegDescriptor>>  TDvbDb::FindDescriptor(string queryStr)
             strcmp(qry.column_name(1), "descriptor") != 0)
         {
             OS_LOG(DVB_DEBUG,  "<%s> - Invalid columns specified.\n", __FUNCTION__);
-            throw new logic_error("Invalid column selected.");
+            throw logic_error("Invalid column selected.");
         }
 
         for(query::iterator it=qry.begin(); it != qry.end(); ++it)
         {
-            string descriptor;
-            int8_t descriptor_id;
-
-            (*it).getter() >> descriptor_id >> descriptor;
+            // The descriptor is a blob, it may contain zero bytes
+            int descriptor_id = (*it).get<int>(0);
+            const void* descriptor = (*it).get<const void*>(1);
+            int size = (*it).column_bytes(1);
 
             shared_ptr<TMpegDescriptor> mpeg(new TMpegDescriptor(static_cast<TDescriptorTag>(descriptor_id), 
-                                                               (uint8_t*)descriptor.data(), 
-                                                                static_cast<uint8_t>(descriptor.size())));
+                                                               (uint8_t*)descriptor, 
+                                                                static_cast<uint8_t>(size)));
                 results.push_back(mpeg);
         }
     }
@@ -717,6 +763,39 @@ vector<shared_ptr<TMpegDescriptor>>  TDvbDb::FindDescriptor(string queryStr)
 
     return  results;
 }
+
+int32_t TDvbDb::FindAllDescriptors(const char* tableName, std::map<int64_t, std::vector<TMpegDescriptor>>& descMap)
+{
+  std::lock_guard<std::mutex> lock(DbMutex);
+  int32_t rc(-1);
+
+  if (tableName) {
+    string queryStr("SELECT fkey, descriptor_id, descriptor FROM ");
+    queryStr += tableName;
+    queryStr += " ORDER BY fkey, rowid;";
+    try {
+      sqlite3pp::query qry(Sqlite3ppWrapper, queryStr.c_str());
+      for (query::iterator it = qry.begin(); it != qry.end(); ++it) {
+        // The descriptor is a blob, it may contain zero bytes
+        int64_t fkey = (*it).get<long long int>(0);
+        int descriptorId = (*it).get<int>(1);
+        const void* descriptor = (*it).get<const void*>(2);
+        int size = (*it).column_bytes(2);
+        descMap[fkey].push_back(TMpegDescriptor(static_cast<TDescriptorTag>(descriptorId), (uint8_t*)descriptor,
+          static_cast<uint8_t>(size)));
+      }
+      rc = 0;
+    }
+    catch (exception& ex) {
+      OS_LOG(DVB_ERROR,  "<%s> - Exception: %s cmd: %s\n", __FUNCTION__, ex.what(), queryStr.c_str());
+    }
+    catch (...) {
+      OS_LOG(DVB_ERROR,  "<%s> - Unknown Exception: cmd: %s\n", __FUNCTION__, queryStr.c_str());
+    }
+  }
+  return rc;
+}
+
 int32_t  TDvbDb::InsertDescriptor(const char* tableName, const int64_t& fkey, const std::vector<TMpegDescriptor>& descList)
 {
   std::lock_guard<std::mutex> lock(DbMutex);
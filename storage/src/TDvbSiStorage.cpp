@@ -30,6 +30,8 @@
 #include "TShortEventDescriptor.h"
 //#include ""
 
+#include <algorithm>
+#include <set>
 #include <sstream>
 #include <utility>
 #include <vector>
@@ -38,35 +40,56 @@ using namespace TDvbStorageNamespace;
 
 // private function implementations.
 
-void TDvbSiStorage::HandleNitEvent(const TNitTable& nit)
+void TDvbSiStorage::HandleNitEvent(const std::shared_ptr<const TNitTable>& nit)
 {
   // TODO: Consider removing one level of handle methods.
-  ProcessNitEventCache(nit);
-  ProcessNitEventDb(nit);
+  bool isCompletion = ProcessNitEventCache(nit);
+  ProcessNitEventDb(*nit, isCompletion);
 }
 
-void TDvbSiStorage::ProcessNitEventCache(const TNitTable& nit)
+// Returns true if the table completes the partial table of the same version
+bool TDvbSiStorage::ProcessNitEventCache(const std::shared_ptr<const TNitTable>& table)
 {
-  std::lock_guard<std::mutex> lock(CacheDataMutex);
-
-  auto it = NitTableMap.find(nit.GetNetworkId());
-  if (it == NitTableMap.end()) {
-    OS_LOG(DVB_DEBUG,   "<%s> Adding NIT table to the map. Network id: 0x%x\n", __FUNCTION__, nit.GetNetworkId());
-    NitTableMap.insert(std::make_pair(nit.GetNetworkId(), std::make_shared<TNitTable>(nit)));
-  }
-  else {
-    OS_LOG(DVB_DEBUG,   "<%s> NIT already in cache. Network id: %d version: %d\n", __FUNCTION__,nit.GetNetworkId(),nit.GetVersionNumber());
-    if (nit.GetVersionNumber() == it->second->GetVersionNumber()) {
-      OS_LOG(DVB_DEBUG,   "<%s> NIT version matches (%d). Skipping\n", __FUNCTION__, nit.GetVersionNumber());
+  const TNitTable& nit = *table;
+  bool isCompletion(false);
+  {
+    std::unique_lock<std::mutex> lock(LockCacheWrite());
+    std::shared_ptr<const TNitTableMap> nitMap = std::atomic_load(&NitTableMap);
+    auto it = nitMap->find(nit.GetNetworkId());
+    if (it == nitMap->end()) {
+      OS_LOG(DVB_DEBUG,   "<%s> Adding NIT table to the map. Network id: 0x%x\n", __FUNCTION__, nit.GetNetworkId());
     }
     else {
-      OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second->GetVersionNumber(), nit.GetVersionNumber());
-      it->second = std::make_shared<TNitTable>(nit);
+      OS_LOG(DVB_DEBUG,   "<%s> NIT already in cache. Network id: %d version: %d\n", __FUNCTION__,nit.GetNetworkId(),nit.GetVersionNumber());
+      if (nit.GetVersionNumber() == it->second->GetVersionNumber()) {
+        if (nit.IsPartial() || !it->second->IsPartial()) {
+          OS_LOG(DVB_DEBUG,   "<%s> NIT version matches (%d). Skipping\n", __FUNCTION__, nit.GetVersionNumber());
+          ++CacheSkippedWriteCount;
+          return false;
+        }
+        OS_LOG(DVB_DEBUG,   "<%s> NIT version %d complete\n", __FUNCTION__, nit.GetVersionNumber());
+        isCompletion = true;
+      }
+      else {
+        OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second->GetVersionNumber(), nit.GetVersionNumber());
+      }
     }
+    if (!nit.IsPartial() && ((it == nitMap->end()) || it->second->IsPartial())) {
+      std::shared_ptr<const TNitTableMap> previousMap = std::atomic_load(&PreviousNitTableMap);
+      auto previous = previousMap->find(nit.GetNetworkId());
+      if ((previous != previousMap->end()) && (previous->second->GetVersionNumber() == nit.GetVersionNumber())) {
+        OS_LOG(DVB_DEBUG,   "<%s> NIT version verified (%d)\n", __FUNCTION__, nit.GetVersionNumber());
+        ++CacheVerifiedCount;
+      }
+    }
+    PublishCacheEntry(NitTableMap, nit.GetNetworkId(), table);
   }
+  SignalCacheWaiters();
+  return isCompletion;
 }
 
-void TDvbSiStorage::ProcessNitEventDb(const TNitTable& nit)
+// isCompletion: the table completes a partial table of the same version already stored
+void TDvbSiStorage::ProcessNitEventDb(const TNitTable& nit, bool isCompletion)
 {
   int64_t network_fk(-1);
   int8_t nitVersion(-1);
@@ -82,6 +105,15 @@ void TDvbSiStorage::ProcessNitEventDb(const TNitTable& nit)
   if (nit_fk > 0) {
     if (nit.GetVersionNumber() == nitVersion) {
       OS_LOG(DVB_DEBUG,   "<%s> NIT version matches (%d). Skipping\n", __FUNCTION__, nit.GetVersionNumber());
+      if (isCompletion) {
+        // The transports of the missing sections are added below
+        std::string cmdStr("SELECT network_pk FROM Network WHERE network_id = ");
+        std::stringstream ss;
+        ss << nit.GetNetworkId();
+        cmdStr += ss.str();
+        cmdStr += ";";
+        network_fk = StorageDb.FindPrimaryKey(cmdStr);
+      }
     }
     else {
       OS_LOG(DVB_DEBUG,   "<%s> Current version: %d, new version: %d\n", __FUNCTION__, nitVersion, nit.GetVersionNumber());
@@ -223,32 +255,52 @@ int64_t  TDvbSiStorage::ProcessTransport(const TTransportStream& ts, int64_t net
   return  transport_fk;
 }
 
-void TDvbSiStorage::HandleSdtEvent(const TSdtTable& sdt)
+void TDvbSiStorage::HandleSdtEvent(const std::shared_ptr<const TSdtTable>& sdt)
 {
   ProcessSdtEventCache(sdt);
-  ProcessSdtEventDb(sdt);
+  ProcessSdtEventDb(*sdt);
 }
 
-void TDvbSiStorage::ProcessSdtEventCache(const TSdtTable& sdt)
+// Returns true if the table completes the partial table of the same version
+bool TDvbSiStorage::ProcessSdtEventCache(const std::shared_ptr<const TSdtTable>& table)
 {
-  std::lock_guard<std::mutex> lock(CacheDataMutex);
+  const TSdtTable& sdt = *table;
   std::pair<uint16_t, uint16_t> key(sdt.GetOriginalNetworkId(), sdt.GetTableExtensionId());
-  auto it = SdtTableMap.find(key);
-
-  if (it == SdtTableMap.end()) {
-    OS_LOG(DVB_DEBUG,   "<%s> Adding SDT table to the cache. nid.tsid: 0x%x.0x%x\n", __FUNCTION__, sdt.GetOriginalNetworkId(), sdt.GetTableExtensionId());
-    SdtTableMap.insert(std::make_pair(key, std::make_shared<TSdtTable>(sdt)));
-  }
-  else {
-    OS_LOG(DVB_DEBUG,   "<%s> SDT already in cache. nid.tsid: %d.%d\n", __FUNCTION__, sdt.GetOriginalNetworkId(), sdt.GetTableExtensionId());
-    if (sdt.GetVersionNumber() == it->second->GetVersionNumber()) {
-      OS_LOG(DVB_DEBUG,   "<%s> SDT version matches (0x%x). Skipping\n", __FUNCTION__, sdt.GetVersionNumber());
+  bool isCompletion(false);
+  {
+    std::unique_lock<std::mutex> lock(LockCacheWrite());
+    std::shared_ptr<const TSdtTableMap> sdtMap = std::atomic_load(&SdtTableMap);
+    auto it = sdtMap->find(key);
+    if (it == sdtMap->end()) {
+      OS_LOG(DVB_DEBUG,   "<%s> Adding SDT table to the cache. nid.tsid: 0x%x.0x%x\n", __FUNCTION__, sdt.GetOriginalNetworkId(), sdt.GetTableExtensionId());
     }
     else {
-      OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second->GetVersionNumber(), sdt.GetVersionNumber());
-      it->second = std::make_shared<TSdtTable>(sdt);
+      OS_LOG(DVB_DEBUG,   "<%s> SDT already in cache. nid.tsid: %d.%d\n", __FUNCTION__, sdt.GetOriginalNetworkId(), sdt.GetTableExtensionId());
+      if (sdt.GetVersionNumber() == it->second->GetVersionNumber()) {
+        if (sdt.IsPartial() || !it->second->IsPartial()) {
+          OS_LOG(DVB_DEBUG,   "<%s> SDT version matches (0x%x). Skipping\n", __FUNCTION__, sdt.GetVersionNumber());
+          ++CacheSkippedWriteCount;
+          return false;
+        }
+        OS_LOG(DVB_DEBUG,   "<%s> SDT version 0x%x complete\n", __FUNCTION__, sdt.GetVersionNumber());
+        isCompletion = true;
+      }
+      else {
+        OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second->GetVersionNumber(), sdt.GetVersionNumber());
+      }
     }
+    if (!sdt.IsPartial() && ((it == sdtMap->end()) || it->second->IsPartial())) {
+      std::shared_ptr<const TSdtTableMap> previousMap = std::atomic_load(&PreviousSdtTableMap);
+      auto previous = previousMap->find(key);
+      if ((previous != previousMap->end()) && (previous->second->GetVersionNumber() == sdt.GetVersionNumber())) {
+        OS_LOG(DVB_DEBUG,   "<%s> SDT version verified (0x%x)\n", __FUNCTION__, sdt.GetVersionNumber());
+        ++CacheVerifiedCount;
+      }
+    }
+    PublishCacheEntry(SdtTableMap, key, table);
   }
+  SignalCacheWaiters();
+  return isCompletion;
 }
 
 void TDvbSiStorage::ProcessSdtEventDb(const TSdtTable& sdt)
@@ -296,6 +348,8 @@ void TDvbSiStorage::ProcessSdtEventDb(const TSdtTable& sdt)
     int64_t sdt_fk = StorageDb.FindPrimaryKey(cmdStr, sdtVersion);
     // FOUND 
     if (sdt_fk > 0) {
+      // The services are stored one by one: those of the sections a partial table missed are
+      // NOT FOUND, so the complete table of the same version adds them
       if (sdt.GetVersionNumber() == sdtVersion) {
         OS_LOG(DVB_DEBUG,   "<%s> Sdt version matches (%d). Skipping\n", __FUNCTION__, sdt.GetVersionNumber());
       }
@@ -523,20 +577,7 @@ void TDvbSiStorage::HandleTotEvent(const TTotTable& tot)
 {
   if (tot.GetTableId() == TTableId::TABLE_ID_TDT) {
     //OS_LOG(DVB_DEBUG,   "  TDT: Time and Date Table\n");
-    time_t newTime = tot.GetUtcTime();
-    if (newTime > 0) {
-      OS_LOG(DVB_DEBUG,   "<%s> newTime = %ld\n", __FUNCTION__, newTime);
-      struct timeval timeVal;
-      timeVal.tv_sec = newTime;
-      int ret = settimeofday(&timeVal, NULL);
-      if (ret < 0) {
-        OS_LOG(DVB_ERROR,   "<%s> settimeofday(%ld) failed, %s\n", __FUNCTION__, newTime, strerror(errno));
-      }
-      StorageDb.UpdateTotStatus(true);
-    }
-    else {
-      OS_LOG(DVB_ERROR,   "<%s> MjdToDate() failed: %s\n", __FUNCTION__, strerror(errno));
-    }
+    HandleTdtEvent(tot.GetUtcTime());
   }
   else if (tot.GetTableId() == TTableId::TABLE_ID_TDT) {
     //OS_LOG(DVB_DEBUG,   "  TOT: Time Offset Table\n");
@@ -544,33 +585,66 @@ void TDvbSiStorage::HandleTotEvent(const TTotTable& tot)
   //OS_LOG(DVB_DEBUG,   "\tUTC time       : %" PRId64"\n", tot.GetUtcTimeBcd());
 }
 
+void TDvbSiStorage::HandleTdtEvent(time_t newTime)
+{
+  if (newTime > 0) {
+    OS_LOG(DVB_DEBUG,   "<%s> newTime = %ld\n", __FUNCTION__, newTime);
+    struct timeval timeVal;
+    timeVal.tv_sec = newTime;
+    int ret = settimeofday(&timeVal, NULL);
+    if (ret < 0) {
+      OS_LOG(DVB_ERROR,   "<%s> settimeofday(%ld) failed, %s\n", __FUNCTION__, newTime, strerror(errno));
+    }
+    StorageDb.UpdateTotStatus(true);
+  }
+  else {
+    OS_LOG(DVB_ERROR,   "<%s> MjdToDate() failed: %s\n", __FUNCTION__, strerror(errno));
+  }
+}
+
 void TDvbSiStorage::HandleBatEvent(const TBatTable& bat)
 {
-  ProcessBatEventCache(bat);
-  ProcessBatEventDb(bat);
+  bool isCompletion = ProcessBatEventCache(bat);
+  ProcessBatEventDb(bat, isCompletion);
 }
 
-void TDvbSiStorage::ProcessBatEventCache(const TBatTable& bat)
+// Only the arrival of the BAT is cached, the table itself goes to the database.
+// Returns true if the table completes the partial table of the same version.
+bool TDvbSiStorage::ProcessBatEventCache(const TBatTable& bat)
 {
-  std::lock_guard<std::mutex> lock(CacheDataMutex);
-  auto it = BatTableMap.find(bat.GetBouquetId());
-  if (it == BatTableMap.end()) {
-    OS_LOG(DVB_DEBUG,   "<%s> Adding BAT table to the map. Bouquet id: 0x%x\n", __FUNCTION__, bat.GetBouquetId());
-    BatTableMap.insert(std::make_pair(bat.GetBouquetId(), std::make_shared<TBatTable>(bat)));
-  }
-  else {
-    OS_LOG(DVB_DEBUG,   "<%s> BAT already in cache. Bouquet id: %d version: %d\n", __FUNCTION__, bat.GetBouquetId(),bat.GetVersionNumber());
-    if (bat.GetVersionNumber() == it->second->GetVersionNumber()) {
-      OS_LOG(DVB_DEBUG,   "<%s> BAT version matches (%d). Skipping\n", __FUNCTION__, bat.GetVersionNumber());
+  TTableLedgerEntry entry(bat.GetVersionNumber(), time(NULL), bat.GetTransportStreams().size(), bat.IsPartial());
+  bool isCompletion(false);
+  {
+    std::unique_lock<std::mutex> lock(LockLedger());
+    auto it = BatLedger.find(bat.GetBouquetId());
+    if (it == BatLedger.end()) {
+      OS_LOG(DVB_DEBUG,   "<%s> Adding BAT table to the ledger. Bouquet id: 0x%x\n", __FUNCTION__, bat.GetBouquetId());
     }
     else {
-      OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second->GetVersionNumber(), bat.GetVersionNumber());
-      it->second = std::make_shared<TBatTable>(bat);
+      OS_LOG(DVB_DEBUG,   "<%s> BAT already in ledger. Bouquet id: %d version: %d\n", __FUNCTION__, bat.GetBouquetId(),bat.GetVersionNumber());
+      if (bat.GetVersionNumber() == it->second.VersionNumber) {
+        if (bat.IsPartial() || !it->second.IsPartial) {
+          OS_LOG(DVB_DEBUG,   "<%s> BAT version matches (%d). Skipping\n", __FUNCTION__, bat.GetVersionNumber());
+          ++CacheSkippedWriteCount;
+          return false;
+        }
+        OS_LOG(DVB_DEBUG,   "<%s> BAT version %d complete\n", __FUNCTION__, bat.GetVersionNumber());
+        isCompletion = true;
+      }
+      else {
+        OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second.VersionNumber, bat.GetVersionNumber());
+      }
     }
+    BatLedger.erase(bat.GetBouquetId());
+    BatLedger.insert(std::make_pair(bat.GetBouquetId(), entry));
+    ++CachePublishCount;
   }
+  SignalCacheWaiters();
+  return isCompletion;
 }
 
-void TDvbSiStorage::ProcessBatEventDb(const TBatTable& bat)
+// isCompletion: the table completes a partial table of the same version already stored
+void TDvbSiStorage::ProcessBatEventDb(const TBatTable& bat, bool isCompletion)
 {
   int64_t network_fk(-1);
 
@@ -602,6 +676,9 @@ void TDvbSiStorage::ProcessBatEventDb(const TBatTable& bat)
   if (bat_fk > 0) {
     if (bat.GetVersionNumber() == batVersion) {
       OS_LOG(DVB_DEBUG,   "<%s> BAT version matches (%d). Skipping\n", __FUNCTION__, bat.GetVersionNumber());
+      if (isCompletion) {
+        ProcessBouquet(bat, true);
+      }
     }
     else {
       OS_LOG(DVB_DEBUG,   "<%s> Current version: %d, new version: %d\n", __FUNCTION__, batVersion, bat.GetVersionNumber());
@@ -617,7 +694,7 @@ void TDvbSiStorage::ProcessBatEventDb(const TBatTable& bat)
       StorageDb.SqlCommand(std::string("DELETE FROM BatTransportDescriptor WHERE fkey NOT IN " \
         " (SELECT DISTINCT bat_transport_pk FROM BatTransport);"));
       versionChange.CommitSqlStatements();
-      ProcessBouquet(bat);
+      ProcessBouquet(bat, false);
       bat_fk = StorageDb.FindPrimaryKey(cmdStr, batVersion);
     }
   }
@@ -630,7 +707,7 @@ void TDvbSiStorage::ProcessBatEventDb(const TBatTable& bat)
     cmd.Execute(bat_fk);
 
     OS_LOG(DVB_DEBUG,   "<%s> Insert bat_fk %ld\n", __FUNCTION__, bat_fk);
-    ProcessBouquet(bat);
+    ProcessBouquet(bat, false);
   }
   if (bat_fk > 0) {
     StorageDb.InsertDescriptor(static_cast<const char*>("BatDescriptor"), bat_fk, bat.GetBouquetDescriptors());
@@ -684,7 +761,8 @@ void TDvbSiStorage::ProcessBatEventDb(const TBatTable& bat)
   StorageDb.PerformUpdate();
 }
 
-int64_t TDvbSiStorage::ProcessBouquet(const TBatTable& bat)
+// isCompletion: the bouquet of the same version was stored from a partial table
+int64_t TDvbSiStorage::ProcessBouquet(const TBatTable& bat, bool isCompletion)
 {
   std::string cmdStr("SELECT bouquet_pk, version FROM Bouquet WHERE bouquet_id = ");
   std::stringstream ss;
@@ -698,6 +776,10 @@ int64_t TDvbSiStorage::ProcessBouquet(const TBatTable& bat)
   if (bouquet_fk > 0) {
     if (bat.GetVersionNumber() == bouquetVersion) {
       OS_LOG(DVB_DEBUG,   "<%s> BAT version matches (%d). Skipping\n", __FUNCTION__, bat.GetVersionNumber());
+      if (isCompletion) {
+        // The transports of the missing sections join the bouquet
+        UpdateBouquetTransports(bat, bouquet_fk);
+      }
     }
     else {
       OS_LOG(DVB_DEBUG,   "<%s> Current version: %d, new version: %d\n", __FUNCTION__, bouquetVersion, bat.GetVersionNumber());
@@ -760,81 +842,110 @@ int64_t TDvbSiStorage::ProcessBouquet(const TBatTable& bat)
     OS_LOG(DVB_DEBUG,   "<%s> Insert bouquet_fk %ld\n", __FUNCTION__, bouquet_fk);
     // Set bouquet_fk foreign key in Transport.
     if (bouquet_fk > 0) {
-      const std::vector<TTransportStream>& tsList = bat.GetTransportStreams();
-      for (auto it = tsList.begin(); it != tsList.end(); ++it)  {
-        std::string cmdStr("SELECT transport_pk FROM Transport WHERE original_network_id = ");
-         std::stringstream ss;
-        ss << it->GetOriginalNetworkId();
+      UpdateBouquetTransports(bat, bouquet_fk);
+    }
+  }
+  return bouquet_fk;
+}
+
+// Sets the bouquet_fk foreign key of the stored transports of the bouquet
+void TDvbSiStorage::UpdateBouquetTransports(const TBatTable& bat, int64_t bouquet_fk)
+{
+  const std::vector<TTransportStream>& tsList = bat.GetTransportStreams();
+  for (auto it = tsList.begin(); it != tsList.end(); ++it)  {
+    std::string cmdStr("SELECT transport_pk FROM Transport WHERE original_network_id = ");
+    std::stringstream ss;
+    ss << it->GetOriginalNetworkId();
+    cmdStr += ss.str();
+    cmdStr += " AND transport_id = ";
+
+    ss.str("");
+    ss << it->GetTsId();
+    cmdStr += ss.str();
+    cmdStr += ";";
+
+    int64_t transport_fk = StorageDb.FindPrimaryKey(cmdStr);
+    if (transport_fk > 0) {
+      TDvbDb::TCommand cmd(StorageDb, std::string("UPDATE Transport SET bouquet_fk = ? WHERE transport_pk = ?;"));
+      cmd.Bind(1, static_cast<long long int>(bouquet_fk));
+      cmd.Bind(2, static_cast<long long int>(transport_fk));
+      cmd.Execute();
+      // no change schedule an update 
+      if (StorageDb.GetNumberOfRowsModified() == 0) {
+        std::string cmdStr("UPDATE Transport SET bouquet_fk = ");
+        std::stringstream ss;
+        ss << bouquet_fk;
         cmdStr += ss.str();
-        cmdStr += " AND transport_id = ";
- 
+        cmdStr += " WHERE transport_pk = ";
+
         ss.str("");
-        ss << it->GetTsId();
+        ss << transport_fk;
         cmdStr += ss.str();
         cmdStr += ";";
- 
-        int64_t transport_fk = StorageDb.FindPrimaryKey(cmdStr);
-        if (transport_fk > 0) {
-          TDvbDb::TCommand cmd(StorageDb, std::string("UPDATE Transport SET bouquet_fk = ? WHERE transport_pk = ?;"));
-          cmd.Bind(1, static_cast<long long int>(bouquet_fk));
-          cmd.Bind(2, static_cast<long long int>(transport_fk));
-          cmd.Execute();
-          // no change schedule an update 
-          if (StorageDb.GetNumberOfRowsModified() == 0) {
-            std::string cmdStr("UPDATE Transport SET bouquet_fk = ");
-            std::stringstream ss;
-            ss << bouquet_fk;
-            cmdStr += ss.str();
-            cmdStr += " WHERE transport_pk = ";
- 
-            ss.str("");
-            ss << transport_fk;
-            cmdStr += ss.str();
-            cmdStr += ";";
-            StorageDb.AddUpdate(cmdStr.c_str());
-           }
-         }
-       }
-     }
-   }
-  return bouquet_fk;
+        StorageDb.AddUpdate(cmdStr.c_str());
+      }
+    }
+  }
 }
 
 void TDvbSiStorage::HandleEitEvent(const TEitTable& eit)
 {
   ProcessEitEventCache(eit);
+  EpgGridIndex.Update(eit);
+
+  TTableId tableId = eit.GetTableId();
+  if ((tableId == TTableId::TABLE_ID_EIT_PF) || (tableId == TTableId::TABLE_ID_EIT_PF_OTHER)) {
+    uint16_t serviceHandle(INVALID_SERVICE_HANDLE);
+    std::shared_ptr<const NowNextStruct> nowNext;
+    if (NowNextTable.Update(eit, serviceHandle, nowNext)) {
+      NotifyNowNextObserver(serviceHandle, nowNext);
+    }
+  }
   ProcessEitEventDb(eit);
 }
 
-void TDvbSiStorage::ProcessEitEventCache(const TEitTable& eit)
+// Only the arrival of the EIT is cached, the events go to the database.
+// Returns true if the table completes the partial table of the same version.
+bool TDvbSiStorage::ProcessEitEventCache(const TEitTable& eit)
 {
-  std::lock_guard<std::mutex> lock(CacheDataMutex);
-
   bool isPf(false);
   TTableId tableId = eit.GetTableId();
   if (tableId == TTableId::TABLE_ID_EIT_PF || tableId == TTableId::TABLE_ID_EIT_PF_OTHER) {
     isPf = true;
   }
 
+  TTableLedgerEntry entry(eit.GetVersionNumber(), time(NULL), eit.GetEvents().size(), eit.IsPartial());
+  bool isCompletion(false);
   std::tuple<uint16_t, uint16_t, uint16_t, bool> key(eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId(), isPf);
-  auto it = EitTableMap.find(key);
-  if (it == EitTableMap.end()) {
-    OS_LOG(DVB_DEBUG,   "<%s> Adding EIT table to the cache. nid.tsid.sid: 0x%x.0x%x.0x%x\n",
-      __FUNCTION__, eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
-
-    EitTableMap.insert(std::make_pair(key, std::make_shared<TEitTable>(eit)));
-  }
-  else {
-    OS_LOG(DVB_DEBUG, "<%s> EIT already in cache. nid.tsid.sid: 0x%x.0x%x.0x%x\n", __FUNCTION__,
-      eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
-    if (eit.GetVersionNumber() == it->second->GetVersionNumber()) {
-      OS_LOG(DVB_DEBUG,   "<%s> EIT version matches (0x%x). Skipping\n", __FUNCTION__, eit.GetVersionNumber());
+  {
+    std::unique_lock<std::mutex> lock(LockLedger());
+    auto it = EitLedger.find(key);
+    if (it == EitLedger.end()) {
+      OS_LOG(DVB_DEBUG,   "<%s> Adding EIT table to the ledger. nid.tsid.sid: 0x%x.0x%x.0x%x\n",
+        __FUNCTION__, eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
     }
     else {
-      OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second->GetVersionNumber(), eit.GetVersionNumber());
-      it->second = std::make_shared<TEitTable>(eit);
+      OS_LOG(DVB_DEBUG, "<%s> EIT already in ledger. nid.tsid.sid: 0x%x.0x%x.0x%x\n", __FUNCTION__,
+        eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
+      if (eit.GetVersionNumber() == it->second.VersionNumber) {
+        if (eit.IsPartial() || !it->second.IsPartial) {
+          OS_LOG(DVB_DEBUG,   "<%s> EIT version matches (0x%x). Skipping\n", __FUNCTION__, eit.GetVersionNumber());
+          ++CacheSkippedWriteCount;
+          return false;
+        }
+        OS_LOG(DVB_DEBUG,   "<%s> EIT version 0x%x complete\n", __FUNCTION__, eit.GetVersionNumber());
+        isCompletion = true;
+      }
+      else {
+        OS_LOG(DVB_DEBUG,   "<%s> Current version: 0x%x, new version: 0x%x\n", __FUNCTION__, it->second.VersionNumber, eit.GetVersionNumber());
+      }
     }
+    EitLedger.erase(key);
+    EitLedger.insert(std::make_pair(key, entry));
+    ++CachePublishCount;
   }
+  SignalCacheWaiters();
+  return isCompletion;
 }
 
 void TDvbSiStorage::ProcessEitEventDb(const TEitTable& eit)
@@ -867,6 +978,7 @@ void TDvbSiStorage::ProcessEitEventDb(const TEitTable& eit)
     int64_t eit_fk = StorageDb.FindPrimaryKey(cmdStr, eitVersion);
     // FOUND
     if (eit_fk > 0) {
+      // As for the SDT, the events a partial table missed are NOT FOUND and added by the complete table
       if (eit.GetVersionNumber() == eitVersion) {
         OS_LOG(DVB_DEBUG,   "<%s> EIT version matches (%d). Skipping\n", __FUNCTION__, eit.GetVersionNumber());
       }
@@ -1098,233 +1210,789 @@ int64_t  TDvbSiStorage::ProcessEventItem(const std::vector<TMpegDescriptor>& des
 }
 
 // Scan thread related methods
+
+// The scan is an event driven state machine. Tune completion and table arrival are
+// posted as events, timeouts are the deadlines of the tuners. The scan thread
+// never sleeps on a step and a queued event (restart, stop) is handled at once.
+// The jobs of a run are spread over the available tuners.
 void TDvbSiStorage::ScanThread()
 {
   OS_LOG(DVB_INFO,   "%s(): created\n", __FUNCTION__);
+  StartScanRun();
+
+  std::unique_lock<std::mutex> lock(ScanMutex);
   while (true) {
-    if (IsFastScan) {
-      DvbScanStatus.ScanState = TDvbScanState::SCAN_IN_PROGRESS_FAST;
-      if (!IsFastScanEnabled()) {
-        OS_LOG(DVB_ERROR,   "%s(): IsFastScanEnabled() failed\n", __FUNCTION__);
-        DvbScanStatus.ScanState = TDvbScanState::SCAN_FAILED;
-      }
-      else {
-        // It's enough to run the fast scan only once
-        IsFastScan = false;
-        continue;
+    if (!ThreadScanCondition.wait_until(lock, GetScanDeadline(), [this] { return !ScanEventQueue.empty(); })) {
+      lock.unlock();
+      HandleScanTimeout();
+      lock.lock();
+      continue;
+    }
+    TScanEvent event = ScanEventQueue.front();
+    ScanEventQueue.pop_front();
+    // The handlers take CacheWaitMutex and call the observers
+    lock.unlock();
+    if (event.Type == SCAN_EVENT_STOP) {
+      AbortScanRun();
+      OS_LOG(DVB_INFO,   "%s(): stopping\n", __FUNCTION__);
+      SetScanState(TDvbScanState::SCAN_STOPPED);
+      return;
+    }
+    HandleScanEvent(event);
+    lock.lock();
+  }
+}
+
+void TDvbSiStorage::PostScanEvent(const TScanEvent& event)
+{
+  std::lock_guard<std::mutex> lock(ScanMutex);
+  ScanEventQueue.push_back(event);
+  ThreadScanCondition.notify_one();
+}
+
+void TDvbSiStorage::HandleScanEvent(const TScanEvent& event)
+{
+  if (event.Type == SCAN_EVENT_RESTART) {
+    OS_LOG(DVB_INFO,   "%s(): restarting the scan\n", __FUNCTION__);
+    AbortScanRun();
+    StartScanRun();
+    return;
+  }
+  if (event.Tuner >= ScanTuners.size()) {
+    OS_LOG(DVB_ERROR,   "%s(): unknown tuner %d\n", __FUNCTION__, event.Tuner);
+    return;
+  }
+
+  TScanTuner& tuner = *ScanTuners[event.Tuner];
+  switch (event.Type) {
+  case SCAN_EVENT_TUNE_DONE:
+    if (tuner.Step == SCAN_STEP_TUNING) {
+      tuner.Step = SCAN_STEP_COLLECTING;
+      tuner.CollectStart = std::chrono::steady_clock::now();
+      StartScanPhase(tuner);
+    }
+    break;
+  case SCAN_EVENT_TUNE_FAILED:
+    if (tuner.Step == SCAN_STEP_TUNING) {
+      OS_LOG(DVB_ERROR,   "%s(): tuner %d: tune(%d) failed\n", __FUNCTION__, event.Tuner, tuner.Job.Frequency);
+      CompleteScanJob(tuner);
+    }
+    break;
+  case SCAN_EVENT_TABLES_READY:
+    // Tables of an earlier phase may complete after its timeout
+    if ((tuner.Step == SCAN_STEP_COLLECTING) && (event.Sequence == tuner.Sequence)) {
+      RecordAcquisitionTime(tuner, true);
+      CompleteScanPhase(tuner, true);
+    }
+    break;
+  case SCAN_EVENT_TUNER_LOST:
+    if (tuner.IsAvailable) {
+      OS_LOG(DVB_INFO,   "%s(): tuner %d taken\n", __FUNCTION__, event.Tuner);
+      tuner.IsAvailable = false;
+      if (tuner.Step != SCAN_STEP_IDLE) {
+        ReleaseScanTuner(tuner, true);
       }
     }
+    break;
+  case SCAN_EVENT_TUNER_AVAILABLE:
+    if (!tuner.IsAvailable) {
+      OS_LOG(DVB_INFO,   "%s(): tuner %d available\n", __FUNCTION__, event.Tuner);
+      tuner.IsAvailable = true;
+      DispatchScanJobs();
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void TDvbSiStorage::HandleScanTimeout()
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (!ScanRunActive) {
+    if (now >= ScanDeadline) {
+      StartScanRun();
+    }
+    return;
+  }
+  for (auto it = ScanTuners.begin(), end = ScanTuners.end(); it != end; ++it) {
+    TScanTuner& tuner = **it;
+    if ((tuner.Step == SCAN_STEP_IDLE) || (now < tuner.Deadline)) {
+      continue;
+    }
+    if (tuner.Step == SCAN_STEP_TUNING) {
+      OS_LOG(DVB_ERROR,   "%s(): tune(%d) timed out\n", __FUNCTION__, tuner.Job.Frequency);
+      CompleteScanJob(tuner);
+    }
     else {
-      DvbScanStatus.ScanState = TDvbScanState::SCAN_IN_PROGRESS_BKGD;
-      if (!IsBackgroundScanEnabled()) {
-        OS_LOG(DVB_ERROR,   "%s(): IsBackgroundScanEnabled() failed\n", __FUNCTION__);
-        DvbScanStatus.ScanState = TDvbScanState::SCAN_FAILED;
+      RecordAcquisitionTime(tuner, false);
+      CompleteScanPhase(tuner, false);
+    }
+    // The run may have finished or restarted, other expired tuners are handled on the next wake-up
+    return;
+  }
+}
+
+std::chrono::steady_clock::time_point TDvbSiStorage::GetScanDeadline()
+{
+  if (!ScanRunActive) {
+    return ScanDeadline;
+  }
+  // Nothing to time out while all the tuners are taken
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+  for (auto it = ScanTuners.begin(), end = ScanTuners.end(); it != end; ++it) {
+    if (((*it)->Step != SCAN_STEP_IDLE) && ((*it)->Deadline < deadline)) {
+      deadline = (*it)->Deadline;
+    }
+  }
+  return deadline;
+}
+
+void TDvbSiStorage::StartScanRun()
+{
+  ScanRunIsFast = IsFastScan;
+  OS_LOG(DVB_INFO, "%s: Started %s scan on %d tuner(s)\n", __FUNCTION__, ScanRunIsFast ? "fast" : "background", TunerCount.load());
+  {
+    std::lock_guard<std::mutex> lock(ScanStatusMutex);
+    DvbScanStatus.ScanState = ScanRunIsFast ? TDvbScanState::SCAN_IN_PROGRESS_FAST : TDvbScanState::SCAN_IN_PROGRESS_BKGD;
+    DvbScanStatus.TsList.clear();
+    DvbScanStatus.NaiveTuneCount = 0;
+    DvbScanStatus.PlannedTuneCount = 0;
+  }
+  ScanElapse.StartTimeMeasurement();
+  if (!IsAcquisitionHistoryLoaded) {
+    LoadAcquisitionHistory();
+  }
+
+  // All the tuners are idle between the runs
+  size_t tunerCount = TunerCount.load();
+  if (!tunerCount) {
+    tunerCount = 1;
+  }
+  while (ScanTuners.size() < tunerCount) {
+    ScanTuners.emplace_back(new TScanTuner(ScanTuners.size()));
+  }
+  ScanTuners.resize(tunerCount);
+
+  // Let's start over clean slate
+  ClearCachedTables();
+  ScanJobs.clear();
+  ScanJobs.emplace_back(HomeTsFrequency, HomeTsModulationMode, HomeTsSymbolRate, PreferredNetworkId, 0);
+  ScanJobs.back().Phases.push_back(SCAN_PHASE_NIT_BAT);
+  ScanJobs.back().Phases.push_back(SCAN_PHASE_HOME_SDT);
+  ScanJobs.back().Phases.push_back(SCAN_PHASE_HOME_INVENTORY);
+  ScanJobs.back().IsExclusive = true;
+  ScanRunActive = true;
+  DispatchScanJobs();
+}
+
+void TDvbSiStorage::FinishScanRun(bool isSuccess)
+{
+  AbortScanRun();
+  ScanElapse.FinishTimeMeasurement();
+
+  TCacheStats stats = GetCacheStats();
+  OS_LOG(DVB_INFO,   "%s(): cache publishes: %llu, skipped writes: %llu, write contentions: %llu, verified: %llu/%llu\n",
+    __FUNCTION__, (unsigned long long)stats.Publishes, (unsigned long long)stats.SkippedWrites,
+    (unsigned long long)stats.WriteContentions, (unsigned long long)stats.VerifiedTables, (unsigned long long)stats.RestoredTables);
+
+  if (isSuccess) {
+    // The run has the NIT, a previous SDT is only dropped once the run has the SDT again or its
+    // transport is gone from the NIT. A transport whose tune or SDT timed out keeps its services.
+    std::unique_lock<std::mutex> lock(LockCacheWrite());
+    std::shared_ptr<const TNitTableMap> nitMap = std::atomic_load(&NitTableMap);
+    std::shared_ptr<const TSdtTableMap> sdtMap = std::atomic_load(&SdtTableMap);
+    std::set<std::pair<uint16_t, uint16_t>> transports;
+    for (auto nit = nitMap->begin(), end = nitMap->end(); nit != end; ++nit) {
+      const std::vector<TTransportStream>& tsList = nit->second->GetTransportStreams();
+      for (auto ts = tsList.begin(), tsEnd = tsList.end(); ts != tsEnd; ++ts) {
+        transports.insert(std::make_pair(ts->GetOriginalNetworkId(), ts->GetTsId()));
       }
-      else {
-        OS_LOG(DVB_INFO,   "%s(): scan completed successfully\n", __FUNCTION__);
-        DvbScanStatus.ScanState = TDvbScanState::SCAN_COMPLETED;
+    }
+    std::shared_ptr<TSdtTableMap> previousSdtMap(new TSdtTableMap());
+    std::shared_ptr<const TSdtTableMap> currentPreviousSdtMap = std::atomic_load(&PreviousSdtTableMap);
+    for (auto it = currentPreviousSdtMap->begin(), end = currentPreviousSdtMap->end(); it != end; ++it) {
+      if ((transports.find(it->first) != transports.end()) && (sdtMap->find(it->first) == sdtMap->end())) {
+        OS_LOG(DVB_INFO,   "%s(): keeping the previous SDT of 0x%x.0x%x\n", __FUNCTION__, it->first.first, it->first.second);
+        previousSdtMap->insert(*it);
       }
     }
-    StorageDb.Audits();
-    // Let's check if we need to stop the scan
-    {
-       std::unique_lock<std::mutex> lk(ScanMutex);
-       // TODO: Handle spurious wake-ups
-       if (ThreadScanCondition.wait_for(lk, std::chrono::seconds(IsFastScan ? 30 : BackGroundScanInterval)) == std::cv_status::no_timeout) {
-         OS_LOG(DVB_INFO,   "%s(): stopping\n", __FUNCTION__);
-         DvbScanStatus.ScanState = TDvbScanState::SCAN_STOPPED;
-         return;
-       }
-     }
-   }
-}
-
-bool TDvbSiStorage::IsFastScanEnabled()
-{
-  OS_LOG(DVB_INFO, "%s: Started\n", __FUNCTION__);
-  DvbScanStatus.TsList.clear();
-  if (!ScanHome()) {
-    OS_LOG(DVB_ERROR,   "%s: ScanHome() failed\n", __FUNCTION__);
-    return false;
+    std::atomic_store(&PreviousNitTableMap, std::shared_ptr<const TNitTableMap>(new TNitTableMap()));
+    std::atomic_store(&PreviousSdtTableMap, std::shared_ptr<const TSdtTableMap>(previousSdtMap));
+    CachePublishCount += 2;
   }
-//    rmf_DvbTuner tuner;
 
-  std::vector<std::shared_ptr<TStorageTransportStreamStruct>> tsList = GetTsListByNetIdCache(PreferredNetworkId);
-  for (auto it = tsList.begin(), end = tsList.end(); it != end; ++it) {
-    TDvbSiTableStatus status;
-    // collect SDTa & EITa pf
-    TSdtTable* sdt = new TSdtTable((uint8_t)TTableId::TABLE_ID_SDT, (*it)->TransportStreamId, 0, true);
-    sdt->SetOriginalNetworkId((*it)->NetworkId);
-    std::vector<std::shared_ptr<TSiTable>> tables;
-    tables.emplace_back(sdt);
-    std::vector<std::shared_ptr<ServiceStruct>> serviceList = GetServiceListByTsIdCache((*it)->NetworkId, (*it)->TransportStreamId);
-    for (auto srv = serviceList.begin(), end = serviceList.end(); srv != end; ++srv) {
-      OS_LOG(DVB_DEBUG,   "%s:%d: Adding EITpf(0x%x.0x%x.0x%x) to the list\n",
-        __FUNCTION__, __LINE__, (*it)->NetworkId, (*it)->TransportStreamId, (*srv)->ServiceId);
+  if (ScanRunIsFast) {
+    if (isSuccess) {
+      // It's enough to run the fast scan only once
+      IsFastScan = false;
+      StartScanRun();
+      return;
+    }
+    OS_LOG(DVB_ERROR,   "%s(): fast scan failed\n", __FUNCTION__);
+    SetScanState(TDvbScanState::SCAN_FAILED);
+  }
+  else if (isSuccess) {
+    OS_LOG(DVB_INFO,   "%s(): scan completed successfully\n", __FUNCTION__);
+    SetScanState(TDvbScanState::SCAN_COMPLETED);
+  }
+  else {
+    OS_LOG(DVB_ERROR,   "%s(): background scan failed\n", __FUNCTION__);
+    SetScanState(TDvbScanState::SCAN_FAILED);
+  }
+  OS_LOG(DVB_INFO,   "%s(): scan took %lf seconds\n", __FUNCTION__, ScanElapse.GetElapsedTime());
+  StorageDb.Audits();
 
-      TEitTable* eit = new TEitTable((uint8_t)TTableId::TABLE_ID_EIT_PF, (*srv)->ServiceId, 0, true);
-      eit->SetNetworkId((*it)->NetworkId);
-      eit->SetTsId((*it)->TransportStreamId);
-      tables.emplace_back(eit);
+  ScanDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(IsFastScan ? 30 : BackGroundScanInterval);
+}
+
+// Drops the remaining jobs of the current run and releases the tuners
+void TDvbSiStorage::AbortScanRun()
+{
+  for (auto it = ScanTuners.begin(), end = ScanTuners.end(); it != end; ++it) {
+    if ((*it)->Step != SCAN_STEP_IDLE) {
+      ReleaseScanTuner(**it, false);
+    }
+  }
+  ScanJobs.clear();
+  ScanRunActive = false;
+}
+
+// Hands the waiting jobs to the idle tuners and finishes the run once all of them are done
+void TDvbSiStorage::DispatchScanJobs()
+{
+  bool isExclusiveBusy = false;
+  size_t busyCount = 0;
+  for (auto it = ScanTuners.begin(), end = ScanTuners.end(); it != end; ++it) {
+    if ((*it)->Step != SCAN_STEP_IDLE) {
+      ++busyCount;
+      isExclusiveBusy = isExclusiveBusy || (*it)->Job.IsExclusive;
     }
-    if (IsFastScan && CheckCacheTableCollections(tables, 0)) {
-      OS_LOG(DVB_INFO, "%s:%d: SDTa(0x%x.0x%x) & EITa pf already received. Skipping.\n",
-        __FUNCTION__, __LINE__, (*it)->NetworkId, sdt->GetTableExtensionId());
-      status.SdtAcquired = true;
-      status.EitPfAcquired = true;
+  }
+
+  while (!ScanJobs.empty() && !isExclusiveBusy) {
+    // Tables harvested on the other tuners since the job was planned
+    TScanJob& job = ScanJobs.front();
+    if (PlanScanJob(job)) {
+      std::lock_guard<std::mutex> lock(ScanStatusMutex);
+      DvbScanStatus.TsList.emplace_back(job.Frequency, job.Status);
+      --DvbScanStatus.PlannedTuneCount;
+      ScanJobs.pop_front();
+      continue;
     }
-    else {
-      OS_LOG(DVB_INFO,   "%s:%d: tune(%d)\n", __FUNCTION__, __LINE__, (*it)->Frequency);
-      NotifyDvbStorageTuneObserver((*it)->Frequency, (*it)->Modulation, (*it)->SymbolRate);
-      OS_LOG(DVB_INFO,   "%s:%d: Collecting SDTa & EITs pf\n", __FUNCTION__, __LINE__);
-      if (CheckCacheTableCollections(tables, SDT_TIMEOUT > EIT_PF_TIMEOUT ? SDT_TIMEOUT : EIT_PF_TIMEOUT)) {
-        OS_LOG(DVB_INFO,   "%s:%d: SDT(0x%x.0x%x) & EITs pf received\n",
-          __FUNCTION__, __LINE__, (*it)->NetworkId, sdt->GetTableExtensionId());
-        status.SdtAcquired = true;
-        status.EitPfAcquired = true;
-      }
-      else {
-        OS_LOG(DVB_ERROR,   "%s:%d: SDT(0x%x.0x%x) and/or EITs pf not received\n",
-        __FUNCTION__, __LINE__, (*it)->NetworkId, sdt->GetTableExtensionId());
+    if (job.IsExclusive && busyCount) {
+      break;
+    }
+    auto tuner = std::find_if(ScanTuners.begin(), ScanTuners.end(), [](const std::unique_ptr<TScanTuner>& t) {
+      return t->IsAvailable && (t->Step == SCAN_STEP_IDLE);
+    });
+    if (tuner == ScanTuners.end()) {
+      if (!busyCount) {
+        OS_LOG(DVB_INFO,   "%s(): all the tuners are taken, %lu jobs waiting\n", __FUNCTION__, ScanJobs.size());
       }
-      OS_LOG(DVB_INFO,   "%s:%d: untune(%d)\n", __FUNCTION__, __LINE__, (*it)->Frequency);
-      NotifyDvbStorageUnTuneObserver();
+      break;
     }
-    DvbScanStatus.TsList.emplace_back((*it)->Frequency, status);
+    (*tuner)->Job = job;
+    ScanJobs.pop_front();
+    ++busyCount;
+    isExclusiveBusy = (*tuner)->Job.IsExclusive;
+    StartScanJob(**tuner);
+  }
+
+  if (ScanRunActive && ScanJobs.empty() && !busyCount) {
+    FinishScanRun(true);
   }
-  OS_LOG(DVB_ERROR,   "%s:%d: Done\n", __FUNCTION__, __LINE__);
-  return true;
 }
 
-bool TDvbSiStorage::IsBackgroundScanEnabled()
+// Drops the phases whose tables are already cached, e.g. from the SDT other and
+// EIT other tables of the multiplexes tuned so far. Returns true if the job needs no tune.
+bool TDvbSiStorage::PlanScanJob(TScanJob& job)
 {
-  OS_LOG(DVB_INFO,   "%s: Started\n", __FUNCTION__);
-  DvbScanStatus.TsList.clear();
-
-  if (!ScanHome()) {
-    OS_LOG(DVB_ERROR,   "%s: ScanHome() failed\n", __FUNCTION__);
+  if (job.IsExclusive || !IsScanPhaseCached(job, SCAN_PHASE_SDT)) {
+    // The services and so the EIT tables of the transport are not known yet
     return false;
   }
-  std::vector<std::shared_ptr<TSiTable>> fullEitSchedule;
+  for (auto phase = job.Phases.begin(); phase != job.Phases.end(); ) {
+    if (IsScanPhaseCached(job, *phase)) {
+      SetScanPhaseStatus(job.Status, *phase, true);
+      phase = job.Phases.erase(phase);
+    }
+    else {
+      ++phase;
+    }
+  }
+  if (job.Phases.empty()) {
+    OS_LOG(DVB_INFO, "%s:%d: ts(0x%x.0x%x) tables already received. Skipping.\n",
+      __FUNCTION__, __LINE__, job.NetworkId, job.TransportStreamId);
+    return true;
+  }
+  return false;
+}
+
+bool TDvbSiStorage::IsScanPhaseCached(const TScanJob& job, TScanPhase phase)
+{
+  std::vector<std::shared_ptr<TSiTable>> tables = GetScanPhaseTables(job, phase);
+  return CheckCacheTableCollections(tables, 0);
+}
+
+// Expected time on the tuner in milliseconds, the sum of the phase timeouts
+int TDvbSiStorage::GetScanJobCost(const TScanJob& job)
+{
+  int cost = TUNE_TIMEOUT * 1000;
+  for (auto phase = job.Phases.begin(), end = job.Phases.end(); phase != end; ++phase) {
+    cost += GetScanPhaseTimeout(job, *phase);
+  }
+  return cost;
+}
+
+void TDvbSiStorage::StartScanJob(TScanTuner& tuner)
+{
+  uint8_t tunerIndex = tuner.Index;
+  if (tuner.Job.Phases.front() == SCAN_PHASE_BARKER_EIT) {
+    OS_LOG(DVB_DEBUG,   "%s:%d: Clearing cached EIT tables\n", __FUNCTION__, __LINE__);
+    std::unique_lock<std::mutex> lock(LockLedger());
+    EitLedger.clear();
+    ++CachePublishCount;
+  }
+
+  // Tune completion reported for an earlier tune is stale
+  {
+    std::lock_guard<std::mutex> lock(ScanMutex);
+    ScanEventQueue.erase(std::remove_if(ScanEventQueue.begin(), ScanEventQueue.end(),
+      [tunerIndex](const TScanEvent& event) {
+        return (event.Tuner == tunerIndex) && ((event.Type == SCAN_EVENT_TUNE_DONE) || (event.Type == SCAN_EVENT_TUNE_FAILED));
+      }), ScanEventQueue.end());
+  }
+  tuner.Step = SCAN_STEP_TUNING;
+  tuner.Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(TUNE_TIMEOUT);
+  tuner.IsTuned = true;
+  OS_LOG(DVB_INFO,   "%s:%d: tuner %d: tune(%d)\n", __FUNCTION__, __LINE__, tunerIndex, tuner.Job.Frequency);
+  for (auto it = ObserverVector.begin(), end = ObserverVector.end(); it != end; ++it) {
+    (*it)->Tune(tunerIndex, tuner.Job.Frequency, tuner.Job.Modulation, tuner.Job.SymbolRate);
+  }
+}
+
+void TDvbSiStorage::StartScanPhase(TScanTuner& tuner)
+{
+  TScanJob& job = tuner.Job;
+  if (job.PhaseIndex >= job.Phases.size()) {
+    CompleteScanJob(tuner);
+    return;
+  }
+  TScanPhase phase = job.Phases[job.PhaseIndex];
+  std::vector<std::shared_ptr<TSiTable>> tables = GetScanPhaseTables(job, phase);
+  int timeout = GetScanPhaseTimeout(job, phase);
+  if (phase == SCAN_PHASE_HOME_INVENTORY) {
+    // Bounded by the time since the tune: the other tables had the earlier home phases to arrive too
+    int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tuner.CollectStart).count();
+    timeout = std::max(timeout - elapsed, 0);
+  }
+  OS_LOG(DVB_INFO,   "%s:%d: Collecting %lu tables on %d, phase %d, timeout %d ms\n",
+    __FUNCTION__, __LINE__, tables.size(), job.Frequency, phase, timeout);
+  if (ArmScanWait(tuner, tables, timeout)) {
+    CompleteScanPhase(tuner, true);
+  }
+}
+
+void TDvbSiStorage::CompleteScanPhase(TScanTuner& tuner, bool isReceived)
+{
+  DisarmScanWait(tuner);
+  TScanJob& job = tuner.Job;
+  TScanPhase phase = job.Phases[job.PhaseIndex];
+  if ((phase == SCAN_PHASE_HOME_INVENTORY) && isReceived && !IsScanPhaseCached(job, phase)) {
+    // The SDT other received meanwhile named more services, wait for their EIT p/f other too
+    StartScanPhase(tuner);
+    return;
+  }
+  // The inventory only saves tunes, it is not expected to be complete
+  OS_LOG((isReceived || (phase == SCAN_PHASE_HOME_INVENTORY)) ? DVB_INFO : DVB_ERROR,   "%s:%d: Tables on %d, phase %d %s\n",
+    __FUNCTION__, __LINE__, job.Frequency, phase, isReceived ? "received" : "not received");
+
+  if ((phase == SCAN_PHASE_NIT_BAT) && !isReceived) {
+    OS_LOG(DVB_ERROR,   "%s:%d: NIT & BAT(s) not found\n", __FUNCTION__, __LINE__);
+    FinishScanRun(false);
+    return;
+  }
+  SetScanPhaseStatus(job.Status, phase, isReceived);
+
+  ++job.PhaseIndex;
+  StartScanPhase(tuner);
+}
+
+void TDvbSiStorage::SetScanPhaseStatus(TDvbSiTableStatus& status, TScanPhase phase, bool isReceived)
+{
+  switch (phase) {
+  case SCAN_PHASE_NIT_BAT:
+    status.NitAcquired = isReceived;
+    status.BatAcquired = isReceived;
+    break;
+  case SCAN_PHASE_HOME_SDT:
+  case SCAN_PHASE_SDT:
+    status.SdtAcquired = isReceived;
+    break;
+  case SCAN_PHASE_SDT_EIT_PF:
+    status.SdtAcquired = isReceived;
+    status.EitPfAcquired = isReceived;
+    break;
+  case SCAN_PHASE_EIT_PF:
+    status.EitPfAcquired = isReceived;
+    break;
+  case SCAN_PHASE_EIT_SCHED:
+  case SCAN_PHASE_BARKER_EIT:
+    status.EitAcquired = isReceived;
+    break;
+  case SCAN_PHASE_HOME_INVENTORY:
+    // The tables of the other transports, their jobs report them
+    break;
+  }
+}
+
+void TDvbSiStorage::CompleteScanJob(TScanTuner& tuner)
+{
+  TScanJob& job = tuner.Job;
+  ReleaseScanTuner(tuner, false);
+  {
+    std::lock_guard<std::mutex> lock(ScanStatusMutex);
+    DvbScanStatus.TsList.emplace_back(job.Frequency, job.Status);
+  }
+
+  if (job.Phases.front() == SCAN_PHASE_NIT_BAT) {
+    if (!job.Status.NitAcquired) {
+      FinishScanRun(false);
+      return;
+    }
+    AddTransportScanJobs();
+  }
+  DispatchScanJobs();
+}
+
+// Ends the job of the tuner. A job interrupted by losing the tuner goes back to the queue.
+void TDvbSiStorage::ReleaseScanTuner(TScanTuner& tuner, bool isLost)
+{
+  DisarmScanWait(tuner);
+  if (tuner.IsTuned && !isLost) {
+    OS_LOG(DVB_INFO,   "%s:%d: tuner %d: untune(%d)\n", __FUNCTION__, __LINE__, tuner.Index, tuner.Job.Frequency);
+    for (auto it = ObserverVector.begin(), end = ObserverVector.end(); it != end; ++it) {
+      (*it)->UnTune(tuner.Index);
+    }
+  }
+  tuner.IsTuned = false;
+  tuner.Step = SCAN_STEP_IDLE;
+
+  if (isLost && ScanRunActive) {
+    // The phases planned away from the cache keep their status
+    tuner.Job.PhaseIndex = 0;
+    for (auto phase = tuner.Job.Phases.begin(), end = tuner.Job.Phases.end(); phase != end; ++phase) {
+      SetScanPhaseStatus(tuner.Job.Status, *phase, false);
+    }
+    ScanJobs.push_front(tuner.Job);
+    DispatchScanJobs();
+  }
+}
+
+// The transport streams of the preferred network, known once the home tables are in.
+// Only the transports with tables missing from the cache are tuned, the longest jobs
+// first so that the tuners finish together, then in frequency order from home.
+void TDvbSiStorage::AddTransportScanJobs()
+{
+  std::vector<TScanJob> jobs;
   std::vector<std::shared_ptr<TStorageTransportStreamStruct>> tsList = GetTsListByNetIdCache(PreferredNetworkId);
   for (auto it = tsList.begin(), end = tsList.end(); it != end; ++it) {
-    TDvbSiTableStatus status;
-    OS_LOG(DVB_INFO,   "%s:%d: tune(%d)\n", __FUNCTION__, __LINE__, (*it)->Frequency);
-    NotifyDvbStorageTuneObserver((*it)->Frequency, (*it)->Modulation, (*it)->SymbolRate);
-    IsTuneDone();
-    // collect SDTa & EITa pf
-    // SDTa
-    TSdtTable* sdt = new TSdtTable((uint8_t)TTableId::TABLE_ID_SDT, (*it)->TransportStreamId, 0, true);
-    sdt->SetOriginalNetworkId((*it)->NetworkId);
-
-    std::vector<std::shared_ptr<TSiTable>> tables;
-    std::vector<std::shared_ptr<TSiTable>> eitSchedule;
-    tables.emplace_back(sdt);
+    jobs.emplace_back((*it)->Frequency, (*it)->Modulation, (*it)->SymbolRate, (*it)->NetworkId, (*it)->TransportStreamId);
+    TScanJob& job = jobs.back();
+    if (ScanRunIsFast) {
+      job.Phases.push_back(SCAN_PHASE_SDT_EIT_PF);
+    }
+    else {
+      job.Phases.push_back(SCAN_PHASE_SDT);
+      job.Phases.push_back(SCAN_PHASE_EIT_PF);
+      if ((*it)->Frequency != BarkerFrequency) {
+        job.Phases.push_back(SCAN_PHASE_EIT_SCHED);
+      }
+      else {
+        OS_LOG(DVB_INFO,   "%s:%d: Not collecting EITa sched on barker(%d)\n",
+          __FUNCTION__, __LINE__, (*it)->Frequency);
+      }
+    }
+  }
+  uint32_t naiveCount = jobs.size();
 
-    OS_LOG(DVB_INFO,   "%s:%d: Collecting SDTa(0x%x.0x%x)\n",
-      __FUNCTION__, __LINE__, (*it)->NetworkId, sdt->GetTableExtensionId());
-    if (CheckCacheTableCollections(tables, SDT_TIMEOUT)) {
-      OS_LOG(DVB_INFO,   "%s:%d: SDTa(0x%x.0x%x) received\n",
-        __FUNCTION__, __LINE__, (*it)->NetworkId, sdt->GetTableExtensionId());
-      status.SdtAcquired = true;
+  std::vector<TScanJob> plannedJobs;
+  for (auto job = jobs.begin(), end = jobs.end(); job != end; ++job) {
+    if (PlanScanJob(*job)) {
+      std::lock_guard<std::mutex> lock(ScanStatusMutex);
+      DvbScanStatus.TsList.emplace_back(job->Frequency, job->Status);
     }
     else {
-      OS_LOG(DVB_ERROR,   "%s:%d: SDTa(0x%x.0x%x) not received\n",
-       __FUNCTION__, __LINE__, (*it)->NetworkId, sdt->GetTableExtensionId());
-     }
-     tables.clear();
-
-     //EITa shed & EITa pf
-     std::vector<std::shared_ptr<ServiceStruct>> serviceList = GetServiceListByTsIdCache((*it)->NetworkId, (*it)->TransportStreamId);
-     for (auto srv = serviceList.begin(), end = serviceList.end(); srv != end; ++srv) {
-       OS_LOG(DVB_DEBUG,   "%s:%d: Adding EITsched(0x%x.0x%x.0x%x) to the list\n",
-         __FUNCTION__, __LINE__, (*it)->NetworkId, (*it)->TransportStreamId, (*srv)->ServiceId);
-
-       TEitTable* eitSched = new TEitTable((uint8_t)TTableId::TABLE_ID_EIT_SCHED_START, (*srv)->ServiceId, 0, true);
-       eitSched->SetNetworkId((*it)->NetworkId);
-       eitSched->SetTsId((*it)->TransportStreamId);
-       eitSchedule.emplace_back(eitSched);
-
-       TEitTable* eit = new TEitTable((uint8_t)TTableId::TABLE_ID_EIT_PF, (*srv)->ServiceId, 0, true);
-       eit->SetNetworkId((*it)->NetworkId);
-       eit->SetTsId((*it)->TransportStreamId);
-       tables.emplace_back(eit);
-     }
-     fullEitSchedule.insert(fullEitSchedule.end(), eitSchedule.begin(), eitSchedule.end());
-
-     OS_LOG(DVB_INFO,   "%s:%d: Collecting EITa pf\n", __FUNCTION__, __LINE__);
-     if (CheckCacheTableCollections(tables, EIT_PF_TIMEOUT)) {
-       OS_LOG(DVB_INFO,   "%s:%d: EITa pf received\n",
-         __FUNCTION__, __LINE__);
-       status.EitPfAcquired = true;
-     }
-     else {
-       OS_LOG(DVB_ERROR,   "%s:%d: EITa pf not received\n",
-         __FUNCTION__, __LINE__);
-     }
-     if ((*it)->Frequency != BarkerFrequency) {
-       OS_LOG(DVB_INFO,   "%s:%d: Collecting EITa sched\n", __FUNCTION__, __LINE__);
-       if (CheckCacheTableCollections(eitSchedule, EIT_8_DAY_SCHED_TIMEOUT)) {
-         OS_LOG(DVB_INFO,   "%s:%d: EITsched received\n", __FUNCTION__, __LINE__);
-         status.EitAcquired = true;
-       }
-       else {
-         OS_LOG(DVB_ERROR,   "%s:%d: EITsched not received\n", __FUNCTION__, __LINE__);
-       }
-     }
-     else {
-       OS_LOG(DVB_INFO,   "%s:%d: Not collecting EITa sched on barker(%d)\n",
-         __FUNCTION__, __LINE__, (*it)->Frequency);
-     }
-     OS_LOG(DVB_INFO,   "%s:%d: untune(%d)\n", __FUNCTION__, __LINE__, (*it)->Frequency);
-     NotifyDvbStorageUnTuneObserver();
-     DvbScanStatus.TsList.emplace_back((*it)->Frequency, status);
+      plannedJobs.push_back(*job);
+    }
   }
+  uint32_t homeFrequency = HomeTsFrequency;
+  std::stable_sort(plannedJobs.begin(), plannedJobs.end(), [this, homeFrequency](const TScanJob& a, const TScanJob& b) {
+    int costA = GetScanJobCost(a);
+    int costB = GetScanJobCost(b);
+    if (costA != costB) {
+      return costA > costB;
+    }
+    uint32_t distanceA = a.Frequency > homeFrequency ? a.Frequency - homeFrequency : homeFrequency - a.Frequency;
+    uint32_t distanceB = b.Frequency > homeFrequency ? b.Frequency - homeFrequency : homeFrequency - b.Frequency;
+    return distanceA < distanceB;
+  });
+  ScanJobs.insert(ScanJobs.end(), plannedJobs.begin(), plannedJobs.end());
 
   // Sitting on barker ts
-  if (BarkerFrequency && BarkerModulationMode && BarkerSymbolRate) {
-    TDvbSiTableStatus status;
-    // Clear cached EIT tables
-    {
-      OS_LOG(DVB_DEBUG,   "%s:%d: Clearing cached EIT tables\n", __FUNCTION__, __LINE__);
-      std::lock_guard<std::mutex> lock(CacheDataMutex);
-      EitTableMap.clear();
-    }
-    OS_LOG(DVB_INFO,   "%s:%d: tune(%d) barker\n", __FUNCTION__, __LINE__, BarkerFrequency);
-    NotifyDvbStorageTuneObserver(BarkerFrequency, BarkerModulationMode, BarkerSymbolRate);
-    IsTuneDone();
-    OS_LOG(DVB_INFO,   "%s:%d: Collecting EIT sched (barker)\n", __FUNCTION__, __LINE__);
-    if (CheckCacheTableCollections(fullEitSchedule, BarkerEitTimout)) {
-      OS_LOG(DVB_INFO,   "%s:%d: EITsched received (barker)\n", __FUNCTION__, __LINE__);
-      status.EitAcquired = true;
+  if (!ScanRunIsFast && BarkerFrequency && BarkerModulationMode && BarkerSymbolRate) {
+    ScanJobs.emplace_back(BarkerFrequency, BarkerModulationMode, BarkerSymbolRate, PreferredNetworkId, 0);
+    ScanJobs.back().Phases.push_back(SCAN_PHASE_BARKER_EIT);
+    ScanJobs.back().IsExclusive = true;
+    ++naiveCount;
+  }
+
+  std::lock_guard<std::mutex> lock(ScanStatusMutex);
+  DvbScanStatus.NaiveTuneCount = naiveCount + 1;
+  DvbScanStatus.PlannedTuneCount = ScanJobs.size() + 1;
+  OS_LOG(DVB_INFO,   "%s:%d: %u tunes planned, %u without the cached tables\n",
+    __FUNCTION__, __LINE__, DvbScanStatus.PlannedTuneCount, DvbScanStatus.NaiveTuneCount);
+}
+
+std::vector<std::shared_ptr<TSiTable>> TDvbSiStorage::GetScanPhaseTables(const TScanJob& job, TScanPhase phase)
+{
+  std::vector<std::shared_ptr<TSiTable>> tables;
+  switch (phase) {
+  case SCAN_PHASE_NIT_BAT:
+    tables.emplace_back(new TNitTable((uint8_t)TTableId::TABLE_ID_NIT, PreferredNetworkId, 0, true));
+    for (auto it = HomeBouquetsVector.begin(), end = HomeBouquetsVector.end(); it != end; ++it) {
+      OS_LOG(DVB_DEBUG,   "%s:%d: Adding BAT(0x%x) to the list\n", __FUNCTION__, __LINE__, *it);
+      tables.emplace_back(new TBatTable((uint8_t)TTableId::TABLE_ID_BAT, *it, 0, true));
     }
-    else {
-      OS_LOG(DVB_ERROR,   "%s:%d: EITsched not received (barker)\n", __FUNCTION__, __LINE__);
+    break;
+  case SCAN_PHASE_HOME_SDT: {
+    // SDT actual of the home ts, all the SDTs for the fast scan
+    std::vector<std::shared_ptr<TStorageTransportStreamStruct>> tsList = GetTsListByNetIdCache(PreferredNetworkId);
+    for (auto it = tsList.begin(), end = tsList.end(); it != end; ++it) {
+      if (ScanRunIsFast || (HomeTsFrequency == (*it)->Frequency)) {
+        OS_LOG(DVB_DEBUG,   "%s:%d: Adding SDT(0x%x.0x%x) to the list\n",
+          __FUNCTION__, __LINE__, (*it)->NetworkId, (*it)->TransportStreamId);
+        TSdtTable* sdt = new TSdtTable((uint8_t)TTableId::TABLE_ID_SDT, (*it)->TransportStreamId, 0, true);
+        sdt->SetOriginalNetworkId((*it)->NetworkId);
+        tables.emplace_back(sdt);
+        if (!ScanRunIsFast) {
+          break;
+        }
+      }
     }
-    OS_LOG(DVB_INFO,   "%s:%d: untune(%d)\n", __FUNCTION__, __LINE__, BarkerFrequency);
-    NotifyDvbStorageUnTuneObserver();
-    DvbScanStatus.TsList.emplace_back(BarkerFrequency, status);
+    break;
   }
-  OS_LOG(DVB_INFO,   "%s:%d: Done\n", __FUNCTION__, __LINE__);
-  return true;
+  case SCAN_PHASE_SDT_EIT_PF:
+  case SCAN_PHASE_SDT: {
+    TSdtTable* sdt = new TSdtTable((uint8_t)TTableId::TABLE_ID_SDT, job.TransportStreamId, 0, true);
+    sdt->SetOriginalNetworkId(job.NetworkId);
+    tables.emplace_back(sdt);
+    if (phase == SCAN_PHASE_SDT) {
+      break;
+    }
+  }
+  // fall through
+  case SCAN_PHASE_EIT_PF:
+  case SCAN_PHASE_EIT_SCHED: {
+    bool isSched = (phase == SCAN_PHASE_EIT_SCHED);
+    std::vector<std::shared_ptr<ServiceStruct>> serviceList = GetServiceListByTsIdCache(job.NetworkId, job.TransportStreamId);
+    for (auto srv = serviceList.begin(), end = serviceList.end(); srv != end; ++srv) {
+      OS_LOG(DVB_DEBUG,   "%s:%d: Adding EIT%s(0x%x.0x%x.0x%x) to the list\n",
+        __FUNCTION__, __LINE__, isSched ? "sched" : "pf", job.NetworkId, job.TransportStreamId, (*srv)->ServiceId);
+      TEitTable* eit = new TEitTable((uint8_t)(isSched ? TTableId::TABLE_ID_EIT_SCHED_START : TTableId::TABLE_ID_EIT_PF),
+        (*srv)->ServiceId, 0, true);
+      eit->SetNetworkId(job.NetworkId);
+      eit->SetTsId(job.TransportStreamId);
+      tables.emplace_back(eit);
+    }
+    break;
+  }
+  case SCAN_PHASE_BARKER_EIT: {
+    // The schedules of all the transports are collected again on the barker ts
+    std::vector<std::shared_ptr<TStorageTransportStreamStruct>> tsList = GetTsListByNetIdCache(PreferredNetworkId);
+    for (auto it = tsList.begin(), end = tsList.end(); it != end; ++it) {
+      TScanJob tsJob((*it)->Frequency, (*it)->Modulation, (*it)->SymbolRate, (*it)->NetworkId, (*it)->TransportStreamId);
+      std::vector<std::shared_ptr<TSiTable>> eitSchedule = GetScanPhaseTables(tsJob, SCAN_PHASE_EIT_SCHED);
+      tables.insert(tables.end(), eitSchedule.begin(), eitSchedule.end());
+    }
+    break;
+  }
+  case SCAN_PHASE_HOME_INVENTORY: {
+    // SDT other of the other transports and EIT p/f other of their services known so far
+    std::vector<std::shared_ptr<TStorageTransportStreamStruct>> tsList = GetTsListByNetIdCache(PreferredNetworkId);
+    for (auto it = tsList.begin(), end = tsList.end(); it != end; ++it) {
+      if ((*it)->Frequency == HomeTsFrequency) {
+        continue;
+      }
+      TScanJob tsJob((*it)->Frequency, (*it)->Modulation, (*it)->SymbolRate, (*it)->NetworkId, (*it)->TransportStreamId);
+      std::vector<std::shared_ptr<TSiTable>> other = GetScanPhaseTables(tsJob, SCAN_PHASE_SDT_EIT_PF);
+      tables.insert(tables.end(), other.begin(), other.end());
+    }
+    break;
+  }
+  }
+  return tables;
 }
 
-std::vector<std::shared_ptr<TStorageTransportStreamStruct>> TDvbSiStorage::GetTsListByNetIdCache(uint16_t nId)
+// Default timeout of the phase in seconds, used until enough acquisition times are known
+int TDvbSiStorage::GetScanPhaseDefaultTimeout(TScanPhase phase)
 {
-  std::vector<std::shared_ptr<TStorageTransportStreamStruct>> ret;
-  std::lock_guard<std::mutex> lock(CacheDataMutex);
+  switch (phase) {
+  case SCAN_PHASE_NIT_BAT:
+    return NIT_TIMEOUT > BAT_TIMEOUT ? NIT_TIMEOUT : BAT_TIMEOUT;
+  case SCAN_PHASE_HOME_SDT:
+    return ScanRunIsFast ? SDT_OTHER_TIMEOUT : SDT_TIMEOUT;
+  case SCAN_PHASE_SDT_EIT_PF:
+    return SDT_TIMEOUT > EIT_PF_TIMEOUT ? SDT_TIMEOUT : EIT_PF_TIMEOUT;
+  case SCAN_PHASE_SDT:
+    return SDT_TIMEOUT;
+  case SCAN_PHASE_EIT_PF:
+    return EIT_PF_TIMEOUT;
+  case SCAN_PHASE_EIT_SCHED:
+    return EIT_8_DAY_SCHED_TIMEOUT;
+  case SCAN_PHASE_BARKER_EIT:
+    return BarkerEitTimout;
+  case SCAN_PHASE_HOME_INVENTORY:
+    return SDT_OTHER_TIMEOUT;
+  }
+  return 0;
+}
 
-  auto it = NitTableMap.begin();
-  if (nId != 0) {
-    it = NitTableMap.find(nId);
+// Timeout of the phase in milliseconds: a high percentile of the acquisition times
+// seen on the frequency plus a margin, bounded by a multiple of the default timeout
+int TDvbSiStorage::GetScanPhaseTimeout(const TScanJob& job, TScanPhase phase)
+{
+  int defaultTimeout = GetScanPhaseDefaultTimeout(phase) * 1000;
+  auto it = AcquisitionHistory.find(std::make_pair(job.Frequency, GetScanPhaseTableType(phase)));
+  if ((it == AcquisitionHistory.end()) || (it->second.size() < ACQUISITION_MIN_SAMPLES)) {
+    return defaultTimeout;
   }
-  else if (PreferredNetworkId != 0) {
-    it = NitTableMap.find(PreferredNetworkId);
+
+  std::vector<uint32_t> times(it->second.begin(), it->second.end());
+  size_t index = (times.size() - 1) * ACQUISITION_PERCENTILE / 100;
+  std::nth_element(times.begin(), times.begin() + index, times.end());
+  int percentile = times[index];
+  int timeout = percentile + std::max(percentile / 2, (int)ACQUISITION_MARGIN_MS);
+  return std::min(timeout, defaultTimeout * ACQUISITION_MAX_FACTOR);
+}
+
+void TDvbSiStorage::LoadAcquisitionHistory()
+{
+  AcquisitionHistory.clear();
+  std::vector<std::vector<uint32_t>> rows = StorageDb.GetAcquisitionTimes();
+  for (auto row = rows.begin(), end = rows.end(); row != end; ++row) {
+    std::deque<uint32_t>& times = AcquisitionHistory[std::make_pair((*row)[0], (*row)[1])];
+    times.push_back((*row)[2]);
+    if (times.size() > ACQUISITION_HISTORY_SIZE) {
+      times.pop_front();
+    }
+  }
+  IsAcquisitionHistoryLoaded = true;
+  OS_LOG(DVB_INFO,   "%s:%d: %lu acquisition times of %lu tables\n", __FUNCTION__, __LINE__, rows.size(), AcquisitionHistory.size());
+}
+
+// Stable code of the tables a phase waits for, stored as the table type of the acquisition
+// times: the table_ids packed from the low byte up, 0 if the phase is not learned
+uint32_t TDvbSiStorage::GetScanPhaseTableType(TScanPhase phase)
+{
+  switch (phase) {
+  case SCAN_PHASE_NIT_BAT:
+    return (uint32_t)TTableId::TABLE_ID_NIT | ((uint32_t)TTableId::TABLE_ID_BAT << 8);
+  case SCAN_PHASE_HOME_SDT:
+    return ScanRunIsFast ? ((uint32_t)TTableId::TABLE_ID_SDT | ((uint32_t)TTableId::TABLE_ID_SDT_OTHER << 8)) :
+      (uint32_t)TTableId::TABLE_ID_SDT;
+  case SCAN_PHASE_SDT_EIT_PF:
+    return (uint32_t)TTableId::TABLE_ID_SDT | ((uint32_t)TTableId::TABLE_ID_EIT_PF << 8);
+  case SCAN_PHASE_SDT:
+    return (uint32_t)TTableId::TABLE_ID_SDT;
+  case SCAN_PHASE_EIT_PF:
+    return (uint32_t)TTableId::TABLE_ID_EIT_PF;
+  case SCAN_PHASE_EIT_SCHED:
+    return (uint32_t)TTableId::TABLE_ID_EIT_SCHED_START;
+  case SCAN_PHASE_BARKER_EIT:
+    return (uint32_t)TTableId::TABLE_ID_EIT_SCHED_START | ((uint32_t)TTableId::TABLE_ID_EIT_SCHED_OTHER_START << 8);
+  case SCAN_PHASE_HOME_INVENTORY:
+    // Its timeout is the rest of a fixed budget, not learned
+    return 0;
+  }
+  return 0;
+}
+
+// A timed out phase is recorded with the default timeout, so that repeated timeouts bring the
+// timeout back to the default instead of growing it up to the bound
+void TDvbSiStorage::RecordAcquisitionTime(const TScanTuner& tuner, bool isReceived)
+{
+  const TScanJob& job = tuner.Job;
+  TScanPhase phase = job.Phases[job.PhaseIndex];
+  uint32_t tableType = GetScanPhaseTableType(phase);
+  if (tableType == 0) {
+    return;
+  }
+  uint32_t timeMs = GetScanPhaseDefaultTimeout(phase) * 1000;
+  if (isReceived) {
+    timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tuner.PhaseStart).count();
+  }
+
+  std::deque<uint32_t>& times = AcquisitionHistory[std::make_pair(job.Frequency, tableType)];
+  times.push_back(timeMs);
+  if (times.size() > ACQUISITION_HISTORY_SIZE) {
+    times.pop_front();
+  }
+  StorageDb.AddAcquisitionTime(job.Frequency, tableType, timeMs, ACQUISITION_HISTORY_SIZE);
+  OS_LOG(DVB_DEBUG,   "%s:%d: freq %d tables 0x%x: %u ms%s\n", __FUNCTION__, __LINE__, job.Frequency, tableType, timeMs,
+    isReceived ? "" : " (timeout)");
+}
+
+// Registers the missing tables with the cache; the last one to arrive posts
+// SCAN_EVENT_TABLES_READY. Returns true if all the tables are already cached.
+bool TDvbSiStorage::ArmScanWait(TScanTuner& tuner, const std::vector<std::shared_ptr<TSiTable>>& tables, int timeout)
+{
+  uint8_t tunerIndex = tuner.Index;
+  uint32_t sequence = ++tuner.Sequence;
+  tuner.PhaseStart = std::chrono::steady_clock::now();
+  tuner.Deadline = tuner.PhaseStart + std::chrono::milliseconds(timeout);
+
+  std::lock_guard<std::mutex> lock(CacheWaitMutex);
+  TCacheWaitRequest& wait = tuner.Wait;
+  wait.Pending.clear();
+  wait.IsPartialAccepted = IsPartialAccepted;
+  for (auto tbl = tables.begin(), end = tables.end(); tbl != end; ++tbl) {
+    if (!IsTableCached(**tbl, wait.IsPartialAccepted)) {
+      wait.Pending.push_back(*tbl);
+    }
   }
-  if (it == NitTableMap.end()) {
+  if (wait.Pending.empty()) {
+    return true;
+  }
+  wait.Notify = [this, tunerIndex, sequence] { PostScanEvent(TScanEvent(SCAN_EVENT_TABLES_READY, tunerIndex, sequence)); };
+  CacheWaitList.push_back(&wait);
+  return false;
+}
+
+void TDvbSiStorage::DisarmScanWait(TScanTuner& tuner)
+{
+  ++tuner.Sequence;
+  std::lock_guard<std::mutex> lock(CacheWaitMutex);
+  CacheWaitList.remove(&tuner.Wait);
+  tuner.Wait.Pending.clear();
+  tuner.Wait.Notify = nullptr;
+}
+
+void TDvbSiStorage::SetScanState(TDvbScanState state)
+{
+  std::lock_guard<std::mutex> lock(ScanStatusMutex);
+  DvbScanStatus.ScanState = state;
+}
+
+std::vector<std::shared_ptr<TStorageTransportStreamStruct>> TDvbSiStorage::GetTsListByNetIdCache(uint16_t nId)
+{
+  std::vector<std::shared_ptr<TStorageTransportStreamStruct>> ret;
+  std::shared_ptr<const TNitTable> nit = FindCachedNit(nId);
+  if (!nit) {
     return ret;
   }
-  const std::vector<TTransportStream>& tsList = it->second->GetTransportStreams();
+  const std::vector<TTransportStream>& tsList = nit->GetTransportStreams();
   for (auto it = tsList.begin(), end = tsList.end(); it != end; ++it) {
     const std::vector<TMpegDescriptor>& tsDescriptors = it->GetTsDescriptors();
     const TMpegDescriptor* desc = TMpegDescriptor::FindMpegDescriptor(tsDescriptors, TDescriptorTag::CABLE_DELIVERY_TAG);
@@ -1346,81 +2014,99 @@ std::vector<std::shared_ptr<TStorageTransportStreamStruct>> TDvbSiStorage::GetTs
   return ret;
 }
 
-bool TDvbSiStorage::CheckCacheTableCollections(std::vector<std::shared_ptr<TSiTable>>& tables, int timeout)
+// Looks the table up in the current snapshot of its cache. A partial table only counts if accepted.
+bool TDvbSiStorage::IsTableCached(const TSiTable& wanted, bool isPartialAccepted)
 {
-  do {
-    bool found(true); 
-    for (auto tbl = tables.begin(), end = tables.end(); tbl != end; ++tbl) {
-      std::lock_guard<std::mutex> lock(CacheDataMutex);
-      TTableId tableId = (*tbl)->GetTableId();
-      if ((tableId == TTableId::TABLE_ID_NIT) || (tableId == TTableId::TABLE_ID_NIT_OTHER)) {
-        OS_LOG(DVB_DEBUG,   "%s:%d: Looking for NIT(0x%x)\n",
-          __FUNCTION__, __LINE__, (*tbl)->GetTableExtensionId());
-        auto it = NitTableMap.find((*tbl)->GetTableExtensionId());
-        if (it == NitTableMap.end()) {
-          found = false;
-          break;
-        }
-        else {
-          OS_LOG(DVB_DEBUG,   "%s:%d: NIT(0x%x) found\n",
-            __FUNCTION__, __LINE__, (*tbl)->GetTableExtensionId());
-        }
-      }
-      else if (tableId == TTableId::TABLE_ID_BAT) {
-        OS_LOG(DVB_DEBUG,   "%s:%d: Looking for BAT(0x%x)\n",
-          __FUNCTION__, __LINE__, (*tbl)->GetTableExtensionId());
-        auto it = BatTableMap.find((*tbl)->GetTableExtensionId());
-        if (it == BatTableMap.end()) {
-          found = false;
-          break;
-        }
-        else {
-          OS_LOG(DVB_DEBUG,   "%s:%d: BAT(0x%x) found\n",
-            __FUNCTION__, __LINE__, (*tbl)->GetTableExtensionId());
-        }
-      }
-      else if ((tableId == TTableId::TABLE_ID_SDT) || (tableId == TTableId::TABLE_ID_SDT_OTHER)) {
-        std::shared_ptr<TSdtTable> sdt = std::static_pointer_cast<TSdtTable>((*tbl));
-        OS_LOG(DVB_DEBUG,   "%s:%d: Looking for SDT(0x%x.0x%x)\n",
-          __FUNCTION__, __LINE__, sdt->GetOriginalNetworkId(), sdt->GetTableExtensionId());
-
-        std::pair<uint16_t, uint16_t> key(sdt->GetOriginalNetworkId(), sdt->GetTableExtensionId());
-        auto it = SdtTableMap.find(key);
-        if (it == SdtTableMap.end()) {
-          found = false;
-          break;
-        }
-        else {
-          OS_LOG(DVB_DEBUG,   "%s:%d: SDT(0x%x.0x%x) found\n",
-            __FUNCTION__, __LINE__, sdt->GetOriginalNetworkId(), sdt->GetTableExtensionId());
-        }
+  TTableId tableId = wanted.GetTableId();
+  if ((tableId == TTableId::TABLE_ID_NIT) || (tableId == TTableId::TABLE_ID_NIT_OTHER)) {
+    OS_LOG(DVB_DEBUG,   "%s:%d: Looking for NIT(0x%x)\n",
+      __FUNCTION__, __LINE__, wanted.GetTableExtensionId());
+    std::shared_ptr<const TNitTableMap> nitMap = std::atomic_load(&NitTableMap);
+    auto it = nitMap->find(wanted.GetTableExtensionId());
+    return (it != nitMap->end()) && (isPartialAccepted || !it->second->IsPartial());
+  }
+  else if (tableId == TTableId::TABLE_ID_BAT) {
+    OS_LOG(DVB_DEBUG,   "%s:%d: Looking for BAT(0x%x)\n",
+      __FUNCTION__, __LINE__, wanted.GetTableExtensionId());
+    std::lock_guard<std::mutex> lock(LedgerMutex);
+    auto it = BatLedger.find(wanted.GetTableExtensionId());
+    return (it != BatLedger.end()) && (isPartialAccepted || !it->second.IsPartial);
+  }
+  else if ((tableId == TTableId::TABLE_ID_SDT) || (tableId == TTableId::TABLE_ID_SDT_OTHER)) {
+    const TSdtTable& sdt = static_cast<const TSdtTable&>(wanted);
+    OS_LOG(DVB_DEBUG,   "%s:%d: Looking for SDT(0x%x.0x%x)\n",
+      __FUNCTION__, __LINE__, sdt.GetOriginalNetworkId(), sdt.GetTableExtensionId());
+    std::pair<uint16_t, uint16_t> key(sdt.GetOriginalNetworkId(), sdt.GetTableExtensionId());
+    std::shared_ptr<const TSdtTableMap> sdtMap = std::atomic_load(&SdtTableMap);
+    auto it = sdtMap->find(key);
+    return (it != sdtMap->end()) && (isPartialAccepted || !it->second->IsPartial());
+  }
+  else if ((tableId >= TTableId::TABLE_ID_EIT_PF) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END)) {
+    bool isPf = false;
+    if (tableId == TTableId::TABLE_ID_EIT_PF || tableId == TTableId::TABLE_ID_EIT_PF_OTHER) {
+      isPf = true;
+    }
+    const TEitTable& eit = static_cast<const TEitTable&>(wanted);
+    OS_LOG(DVB_DEBUG,   "%s:%d: Looking for EIT(0x%x.0x%x.0x%x) isPF: %d\n",
+      __FUNCTION__, __LINE__, eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId(), isPf);
+    std::tuple<uint16_t, uint16_t, uint16_t, bool> key(eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId(), isPf);
+    std::lock_guard<std::mutex> lock(LedgerMutex);
+    auto it = EitLedger.find(key);
+    return (it != EitLedger.end()) && (isPartialAccepted || !it->second.IsPartial);
+  }
+  return true;
+}
+
+// Called after a new cache snapshot has been published
+void TDvbSiStorage::SignalCacheWaiters()
+{
+  std::lock_guard<std::mutex> lock(CacheWaitMutex);
+  for (auto it = CacheWaitList.begin(), end = CacheWaitList.end(); it != end; ++it) {
+    TCacheWaitRequest& request = **it;
+    std::vector<std::shared_ptr<TSiTable>>& pending = request.Pending;
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+      [this, &request](const std::shared_ptr<TSiTable>& tbl) { return IsTableCached(*tbl, request.IsPartialAccepted); }),
+      pending.end());
+    if (pending.empty()) {
+      if (request.Notify) {
+        request.Notify();
       }
-      else if ((tableId >= TTableId::TABLE_ID_EIT_PF) && (tableId <= TTableId::TABLE_ID_EIT_SCHED_OTHER_END)) {
-        bool isPf = false;
-        if (tableId == TTableId::TABLE_ID_EIT_PF || tableId == TTableId::TABLE_ID_EIT_PF_OTHER) {
-          isPf = true;
-        }
-        std::shared_ptr<TEitTable> eit = std::static_pointer_cast<TEitTable>((*tbl));
-        OS_LOG(DVB_DEBUG,   "%s:%d: Looking for EIT(0x%x.0x%x.0x%x) isPF: %d\n",
-          __FUNCTION__, __LINE__, eit->GetNetworkId(), eit->GetTsId(), eit->GetTableExtensionId(), isPf);
-        std::tuple<uint16_t, uint16_t, uint16_t, bool> key(eit->GetNetworkId(), eit->GetTsId(), eit->GetTableExtensionId(), isPf);
-        auto it = EitTableMap.find(key);
-        if (it == EitTableMap.end()) {
-          found = false;
-          break;
-        }
-        else {
-          OS_LOG(DVB_DEBUG,   "%s:%d: Looking for EIT(0x%x.0x%x.0x%x) isPF: %d found\n",
-          __FUNCTION__, __LINE__, eit->GetNetworkId(), eit->GetTsId(), eit->GetTableExtensionId(), isPf);
-        }
+      else {
+        request.Condition.notify_one();
       }
     }
-    if (found) {
-      return true;
+  }
+}
+
+// Waits until all the tables are in the cache. Returns as soon as the last one arrives.
+bool TDvbSiStorage::CheckCacheTableCollections(std::vector<std::shared_ptr<TSiTable>>& tables, int timeout,
+  bool isPartialAccepted)
+{
+  TElapseTime elapse;
+  elapse.StartTimeMeasurement();
+
+  TCacheWaitRequest request;
+  request.IsPartialAccepted = isPartialAccepted;
+  std::unique_lock<std::mutex> lock(CacheWaitMutex);
+  for (auto tbl = tables.begin(), end = tables.end(); tbl != end; ++tbl) {
+    if (!IsTableCached(**tbl, isPartialAccepted)) {
+      request.Pending.push_back(*tbl);
     }
-    sleep(1);
-  } while(timeout-- > 0);
-  return false;
+  }
+
+  if (!request.Pending.empty() && timeout > 0) {
+    CacheWaitList.push_back(&request);
+    request.Condition.wait_for(lock, std::chrono::seconds(timeout), [&request] { return request.Pending.empty(); });
+    CacheWaitList.remove(&request);
+  }
+
+  bool found = request.Pending.empty();
+  lock.unlock();
+
+  elapse.FinishTimeMeasurement();
+  OS_LOG(DVB_DEBUG,   "<%s> %lu tables, %lu missing, timeout %d s\n", __FUNCTION__, tables.size(), request.Pending.size(), timeout);
+  elapse.Display();
+  return found;
 }
 
 std::vector<std::shared_ptr<TDvbStorageNamespace::EventStruct>> TDvbSiStorage::GetEventListByServiceId(uint16_t nId, uint16_t tsId, uint16_t sId)
@@ -1490,6 +2176,18 @@ std::vector<std::shared_ptr<TDvbStorageNamespace::EventStruct>> TDvbSiStorage::G
   return ret;
 }
 
+std::vector<std::shared_ptr<const TDvbStorageNamespace::EventStruct>> TDvbSiStorage::GetEventsInWindow(uint16_t nId,
+  uint16_t tsId, uint16_t sId, time_t startTime, time_t endTime)
+{
+  return EpgGridIndex.GetEvents(TServiceKey(nId, tsId, sId), startTime, endTime);
+}
+
+std::vector<std::vector<std::shared_ptr<const TDvbStorageNamespace::EventStruct>>> TDvbSiStorage::GetEventGrid(
+  const std::vector<TServiceKey>& services, time_t startTime, time_t endTime)
+{
+  return EpgGridIndex.GetEvents(services, startTime, endTime);
+}
+
 std::vector<std::shared_ptr<TDvbStorageNamespace::ServiceStruct>> TDvbSiStorage::GetServiceListByTsId(uint16_t nId, uint16_t tsId)
 {
   std::vector<std::shared_ptr<TDvbStorageNamespace::ServiceStruct>> ret;
@@ -1534,15 +2232,13 @@ std::vector<std::shared_ptr<TDvbStorageNamespace::ServiceStruct>> TDvbSiStorage:
 std::vector<std::shared_ptr<ServiceStruct>> TDvbSiStorage::GetServiceListByTsIdCache(uint16_t nId, uint16_t tsId)
 {
   std::vector<std::shared_ptr<ServiceStruct>> ret;
-  std::lock_guard<std::mutex> lock(CacheDataMutex);
   OS_LOG(DVB_DEBUG,   "<%s> called: nid.tsid = 0x%x.0x%x\n", __FUNCTION__, nId, tsId);
-  std::pair<uint16_t, uint16_t> key(nId, tsId);
-  auto it = SdtTableMap.find(key);
-  if (it == SdtTableMap.end()) {
+  std::shared_ptr<const TSdtTable> sdt = FindCachedSdt(nId, tsId);
+  if (!sdt) {
     OS_LOG(DVB_ERROR,   "<%s> No SDT found for nid.tsid = 0x%x.0x%x\n", __FUNCTION__, nId, tsId);
     return ret;
   }
-  const std::vector<TSdtService>& serviceList = it->second->GetServices();
+  const std::vector<TSdtService>& serviceList = sdt->GetServices();
   for (auto srv = serviceList.begin(), end = serviceList.end(); srv != end; ++srv) {
     const std::vector<TMpegDescriptor>& serviceDescriptors = srv->GetServiceDescriptors();
     const TMpegDescriptor* desc = TMpegDescriptor::FindMpegDescriptor(serviceDescriptors, TDescriptorTag::SERVICE_TAG);
@@ -1550,7 +2246,7 @@ std::vector<std::shared_ptr<ServiceStruct>> TDvbSiStorage::GetServiceListByTsIdC
       TServiceDescriptor servDesc(*desc);
       OS_LOG(DVB_DEBUG,   "<%s> SDT table: type = 0x%x, provider = %s, name = %s\n",
         __FUNCTION__, servDesc.GetServiceType(), servDesc.GetServiceProviderName().c_str(), servDesc.GetServiceName().c_str());
-      std::shared_ptr<Service> service(new Service(it->second->GetOriginalNetworkId(), it->second->GetTableExtensionId(),
+      std::shared_ptr<Service> service(new Service(sdt->GetOriginalNetworkId(), sdt->GetTableExtensionId(),
         srv->GetServiceId(), servDesc.GetServiceName()));
       ret.push_back(service);
     }
@@ -1561,64 +2257,6 @@ std::vector<std::shared_ptr<ServiceStruct>> TDvbSiStorage::GetServiceListByTsIdC
   return ret;
 }
 
-bool TDvbSiStorage::ScanHome()
-{
-  TDvbSiTableStatus status;
-  // Let's start over clean slate
-  ClearCachedTables();
-  NotifyDvbStorageTuneObserver(HomeTsFrequency, HomeTsModulationMode, HomeTsSymbolRate);
-  IsTuneDone();
-  std::vector<std::shared_ptr<TSiTable>> tables;
-  // NIT
-  tables.emplace_back(new TNitTable((uint8_t)TTableId::TABLE_ID_NIT, PreferredNetworkId, 0, true));
-  // BAT(s)
-  for (auto it = HomeBouquetsVector.begin(), end = HomeBouquetsVector.end(); it != end; ++it) {
-    OS_LOG(DVB_DEBUG,   "%s:%d: Adding BAT(0x%x) to the list\n", __FUNCTION__, __LINE__, *it);
-    tables.emplace_back(new TBatTable((uint8_t)TTableId::TABLE_ID_BAT, *it, 0, true));
-  }
-  OS_LOG(DVB_INFO,   "%s:%d: Collecting NIT & BAT(s)\n", __FUNCTION__, __LINE__);
-  if (CheckCacheTableCollections(tables, NIT_TIMEOUT > BAT_TIMEOUT ? NIT_TIMEOUT : BAT_TIMEOUT)) {
-    OS_LOG(DVB_INFO,   "%s:%d: NIT & BAT(s) found\n", __FUNCTION__, __LINE__);
-    status.NitAcquired = true;
-    status.BatAcquired = true;
-  }
-  else {
-    OS_LOG(DVB_ERROR,   "%s:%d: NIT & BAT(s) not found\n", __FUNCTION__, __LINE__);
-    return false;
-  }
-  tables.clear();
-  // Collect SDT & EIT pf(optional)
-  std::vector<std::shared_ptr<TStorageTransportStreamStruct>> tsList = GetTsListByNetIdCache(PreferredNetworkId);
-  for (auto it = tsList.begin(), end = tsList.end(); it != end; ++it) {
-    if (!IsFastScan) {
-      if (HomeTsFrequency == (*it)->Frequency) {
-        OS_LOG(DVB_DEBUG,   "%s:%d: Adding SDT(0x%x.0x%x) actual to the list\n",
-        __FUNCTION__, __LINE__, (*it)->NetworkId, (*it)->TransportStreamId);
-        TSdtTable* sdt = new TSdtTable((uint8_t)TTableId::TABLE_ID_SDT, (*it)->TransportStreamId, 0, true);
-        sdt->SetOriginalNetworkId((*it)->NetworkId);
-        tables.emplace_back(sdt);
-        break;
-      }
-    }
-    else {
-      OS_LOG(DVB_DEBUG,   "%s:%d: Adding SDT(0x%x.0x%x) to the list\n",
-        __FUNCTION__, __LINE__, (*it)->NetworkId, (*it)->TransportStreamId);
-      TSdtTable* sdt = new TSdtTable((uint8_t)TTableId::TABLE_ID_SDT, (*it)->TransportStreamId, 0, true);
-      sdt->SetOriginalNetworkId((*it)->NetworkId);
-      tables.emplace_back(sdt);
-    }
-  }
-  if (CheckCacheTableCollections(tables, IsFastScan ? SDT_OTHER_TIMEOUT : SDT_TIMEOUT)) {
-    OS_LOG(DVB_INFO,   "%s:%d: All SDTs received\n", __FUNCTION__, __LINE__);
-    status.SdtAcquired = true;
-  }
-  else {
-    OS_LOG(DVB_ERROR,   "%s:%d: All SDTs not received\n", __FUNCTION__, __LINE__);
-  }
-  DvbScanStatus.TsList.emplace_back(HomeTsFrequency, status);
-  return true;
-}
-
 TModulationMode TDvbSiStorage::MapModulationMode(TDVBConstellation in)
 {
   TModulationMode out;
@@ -1648,20 +2286,181 @@ TModulationMode TDvbSiStorage::MapModulationMode(TDVBConstellation in)
 
 void TDvbSiStorage::ClearCachedTables()
 {
-  std::lock_guard<std::mutex> lock(CacheDataMutex);
+  std::unique_lock<std::mutex> lock(LockCacheWrite());
   OS_LOG(DVB_INFO,   "%s:%d: Clearing cached tables\n", __FUNCTION__, __LINE__);
-  NitTableMap.clear();
-  SdtTableMap.clear();
-  EitTableMap.clear();
-  BatTableMap.clear();
+  // The getters keep serving the NIT and SDT tables until the run has acquired them again
+  std::atomic_store(&PreviousNitTableMap, MergeCache(std::atomic_load(&PreviousNitTableMap), std::atomic_load(&NitTableMap)));
+  std::atomic_store(&PreviousSdtTableMap, MergeCache(std::atomic_load(&PreviousSdtTableMap), std::atomic_load(&SdtTableMap)));
+  std::atomic_store(&NitTableMap, std::shared_ptr<const TNitTableMap>(new TNitTableMap()));
+  std::atomic_store(&SdtTableMap, std::shared_ptr<const TSdtTableMap>(new TSdtTableMap()));
+  std::unique_lock<std::mutex> ledgerLock(LockLedger());
+  EitLedger.clear();
+  BatLedger.clear();
+  CachePublishCount += 6;
+}
+
+std::shared_ptr<const TNitTable> TDvbSiStorage::FindCachedNit(uint16_t nId)
+{
+  if (nId == 0) {
+    nId = PreferredNetworkId;
+  }
+  std::shared_ptr<const TNitTableMap> nitMaps[] = { std::atomic_load(&NitTableMap), std::atomic_load(&PreviousNitTableMap) };
+  for (size_t i = 0; i < sizeof(nitMaps) / sizeof(nitMaps[0]); i++) {
+    auto it = (nId != 0) ? nitMaps[i]->find(nId) : nitMaps[i]->begin();
+    if (it != nitMaps[i]->end()) {
+      return it->second;
+    }
+  }
+  return std::shared_ptr<const TNitTable>();
 }
 
-bool TDvbSiStorage::IsTuneDone()
+std::shared_ptr<const TSdtTable> TDvbSiStorage::FindCachedSdt(uint16_t nId, uint16_t tsId)
 {
-  while(!CurrentTuneStatus) {
-    usleep(100000);
+  std::pair<uint16_t, uint16_t> key(nId, tsId);
+  std::shared_ptr<const TSdtTableMap> sdtMaps[] = { std::atomic_load(&SdtTableMap), std::atomic_load(&PreviousSdtTableMap) };
+  for (size_t i = 0; i < sizeof(sdtMaps) / sizeof(sdtMaps[0]); i++) {
+    auto it = sdtMaps[i]->find(key);
+    if (it != sdtMaps[i]->end()) {
+      return it->second;
+    }
   }
-  return true; 
+  return std::shared_ptr<const TSdtTable>();
+}
+
+// Rebuilds the NIT and SDT tables stored by the last scans, so the getters can answer before
+// the first scan run has acquired them. The run verifies them as it goes: a restored table ends
+// the scan wait once the first section of its version is seen, see OnVersionSeen().
+void TDvbSiStorage::LoadCachedTables()
+{
+  TElapseTime elapse;
+  elapse.StartTimeMeasurement();
+
+  // One query per descriptor table, looking the descriptors up row by row is much slower
+  std::map<int64_t, std::vector<TMpegDescriptor>> nitDescriptors;
+  std::map<int64_t, std::vector<TMpegDescriptor>> tsDescriptors;
+  std::map<int64_t, std::vector<TMpegDescriptor>> sdtDescriptors;
+  StorageDb.FindAllDescriptors("NitDescriptor", nitDescriptors);
+  StorageDb.FindAllDescriptors("NitTransportDescriptor", tsDescriptors);
+  StorageDb.FindAllDescriptors("SdtDescriptor", sdtDescriptors);
+
+  std::shared_ptr<TNitTableMap> nitMap(new TNitTableMap());
+  std::string cmdStr("SELECT nit_pk, network_id, version FROM Nit;");
+  std::vector<std::vector<std::string>> nitRows = StorageDb.QueryDb(cmdStr);
+  for (auto row = nitRows.begin(), end = nitRows.end(); row != end; ++row) {
+    if (row->size() != 3) {
+      continue;
+    }
+    int64_t nitPk;
+    int networkId;
+    int version;
+    std::stringstream(row->at(0)) >> nitPk;
+    std::stringstream(row->at(1)) >> networkId;
+    std::stringstream(row->at(2)) >> version;
+    // Same filter as the acquisition
+    if ((PreferredNetworkId != 0) && (PreferredNetworkId != networkId)) {
+      continue;
+    }
+
+    std::shared_ptr<TNitTable> nit(new TNitTable(TTableId::TABLE_ID_NIT, networkId, version, true));
+    nit->AddNetworkDescriptors(nitDescriptors[nitPk]);
+
+    std::stringstream ss;
+    ss << "SELECT nit_transport_pk, original_network_id, transport_id FROM NitTransport WHERE nit_fk = " << nitPk << ";";
+    cmdStr = ss.str();
+    std::vector<std::vector<std::string>> tsRows = StorageDb.QueryDb(cmdStr);
+    for (auto tsRow = tsRows.begin(), tsEnd = tsRows.end(); tsRow != tsEnd; ++tsRow) {
+      if (tsRow->size() != 3) {
+        continue;
+      }
+      int64_t tsPk;
+      int onId;
+      int tsId;
+      std::stringstream(tsRow->at(0)) >> tsPk;
+      std::stringstream(tsRow->at(1)) >> onId;
+      std::stringstream(tsRow->at(2)) >> tsId;
+      TTransportStream ts(tsId, onId);
+      ts.AddDescriptors(tsDescriptors[tsPk]);
+      nit->AddTransportStream(ts);
+    }
+    nitMap->insert(std::make_pair(static_cast<uint16_t>(networkId), nit));
+  }
+
+  // The services of a transport stream make up its SDT, the table has the newest version
+  std::map<std::pair<uint16_t, uint16_t>, std::shared_ptr<TSdtTable>> sdts;
+  cmdStr = "SELECT s.sdt_pk, t.original_network_id, t.transport_id, s.service_id, v.version, s.schedule, "  \
+    "s.present_following, s.running, s.scrambled FROM Sdt s INNER JOIN NitTransport t "                    \
+    "ON s.nit_transport_fk = t.nit_transport_pk INNER JOIN "                                                \
+    "(SELECT nit_transport_fk, MAX(version) AS version FROM Sdt GROUP BY nit_transport_fk) v "              \
+    "ON s.nit_transport_fk = v.nit_transport_fk ORDER BY t.original_network_id, t.transport_id, s.service_id;";
+  std::vector<std::vector<std::string>> sdtRows = StorageDb.QueryDb(cmdStr);
+  for (auto row = sdtRows.begin(), end = sdtRows.end(); row != end; ++row) {
+    if (row->size() != 9) {
+      continue;
+    }
+    int64_t sdtPk;
+    int onId;
+    int tsId;
+    int serviceId;
+    int version;
+    int schedule;
+    int presentFollowing;
+    int running;
+    int scrambled;
+    std::stringstream(row->at(0)) >> sdtPk;
+    std::stringstream(row->at(1)) >> onId;
+    std::stringstream(row->at(2)) >> tsId;
+    std::stringstream(row->at(3)) >> serviceId;
+    std::stringstream(row->at(4)) >> version;
+    std::stringstream(row->at(5)) >> schedule;
+    std::stringstream(row->at(6)) >> presentFollowing;
+    std::stringstream(row->at(7)) >> running;
+    std::stringstream(row->at(8)) >> scrambled;
+
+    std::pair<uint16_t, uint16_t> key(onId, tsId);
+    std::shared_ptr<TSdtTable>& sdt = sdts[key];
+    if (!sdt) {
+      sdt.reset(new TSdtTable(TTableId::TABLE_ID_SDT, tsId, version, true));
+      sdt->SetOriginalNetworkId(onId);
+    }
+    TSdtService service(serviceId, schedule != 0, presentFollowing != 0, running, scrambled != 0);
+    service.AddDescriptors(sdtDescriptors[sdtPk]);
+    sdt->AddService(service);
+  }
+  std::shared_ptr<TSdtTableMap> sdtMap(new TSdtTableMap(sdts.begin(), sdts.end()));
+
+  {
+    std::unique_lock<std::mutex> lock(LockCacheWrite());
+    std::atomic_store(&PreviousNitTableMap, std::shared_ptr<const TNitTableMap>(nitMap));
+    std::atomic_store(&PreviousSdtTableMap, std::shared_ptr<const TSdtTableMap>(sdtMap));
+    CachePublishCount += 2;
+    CacheRestoredCount += nitMap->size() + sdtMap->size();
+  }
+
+  elapse.FinishTimeMeasurement();
+  OS_LOG(DVB_INFO,   "%s:%d: Restored %lu NIT and %lu SDT tables from the database in %.3f s\n", __FUNCTION__, __LINE__,
+    nitMap->size(), sdtMap->size(), elapse.GetElapsedTime());
+}
+
+// Takes the cache write mutex, counting the writers that had to wait for it
+std::unique_lock<std::mutex> TDvbSiStorage::LockCacheWrite()
+{
+  std::unique_lock<std::mutex> lock(CacheWriteMutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    ++CacheWriteContentionCount;
+    lock.lock();
+  }
+  return lock;
+}
+
+// Takes the ledger mutex, counting the writers that had to wait for it
+std::unique_lock<std::mutex> TDvbSiStorage::LockLedger()
+{
+  std::unique_lock<std::mutex> lock(LedgerMutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    ++CacheWriteContentionCount;
+    lock.lock();
+  }
+  return lock;
 }
 
 // public function implementations.
@@ -1676,9 +2475,27 @@ TDvbSiStorage::TDvbSiStorage(const uint32_t& freq, const TModulationMode& modula
     NetworkConfigJsonFile(networkConfigFile),
     BackGroundScanInterval(21600),
     IsFastScan(false),
-    CurrentTuneStatus(false),
-    TunerIndex(0),
-    JsonParser (new TDvbJanssonParser(NetworkConfigJsonFile))
+    TunerCount(1),
+    IsPartialAccepted(false),
+    JsonParser (new TDvbJanssonParser(NetworkConfigJsonFile)),
+    CachePublishCount(0),
+    CacheSkippedWriteCount(0),
+    CacheWriteContentionCount(0),
+    CacheRestoredCount(0),
+    CacheVerifiedCount(0),
+    ScanRunActive(false),
+    ScanRunIsFast(false),
+    ScanDeadline(std::chrono::steady_clock::now()),
+    IsAcquisitionHistoryLoaded(false),
+    BarkerFrequency(0),
+    BarkerSymbolRate(0),
+    BarkerEitTimout(EIT_8_DAY_SCHED_TIMEOUT),
+    BarkerModulationMode(MODULATION_MODE_UNKNOWN),
+    NitTableMap(new TNitTableMap()),
+    SdtTableMap(new TSdtTableMap()),
+    PreviousNitTableMap(new TNitTableMap()),
+    PreviousSdtTableMap(new TSdtTableMap()),
+    NowNextObserverVector(new std::vector<IDvbNowNextObserver*>())
 {
   // Empty
 }
@@ -1691,8 +2508,12 @@ TDvbSiStorage::~TDvbSiStorage()
 TFileStatus TDvbSiStorage::CreateDatabase()
 {
   TFileStatus status(FILE_STATUS_ERROR);
-  DvbScanStatus.ScanState = TDvbScanState::SCAN_STOPPED;
+  SetScanState(TDvbScanState::SCAN_STOPPED);
   status = StorageDb.CreateDbFile(DbFilePath);
+  if (status == FILE_STATUS_OPENED) {
+    // Warm start, the database is populated
+    LoadCachedTables();
+  }
   status = FILE_STATUS_CREATED;
   return status;
 }
@@ -1705,12 +2526,12 @@ void TDvbSiStorage::HandleTableEvent(const TSiTable& tbl)
   case TTableId::TABLE_ID_NIT_OTHER:
     // Only handle NIT tables from preferred Network if specified.
     if (PreferredNetworkId == 0 || PreferredNetworkId == tbl.GetTableExtensionId()) {
-      HandleNitEvent(static_cast<const TNitTable&>(tbl));
+      HandleNitEvent(std::make_shared<TNitTable>(static_cast<const TNitTable&>(tbl)));
     }
     break;
   case TTableId::TABLE_ID_SDT:
   case TTableId::TABLE_ID_SDT_OTHER:
-    HandleSdtEvent(static_cast<const TSdtTable&>(tbl));
+    HandleSdtEvent(std::make_shared<TSdtTable>(static_cast<const TSdtTable&>(tbl)));
     break;
   case TTableId::TABLE_ID_TDT:
   case TTableId::TABLE_ID_TOT:
@@ -1729,6 +2550,62 @@ void TDvbSiStorage::HandleTableEvent(const TSiTable& tbl)
   }
 }
 
+// IDvbTableObserver
+void TDvbSiStorage::OnNit(const std::shared_ptr<const TNitTable>& nit)
+{
+  // Only handle NIT tables from preferred Network if specified.
+  if (PreferredNetworkId == 0 || PreferredNetworkId == nit->GetTableExtensionId()) {
+    HandleNitEvent(nit);
+  }
+}
+
+void TDvbSiStorage::OnSdt(const std::shared_ptr<const TSdtTable>& sdt)
+{
+  HandleSdtEvent(sdt);
+}
+
+void TDvbSiStorage::OnBat(const std::shared_ptr<const TBatTable>& bat)
+{
+  HandleBatEvent(*bat);
+}
+
+void TDvbSiStorage::OnEit(const std::shared_ptr<const TEitTable>& eit)
+{
+  HandleEitEvent(*eit);
+}
+
+void TDvbSiStorage::OnTot(const std::shared_ptr<const TTotTable>& tot)
+{
+  HandleTotEvent(*tot);
+}
+
+void TDvbSiStorage::OnTdt(time_t utcTime, uint64_t /*utcTimeBcd*/)
+{
+  HandleTdtEvent(utcTime);
+}
+
+// A NIT or SDT kept from an earlier run, e.g. restored at start up, is current again as soon as
+// the first section of its version arrives. The scan waits don't wait for the whole table.
+void TDvbSiStorage::OnVersionSeen(uint8_t tableId, uint16_t extId, uint16_t onId, uint8_t version)
+{
+  bool isPromoted(false);
+  {
+    std::unique_lock<std::mutex> lock(LockCacheWrite());
+    if (tableId == TTableId::TABLE_ID_NIT) {
+      if ((PreferredNetworkId == 0) || (PreferredNetworkId == extId)) {
+        isPromoted = PromotePreviousEntry(NitTableMap, PreviousNitTableMap, extId, version);
+      }
+    }
+    else if ((tableId == TTableId::TABLE_ID_SDT) || (tableId == TTableId::TABLE_ID_SDT_OTHER)) {
+      isPromoted = PromotePreviousEntry(SdtTableMap, PreviousSdtTableMap, std::make_pair(onId, extId), version);
+    }
+  }
+  if (isPromoted) {
+    OS_LOG(DVB_DEBUG,   "<%s> 0x%x.0x%x.0x%x version %d verified\n", __FUNCTION__, tableId, onId, extId, version);
+    SignalCacheWaiters();
+  }
+}
+
 void TDvbSiStorage::SetBarkerInfo(const uint32_t& barkerFreq, const TModulationMode& barkMod, const uint32_t& barkSymbRate)
 {
   BarkerFrequency = barkerFreq;
@@ -1758,13 +2635,41 @@ void TDvbSiStorage::NotifyDvbStorageTuneObserver(const uint32_t& freq, const TMo
 
 void TDvbSiStorage::NotifyDvbStorageUnTuneObserver()
 {
-  CurrentTuneStatus = false;
   std::vector<IDvbStorageObserver*>::const_iterator iter = ObserverVector.begin();
   for (; iter != ObserverVector.end(); ++iter) {
     (*iter)->UnTune();
   }
 }
 
+void TDvbSiStorage::RegisterNowNextObserver(IDvbNowNextObserver* observerObject)
+{
+  std::lock_guard<std::mutex> lock(NowNextObserverMutex);
+  std::shared_ptr<std::vector<IDvbNowNextObserver*>> observers(new std::vector<IDvbNowNextObserver*>(*NowNextObserverVector));
+  observers->push_back(observerObject);
+  NowNextObserverVector = observers;
+}
+
+void TDvbSiStorage::RemoveNowNextObserver(IDvbNowNextObserver* observerObject)
+{
+  std::lock_guard<std::mutex> lock(NowNextObserverMutex);
+  std::shared_ptr<std::vector<IDvbNowNextObserver*>> observers(new std::vector<IDvbNowNextObserver*>(*NowNextObserverVector));
+  observers->erase(std::remove(observers->begin(), observers->end(), observerObject), observers->end());
+  NowNextObserverVector = observers;
+}
+
+void TDvbSiStorage::NotifyNowNextObserver(uint16_t serviceHandle, const std::shared_ptr<const NowNextStruct>& nowNext)
+{
+  std::shared_ptr<const std::vector<IDvbNowNextObserver*>> observers;
+  {
+    std::lock_guard<std::mutex> lock(NowNextObserverMutex);
+    observers = NowNextObserverVector;
+  }
+  std::vector<IDvbNowNextObserver*>::const_iterator iter = observers->begin();
+  for (; iter != observers->end(); ++iter) {
+    (*iter)->NowNextChanged(serviceHandle, nowNext);
+  }
+}
+
 void TDvbSiStorage::ScanThreadInit(void *arg)
 {
   TDvbSiStorage* siStorageInstance = static_cast<TDvbSiStorage*>(arg);
@@ -1779,7 +2684,51 @@ void TDvbSiStorage::UpdateScanType(bool isFastScan)
 
 void TDvbSiStorage::UpdateTuneStatus(bool isTuneSuccess)
 {
-  CurrentTuneStatus = isTuneSuccess;
+  UpdateTuneStatus(0, isTuneSuccess);
+}
+
+// false means "not tuned yet", as for the single tuner scan: the job keeps waiting for its tune timeout
+void TDvbSiStorage::UpdateTuneStatus(uint8_t tunerIndex, bool isTuneSuccess)
+{
+  if (isTuneSuccess) {
+    PostScanEvent(TScanEvent(SCAN_EVENT_TUNE_DONE, tunerIndex));
+  }
+}
+
+// The tune will not succeed, the job completes without waiting for the tune timeout
+void TDvbSiStorage::ReportTuneFailure(uint8_t tunerIndex)
+{
+  PostScanEvent(TScanEvent(SCAN_EVENT_TUNE_FAILED, tunerIndex));
+}
+
+// Number of tuners the scan may use, applied from the next scan run
+void TDvbSiStorage::SetTunerCount(uint8_t count)
+{
+  TunerCount = count;
+}
+
+// A tuner taken for live viewing is released by the scan and its job moves to another tuner
+void TDvbSiStorage::SetTunerAvailable(uint8_t tunerIndex, bool isAvailable)
+{
+  PostScanEvent(TScanEvent(isAvailable ? SCAN_EVENT_TUNER_AVAILABLE : SCAN_EVENT_TUNER_LOST, tunerIndex));
+}
+
+// Abandons the current scan and starts a new one of the type set by UpdateScanType()
+void TDvbSiStorage::RestartScan()
+{
+  PostScanEvent(TScanEvent(SCAN_EVENT_RESTART));
+}
+
+// Abandons the current scan and ends the scan thread
+void TDvbSiStorage::StopScan()
+{
+  PostScanEvent(TScanEvent(SCAN_EVENT_STOP));
+}
+
+// Applied from the next scan step
+void TDvbSiStorage::SetPartialTablesAccepted(bool accept)
+{
+  IsPartialAccepted = accept;
 }
 
 
@@ -1857,6 +2806,28 @@ std::vector<std::shared_ptr<TStorageTransportStreamStruct>> TDvbSiStorage::GetTs
 
 TDvbScanStatus TDvbSiStorage::GetScanStatus()
 {
+  std::lock_guard<std::mutex> lock(ScanStatusMutex);
   OS_LOG(DVB_INFO,   "%s:%d DvbScanStatus.tsList.size() = %lu\n", __FUNCTION__, __LINE__, DvbScanStatus.TsList.size());
   return DvbScanStatus;
 }
+
+uint16_t TDvbSiStorage::GetServiceHandle(uint16_t nId, uint16_t tsId, uint16_t sId)
+{
+  return NowNextTable.GetServiceHandle(TServiceKey(nId, tsId, sId));
+}
+
+std::shared_ptr<const NowNextStruct> TDvbSiStorage::GetNowNext(uint16_t serviceHandle)
+{
+  return NowNextTable.Get(serviceHandle);
+}
+
+TCacheStats TDvbSiStorage::GetCacheStats()
+{
+  TCacheStats stats;
+  stats.Publishes = CachePublishCount;
+  stats.SkippedWrites = CacheSkippedWriteCount;
+  stats.WriteContentions = CacheWriteContentionCount;
+  stats.RestoredTables = CacheRestoredCount;
+  stats.VerifiedTables = CacheVerifiedCount;
+  return stats;
+}
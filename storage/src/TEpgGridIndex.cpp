@@ -0,0 +1,203 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TEpgGridIndex.h"
+#include "oswrap.h"
+
+#include "DvbUtils.h"
+#include "TMpegDescriptor.h"
+#include "TEitTable.h"
+#include "TShortEventDescriptor.h"
+
+#include <algorithm>
+#include <bitset>
+
+using namespace TDvbStorageNamespace;
+
+TEpgGridIndex::TEpgGridIndex(uint32_t retention)
+  : Services(new TServiceMap()),
+    EventCount(0),
+    RetentionTime(retention)
+{
+  // Empty
+}
+
+std::shared_ptr<TEpgGridIndex::TServiceSlot> TEpgGridIndex::FindSlot(const TServiceKey& key) const
+{
+  std::shared_ptr<const TServiceMap> services = std::atomic_load(&Services);
+  auto it = services->find(key);
+  if (it == services->end()) {
+    return std::shared_ptr<TServiceSlot>();
+  }
+  return it->second;
+}
+
+std::shared_ptr<const EventStruct> TEpgGridIndex::CreateEvent(const TEitTable& eit, const TEitEvent& eitEvent)
+{
+  std::shared_ptr<Event> event(new Event);
+  event->NetworkId = eit.GetNetworkId();
+  event->TransportStreamId = eit.GetTsId();
+  event->ServiceId = eit.GetTableExtensionId();
+  event->EventId = eitEvent.GetEventId();
+  event->StartTime = MjdToUtcEpoch(eitEvent.GetStartTimeBcd());
+  event->Duration = eitEvent.GetDuration();
+
+  const std::vector<TMpegDescriptor>& descList = eitEvent.GetEventDescriptors();
+  const TMpegDescriptor* desc = TMpegDescriptor::FindMpegDescriptor(descList, TDescriptorTag::SHORT_EVENT_TAG);
+  if (desc) {
+    TShortEventDescriptor sed(*desc);
+    event->EventName = sed.GetEventName();
+    event->EventText = sed.GetText();
+  }
+  return event;
+}
+
+void TEpgGridIndex::Update(const TEitTable& eit)
+{
+  const std::vector<TEitEvent>& eventList = eit.GetEvents();
+  uint8_t tableId = (uint8_t)eit.GetTableId();
+  TServiceKey key(eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
+  std::lock_guard<std::mutex> lock(WriteMutex);
+
+  std::shared_ptr<TServiceSlot> slot = FindSlot(key);
+  if (!slot) {
+    if (eventList.empty()) {
+      return;
+    }
+    OS_LOG(DVB_DEBUG,   "<%s> Adding service 0x%x.0x%x.0x%x\n", __FUNCTION__,
+      eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
+    slot.reset(new TServiceSlot);
+    slot->Events.reset(new TServiceEvents);
+    std::shared_ptr<TServiceMap> services(new TServiceMap(*std::atomic_load(&Services)));
+    services->insert(std::make_pair(key, slot));
+    std::atomic_store(&Services, std::shared_ptr<const TServiceMap>(services));
+  }
+
+  // Segments whose events are all in this table, the whole table unless it is partial
+  std::bitset<32> replaced;
+  replaced.set();
+  if (eit.IsPartial()) {
+    const std::bitset<256>& missing = eit.GetMissingSections();
+    for (uint32_t section = 0; section < missing.size(); section++) {
+      if (missing[section]) {
+        replaced.reset(section / 8);
+      }
+    }
+  }
+
+  std::vector<uint16_t> eventIds;
+  eventIds.reserve(eventList.size());
+  for (auto it = eventList.begin(), end = eventList.end(); it != end; ++it) {
+    eventIds.push_back(it->GetEventId());
+  }
+  std::sort(eventIds.begin(), eventIds.end());
+
+  std::shared_ptr<const TServiceEvents> current = std::atomic_load(&slot->Events);
+  time_t expiry = time(NULL) - RetentionTime;
+
+  std::vector<TEntry> added;
+  added.reserve(eventList.size());
+  for (auto it = eventList.begin(), end = eventList.end(); it != end; ++it) {
+    TEntry entry;
+    entry.StartTime = MjdToUtcEpoch(it->GetStartTimeBcd());
+    entry.EndTime = entry.StartTime + it->GetDuration();
+    if (entry.EndTime <= expiry) {
+      continue;
+    }
+
+    entry.TableId = tableId;
+    entry.Segment = it->GetSectionNumber() / 8;
+    entry.Event = CreateEvent(eit, *it);
+    added.push_back(entry);
+  }
+  auto isEarlier = [](const TEntry& a, const TEntry& b) { return a.StartTime < b.StartTime; };
+  std::stable_sort(added.begin(), added.end(), isEarlier);
+
+  // The events that are neither replaced by this table nor expired are already sorted,
+  // merge the new ones into them
+  std::shared_ptr<TServiceEvents> next(new TServiceEvents);
+  next->Entries.reserve(current->Entries.size() + added.size());
+  auto newIt = added.begin();
+  for (auto it = current->Entries.begin(), end = current->Entries.end(); it != end; ++it) {
+    if ((it->EndTime <= expiry) || ((it->TableId == tableId) && replaced[it->Segment]) ||
+        std::binary_search(eventIds.begin(), eventIds.end(), it->Event->EventId)) {
+      continue;
+    }
+    for (; (newIt != added.end()) && isEarlier(*newIt, *it); ++newIt) {
+      next->Entries.push_back(*newIt);
+    }
+    next->Entries.push_back(*it);
+    next->MaxDuration = std::max(next->MaxDuration, it->Event->Duration);
+  }
+  next->Entries.insert(next->Entries.end(), newIt, added.end());
+  for (auto it = added.begin(), end = added.end(); it != end; ++it) {
+    next->MaxDuration = std::max(next->MaxDuration, it->Event->Duration);
+  }
+
+  EventCount += next->Entries.size();
+  EventCount -= current->Entries.size();
+  std::atomic_store(&slot->Events, std::shared_ptr<const TServiceEvents>(next));
+}
+
+void TEpgGridIndex::Clear()
+{
+  std::lock_guard<std::mutex> lock(WriteMutex);
+  std::atomic_store(&Services, std::shared_ptr<const TServiceMap>(new TServiceMap()));
+  EventCount = 0;
+}
+
+void TEpgGridIndex::GetEvents(const TServiceEvents& events, time_t startTime, time_t endTime,
+  std::vector<std::shared_ptr<const EventStruct>>& out) const
+{
+  // No event starting before startTime - MaxDuration can reach into the window
+  time_t from = startTime - events.MaxDuration;
+  auto it = std::lower_bound(events.Entries.begin(), events.Entries.end(), from,
+    [](const TEntry& entry, time_t t) { return entry.StartTime < t; });
+  for (auto end = events.Entries.end(); (it != end) && (it->StartTime < endTime); ++it) {
+    if (it->EndTime > startTime) {
+      out.push_back(it->Event);
+    }
+  }
+}
+
+std::vector<std::shared_ptr<const EventStruct>> TEpgGridIndex::GetEvents(const TServiceKey& service,
+  time_t startTime, time_t endTime) const
+{
+  std::vector<std::shared_ptr<const EventStruct>> ret;
+  std::shared_ptr<TServiceSlot> slot = FindSlot(service);
+  if (slot) {
+    std::shared_ptr<const TServiceEvents> events = std::atomic_load(&slot->Events);
+    GetEvents(*events, startTime, endTime, ret);
+  }
+  return ret;
+}
+
+std::vector<std::vector<std::shared_ptr<const EventStruct>>> TEpgGridIndex::GetEvents(
+  const std::vector<TServiceKey>& services, time_t startTime, time_t endTime) const
+{
+  std::vector<std::vector<std::shared_ptr<const EventStruct>>> ret(services.size());
+  std::shared_ptr<const TServiceMap> serviceMap = std::atomic_load(&Services);
+  for (size_t i = 0; i < services.size(); i++) {
+    auto it = serviceMap->find(services[i]);
+    if (it != serviceMap->end()) {
+      std::shared_ptr<const TServiceEvents> events = std::atomic_load(&it->second->Events);
+      GetEvents(*events, startTime, endTime, ret[i]);
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,116 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "TNowNextTable.h"
+#include "oswrap.h"
+
+#include "DvbUtils.h"
+#include "TMpegDescriptor.h"
+#include "TEitTable.h"
+#include "TEpgGridIndex.h"
+
+using namespace TDvbStorageNamespace;
+
+TNowNextTable::TNowNextTable()
+  : ServiceCount(0)
+{
+  // Empty
+}
+
+bool TNowNextTable::IsSameEvent(const std::shared_ptr<const EventStruct>& a, const std::shared_ptr<const EventStruct>& b)
+{
+  if (!a || !b) {
+    return !a && !b;
+  }
+  return (a->EventId == b->EventId) && (a->StartTime == b->StartTime) && (a->Duration == b->Duration) &&
+    (a->EventName == b->EventName) && (a->EventText == b->EventText);
+}
+
+uint16_t TNowNextTable::GetServiceHandle(const TServiceKey& service) const
+{
+  std::lock_guard<std::mutex> lock(HandleMutex);
+  auto it = Handles.find(service);
+  if (it == Handles.end()) {
+    return INVALID_SERVICE_HANDLE;
+  }
+  return it->second;
+}
+
+bool TNowNextTable::Update(const TEitTable& eit, uint16_t& handle, std::shared_ptr<const NowNextStruct>& nowNext)
+{
+  TServiceKey key(eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
+  std::shared_ptr<NowNext> next(new NowNext(eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId(),
+    eit.GetVersionNumber()));
+
+  // The present event is in section 0 and the following one in section 1
+  const std::vector<TEitEvent>& events = eit.GetEvents();
+  const TEitEvent* present = NULL;
+  const TEitEvent* following = NULL;
+  for (auto it = events.begin(), end = events.end(); it != end; ++it) {
+    if (it->GetSectionNumber() == 0) {
+      present = &*it;
+    }
+    else if (it->GetSectionNumber() == 1) {
+      following = &*it;
+    }
+  }
+  if (present) {
+    next->Present = TEpgGridIndex::CreateEvent(eit, *present);
+    next->PresentRunningStatus = present->GetRunningStatus();
+  }
+  if (following) {
+    next->Following = TEpgGridIndex::CreateEvent(eit, *following);
+    next->FollowingRunningStatus = following->GetRunningStatus();
+  }
+
+  std::lock_guard<std::mutex> lock(WriteMutex);
+  handle = GetServiceHandle(key);
+  if (handle == INVALID_SERVICE_HANDLE) {
+    if (ServiceCount >= INVALID_SERVICE_HANDLE) {
+      OS_LOG(DVB_ERROR,   "<%s> No handle left for service 0x%x.0x%x.0x%x\n", __FUNCTION__,
+        eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId());
+      return false;
+    }
+    handle = ServiceCount;
+    if (!Chunks[handle / CHUNK_SIZE]) {
+      Chunks[handle / CHUNK_SIZE].reset(new TSlot[CHUNK_SIZE]);
+    }
+    OS_LOG(DVB_DEBUG,   "<%s> Service 0x%x.0x%x.0x%x gets handle %d\n", __FUNCTION__,
+      eit.GetNetworkId(), eit.GetTsId(), eit.GetTableExtensionId(), handle);
+    // The slot is filled before the handle becomes valid for the readers
+    std::atomic_store(&GetSlot(handle).NowNext, std::shared_ptr<const NowNextStruct>(next));
+    ++ServiceCount;
+    {
+      std::lock_guard<std::mutex> handleLock(HandleMutex);
+      Handles.insert(std::make_pair(key, handle));
+    }
+    nowNext = next;
+    return true;
+  }
+
+  std::shared_ptr<const NowNextStruct> current = std::atomic_load(&GetSlot(handle).NowNext);
+  if (IsSameEvent(current->Present, next->Present) && IsSameEvent(current->Following, next->Following) &&
+      (current->PresentRunningStatus == next->PresentRunningStatus) &&
+      (current->FollowingRunningStatus == next->FollowingRunningStatus)) {
+    nowNext = current;
+    return false;
+  }
+  std::atomic_store(&GetSlot(handle).NowNext, std::shared_ptr<const NowNextStruct>(next));
+  nowNext = next;
+  return true;
+}
@@ -0,0 +1,194 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Guide queries on the EPG grid index: a benchmark at 500 services x 8 days of one hour
+// events, the replacement of the events per segment of an EIT sub-table, and a query
+// through the storage agreeing with its database.
+
+#include "TSimulatedNetwork.h"
+#include "TEpgGridIndex.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+const uint32_t SERVICE_COUNT = 500;
+const uint32_t DAY_COUNT = 8;
+// A schedule sub-table covers 4 days of 32 segments of 3 hours
+const uint32_t EVENTS_PER_TABLE = 96;
+const uint32_t GRID_SERVICE_COUNT = 50;
+const uint32_t QUERY_COUNT = 1000;
+
+// One hour events from startTime, three per segment. eventIds lists the id of each event,
+// 0 leaves the slot empty.
+std::shared_ptr<TEitTable> MakeSchedule(uint16_t serviceId, uint8_t tableId, uint8_t version, time_t startTime,
+  const std::vector<uint16_t>& eventIds)
+{
+  std::shared_ptr<TEitTable> eit(new TEitTable(tableId, serviceId, version, true));
+  eit->SetNetworkId(NETWORK_ID);
+  eit->SetTsId(TS_ID);
+  for (uint32_t i = 0; i < eventIds.size(); i++) {
+    if (!eventIds[i]) {
+      continue;
+    }
+    TEitEvent event(eventIds[i], EncodeMjdUtc(startTime + 3600 * i), EncodeDurationBcd(3600), 4, false);
+    event.SetSectionNumber((uint8_t)((i / 3) * 8 + i % 3));
+    uint8_t data[] = {'e', 'n', 'g', 4, 'N', 'e', 'w', 's', 0};
+    event.AddDescriptor(TMpegDescriptor(TDescriptorTag::SHORT_EVENT_TAG, data, sizeof(data)));
+    eit->AddEvent(event);
+  }
+  return eit;
+}
+
+std::vector<uint16_t> GetEventIds(uint16_t firstId, uint32_t count)
+{
+  std::vector<uint16_t> ids;
+  for (uint32_t i = 0; i < count; i++) {
+    ids.push_back(firstId + i);
+  }
+  return ids;
+}
+
+std::vector<uint16_t> GetWindowEventIds(const TEpgGridIndex& index, uint16_t serviceId, time_t startTime, time_t endTime)
+{
+  std::vector<uint16_t> ids;
+  std::vector<std::shared_ptr<const EventStruct>> events =
+    index.GetEvents(TServiceKey(NETWORK_ID, TS_ID, serviceId), startTime, endTime);
+  for (auto it = events.begin(), end = events.end(); it != end; ++it) {
+    ids.push_back((*it)->EventId);
+  }
+  return ids;
+}
+
+void RunBenchmark(time_t startTime)
+{
+  TEpgGridIndex index;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint16_t sid = 1; sid <= SERVICE_COUNT; sid++) {
+    for (uint32_t table = 0; table < DAY_COUNT / 4; table++) {
+      std::shared_ptr<TEitTable> eit = MakeSchedule(sid, (uint8_t)(TTableId::TABLE_ID_EIT_SCHED_START + table), 1,
+        startTime + table * EVENTS_PER_TABLE * 3600, GetEventIds(1 + table * EVENTS_PER_TABLE, EVENTS_PER_TABLE));
+      index.Update(*eit);
+    }
+  }
+  int64_t buildMs = ElapsedMs(start);
+  TEST_CHECK(index.GetEventCount() == SERVICE_COUNT * DAY_COUNT * 24);
+
+  // Three hour windows of 50 services spread over the 8 days
+  std::vector<TServiceKey> services;
+  for (uint16_t sid = 1; sid <= GRID_SERVICE_COUNT; sid++) {
+    services.push_back(TServiceKey(NETWORK_ID, TS_ID, sid * (SERVICE_COUNT / GRID_SERVICE_COUNT)));
+  }
+  size_t eventCount = 0;
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < QUERY_COUNT; i++) {
+    time_t windowStart = startTime + (i * 7919 % (DAY_COUNT * 24 - 3)) * 3600;
+    std::vector<std::vector<std::shared_ptr<const EventStruct>>> grid = index.GetEvents(services, windowStart, windowStart + 3 * 3600);
+    for (auto it = grid.begin(), end = grid.end(); it != end; ++it) {
+      eventCount += it->size();
+    }
+  }
+  double gridUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / QUERY_COUNT;
+  TEST_CHECK(eventCount == QUERY_COUNT * GRID_SERVICE_COUNT * 3);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < QUERY_COUNT; i++) {
+    eventCount = index.GetEvents(services[i % GRID_SERVICE_COUNT], startTime, startTime + DAY_COUNT * 86400).size();
+  }
+  double serviceUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / QUERY_COUNT;
+  TEST_CHECK(eventCount == DAY_COUNT * 24);
+
+  printf("%u services x %u days: %u events indexed in %lld ms, %u services x 3 hour grid: %.1f us, 8 days of a service: %.1f us\n",
+    SERVICE_COUNT, DAY_COUNT, index.GetEventCount(), (long long)buildMs, GRID_SERVICE_COUNT, gridUs, serviceUs);
+}
+
+void CheckSegmentReplacement(time_t startTime)
+{
+  TEpgGridIndex index;
+  time_t endTime = startTime + 9 * 3600;
+  const uint8_t tableId = (uint8_t)TTableId::TABLE_ID_EIT_SCHED_START;
+
+  // Segments 0, 1 and 2
+  index.Update(*MakeSchedule(1, tableId, 1, startTime, GetEventIds(1, 9)));
+  TEST_CHECK(GetWindowEventIds(index, 1, startTime, endTime) == GetEventIds(1, 9));
+
+  // Version 2 drops the events of segment 1 and renumbers segment 2
+  uint16_t v2[] = {1, 2, 3, 0, 0, 0, 17, 18, 19};
+  index.Update(*MakeSchedule(1, tableId, 2, startTime, std::vector<uint16_t>(std::begin(v2), std::end(v2))));
+  uint16_t afterV2[] = {1, 2, 3, 17, 18, 19};
+  TEST_CHECK(GetWindowEventIds(index, 1, startTime, endTime) == std::vector<uint16_t>(std::begin(afterV2), std::end(afterV2)));
+
+  // Version 3 is partial: segment 0 is missing, it keeps its events while segment 2 is replaced
+  uint16_t v3[] = {0, 0, 0, 0, 0, 0, 27, 28, 0};
+  std::shared_ptr<TEitTable> partial = MakeSchedule(1, tableId, 3, startTime, std::vector<uint16_t>(std::begin(v3), std::end(v3)));
+  std::bitset<256> missing;
+  missing.set(0);
+  missing.set(1);
+  missing.set(2);
+  partial->SetPartial(missing);
+  index.Update(*partial);
+  uint16_t afterV3[] = {1, 2, 3, 27, 28};
+  TEST_CHECK(GetWindowEventIds(index, 1, startTime, endTime) == std::vector<uint16_t>(std::begin(afterV3), std::end(afterV3)));
+
+  // Another sub-table of the service keeps its events, an empty complete version removes all of them
+  index.Update(*MakeSchedule(1, tableId + 1, 1, endTime, GetEventIds(100, 3)));
+  index.Update(*MakeSchedule(1, tableId, 4, startTime, std::vector<uint16_t>()));
+  TEST_CHECK(GetWindowEventIds(index, 1, startTime, endTime + 3 * 3600) == GetEventIds(100, 3));
+  TEST_CHECK(index.GetEventCount() == 3);
+}
+
+void CheckStorageQuery(time_t startTime)
+{
+  std::string dbPath = GetTestDbPath("EpgGridIndexTest");
+  std::string configPath;
+  TDvbSiStorage storage(474000000, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  storage.OnEit(MakeSchedule(7, (uint8_t)TTableId::TABLE_ID_EIT_SCHED_START, 1, startTime, GetEventIds(1, 6)));
+
+  std::vector<std::shared_ptr<const EventStruct>> events =
+    storage.GetEventsInWindow(NETWORK_ID, TS_ID, 7, startTime + 3600, startTime + 3 * 3600);
+  TEST_CHECK(events.size() == 2);
+  if (events.size() == 2) {
+    TEST_CHECK((events[0]->EventId == 2) && (events[1]->EventId == 3));
+    TEST_CHECK(events[0]->StartTime == (uint64_t)(startTime + 3600));
+  }
+
+  // The database has the same UTC start times as the index
+  std::vector<std::shared_ptr<EventStruct>> dbEvents = storage.GetEventListByServiceId(NETWORK_ID, TS_ID, 7);
+  TEST_CHECK(dbEvents.size() == 6);
+  for (auto it = dbEvents.begin(), end = dbEvents.end(); it != end; ++it) {
+    TEST_CHECK((*it)->StartTime == (uint64_t)(startTime + 3600 * ((*it)->EventId - 1)));
+  }
+}
+
+} // namespace
+
+int main()
+{
+  // A local time zone with daylight saving time, the start times must not depend on it
+  setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+  tzset();
+  time_t startTime = TSimulatedNetwork::GetStartTime();
+  RunBenchmark(startTime);
+  CheckSegmentReplacement(startTime);
+  CheckStorageQuery(startTime);
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Acquisition ledger: an EIT or BAT is published once per version, received again it is skipped,
+// and a new version replaces the entry of its table only.
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t SERVICES_PER_TRANSPORT = 3;
+const uint16_t BOUQUET_ID = 0x10;
+
+std::shared_ptr<TBatTable> MakeBat(const TSimulatedNetwork& network, uint16_t bouquetId, uint8_t version)
+{
+  std::shared_ptr<TBatTable> bat(new TBatTable((uint8_t)TTableId::TABLE_ID_BAT, bouquetId, version, true));
+  uint8_t name[] = {'b', 'o', 'u', 'q', 'u', 'e', 't'};
+  bat->AddBouquetDescriptor(TMpegDescriptor(TDescriptorTag::BOUQUET_NAME_TAG, name, sizeof(name)));
+  const std::vector<TSimulatedNetwork::TTransport>& transports = network.GetTransports();
+  for (auto it = transports.begin(), end = transports.end(); it != end; ++it) {
+    bat->AddTransportStream(TTransportStream(it->TransportStreamId, NETWORK_ID));
+  }
+  return bat;
+}
+
+// Delivers the table, publishes and skippedWrites being the change of the cache counters
+template<typename TTable>
+void Deliver(TDvbSiStorage& storage, void (TDvbSiStorage::*onTable)(const std::shared_ptr<const TTable>&),
+  const std::shared_ptr<TTable>& table, uint64_t& publishes, uint64_t& skippedWrites)
+{
+  TCacheStats before = storage.GetCacheStats();
+  (storage.*onTable)(table);
+  TCacheStats after = storage.GetCacheStats();
+  publishes = after.Publishes - before.Publishes;
+  skippedWrites = after.SkippedWrites - before.SkippedWrites;
+}
+
+void CheckEitLedger()
+{
+  TSimulatedNetwork network(NETWORK_ID, 1, SERVICES_PER_TRANSPORT);
+  const TSimulatedNetwork::TTransport& home = network.GetTransports().front();
+  std::string dbPath = GetTestDbPath("LedgerTest");
+  std::string configPath;
+  TDvbSiStorage storage(home.Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  storage.OnNit(network.MakeNit(1));
+
+  uint16_t first = home.ServiceIds[0];
+  uint16_t second = home.ServiceIds[1];
+  time_t startTime = TSimulatedNetwork::GetStartTime();
+  uint8_t pf = (uint8_t)TTableId::TABLE_ID_EIT_PF;
+  uint8_t sched = (uint8_t)TTableId::TABLE_ID_EIT_SCHED_START;
+  uint64_t publishes = 0;
+  uint64_t skippedWrites = 0;
+
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, first, pf, 1, startTime, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, first, pf, 1, startTime, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 0) && (skippedWrites == 1));
+
+  // The p/f and the schedule of a service, and each service, have their own entry
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, first, sched, 1, startTime, 24), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, second, pf, 1, startTime, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+
+  // A new version replaces the entry: it is skipped in turn, and the previous version is a change again
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, first, pf, 2, startTime, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, first, pf, 2, startTime, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 0) && (skippedWrites == 1));
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, first, pf, 1, startTime, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+
+  // The replacement left the other entries alone
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, first, sched, 1, startTime, 24), publishes, skippedWrites);
+  TEST_CHECK((publishes == 0) && (skippedWrites == 1));
+  Deliver(storage, &TDvbSiStorage::OnEit, network.MakeEit(home, second, pf, 1, startTime, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 0) && (skippedWrites == 1));
+}
+
+void CheckBatLedger()
+{
+  TSimulatedNetwork network(NETWORK_ID, 2, SERVICES_PER_TRANSPORT);
+  std::string dbPath = GetTestDbPath("LedgerTestBat");
+  std::string configPath;
+  TDvbSiStorage storage(network.GetTransports().front().Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID,
+    dbPath, configPath);
+  storage.CreateDatabase();
+  storage.OnNit(network.MakeNit(1));
+
+  uint64_t publishes = 0;
+  uint64_t skippedWrites = 0;
+  Deliver(storage, &TDvbSiStorage::OnBat, MakeBat(network, BOUQUET_ID, 1), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+  Deliver(storage, &TDvbSiStorage::OnBat, MakeBat(network, BOUQUET_ID, 1), publishes, skippedWrites);
+  TEST_CHECK((publishes == 0) && (skippedWrites == 1));
+  Deliver(storage, &TDvbSiStorage::OnBat, MakeBat(network, BOUQUET_ID + 1, 1), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+
+  Deliver(storage, &TDvbSiStorage::OnBat, MakeBat(network, BOUQUET_ID, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 1) && (skippedWrites == 0));
+  Deliver(storage, &TDvbSiStorage::OnBat, MakeBat(network, BOUQUET_ID, 2), publishes, skippedWrites);
+  TEST_CHECK((publishes == 0) && (skippedWrites == 1));
+  Deliver(storage, &TDvbSiStorage::OnBat, MakeBat(network, BOUQUET_ID + 1, 1), publishes, skippedWrites);
+  TEST_CHECK((publishes == 0) && (skippedWrites == 1));
+}
+
+} // namespace
+
+int main()
+{
+  CheckEitLedger();
+  CheckBatLedger();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Now/next of the services from EIT p/f: the observer calls and GetNowNext() through the
+// storage, the handle limit of the table, and the cost of a read.
+
+#include "TSimulatedNetwork.h"
+#include "TNowNextTable.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint16_t TS_ID = 0x100;
+const uint32_t READ_COUNT = 1000000;
+
+// Present event in section 0, following event in section 1, an id of 0 leaves the section
+// empty. The following event comes first in the table if isReversed.
+std::shared_ptr<TEitTable> MakePf(uint16_t serviceId, uint8_t version, uint16_t presentId, uint8_t presentStatus,
+  uint16_t followingId, bool isReversed = false)
+{
+  std::shared_ptr<TEitTable> eit(new TEitTable((uint8_t)TTableId::TABLE_ID_EIT_PF, serviceId, version, true));
+  eit->SetNetworkId(NETWORK_ID);
+  eit->SetTsId(TS_ID);
+  time_t startTime = TSimulatedNetwork::GetStartTime();
+  std::vector<TEitEvent> events;
+  if (presentId) {
+    events.push_back(TEitEvent(presentId, EncodeMjdUtc(startTime), EncodeDurationBcd(3600), presentStatus, false));
+    events.back().SetSectionNumber(0);
+  }
+  if (followingId) {
+    events.push_back(TEitEvent(followingId, EncodeMjdUtc(startTime + 3600), EncodeDurationBcd(3600), 1, false));
+    events.back().SetSectionNumber(1);
+  }
+  if (isReversed) {
+    std::reverse(events.begin(), events.end());
+  }
+  for (auto it = events.begin(), end = events.end(); it != end; ++it) {
+    eit->AddEvent(*it);
+  }
+  return eit;
+}
+
+class TNowNextRecorder : public IDvbNowNextObserver
+{
+public:
+  TNowNextRecorder()
+    : CallCount(0),
+      LastHandle(INVALID_SERVICE_HANDLE)
+  {
+    // Empty
+  }
+
+  virtual void NowNextChanged(uint16_t serviceHandle, const std::shared_ptr<const NowNextStruct>& nowNext)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    ++CallCount;
+    LastHandle = serviceHandle;
+    LastNowNext = nowNext;
+  }
+
+  uint32_t GetCallCount()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return CallCount;
+  }
+
+  uint16_t GetLastHandle()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return LastHandle;
+  }
+
+  std::shared_ptr<const NowNextStruct> GetLastNowNext()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return LastNowNext;
+  }
+
+private:
+  std::mutex Mutex;
+  uint32_t CallCount;
+  uint16_t LastHandle;
+  std::shared_ptr<const NowNextStruct> LastNowNext;
+};
+
+uint16_t GetEventId(const std::shared_ptr<const EventStruct>& event)
+{
+  return event ? event->EventId : 0;
+}
+
+void CheckStorage()
+{
+  std::string dbPath = GetTestDbPath("NowNextTest");
+  std::string configPath;
+  TDvbSiStorage storage(474000000, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  TNowNextRecorder recorder;
+  storage.RegisterNowNextObserver(&recorder);
+
+  TEST_CHECK(storage.GetServiceHandle(NETWORK_ID, TS_ID, 1) == INVALID_SERVICE_HANDLE);
+  TEST_CHECK(!storage.GetNowNext(INVALID_SERVICE_HANDLE));
+
+  // The first EIT p/f of the service gives it a handle
+  storage.OnEit(MakePf(1, 1, 10, 4, 11));
+  uint16_t handle = storage.GetServiceHandle(NETWORK_ID, TS_ID, 1);
+  TEST_CHECK(handle != INVALID_SERVICE_HANDLE);
+  TEST_CHECK(recorder.GetCallCount() == 1);
+  TEST_CHECK(recorder.GetLastHandle() == handle);
+  std::shared_ptr<const NowNextStruct> nowNext = storage.GetNowNext(handle);
+  TEST_CHECK(nowNext && (nowNext == recorder.GetLastNowNext()));
+  if (nowNext) {
+    TEST_CHECK((GetEventId(nowNext->Present) == 10) && (GetEventId(nowNext->Following) == 11));
+    TEST_CHECK(nowNext->PresentRunningStatus == 4);
+  }
+
+  // The same events again change nothing
+  storage.OnEit(MakePf(1, 2, 10, 4, 11));
+  TEST_CHECK(recorder.GetCallCount() == 1);
+
+  // A running status change is reported
+  storage.OnEit(MakePf(1, 3, 10, 2, 11));
+  TEST_CHECK(recorder.GetCallCount() == 2);
+  nowNext = storage.GetNowNext(handle);
+  TEST_CHECK(nowNext && (nowNext->PresentRunningStatus == 2));
+
+  // The sections, not the order of the events, tell present from following
+  storage.OnEit(MakePf(1, 4, 11, 4, 12, true));
+  TEST_CHECK(recorder.GetCallCount() == 3);
+  nowNext = storage.GetNowNext(handle);
+  TEST_CHECK(nowNext && (GetEventId(nowNext->Present) == 11) && (GetEventId(nowNext->Following) == 12));
+
+  // Nothing on: section 0 is empty
+  storage.OnEit(MakePf(1, 5, 0, 0, 12));
+  nowNext = storage.GetNowNext(handle);
+  TEST_CHECK(nowNext && !nowNext->Present && (GetEventId(nowNext->Following) == 12));
+
+  // Another service gets its own handle, the first one keeps its entry
+  storage.OnEit(MakePf(2, 1, 20, 4, 21));
+  uint16_t otherHandle = storage.GetServiceHandle(NETWORK_ID, TS_ID, 2);
+  TEST_CHECK((otherHandle != INVALID_SERVICE_HANDLE) && (otherHandle != handle));
+  TEST_CHECK(recorder.GetLastHandle() == otherHandle);
+  TEST_CHECK(storage.GetNowNext(handle) == nowNext);
+
+  // A removed observer is not called
+  uint32_t callCount = recorder.GetCallCount();
+  storage.RemoveNowNextObserver(&recorder);
+  storage.OnEit(MakePf(2, 2, 21, 4, 22));
+  TEST_CHECK(recorder.GetCallCount() == callCount);
+
+  // Reads never wait for the ingestion
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint32_t presentCount = 0;
+  for (uint32_t i = 0; i < READ_COUNT; i++) {
+    std::shared_ptr<const NowNextStruct> entry = storage.GetNowNext((i & 1) ? handle : otherHandle);
+    presentCount += (entry && entry->Present) ? 1 : 0;
+  }
+  double readNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / READ_COUNT;
+  TEST_CHECK(presentCount == READ_COUNT / 2);
+  printf("GetNowNext: %.1f ns per read\n", readNs);
+}
+
+void CheckHandleLimit()
+{
+  TNowNextTable table;
+  uint16_t handle(INVALID_SERVICE_HANDLE);
+  std::shared_ptr<const NowNextStruct> nowNext;
+  uint32_t handleCount = 0;
+  for (uint32_t i = 0; i < 70000; i++) {
+    // More services than handles, spread over several transports
+    std::shared_ptr<TEitTable> eit = MakePf((uint16_t)(i % 0x8000), 1, 1, 4, 2);
+    eit->SetTsId((uint16_t)(TS_ID + i / 0x8000));
+    if (table.Update(*eit, handle, nowNext)) {
+      TEST_CHECK(handle == handleCount);
+      ++handleCount;
+    }
+  }
+  TEST_CHECK(handleCount == INVALID_SERVICE_HANDLE);
+  TEST_CHECK(table.GetServiceHandle(TServiceKey(NETWORK_ID, TS_ID + 1, 0)) == 0x8000);
+  TEST_CHECK(table.Get(INVALID_SERVICE_HANDLE - 1) && !table.Get(INVALID_SERVICE_HANDLE));
+  printf("%u services, %u handles\n", 70000, handleCount);
+}
+
+} // namespace
+
+int main()
+{
+  CheckStorage();
+  CheckHandleLimit();
+  return TestFailures ? 1 : 0;
+}
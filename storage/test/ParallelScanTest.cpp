@@ -0,0 +1,123 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Wall-clock time of a background scan against the number of tuners, and a scan that
+// loses tuners to live viewing half way through. The home transport carries the SDT
+// other and EIT p/f other, every other transport is tuned for its schedule.
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t TRANSPORT_COUNT = 16;
+const uint32_t SERVICES_PER_TRANSPORT = 2;
+const uint32_t TUNE_DELAY_MS = 150;
+const uint32_t TABLE_DELAY_MS = 250;
+
+struct TScanResult {
+  int64_t ScanTime;
+  uint32_t TuneCount;
+  uint32_t MaxActiveCount;
+  uint32_t TakenTuneCount;
+  uint32_t AcquiredCount;
+};
+
+// Scans the network with tunerCount tuners, the tuners in takenTuners are taken once all the tuners are busy
+TScanResult ScanNetwork(const TSimulatedNetwork& network, uint8_t tunerCount,
+  const std::vector<uint8_t>& takenTuners = std::vector<uint8_t>())
+{
+  uint32_t homeFrequency = network.GetTransports().front().Frequency;
+  std::string dbPath = GetTestDbPath("ParallelScanTest");
+  std::string configPath;
+  TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  storage.SetTunerCount(tunerCount);
+
+  TSimulatedTuners tuners(storage, [&network, homeFrequency](TDvbSiStorage& s, uint32_t frequency,
+    const TSimulatedNetwork::TTableHook& hook) {
+    if (frequency == homeFrequency) {
+      network.DeliverHome(s, true, 1, hook);
+    }
+    else if (const TSimulatedNetwork::TTransport* ts = network.FindTransport(frequency)) {
+      network.DeliverTransport(s, *ts, 1, hook);
+    }
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  storage.RegisterDvbStorageObserver(&tuners);
+
+  bool isTaken = false;
+  TScanResult result;
+  result.ScanTime = RunScan(storage, 120000, [&](int64_t) {
+    if (!isTaken && !takenTuners.empty() && (tuners.GetMaxActiveCount() == tunerCount)) {
+      for (auto it = takenTuners.begin(), end = takenTuners.end(); it != end; ++it) {
+        tuners.TakeTuner(*it);
+      }
+      isTaken = true;
+    }
+  });
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+
+  result.TuneCount = tuners.GetTuneCount();
+  result.MaxActiveCount = tuners.GetMaxActiveCount();
+  result.TakenTuneCount = tuners.GetTakenTuneCount();
+  result.AcquiredCount = 0;
+  TDvbScanStatus status = storage.GetScanStatus();
+  for (auto it = status.TsList.begin(), end = status.TsList.end(); it != end; ++it) {
+    // The home job reports the NIT and the home SDT, the transport jobs their SDT and schedule
+    if (!it->second.NitAcquired && it->second.SdtAcquired && it->second.EitAcquired) {
+      ++result.AcquiredCount;
+    }
+  }
+  printf("%d tuner(s)%s: scan time %lld ms, tunes: %u, max active tuners: %u\n", tunerCount,
+    takenTuners.empty() ? "" : " losing some", (long long)result.ScanTime, result.TuneCount, result.MaxActiveCount);
+  return result;
+}
+
+} // namespace
+
+int main()
+{
+  TSimulatedNetwork network(NETWORK_ID, TRANSPORT_COUNT, SERVICES_PER_TRANSPORT);
+
+  std::map<uint8_t, TScanResult> results;
+  uint8_t tunerCounts[] = {1, 2, 4};
+  for (auto count = std::begin(tunerCounts), end = std::end(tunerCounts); count != end; ++count) {
+    TScanResult& result = results[*count] = ScanNetwork(network, *count);
+    TEST_CHECK(result.ScanTime >= 0);
+    TEST_CHECK(result.MaxActiveCount == *count);
+    TEST_CHECK(result.AcquiredCount == TRANSPORT_COUNT);
+  }
+  TEST_CHECK(results[2].ScanTime < results[1].ScanTime);
+  TEST_CHECK(results[4].ScanTime < results[2].ScanTime);
+
+  // Two of the four tuners are taken mid-scan: their transports are scanned again on the others
+  std::vector<uint8_t> taken;
+  taken.push_back(1);
+  taken.push_back(2);
+  TScanResult degraded = ScanNetwork(network, 4, taken);
+  TEST_CHECK(degraded.ScanTime >= 0);
+  TEST_CHECK(degraded.TakenTuneCount == 0);
+  TEST_CHECK(degraded.TuneCount > TRANSPORT_COUNT);
+  TEST_CHECK(degraded.AcquiredCount == TRANSPORT_COUNT);
+
+  return TestFailures ? 1 : 0;
+}
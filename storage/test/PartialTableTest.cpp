@@ -0,0 +1,144 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Partial tables: the complete table of the same version replaces the partial one in the
+// caches and the database, and a partial table only ends a scan wait once accepted.
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t SERVICES_PER_TRANSPORT = 3;
+const uint32_t TUNE_DELAY_MS = 10;
+const uint32_t TABLE_DELAY_MS = 10;
+
+// The SDT of the transport with its first service only, the others being in the missing section 1
+std::shared_ptr<TSdtTable> MakePartialSdt(const TSimulatedNetwork& network, const TSimulatedNetwork::TTransport& ts,
+  bool isActual, uint8_t version)
+{
+  TSimulatedNetwork::TTransport first(ts);
+  first.ServiceIds.resize(1);
+  std::shared_ptr<TSdtTable> sdt = network.MakeSdt(first, isActual, version);
+  std::bitset<256> missing;
+  missing.set(1);
+  sdt->SetPartial(missing);
+  return sdt;
+}
+
+void CheckReplacement()
+{
+  TSimulatedNetwork network(NETWORK_ID, 2, SERVICES_PER_TRANSPORT);
+  const TSimulatedNetwork::TTransport& ts = network.GetTransports()[1];
+  std::string dbPath = GetTestDbPath("PartialTableTest");
+  std::string configPath;
+  TDvbSiStorage storage(network.GetTransports().front().Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID,
+    dbPath, configPath);
+  storage.CreateDatabase();
+  storage.OnNit(network.MakeNit(1));
+
+  TCacheStats before = storage.GetCacheStats();
+  storage.OnSdt(MakePartialSdt(network, ts, false, 1));
+  TEST_CHECK(storage.GetServiceListByTsId(NETWORK_ID, ts.TransportStreamId).size() == 1);
+
+  // The partial table again is skipped
+  storage.OnSdt(MakePartialSdt(network, ts, false, 1));
+  TCacheStats stats = storage.GetCacheStats();
+  TEST_CHECK(stats.Publishes - before.Publishes == 1);
+  TEST_CHECK(stats.SkippedWrites - before.SkippedWrites == 1);
+
+  // The complete table of the same version replaces it, and is then skipped
+  storage.OnSdt(network.MakeSdt(ts, false, 1));
+  storage.OnSdt(network.MakeSdt(ts, false, 1));
+  stats = storage.GetCacheStats();
+  TEST_CHECK(stats.Publishes - before.Publishes == 2);
+  TEST_CHECK(stats.SkippedWrites - before.SkippedWrites == 2);
+  TEST_CHECK(storage.GetServiceListByTsId(NETWORK_ID, ts.TransportStreamId).size() == SERVICES_PER_TRANSPORT);
+
+  // Same for the EIT ledger
+  before = stats;
+  std::shared_ptr<TEitTable> eit = network.MakeEit(ts, ts.ServiceIds.front(), (uint8_t)TTableId::TABLE_ID_EIT_PF_OTHER,
+    1, TSimulatedNetwork::GetStartTime(), 1);
+  std::bitset<256> missing;
+  missing.set(1);
+  eit->SetPartial(missing);
+  storage.OnEit(eit);
+  storage.OnEit(eit);
+  storage.OnEit(network.MakeEit(ts, ts.ServiceIds.front(), (uint8_t)TTableId::TABLE_ID_EIT_PF_OTHER, 1,
+    TSimulatedNetwork::GetStartTime(), 2));
+  stats = storage.GetCacheStats();
+  TEST_CHECK(stats.Publishes - before.Publishes == 2);
+  TEST_CHECK(stats.SkippedWrites - before.SkippedWrites == 1);
+}
+
+// Scans a network whose SDT actual never completes. Returns the scan time.
+int64_t ScanWithPartialSdt(bool isPartialAccepted)
+{
+  TSimulatedNetwork network(NETWORK_ID, 1, SERVICES_PER_TRANSPORT);
+  const TSimulatedNetwork::TTransport& home = network.GetTransports().front();
+  std::string dbPath = GetTestDbPath("PartialTableTestScan");
+  std::string configPath;
+  TDvbSiStorage storage(home.Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  storage.SetPartialTablesAccepted(isPartialAccepted);
+
+  TSimulatedTuners tuners(storage, [&network, &home](TDvbSiStorage& s, uint32_t /*frequency*/,
+    const TSimulatedNetwork::TTableHook& hook) {
+    if (!hook()) {
+      return;
+    }
+    s.OnNit(network.MakeNit(1));
+    s.OnSdt(MakePartialSdt(network, home, true, 1));
+    for (auto sid = home.ServiceIds.begin(), end = home.ServiceIds.end(); sid != end; ++sid) {
+      if (!hook()) {
+        return;
+      }
+      s.OnEit(network.MakeEit(home, *sid, (uint8_t)TTableId::TABLE_ID_EIT_PF, 1, TSimulatedNetwork::GetStartTime(), 2));
+      s.OnEit(network.MakeEit(home, *sid, (uint8_t)TTableId::TABLE_ID_EIT_SCHED_START, 1,
+        TSimulatedNetwork::GetStartTime(), 24));
+    }
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  storage.RegisterDvbStorageObserver(&tuners);
+  int64_t scanTime = RunScan(storage, 60000);
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+  return scanTime;
+}
+
+void CheckScanWait()
+{
+  // The partial SDT leaves the wait to its timeout
+  int64_t waitedMs = ScanWithPartialSdt(false);
+  TEST_CHECK(waitedMs >= SDT_TIMEOUT * 1000);
+
+  int64_t acceptedMs = ScanWithPartialSdt(true);
+  TEST_CHECK((acceptedMs >= 0) && (acceptedMs < SDT_TIMEOUT * 1000));
+  printf("scan with a partial SDT: %lld ms, accepted: %lld ms\n", (long long)waitedMs, (long long)acceptedMs);
+}
+
+} // namespace
+
+int main()
+{
+  CheckReplacement();
+  CheckScanWait();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Tunes planned by the scan against one tune per transport. The home transport carries
+// the SDT other and EIT p/f other of all the transports and the EIT schedule other of
+// the first ones, so only the remaining transports are tuned, nearest to home first.
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t TRANSPORT_COUNT = 10;
+const uint32_t SERVICES_PER_TRANSPORT = 3;
+// Transports whose schedule is carried on home, after the home transport itself
+const uint32_t SCHEDULE_OTHER_COUNT = 4;
+const uint32_t TUNE_DELAY_MS = 50;
+const uint32_t TABLE_DELAY_MS = 100;
+
+struct TScanResult {
+  int64_t ScanTime;
+  uint32_t NaiveTuneCount;
+  uint32_t PlannedTuneCount;
+  uint32_t AcquiredCount;
+  std::vector<uint32_t> TunedFrequencies;
+};
+
+TScanResult ScanNetwork(const TSimulatedNetwork& network, bool withOther)
+{
+  uint32_t homeFrequency = network.GetTransports().front().Frequency;
+  std::string dbPath = GetTestDbPath("ScanPlannerTest");
+  std::string configPath;
+  TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+
+  TSimulatedTuners tuners(storage, [&network, homeFrequency, withOther](TDvbSiStorage& s, uint32_t frequency,
+    const TSimulatedNetwork::TTableHook& hook) {
+    if (frequency == homeFrequency) {
+      network.DeliverHome(s, withOther, 1, hook, SCHEDULE_OTHER_COUNT);
+    }
+    else if (const TSimulatedNetwork::TTransport* ts = network.FindTransport(frequency)) {
+      network.DeliverTransport(s, *ts, 1, hook);
+    }
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  storage.RegisterDvbStorageObserver(&tuners);
+
+  TScanResult result;
+  result.ScanTime = RunScan(storage, 60000);
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+
+  TDvbScanStatus status = storage.GetScanStatus();
+  result.NaiveTuneCount = status.NaiveTuneCount;
+  result.PlannedTuneCount = status.PlannedTuneCount;
+  result.TunedFrequencies = tuners.GetTunedFrequencies();
+  result.AcquiredCount = 0;
+  for (auto it = status.TsList.begin(), end = status.TsList.end(); it != end; ++it) {
+    if (!it->second.NitAcquired && it->second.SdtAcquired && it->second.EitPfAcquired && it->second.EitAcquired) {
+      ++result.AcquiredCount;
+    }
+  }
+  printf("%s: scan time %lld ms, tunes planned: %u, naive: %u, tuned: %lu\n",
+    withOther ? "home carries the other tables" : "home carries its own tables only", (long long)result.ScanTime,
+    result.PlannedTuneCount, result.NaiveTuneCount, (unsigned long)result.TunedFrequencies.size());
+  return result;
+}
+
+} // namespace
+
+int main()
+{
+  TSimulatedNetwork network(NETWORK_ID, TRANSPORT_COUNT, SERVICES_PER_TRANSPORT);
+  const std::vector<TSimulatedNetwork::TTransport>& transports = network.GetTransports();
+
+  // The home inventory waits out its timeout for the tables that never come
+  TScanResult naive = ScanNetwork(network, false);
+  TEST_CHECK(naive.ScanTime >= 0);
+  TEST_CHECK(naive.NaiveTuneCount == TRANSPORT_COUNT + 1);
+  // Only the home transport itself is planned away
+  TEST_CHECK(naive.PlannedTuneCount == TRANSPORT_COUNT);
+  TEST_CHECK(naive.TunedFrequencies.size() == naive.PlannedTuneCount);
+  TEST_CHECK(naive.AcquiredCount == TRANSPORT_COUNT);
+
+  TScanResult planned = ScanNetwork(network, true);
+  TEST_CHECK(planned.ScanTime >= 0);
+  TEST_CHECK(planned.NaiveTuneCount == TRANSPORT_COUNT + 1);
+  TEST_CHECK(planned.PlannedTuneCount == TRANSPORT_COUNT - SCHEDULE_OTHER_COUNT);
+  TEST_CHECK(planned.TunedFrequencies.size() == planned.PlannedTuneCount);
+  TEST_CHECK(planned.AcquiredCount == TRANSPORT_COUNT);
+  TEST_CHECK(planned.ScanTime < naive.ScanTime);
+
+  // Home first, then the transports missing their schedule, the nearest first
+  std::vector<uint32_t> expected;
+  expected.push_back(transports.front().Frequency);
+  for (uint32_t i = SCHEDULE_OTHER_COUNT + 1; i < TRANSPORT_COUNT; i++) {
+    expected.push_back(transports[i].Frequency);
+  }
+  TEST_CHECK(planned.TunedFrequencies == expected);
+
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Scan state machine: a tune that never locks ends its job at the tune timeout, a reported tune
+// failure ends it at once, RestartScan() starts a new run at once and StopScan() ends the thread.
+
+#include <atomic>
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t SERVICES_PER_TRANSPORT = 3;
+const uint32_t TUNE_DELAY_MS = 10;
+const uint32_t TABLE_DELAY_MS = 10;
+
+// A tuner that never locks, it only reports "not tuned yet"
+class TSilentTuner : public IDvbStorageObserver
+{
+public:
+  TSilentTuner(TDvbSiStorage& storage)
+    : Storage(storage),
+      TuneCount(0),
+      UnTuneCount(0)
+  {
+    // Empty
+  }
+
+  virtual void Tune(const uint32_t& /*freq*/, const TDvbStorageNamespace::TModulationMode& /*mod*/,
+    const uint32_t& /*symbol*/)
+  {
+    ++TuneCount;
+    Storage.UpdateTuneStatus(false);
+  }
+
+  virtual void UnTune()
+  {
+    ++UnTuneCount;
+  }
+
+  uint32_t GetTuneCount() const
+  {
+    return TuneCount;
+  }
+
+  uint32_t GetUnTuneCount() const
+  {
+    return UnTuneCount;
+  }
+
+private:
+  TDvbSiStorage& Storage;
+  std::atomic<uint32_t> TuneCount;
+  std::atomic<uint32_t> UnTuneCount;
+};
+
+void CheckTuneTimeout()
+{
+  TSimulatedNetwork network(NETWORK_ID, 1, SERVICES_PER_TRANSPORT);
+  std::string dbPath = GetTestDbPath("ScanStateTestTimeout");
+  std::string configPath;
+  TDvbSiStorage storage(network.GetTransports().front().Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID,
+    dbPath, configPath);
+  storage.CreateDatabase();
+  TSilentTuner tuner(storage);
+  storage.RegisterDvbStorageObserver(&tuner);
+
+  // Without the home transport the scan fails, once the tune timed out
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int64_t scanTime = RunScan(storage, TUNE_TIMEOUT * 2000);
+  int64_t elapsedMs = ElapsedMs(start);
+  TEST_CHECK(scanTime < 0);
+  TEST_CHECK((elapsedMs >= TUNE_TIMEOUT * 1000) && (elapsedMs < TUNE_TIMEOUT * 1000 + 2000));
+  TEST_CHECK(storage.GetScanStatus().ScanState == SCAN_STOPPED);
+  TEST_CHECK((tuner.GetTuneCount() == 1) && (tuner.GetUnTuneCount() == 1));
+  storage.RemoveDvbStorageObserver(&tuner);
+  printf("tune timed out after %lld ms\n", (long long)elapsedMs);
+}
+
+void CheckTuneFailure()
+{
+  TSimulatedNetwork network(NETWORK_ID, 1, SERVICES_PER_TRANSPORT);
+  const TSimulatedNetwork::TTransport& home = network.GetTransports().front();
+  std::string dbPath = GetTestDbPath("ScanStateTestFailure");
+  std::string configPath;
+  TDvbSiStorage storage(home.Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  TSimulatedTuners tuners(storage, [&network](TDvbSiStorage& s, uint32_t /*frequency*/,
+    const TSimulatedNetwork::TTableHook& hook) {
+    network.DeliverHome(s, false, 1, hook);
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  tuners.SetTuneFailure(home.Frequency);
+  storage.RegisterDvbStorageObserver(&tuners);
+
+  // The scan fails without waiting for the tune timeout
+  bool isFailed = false;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  RunScan(storage, TUNE_TIMEOUT * 2000, [&storage, &isFailed](int64_t /*elapsedMs*/) {
+    isFailed = isFailed || (storage.GetScanStatus().ScanState == SCAN_FAILED);
+  });
+  int64_t elapsedMs = ElapsedMs(start);
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+  TEST_CHECK(isFailed);
+  TEST_CHECK(elapsedMs < 1000);
+  TEST_CHECK(tuners.GetTuneCount() == 1);
+}
+
+void CheckRestart()
+{
+  TSimulatedNetwork network(NETWORK_ID, 1, SERVICES_PER_TRANSPORT);
+  const TSimulatedNetwork::TTransport& home = network.GetTransports().front();
+  std::string dbPath = GetTestDbPath("ScanStateTestRestart");
+  std::string configPath;
+  TDvbSiStorage storage(home.Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+
+  // The first tune brings no table until it is untuned, the next ones bring the network
+  std::atomic<uint32_t> deliveryCount(0);
+  TSimulatedTuners tuners(storage, [&network, &deliveryCount](TDvbSiStorage& s, uint32_t /*frequency*/,
+    const TSimulatedNetwork::TTableHook& hook) {
+    if (deliveryCount++ == 0) {
+      while (hook()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      return;
+    }
+    network.DeliverHome(s, false, 1, hook);
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  storage.RegisterDvbStorageObserver(&tuners);
+
+  // Restarted while waiting for the NIT, the scan tunes again at once instead of waiting for the
+  // NIT timeout
+  bool isRestarted = false;
+  int64_t scanTime = RunScan(storage, 60000, [&storage, &isRestarted](int64_t elapsedMs) {
+    if (!isRestarted && (elapsedMs >= 500)) {
+      storage.RestartScan();
+      isRestarted = true;
+    }
+  });
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+  TEST_CHECK((scanTime >= 500) && (scanTime < NIT_TIMEOUT * 1000));
+  std::vector<uint32_t> frequencies = tuners.GetTunedFrequencies();
+  TEST_CHECK((frequencies.size() >= 2) && (frequencies[0] == home.Frequency) && (frequencies[1] == home.Frequency));
+  TEST_CHECK(deliveryCount >= 2);
+  printf("restarted after 500 ms: scan completed in %lld ms\n", (long long)scanTime);
+}
+
+void CheckStop()
+{
+  TSimulatedNetwork network(NETWORK_ID, 1, SERVICES_PER_TRANSPORT);
+  std::string dbPath = GetTestDbPath("ScanStateTestStop");
+  std::string configPath;
+  TDvbSiStorage storage(network.GetTransports().front().Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID,
+    dbPath, configPath);
+  storage.CreateDatabase();
+  TSilentTuner tuner(storage);
+  storage.RegisterDvbStorageObserver(&tuner);
+
+  std::thread scanThread(TDvbSiStorage::ScanThreadInit, &storage);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while ((tuner.GetTuneCount() == 0) && (ElapsedMs(start) < 5000)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  TEST_CHECK(tuner.GetTuneCount() == 1);
+
+  // The thread ends without waiting for the tune timeout, the tuner released
+  start = std::chrono::steady_clock::now();
+  storage.StopScan();
+  scanThread.join();
+  TEST_CHECK(ElapsedMs(start) < 1000);
+  TEST_CHECK(storage.GetScanStatus().ScanState == SCAN_STOPPED);
+  TEST_CHECK(tuner.GetUnTuneCount() == 1);
+  storage.RemoveDvbStorageObserver(&tuner);
+}
+
+} // namespace
+
+int main()
+{
+  CheckTuneTimeout();
+  CheckTuneFailure();
+  CheckRestart();
+  CheckStop();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Scan time of a background scan on one tuner. The tables of a transport wake the scan
+// as they arrive, so the tuner is released right after them rather than on the next
+// poll of the cache, which cost up to a second per phase.
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t TRANSPORT_COUNT = 12;
+const uint32_t SERVICES_PER_TRANSPORT = 4;
+const uint32_t TUNE_DELAY_MS = 50;
+const uint32_t TABLE_DELAY_MS = 50;
+
+// Well under the second a phase could wait for the next poll of the cache
+const int64_t MAX_IDLE_MS = 500;
+
+} // namespace
+
+int main()
+{
+  TSimulatedNetwork network(NETWORK_ID, TRANSPORT_COUNT, SERVICES_PER_TRANSPORT);
+  uint32_t homeFrequency = network.GetTransports().front().Frequency;
+  std::string dbPath = GetTestDbPath("ScanTimeTest");
+  std::string configPath;
+  TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+
+  TSimulatedTuners tuners(storage, [&network, homeFrequency](TDvbSiStorage& s, uint32_t frequency,
+    const TSimulatedNetwork::TTableHook& hook) {
+    if (frequency == homeFrequency) {
+      network.DeliverHome(s, true, 1, hook);
+    }
+    else if (const TSimulatedNetwork::TTransport* ts = network.FindTransport(frequency)) {
+      network.DeliverTransport(s, *ts, 1, hook);
+    }
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  storage.RegisterDvbStorageObserver(&tuners);
+
+  int64_t scanTime = RunScan(storage, 60000);
+  tuners.Join();
+
+  TDvbScanStatus status = storage.GetScanStatus();
+  printf("scan time: %lld ms, tunes: %u, idle after the tables: mean %lld ms, max %lld ms\n",
+    (long long)scanTime, tuners.GetTuneCount(), (long long)tuners.GetMeanIdleMs(), (long long)tuners.GetMaxIdleMs());
+
+  TEST_CHECK(scanTime >= 0);
+  TEST_CHECK(status.TsList.size() == TRANSPORT_COUNT + 1);
+  for (auto it = status.TsList.begin(), end = status.TsList.end(); it != end; ++it) {
+    // The home job and then a job per transport, including the ones planned away
+    TEST_CHECK(it->second.SdtAcquired);
+    TEST_CHECK(it->second.NitAcquired || (it->second.EitPfAcquired && it->second.EitAcquired));
+  }
+  TEST_CHECK(tuners.GetMaxIdleMs() < MAX_IDLE_MS);
+  // Each tune waits for the lock and the tables, but not for a poll
+  TEST_CHECK(scanTime < tuners.GetTuneCount() * (TUNE_DELAY_MS + TABLE_DELAY_MS + MAX_IDLE_MS));
+
+  storage.RemoveDvbStorageObserver(&tuners);
+  return TestFailures ? 1 : 0;
+}
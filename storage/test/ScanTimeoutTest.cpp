@@ -0,0 +1,154 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Learned scan timeouts: the 95th percentile of the acquisition times plus half of it, at least
+// one second, bounded by 4 times the default timeout, and the timed out waits recorded with the
+// default timeout.
+
+#include "TDvbDb.h"
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t SERVICES_PER_TRANSPORT = 3;
+const uint32_t TUNE_DELAY_MS = 10;
+const uint32_t TABLE_DELAY_MS = 10;
+const uint32_t HISTORY_SIZE = 32;
+const uint32_t NIT_TABLE_TYPE = (uint32_t)TTableId::TABLE_ID_NIT | ((uint32_t)TTableId::TABLE_ID_BAT << 8);
+const uint32_t SDT_TABLE_TYPE = (uint32_t)TTableId::TABLE_ID_SDT;
+
+// Scans the single transport network for at most timeoutMs: the NIT arrives nitDelayMs after the
+// tune, the SDT and EIT after it unless sdtDelivered is false. Returns the time the scan ran.
+int64_t ScanNetwork(TSimulatedNetwork& network, const std::string& dbPath, int64_t nitDelayMs, bool sdtDelivered,
+  int64_t timeoutMs)
+{
+  const TSimulatedNetwork::TTransport& home = network.GetTransports().front();
+  std::string configPath;
+  TDvbSiStorage storage(home.Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  TSimulatedTuners tuners(storage, [&](TDvbSiStorage& s, uint32_t /*frequency*/,
+    const TSimulatedNetwork::TTableHook& hook) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (ElapsedMs(start) < nitDelayMs) {
+      if (!hook()) {
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    s.OnNit(network.MakeNit(1));
+    if (sdtDelivered) {
+      network.DeliverTransport(s, home, 1, hook);
+    }
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  storage.RegisterDvbStorageObserver(&tuners);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  RunScan(storage, timeoutMs);
+  int64_t scanTime = ElapsedMs(start);
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+  return scanTime;
+}
+
+// The acquisition times of the table type on the frequency, oldest first
+std::vector<uint32_t> GetAcquisitionTimes(const std::string& dbPath, uint32_t frequency, uint32_t tableType)
+{
+  TDvbDb db;
+  db.CreateDbFile(dbPath);
+  std::vector<std::vector<uint32_t>> rows = db.GetAcquisitionTimes();
+  db.CloseDbFile();
+  std::vector<uint32_t> times;
+  for (auto row = rows.begin(), end = rows.end(); row != end; ++row) {
+    if (((*row)[0] == frequency) && ((*row)[1] == tableType)) {
+      times.push_back((*row)[2]);
+    }
+  }
+  return times;
+}
+
+// Rescans the network after adding the history to the acquisition times of a first scan.
+// Returns the time the rescan ran and the acquisition times it recorded for the table type.
+int64_t ScanWithHistory(const char* name, uint32_t tableType, const std::vector<uint32_t>& history,
+  int64_t nitDelayMs, bool sdtDelivered, int64_t timeoutMs, std::vector<uint32_t>& recorded)
+{
+  TSimulatedNetwork network(NETWORK_ID, 1, SERVICES_PER_TRANSPORT);
+  uint32_t frequency = network.GetTransports().front().Frequency;
+  std::string dbPath = GetTestDbPath(name);
+  // A database without NIT is recreated when opened
+  ScanNetwork(network, dbPath, 0, true, 60000);
+  {
+    TDvbDb db;
+    db.CreateDbFile(dbPath);
+    for (auto it = history.begin(), end = history.end(); it != end; ++it) {
+      db.AddAcquisitionTime(frequency, tableType, *it, HISTORY_SIZE);
+    }
+    db.CloseDbFile();
+  }
+  size_t seeded = GetAcquisitionTimes(dbPath, frequency, tableType).size();
+
+  int64_t scanTime = ScanNetwork(network, dbPath, nitDelayMs, sdtDelivered, timeoutMs);
+
+  recorded = GetAcquisitionTimes(dbPath, frequency, tableType);
+  recorded.erase(recorded.begin(), recorded.begin() + std::min(seeded, recorded.size()));
+  return scanTime;
+}
+
+void CheckPercentile()
+{
+  // The 95th percentile of 7 samples (the first scan adds one) is the 6th smallest: the outlier is
+  // ignored, the timeout is 200 ms plus the 1 s margin and the NIT arriving after 2.5 s misses it
+  std::vector<uint32_t> recorded;
+  std::vector<uint32_t> history = {200, 9000, 200, 200, 200, 200};
+  int64_t scanTime = ScanWithHistory("ScanTimeoutTestMargin", NIT_TABLE_TYPE, history, 2500, true, 60000, recorded);
+  TEST_CHECK(scanTime < 2500);
+  TEST_CHECK((recorded.size() == 1) && (recorded[0] == NIT_TIMEOUT * 1000));
+
+  // Fewer than 5 samples with the one of the first scan: the default timeout
+  history.resize(3, 200);
+  ScanWithHistory("ScanTimeoutTestFew", NIT_TABLE_TYPE, history, 2500, true, 60000, recorded);
+  TEST_CHECK((recorded.size() == 1) && (recorded[0] >= 2500) && (recorded[0] < NIT_TIMEOUT * 1000));
+
+  // Above 2 s the margin is half of the percentile: 4 s + 2 s
+  history.assign(6, 4000);
+  ScanWithHistory("ScanTimeoutTestHalf", NIT_TABLE_TYPE, history, 5500, true, 60000, recorded);
+  TEST_CHECK((recorded.size() == 1) && (recorded[0] >= 5500) && (recorded[0] < 6000));
+  printf("NIT after 5.5 s with a 4 s percentile: received in %u ms\n", recorded.empty() ? 0 : recorded[0]);
+}
+
+void CheckBound()
+{
+  // 30 s + 15 s learned, bounded by 4 times the 5 s of the SDT wait: in 25 s the SDT wait times
+  // out once, recorded with the default timeout
+  std::vector<uint32_t> recorded;
+  std::vector<uint32_t> history(6, 30000);
+  ScanWithHistory("ScanTimeoutTestBound", SDT_TABLE_TYPE, history, 0, false, 25000, recorded);
+  TEST_CHECK((recorded.size() == 1) && (recorded[0] == SDT_TIMEOUT * 1000));
+  printf("SDT never received: %u waits timed out in 25 s\n", (unsigned)recorded.size());
+}
+
+} // namespace
+
+int main()
+{
+  CheckPercentile();
+  CheckBound();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// NIT and SDT cache snapshots: a new table or version is published, the same version is skipped,
+// and the tables restored from the database are verified by the same versions received again.
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t TRANSPORT_COUNT = 3;
+const uint32_t SERVICES_PER_TRANSPORT = 3;
+
+// The change of the cache counters since before
+void GetChange(TDvbSiStorage& storage, TCacheStats& before, TCacheStats& change)
+{
+  TCacheStats after = storage.GetCacheStats();
+  change.Publishes = after.Publishes - before.Publishes;
+  change.SkippedWrites = after.SkippedWrites - before.SkippedWrites;
+  change.WriteContentions = after.WriteContentions - before.WriteContentions;
+  change.RestoredTables = after.RestoredTables - before.RestoredTables;
+  change.VerifiedTables = after.VerifiedTables - before.VerifiedTables;
+  before = after;
+}
+
+void CheckPublishSkip()
+{
+  TSimulatedNetwork network(NETWORK_ID, TRANSPORT_COUNT, SERVICES_PER_TRANSPORT);
+  const std::vector<TSimulatedNetwork::TTransport>& transports = network.GetTransports();
+  std::string dbPath = GetTestDbPath("SnapshotCacheTest");
+  std::string configPath;
+  TDvbSiStorage storage(transports.front().Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  TCacheStats before = storage.GetCacheStats();
+  TCacheStats change;
+
+  storage.OnNit(network.MakeNit(1));
+  storage.OnNit(network.MakeNit(1));
+  GetChange(storage, before, change);
+  TEST_CHECK((change.Publishes == 1) && (change.SkippedWrites == 1));
+
+  storage.OnSdt(network.MakeSdt(transports[0], true, 1));
+  for (auto ts = transports.begin() + 1, end = transports.end(); ts != end; ++ts) {
+    storage.OnSdt(network.MakeSdt(*ts, false, 1));
+  }
+  GetChange(storage, before, change);
+  TEST_CHECK((change.Publishes == TRANSPORT_COUNT) && (change.SkippedWrites == 0));
+
+  // The SDT actual and other of a transport share the entry
+  storage.OnSdt(network.MakeSdt(transports[0], false, 1));
+  storage.OnSdt(network.MakeSdt(transports[1], true, 1));
+  GetChange(storage, before, change);
+  TEST_CHECK((change.Publishes == 0) && (change.SkippedWrites == 2));
+
+  // A new version replaces the entry of its transport only
+  storage.OnSdt(network.MakeSdt(transports[1], false, 2));
+  storage.OnSdt(network.MakeSdt(transports[1], false, 2));
+  storage.OnSdt(network.MakeSdt(transports[2], false, 1));
+  GetChange(storage, before, change);
+  TEST_CHECK((change.Publishes == 1) && (change.SkippedWrites == 2));
+
+  storage.OnNit(network.MakeNit(2));
+  GetChange(storage, before, change);
+  TEST_CHECK((change.Publishes == 1) && (change.SkippedWrites == 0));
+
+  // Single threaded, the writers never wait for each other and nothing is restored
+  TEST_CHECK((before.WriteContentions == 0) && (before.RestoredTables == 0) && (before.VerifiedTables == 0));
+}
+
+void CheckRestore()
+{
+  TSimulatedNetwork network(NETWORK_ID, TRANSPORT_COUNT, SERVICES_PER_TRANSPORT);
+  const std::vector<TSimulatedNetwork::TTransport>& transports = network.GetTransports();
+  std::string dbPath = GetTestDbPath("SnapshotCacheTestRestore");
+  std::string configPath;
+  {
+    TDvbSiStorage storage(transports.front().Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+    storage.CreateDatabase();
+    storage.OnNit(network.MakeNit(1));
+    for (auto ts = transports.begin(), end = transports.end(); ts != end; ++ts) {
+      storage.OnSdt(network.MakeSdt(*ts, ts == transports.begin(), 1));
+    }
+  }
+
+  // The restored NIT and SDT tables are published as one snapshot each
+  TDvbSiStorage storage(transports.front().Frequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  TCacheStats before = storage.GetCacheStats();
+  TCacheStats change;
+  storage.CreateDatabase();
+  GetChange(storage, before, change);
+  TEST_CHECK(change.Publishes == 2);
+  TEST_CHECK((change.RestoredTables == 1 + TRANSPORT_COUNT) && (change.VerifiedTables == 0));
+
+  // A restored table is verified once, by a table of the same version
+  storage.OnNit(network.MakeNit(1));
+  storage.OnNit(network.MakeNit(1));
+  GetChange(storage, before, change);
+  TEST_CHECK((change.Publishes == 1) && (change.SkippedWrites == 1) && (change.VerifiedTables == 1));
+
+  storage.OnSdt(network.MakeSdt(transports[0], true, 1));
+  storage.OnSdt(network.MakeSdt(transports[1], false, 2));
+  GetChange(storage, before, change);
+  TEST_CHECK((change.Publishes == 2) && (change.VerifiedTables == 1));
+  printf("restored: %llu tables, verified: %llu\n", (unsigned long long)before.RestoredTables,
+    (unsigned long long)before.VerifiedTables);
+}
+
+} // namespace
+
+int main()
+{
+  CheckPublishSkip();
+  CheckRestore();
+  return TestFailures ? 1 : 0;
+}
@@ -0,0 +1,504 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef TSIMULATEDNETWORK_H
+#define TSIMULATEDNETWORK_H
+
+// C system includes
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// C++ system includes
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project's includes
+#include "IDvbStorageObserver.h"
+#include "TCableDeliverySystemDescriptor.h"
+#include "TDvbSiStorage.h"
+#include "TMpegDescriptor.h"
+
+// Failed checks of the test, the exit status of main()
+static int TestFailures = 0;
+
+#define TEST_CHECK(cond)                                                   \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);     \
+      ++TestFailures;                                                      \
+    }                                                                      \
+  } while (0)
+
+static inline uint8_t EncodeBcdByte(uint32_t value)
+{
+  return (uint8_t)(((value / 10) % 10) << 4 | (value % 10));
+}
+
+// 16-bit MJD followed by 6 BCD digits, the start_time of an EIT event
+static inline uint64_t EncodeMjdUtc(time_t utcTime)
+{
+  uint64_t mjd = 40587 + utcTime / 86400;
+  uint32_t seconds = utcTime % 86400;
+  return (mjd << 24) | ((uint64_t)EncodeBcdByte(seconds / 3600) << 16) |
+    ((uint64_t)EncodeBcdByte(seconds / 60 % 60) << 8) | EncodeBcdByte(seconds % 60);
+}
+
+// 6 BCD digits hhmmss, the duration of an EIT event
+static inline uint32_t EncodeDurationBcd(uint32_t seconds)
+{
+  return ((uint32_t)EncodeBcdByte(seconds / 3600) << 16) | ((uint32_t)EncodeBcdByte(seconds / 60 % 60) << 8) |
+    EncodeBcdByte(seconds % 60);
+}
+
+static inline int64_t ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * A cable network of one original network: the transport streams of its NIT, every one
+ * carrying a few services, and the SI tables describing them.
+ */
+class TSimulatedNetwork
+{
+public:
+  struct TTransport {
+    uint32_t Frequency;
+    uint16_t TransportStreamId;
+    std::vector<uint16_t> ServiceIds;
+  };
+
+  // Called before each table is handed to the storage, false stops the delivery
+  typedef std::function<bool()> TTableHook;
+
+  TSimulatedNetwork(uint16_t networkId, uint32_t transportCount, uint32_t servicesPerTransport)
+    : NetworkId(networkId)
+  {
+    for (uint32_t i = 0; i < transportCount; i++) {
+      TTransport ts;
+      ts.Frequency = TCableDeliverySystemDescriptor(GetCableDescriptor(474 + 8 * i)).GetFrequency();
+      ts.TransportStreamId = 0x100 + i;
+      for (uint32_t s = 0; s < servicesPerTransport; s++) {
+        ts.ServiceIds.push_back(ts.TransportStreamId * 0x10 + s);
+      }
+      Transports.push_back(ts);
+    }
+  }
+
+  uint16_t GetNetworkId() const
+  {
+    return NetworkId;
+  }
+
+  // The first transport is the home transport
+  const std::vector<TTransport>& GetTransports() const
+  {
+    return Transports;
+  }
+
+  const TTransport* FindTransport(uint32_t frequency) const
+  {
+    for (auto it = Transports.begin(), end = Transports.end(); it != end; ++it) {
+      if (it->Frequency == frequency) {
+        return &*it;
+      }
+    }
+    return NULL;
+  }
+
+  std::shared_ptr<TNitTable> MakeNit(uint8_t version) const
+  {
+    std::shared_ptr<TNitTable> nit(new TNitTable((uint8_t)TTableId::TABLE_ID_NIT, NetworkId, version, true));
+    uint8_t name[] = {'c', 'a', 'b', 'l', 'e'};
+    TMpegDescriptor nameDescriptor(TDescriptorTag::NETWORK_NAME_TAG, name, sizeof(name));
+    nit->AddNetworkDescriptor(nameDescriptor);
+    for (uint32_t i = 0; i < Transports.size(); i++) {
+      TTransportStream ts(Transports[i].TransportStreamId, NetworkId);
+      TMpegDescriptor cable = GetCableDescriptor(474 + 8 * i);
+      ts.AddDescriptor(cable);
+      nit->AddTransportStream(ts);
+    }
+    return nit;
+  }
+
+  std::shared_ptr<TSdtTable> MakeSdt(const TTransport& ts, bool isActual, uint8_t version) const
+  {
+    std::shared_ptr<TSdtTable> sdt(new TSdtTable((uint8_t)(isActual ? TTableId::TABLE_ID_SDT : TTableId::TABLE_ID_SDT_OTHER),
+      ts.TransportStreamId, version, true));
+    sdt->SetOriginalNetworkId(NetworkId);
+    for (auto sid = ts.ServiceIds.begin(), end = ts.ServiceIds.end(); sid != end; ++sid) {
+      TSdtService service(*sid, true, true, 4, false);
+      uint8_t data[] = {1, 3, 'p', 'r', 'v', 4, 'n', 'a', 'm', 'e'};
+      service.AddDescriptor(TMpegDescriptor(TDescriptorTag::SERVICE_TAG, data, sizeof(data)));
+      sdt->AddService(service);
+    }
+    return sdt;
+  }
+
+  // One hour events from startTime. The p/f events are in sections 0 and 1, the schedule
+  // has three events in each 3 hour segment, startTime being on a segment boundary.
+  std::shared_ptr<TEitTable> MakeEit(const TTransport& ts, uint16_t serviceId, uint8_t tableId, uint8_t version,
+    time_t startTime, uint32_t eventCount) const
+  {
+    std::shared_ptr<TEitTable> eit(new TEitTable(tableId, serviceId, version, true));
+    eit->SetNetworkId(NetworkId);
+    eit->SetTsId(ts.TransportStreamId);
+    for (uint32_t i = 0; i < eventCount; i++) {
+      TEitEvent event(i + 1, EncodeMjdUtc(startTime + 3600 * i), EncodeDurationBcd(3600), 4, false);
+      bool isPf = (tableId == TTableId::TABLE_ID_EIT_PF) || (tableId == TTableId::TABLE_ID_EIT_PF_OTHER);
+      event.SetSectionNumber((uint8_t)(isPf ? i : (i / 3) * 8 + i % 3));
+      uint8_t data[] = {'e', 'n', 'g', 4, 'N', 'e', 'w', 's', 4, 'T', 'e', 'x', 't'};
+      event.AddDescriptor(TMpegDescriptor(TDescriptorTag::SHORT_EVENT_TAG, data, sizeof(data)));
+      eit->AddEvent(event);
+    }
+    return eit;
+  }
+
+  // Tables of the home transport: the NIT, its SDT and EIT, and if withOther the EIT
+  // schedule other of the first scheduleOtherCount other transports, then the SDT other
+  // and EIT p/f other of all of them. Returns false if the delivery was cut by an untune.
+  bool DeliverHome(TDvbSiStorage& storage, bool withOther, uint8_t version = 1, const TTableHook& hook = TTableHook(),
+    uint32_t scheduleOtherCount = 0) const
+  {
+    const TTransport& home = Transports.front();
+    if (!CallHook(hook)) {
+      return false;
+    }
+    storage.OnNit(MakeNit(version));
+    if (!DeliverTransport(storage, home, version, hook)) {
+      return false;
+    }
+    if (!withOther) {
+      return true;
+    }
+    for (uint32_t i = 1; (i <= scheduleOtherCount) && (i < Transports.size()); i++) {
+      const TTransport& ts = Transports[i];
+      for (auto sid = ts.ServiceIds.begin(), end = ts.ServiceIds.end(); sid != end; ++sid) {
+        if (!CallHook(hook)) {
+          return false;
+        }
+        storage.OnEit(MakeEit(ts, *sid, (uint8_t)TTableId::TABLE_ID_EIT_SCHED_OTHER_START, version, GetStartTime(), 24));
+      }
+    }
+    for (auto ts = Transports.begin() + 1, end = Transports.end(); ts != end; ++ts) {
+      if (!CallHook(hook)) {
+        return false;
+      }
+      storage.OnSdt(MakeSdt(*ts, false, version));
+      for (auto sid = ts->ServiceIds.begin(), sidEnd = ts->ServiceIds.end(); sid != sidEnd; ++sid) {
+        if (!CallHook(hook)) {
+          return false;
+        }
+        storage.OnEit(MakeEit(*ts, *sid, (uint8_t)TTableId::TABLE_ID_EIT_PF_OTHER, version, GetStartTime(), 2));
+      }
+    }
+    return true;
+  }
+
+  // SDT actual, EIT p/f and a day of schedule of the transport. Returns false if the
+  // delivery was cut by an untune.
+  bool DeliverTransport(TDvbSiStorage& storage, const TTransport& ts, uint8_t version = 1,
+    const TTableHook& hook = TTableHook()) const
+  {
+    if (!CallHook(hook)) {
+      return false;
+    }
+    storage.OnSdt(MakeSdt(ts, true, version));
+    for (auto sid = ts.ServiceIds.begin(), end = ts.ServiceIds.end(); sid != end; ++sid) {
+      if (!CallHook(hook)) {
+        return false;
+      }
+      storage.OnEit(MakeEit(ts, *sid, (uint8_t)TTableId::TABLE_ID_EIT_PF, version, GetStartTime(), 2));
+      if (!CallHook(hook)) {
+        return false;
+      }
+      storage.OnEit(MakeEit(ts, *sid, (uint8_t)TTableId::TABLE_ID_EIT_SCHED_START, version, GetStartTime(), 24));
+    }
+    return true;
+  }
+
+  // Start of the current 3 hour segment
+  static time_t GetStartTime()
+  {
+    return time(NULL) / 10800 * 10800;
+  }
+
+private:
+  uint16_t NetworkId;
+  std::vector<TTransport> Transports;
+
+  static bool CallHook(const TTableHook& hook)
+  {
+    return !hook || hook();
+  }
+
+  static TMpegDescriptor GetCableDescriptor(uint32_t frequencyMhz)
+  {
+    // 64-QAM, 6.875 Msymbol/s
+    uint8_t data[] = {EncodeBcdByte(frequencyMhz / 100), EncodeBcdByte(frequencyMhz % 100), 0x00, 0x00,
+      0xff, 0xf0, 0x03, 0x00, 0x68, 0x75, 0x00};
+    return TMpegDescriptor(TDescriptorTag::CABLE_DELIVERY_TAG, data, sizeof(data));
+  }
+};
+
+/**
+ * Tuners of the storage scan. A tune locks after TuneDelayMs, then the tables of the
+ * transport, given by the table source, are delivered to the storage after TableDelayMs.
+ * The idle time is measured from the arrival of the last table to the untune.
+ */
+class TSimulatedTuners : public IDvbStorageObserver
+{
+public:
+  typedef std::function<void(TDvbSiStorage& storage, uint32_t frequency, const TSimulatedNetwork::TTableHook& hook)>
+    TTableSource;
+
+  TSimulatedTuners(TDvbSiStorage& storage, const TTableSource& source, uint32_t tuneDelayMs, uint32_t tableDelayMs)
+    : Storage(storage),
+      Source(source),
+      TuneDelayMs(tuneDelayMs),
+      TableDelayMs(tableDelayMs),
+      TuneCount(0),
+      MaxActiveCount(0),
+      TakenTuneCount(0),
+      MaxIdleMs(0),
+      TotalIdleMs(0),
+      IdleCount(0)
+  {
+    // Empty
+  }
+
+  ~TSimulatedTuners()
+  {
+    Join();
+  }
+
+  // Waits for the deliveries still in progress
+  void Join()
+  {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      threads.swap(Threads);
+    }
+    for (auto it = threads.begin(), end = threads.end(); it != end; ++it) {
+      it->join();
+    }
+  }
+
+  virtual void Tune(const uint32_t& freq, const TDvbStorageNamespace::TModulationMode& mod, const uint32_t& symbol)
+  {
+    Tune(0, freq, mod, symbol);
+  }
+
+  virtual void UnTune()
+  {
+    UnTune(0);
+  }
+
+  virtual void Tune(uint8_t tunerIndex, const uint32_t& freq, const TDvbStorageNamespace::TModulationMode& mod,
+    const uint32_t& symbol)
+  {
+    (void)mod;
+    (void)symbol;
+    std::lock_guard<std::mutex> lock(Mutex);
+    ++TuneCount;
+    if (TakenTuners.find(tunerIndex) != TakenTuners.end()) {
+      ++TakenTuneCount;
+    }
+    ActiveTuners.insert(tunerIndex);
+    MaxActiveCount = std::max(MaxActiveCount, (uint32_t)ActiveTuners.size());
+    TunedFrequencies.push_back(freq);
+    uint32_t sequence = ++Sequence[tunerIndex];
+    Threads.emplace_back([this, tunerIndex, freq, sequence] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(TuneDelayMs));
+      if (!IsCurrent(tunerIndex, sequence)) {
+        return;
+      }
+      if (IsFailing(freq)) {
+        Storage.ReportTuneFailure(tunerIndex);
+        return;
+      }
+      Storage.UpdateTuneStatus(tunerIndex, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(TableDelayMs));
+      if (!IsCurrent(tunerIndex, sequence)) {
+        return;
+      }
+      // Tables stop at the untune
+      Source(Storage, freq, [this, tunerIndex, sequence] {
+        std::lock_guard<std::mutex> lock(Mutex);
+        if (Sequence[tunerIndex] != sequence) {
+          return false;
+        }
+        DeliveryTime[tunerIndex] = std::make_pair(sequence, std::chrono::steady_clock::now());
+        return true;
+      });
+    });
+  }
+
+  virtual void UnTune(uint8_t tunerIndex)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    ActiveTuners.erase(tunerIndex);
+    auto delivery = DeliveryTime.find(tunerIndex);
+    if ((delivery != DeliveryTime.end()) && (delivery->second.first == Sequence[tunerIndex])) {
+      // Time the scan stayed on the transport after its last table arrived
+      int64_t idleMs = ElapsedMs(delivery->second.second);
+      MaxIdleMs = std::max(MaxIdleMs, idleMs);
+      TotalIdleMs += idleMs;
+      ++IdleCount;
+    }
+    ++Sequence[tunerIndex];
+  }
+
+  // The tunes to the frequency don't lock
+  void SetTuneFailure(uint32_t frequency)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    FailingFrequencies.insert(frequency);
+  }
+
+  // The tuner is taken, e.g. for live viewing: its tables stop and the scan is told
+  void TakeTuner(uint8_t tunerIndex)
+  {
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      ActiveTuners.erase(tunerIndex);
+      TakenTuners.insert(tunerIndex);
+      ++Sequence[tunerIndex];
+    }
+    Storage.SetTunerAvailable(tunerIndex, false);
+  }
+
+  uint32_t GetTuneCount()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return TuneCount;
+  }
+
+  uint32_t GetMaxActiveCount()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return MaxActiveCount;
+  }
+
+  // Tunes of the taken tuners since they were taken
+  uint32_t GetTakenTuneCount()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return TakenTuneCount;
+  }
+
+  std::vector<uint32_t> GetTunedFrequencies()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return TunedFrequencies;
+  }
+
+  int64_t GetMaxIdleMs()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return MaxIdleMs;
+  }
+
+  int64_t GetMeanIdleMs()
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return IdleCount ? TotalIdleMs / IdleCount : 0;
+  }
+
+private:
+  TDvbSiStorage& Storage;
+  TTableSource Source;
+  uint32_t TuneDelayMs;
+  uint32_t TableDelayMs;
+
+  // Guards the members below
+  std::mutex Mutex;
+  uint32_t TuneCount;
+  uint32_t MaxActiveCount;
+  uint32_t TakenTuneCount;
+  std::set<uint8_t> ActiveTuners;
+  std::set<uint8_t> TakenTuners;
+  std::set<uint32_t> FailingFrequencies;
+  std::vector<std::thread> Threads;
+  std::vector<uint32_t> TunedFrequencies;
+  std::map<uint8_t, uint32_t> Sequence;
+  std::map<uint8_t, std::pair<uint32_t, std::chrono::steady_clock::time_point>> DeliveryTime;
+  int64_t MaxIdleMs;
+  int64_t TotalIdleMs;
+  uint32_t IdleCount;
+
+  bool IsCurrent(uint8_t tunerIndex, uint32_t sequence)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Sequence[tunerIndex] == sequence;
+  }
+
+  bool IsFailing(uint32_t frequency)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return FailingFrequencies.find(frequency) != FailingFrequencies.end();
+  }
+};
+
+// Runs the scan thread of the storage until the scan completes, fails or timeoutMs elapses.
+// Returns the scan time in milliseconds, -1 if the scan didn't complete.
+static inline int64_t RunScan(TDvbSiStorage& storage, int64_t timeoutMs,
+  const std::function<void(int64_t elapsedMs)>& onPoll = std::function<void(int64_t)>())
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::thread scanThread(TDvbSiStorage::ScanThreadInit, &storage);
+  int64_t scanTime = -1;
+  while (ElapsedMs(start) < timeoutMs) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (onPoll) {
+      onPoll(ElapsedMs(start));
+    }
+    TDvbStorageNamespace::TDvbScanState state = storage.GetScanStatus().ScanState;
+    if (state == TDvbStorageNamespace::SCAN_COMPLETED) {
+      scanTime = ElapsedMs(start);
+      break;
+    }
+    if (state == TDvbStorageNamespace::SCAN_FAILED) {
+      break;
+    }
+  }
+  storage.StopScan();
+  scanThread.join();
+  return scanTime;
+}
+
+// A fresh database for the test. TDvbSiStorage keeps references to the database path and
+// the network config file name, the strings have to outlive it.
+static inline std::string GetTestDbPath(const char* name)
+{
+  std::string path = std::string("/tmp/") + name + ".db";
+  remove(path.c_str());
+  return path;
+}
+
+#endif // TSIMULATEDNETWORK_H
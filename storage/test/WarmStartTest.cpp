@@ -0,0 +1,209 @@
+// DVB_SI for Reference Design Kit (RDK)
+//
+// Copyright 2015 ARRIS Enterprises
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+// Warm start: the NIT and SDT tables of the database are restored by CreateDatabase() and
+// the following scans verify them. The SDT of a transport whose tune fails is kept, and a
+// restored table ends the scan wait as soon as the first section of its version is seen.
+
+#include "TSimulatedNetwork.h"
+
+using namespace TDvbStorageNamespace;
+
+namespace {
+
+const uint16_t NETWORK_ID = 0x1234;
+const uint32_t TRANSPORT_COUNT = 6;
+const uint32_t SERVICES_PER_TRANSPORT = 3;
+// The transport whose tune fails in the second scan
+const uint32_t FAILING_TRANSPORT = 3;
+const uint32_t TUNE_DELAY_MS = 50;
+const uint32_t TABLE_DELAY_MS = 50;
+// Database of a larger network for the restore time
+const uint32_t LARGE_TRANSPORT_COUNT = 50;
+const uint32_t LARGE_SERVICES_PER_TRANSPORT = 20;
+
+// Scans the network. The home transport carries the SDT other and EIT p/f other of all
+// the transports but the failing one, whose tune fails.
+bool ScanNetwork(TDvbSiStorage& storage, const TSimulatedNetwork& network, const TSimulatedNetwork::TTransport* failing)
+{
+  const std::vector<TSimulatedNetwork::TTransport>& transports = network.GetTransports();
+  uint32_t homeFrequency = transports.front().Frequency;
+  TSimulatedTuners tuners(storage, [&network, &transports, homeFrequency, failing](TDvbSiStorage& s, uint32_t frequency,
+    const TSimulatedNetwork::TTableHook& hook) {
+    if (frequency != homeFrequency) {
+      if (const TSimulatedNetwork::TTransport* ts = network.FindTransport(frequency)) {
+        network.DeliverTransport(s, *ts, 1, hook);
+      }
+      return;
+    }
+    if (!network.DeliverHome(s, false, 1, hook)) {
+      return;
+    }
+    for (auto ts = transports.begin() + 1, end = transports.end(); ts != end; ++ts) {
+      if (&*ts == failing) {
+        continue;
+      }
+      if (!hook()) {
+        return;
+      }
+      s.OnSdt(network.MakeSdt(*ts, false, 1));
+      for (auto sid = ts->ServiceIds.begin(), sidEnd = ts->ServiceIds.end(); sid != sidEnd; ++sid) {
+        if (!hook()) {
+          return;
+        }
+        s.OnEit(network.MakeEit(*ts, *sid, (uint8_t)TTableId::TABLE_ID_EIT_PF_OTHER, 1, TSimulatedNetwork::GetStartTime(), 2));
+      }
+    }
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  if (failing) {
+    tuners.SetTuneFailure(failing->Frequency);
+  }
+  storage.RegisterDvbStorageObserver(&tuners);
+  int64_t scanTime = RunScan(storage, 60000);
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+  return scanTime >= 0;
+}
+
+void CheckWarmScans()
+{
+  TSimulatedNetwork network(NETWORK_ID, TRANSPORT_COUNT, SERVICES_PER_TRANSPORT);
+  uint32_t homeFrequency = network.GetTransports().front().Frequency;
+  std::string dbPath = GetTestDbPath("WarmStartTest");
+  std::string configPath;
+  {
+    TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+    storage.CreateDatabase();
+    TEST_CHECK(storage.GetCacheStats().RestoredTables == 0);
+    TEST_CHECK(ScanNetwork(storage, network, NULL));
+  }
+
+  // The NIT and an SDT per transport
+  TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  TCacheStats stats = storage.GetCacheStats();
+  TEST_CHECK(stats.RestoredTables == 1 + TRANSPORT_COUNT);
+  TEST_CHECK(stats.VerifiedTables == 0);
+
+  // The tune of a transport fails and no SDT other of it is around: its restored SDT
+  // is kept for the next scan
+  const TSimulatedNetwork::TTransport& failing = network.GetTransports()[FAILING_TRANSPORT];
+  TEST_CHECK(ScanNetwork(storage, network, &failing));
+  uint64_t verified = storage.GetCacheStats().VerifiedTables;
+  TEST_CHECK(verified == TRANSPORT_COUNT);
+
+  // All the tables are verified, including the SDT of the transport missed by the previous scan
+  TEST_CHECK(ScanNetwork(storage, network, NULL));
+  stats = storage.GetCacheStats();
+  TEST_CHECK(stats.VerifiedTables - verified == 1 + TRANSPORT_COUNT);
+  printf("restored: %llu tables, verified by the scans: %llu\n",
+    (unsigned long long)stats.RestoredTables, (unsigned long long)stats.VerifiedTables);
+}
+
+// Only the first section of every NIT and SDT arrives, the EIT p/f tables are complete as in ScanNetwork()
+void CheckVersionSeen()
+{
+  TSimulatedNetwork network(NETWORK_ID, TRANSPORT_COUNT, SERVICES_PER_TRANSPORT);
+  const std::vector<TSimulatedNetwork::TTransport>& transports = network.GetTransports();
+  uint32_t homeFrequency = transports.front().Frequency;
+  std::string dbPath = GetTestDbPath("WarmStartTestVersion");
+  std::string configPath;
+  {
+    TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+    storage.CreateDatabase();
+    TEST_CHECK(ScanNetwork(storage, network, NULL));
+  }
+
+  TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  storage.CreateDatabase();
+  TSimulatedTuners tuners(storage, [&network, &transports, homeFrequency](TDvbSiStorage& s, uint32_t frequency,
+    const TSimulatedNetwork::TTableHook& hook) {
+    const TSimulatedNetwork::TTransport* tuned = network.FindTransport(frequency);
+    if (!tuned || !hook()) {
+      return;
+    }
+    if (frequency == homeFrequency) {
+      s.OnVersionSeen((uint8_t)TTableId::TABLE_ID_NIT, NETWORK_ID, 0, 1);
+      for (auto ts = transports.begin() + 1, end = transports.end(); ts != end; ++ts) {
+        s.OnVersionSeen((uint8_t)TTableId::TABLE_ID_SDT_OTHER, ts->TransportStreamId, NETWORK_ID, 1);
+        for (auto sid = ts->ServiceIds.begin(), sidEnd = ts->ServiceIds.end(); sid != sidEnd; ++sid) {
+          if (!hook()) {
+            return;
+          }
+          s.OnEit(network.MakeEit(*ts, *sid, (uint8_t)TTableId::TABLE_ID_EIT_PF_OTHER, 1,
+            TSimulatedNetwork::GetStartTime(), 2));
+        }
+      }
+    }
+    s.OnVersionSeen((uint8_t)TTableId::TABLE_ID_SDT, tuned->TransportStreamId, NETWORK_ID, 1);
+    for (auto sid = tuned->ServiceIds.begin(), end = tuned->ServiceIds.end(); sid != end; ++sid) {
+      if (!hook()) {
+        return;
+      }
+      s.OnEit(network.MakeEit(*tuned, *sid, (uint8_t)TTableId::TABLE_ID_EIT_PF, 1, TSimulatedNetwork::GetStartTime(), 2));
+      s.OnEit(network.MakeEit(*tuned, *sid, (uint8_t)TTableId::TABLE_ID_EIT_SCHED_START, 1,
+        TSimulatedNetwork::GetStartTime(), 24));
+    }
+  }, TUNE_DELAY_MS, TABLE_DELAY_MS);
+  storage.RegisterDvbStorageObserver(&tuners);
+  int64_t scanTime = RunScan(storage, 60000);
+  tuners.Join();
+  storage.RemoveDvbStorageObserver(&tuners);
+
+  // No wait ran into its timeout
+  TEST_CHECK((scanTime >= 0) && (scanTime < SDT_TIMEOUT * 1000));
+  TEST_CHECK(storage.GetCacheStats().VerifiedTables == 1 + TRANSPORT_COUNT);
+  TEST_CHECK(storage.GetServiceListByTsId(NETWORK_ID, transports.back().TransportStreamId).size() == SERVICES_PER_TRANSPORT);
+  printf("scan verifying the restored versions: %lld ms\n", (long long)scanTime);
+}
+
+void CheckRestoreTime()
+{
+  TSimulatedNetwork network(NETWORK_ID, LARGE_TRANSPORT_COUNT, LARGE_SERVICES_PER_TRANSPORT);
+  uint32_t homeFrequency = network.GetTransports().front().Frequency;
+  std::string dbPath = GetTestDbPath("WarmStartTestLarge");
+  std::string configPath;
+  {
+    TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+    storage.CreateDatabase();
+    storage.OnNit(network.MakeNit(1));
+    const std::vector<TSimulatedNetwork::TTransport>& transports = network.GetTransports();
+    for (auto ts = transports.begin(), end = transports.end(); ts != end; ++ts) {
+      storage.OnSdt(network.MakeSdt(*ts, ts == transports.begin(), 1));
+    }
+  }
+
+  TDvbSiStorage storage(homeFrequency, MODULATION_MODE_QAM64, 6875, NETWORK_ID, dbPath, configPath);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  storage.CreateDatabase();
+  int64_t restoreMs = ElapsedMs(start);
+  TEST_CHECK(storage.GetCacheStats().RestoredTables == 1 + LARGE_TRANSPORT_COUNT);
+  printf("%u transports x %u services: restored in %lld ms\n", LARGE_TRANSPORT_COUNT, LARGE_SERVICES_PER_TRANSPORT,
+    (long long)restoreMs);
+}
+
+} // namespace
+
+int main()
+{
+  CheckWarmScans();
+  CheckVersionSeen();
+  CheckRestoreTime();
+  return TestFailures ? 1 : 0;
+}